@@ -0,0 +1,132 @@
+#ifndef BITPACKED_CAPSULES_HPP
+#define BITPACKED_CAPSULES_HPP
+
+#include "VariantMatrixCapsule.hpp"
+#include "VariantMatrix.hpp"
+#include <mutex>
+#include <vector>
+
+namespace Sequence
+{
+    class BitPackedGenotypeCapsule : public GenotypeCapsule
+    /// \brief Genotype storage for bi-allelic (0/1) data using one bit per
+    /// genotype.
+    ///
+    /// Each site is stored as a row of 64-bit words whose bits are set
+    /// where a sample carries state 1.  Missing data are tracked
+    /// in a separate bit mask with the same layout.  Any negative
+    /// value is considered missing and is read back as -1.
+    /// Unused bits at the end of each row are always zero.
+    ///
+    /// Element access via operator() is supported directly.  The
+    /// pointer-based interface of GenotypeCapsule (data(), begin(), etc.)
+    /// requires a contiguous std::int8_t buffer, which is unpacked lazily
+    /// on first use and cached.  Unpacking happens once, under
+    /// std::call_once, so const objects may be shared between threads.
+    /// Code that is aware of this type should use row_bits() and
+    /// row_missing() instead.
+    ///
+    /// The data are read-only: non-const access throws std::runtime_error.
+    ///
+    /// \ingroup variantmatrix
+    {
+      public:
+        using word_type = std::uint64_t;
+        /// Number of genotypes stored per word_type.
+        static constexpr std::size_t word_bits = 64;
+
+      private:
+        std::vector<word_type> bits, missing;
+        std::size_t nsites_, nsam_, nwords;
+        bool has_missing_;
+        mutable std::vector<std::int8_t> unpacked;
+        mutable std::once_flag unpacked_flag;
+        const std::int8_t* unpack() const;
+
+      public:
+        /// Construct from a row-major matrix with \a num_rows
+        /// sites.  std::invalid_argument is thrown if any
+        /// non-missing value is not 0 or 1, or if the
+        /// reserved VariantMatrix::mask value is present.
+        BitPackedGenotypeCapsule(const std::vector<std::int8_t>& data,
+                                 const std::size_t num_rows);
+
+        /// Construct from a (possibly offset and strided)
+        /// block of row-major data.  The arguments have the
+        /// same meaning as those of NonOwningGenotypeCapsule.
+        BitPackedGenotypeCapsule(const std::int8_t* data, std::size_t nrow,
+                                 std::size_t ncol, std::size_t row_offset,
+                                 std::size_t column_offset,
+                                 std::size_t trailing);
+
+        /// Number of words used to store each row
+        std::size_t words_per_row() const;
+        /// Pointer to the words encoding state 1 at \a site
+        const word_type* row_bits(const std::size_t site) const;
+        /// Pointer to the words encoding missing data at \a site
+        const word_type* row_missing(const std::size_t site) const;
+        /// Returns true if any genotype is missing
+        bool has_missing() const;
+
+        std::size_t& nsites();
+
+        std::size_t& nsam();
+
+        std::size_t nsites() const;
+
+        std::size_t nsam() const;
+
+        std::size_t row_offset() const final;
+
+        std::size_t col_offset() const final;
+
+        std::size_t stride() const final;
+
+        std::int8_t& operator()(std::size_t, std::size_t);
+
+        const std::int8_t& operator()(std::size_t, std::size_t) const;
+
+        std::int8_t* data() final;
+
+        const std::int8_t* data() const final;
+
+        const std::int8_t* cdata() const final;
+
+        std::unique_ptr<GenotypeCapsule> clone() const final;
+
+        std::int8_t* begin() final;
+
+        const std::int8_t* begin() const final;
+
+        std::int8_t* end() final;
+
+        const std::int8_t* end() const final;
+
+        const std::int8_t* cbegin() const final;
+
+        const std::int8_t* cend() const final;
+
+        bool empty() const final;
+
+        std::size_t size() const final;
+
+        bool resizable() const final;
+    };
+
+    /*! \brief Return a copy of a VariantMatrix using bit-packed genotypes
+     * \param m A VariantMatrix
+     *
+     * The returned object uses BitPackedGenotypeCapsule for the genotypes
+     * and copies the positions.  AlleleCountMatrix, difference_matrix,
+     * and two_locus_haplotype_counts detect this storage and use
+     * popcount-based kernels.
+     *
+     * std::invalid_argument is thrown if \a m contains non-missing
+     * states other than 0 and 1.
+     *
+     * \ingroup variantmatrix
+     */
+    VariantMatrix make_bitpacked(const VariantMatrix& m);
+} // namespace Sequence
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef __SEQUENCE_COALESCENT_ARENA_HPP__
+#define __SEQUENCE_COALESCENT_ARENA_HPP__
+
+#include <Sequence/Coalescent/SimTypes.hpp>
+#include <vector>
+#include <cstddef>
+
+/*! \file Arena.hpp
+  @brief Storage for segments and marginal trees that is reused across replicates
+*/
+
+namespace Sequence
+{
+  namespace coalsim {
+    class sim_arena
+    /*!
+      @brief Storage for segments and marginal trees that is reused across replicates
+
+      A chromosome constructed with a pointer to a sim_arena takes its segments
+      from the arena rather than from malloc.  Segment arrays are carved out of
+      large chunks, and arrays that are released are kept on free lists for reuse
+      by later allocations of the same size class.  The chunks are only freed when
+      the arena is destroyed.
+
+      Marginal trees are recycled in the same way.  crossover copies marginal trees
+      into list nodes taken from the arena when the chromosomes of the sample use one,
+      and recycle moves the marginal trees of a finished replicate into the arena.
+
+      A typical loop over replicates is:
+      \code
+      sim_arena arena;
+      std::vector<chromosome> sample;
+      arg history;
+      for(unsigned rep = 0 ; rep < nreps ; ++rep)
+      {
+      arena.init_replicate(std::vector<int>(1,nsam),nsites,&sample,&history);
+      SimData d = neutral_sample(uni,uni01,expo,poiss,theta,rho,nsites,nsam,&sample,&history);
+      }
+      \endcode
+      After the first few replicates, this loop makes almost no calls to the heap
+      while simulating the ARG.
+
+      An arena may only be used by one thread at a time, and it must outlive the
+      chromosomes that use it.
+      \ingroup coalescent
+    */
+    {
+    private:
+      std::vector<std::vector<segment> > chunks;
+      //The chunk from which the next array is carved, and the offset into it
+      std::size_t chunk, offset;
+      //free_arrays[k] holds released arrays of 2^k segments
+      std::vector<std::vector<segment *> > free_arrays;
+      std::vector<segment> scratch_space;
+      std::size_t live;
+      arg spare;
+    public:
+      sim_arena();
+      sim_arena(const sim_arena &) = delete;
+      sim_arena & operator=(const sim_arena &) = delete;
+      segment * allocate( const unsigned & n, unsigned * capacity );
+      void deallocate( segment * segs, const unsigned & capacity );
+      segment * scratch( const std::size_t & n );
+      arg::iterator insert_marginal( arg * sample_history,
+				     arg::iterator pos,
+				     const marginal & m );
+      void recycle( arg * sample_history );
+      void reset();
+      void init_replicate( const std::vector<int> & pop_config,
+			   const int & nsites,
+			   std::vector<chromosome> * sample,
+			   arg * sample_history );
+    };
+  }
+}
+#endif
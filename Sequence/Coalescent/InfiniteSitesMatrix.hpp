@@ -0,0 +1,49 @@
+#ifndef __SEQUENCE_COALESCENT_INFINITESITESMATRIX_HPP__
+#define __SEQUENCE_COALESCENT_INFINITESITESMATRIX_HPP__
+
+#include <Sequence/Coalescent/SimTypes.hpp>
+#include <Sequence/VariantMatrix.hpp>
+
+/*! \file InfiniteSitesMatrix.hpp
+  @brief Infinitely-many sites mutation, storing the sample in a VariantMatrix
+
+  These functions are also declared by including Mutation.hpp.  This header
+  does not depend on the deprecated SimData.
+*/
+
+namespace Sequence
+{
+  namespace coalsim {
+    template<typename poisson_generator,
+	     typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( poisson_generator & poiss,
+						 uniform_generator & uni,
+						 const int & nsites,
+						 const arg & history,
+						 const double & theta );
+
+    template<typename poisson_generator,
+	     typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( const poisson_generator & poiss,
+						 const uniform_generator & uni,
+						 const int & nsites,
+						 const arg & history,
+						 const double & theta );
+
+    template<typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( uniform_generator & uni,
+						 const int & nsites,
+						 const arg & history,
+						 const double * total_times,
+						 const unsigned * segsites );
+
+    template<typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( const uniform_generator & uni,
+						 const int & nsites,
+						 const arg & history,
+						 const double * total_times,
+						 const unsigned * segsites );
+  }
+}
+#endif
+#include <Sequence/Coalescent/bits/InfiniteSitesMatrix.tcc>
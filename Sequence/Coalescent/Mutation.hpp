@@ -2,6 +2,7 @@
 #define __SEQUENCE_COALESCENT_MUTATION_HPP__
 
 #include <Sequence/Coalescent/SimTypes.hpp>
+#include <Sequence/Coalescent/InfiniteSitesMatrix.hpp>
 #include <Sequence/SimData.hpp>
 #include <vector>
 #include <string>
@@ -0,0 +1,140 @@
+#ifndef __SEQUENCE_COALESCENT_REPLICATEDRIVER_HPP__
+#define __SEQUENCE_COALESCENT_REPLICATEDRIVER_HPP__
+
+#include <Sequence/Coalescent/SimTypes.hpp>
+#include <Sequence/VariantMatrix.hpp>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+/*! \file ReplicateDriver.hpp
+  @brief Run many replicates of a coalescent simulation on several threads
+*/
+
+namespace Sequence
+{
+  namespace coalsim {
+    class rng_streams
+    /*!
+      @brief The random number generators used by one replicate
+
+      The public members uni, uni01, expo, and poiss are function objects
+      with the interfaces required by neutral_sample, snm, bottleneck,
+      exponential_change, and infinite_sites_sim_data.  They all draw from
+      engine.
+
+      The engine is seeded from a seed and a replicate number, so the
+      variates of a replicate depend only on those two values, and not on
+      the thread simulating it or on the replicates simulated before it.
+
+      Objects of this type may not be copied, because the function objects
+      refer to the engine.
+      \ingroup coalescent
+    */
+    {
+    public:
+      typedef std::mt19937_64 engine_type;
+
+      struct uniform
+      //! Returns a double uniformly from [a,b)
+      {
+	engine_type * e;
+	double operator()(const double & a, const double & b) const
+	{
+	  return std::uniform_real_distribution<double>(a,b)(*e);
+	}
+      };
+
+      struct uniform01
+      //! Returns a double uniformly from [0,1)
+      {
+	engine_type * e;
+	double operator()() const
+	{
+	  return std::uniform_real_distribution<double>(0.,1.)(*e);
+	}
+      };
+
+      struct exponential
+      /*! Returns an exponential variate with the given mean.
+	An infinite mean, which the simulation routines pass when
+	a rate is zero, returns infinity.
+      */
+      {
+	engine_type * e;
+	double operator()(const double & mean) const
+	{
+	  return (mean < std::numeric_limits<double>::infinity()) ?
+	    std::exponential_distribution<double>(1./mean)(*e) :
+	    std::numeric_limits<double>::infinity();
+	}
+      };
+
+      struct poisson
+      //! Returns a Poisson variate with the given mean, or 0 if mean <= 0
+      {
+	engine_type * e;
+	int operator()(const double & mean) const
+	{
+	  return (mean > 0.) ? std::poisson_distribution<int>(mean)(*e) : 0;
+	}
+      };
+
+      engine_type engine;
+      uniform uni;
+      uniform01 uni01;
+      exponential expo;
+      poisson poiss;
+
+      rng_streams( const std::uint64_t & seed,
+		   const std::uint64_t & replicate );
+      rng_streams( const rng_streams & ) = delete;
+      rng_streams & operator=( const rng_streams & ) = delete;
+      //! Seed the engine for another replicate
+      void reseed( const std::uint64_t & seed,
+		   const std::uint64_t & replicate );
+    };
+
+    struct neutral_replicate
+    /*!
+      @brief The output of one replicate of neutral_replicates
+      \ingroup coalescent
+    */
+    {
+      //! The ancestral recombination graph
+      arg history;
+      //! The sample, with one row per segregating site
+      VariantMatrix genotypes;
+    };
+
+    template<typename simulation_function,
+	     typename output_function>
+    void run_replicates( const std::uint64_t & nreps,
+			 const std::uint64_t & seed,
+			 const unsigned & nthreads,
+			 const simulation_function & simulate,
+			 output_function && output );
+
+    template<typename output_function>
+    void neutral_replicates( const std::uint64_t & nreps,
+			     const std::uint64_t & seed,
+			     const unsigned & nthreads,
+			     const double & theta,
+			     const double & rho,
+			     const int & nsites,
+			     const int & nsam,
+			     output_function && output );
+
+    template<typename output_function>
+    void neutral_variant_matrices( const std::uint64_t & nreps,
+				   const std::uint64_t & seed,
+				   const unsigned & nthreads,
+				   const double & theta,
+				   const double & rho,
+				   const int & nsites,
+				   const int & nsam,
+				   output_function && output );
+  }
+}
+#endif
+#include <Sequence/Coalescent/bits/ReplicateDriver.tcc>
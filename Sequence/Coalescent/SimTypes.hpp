@@ -29,7 +29,8 @@
 
 /*! \struct Sequence::coalsim::chromosome Sequence/Coalescent/SimTypes.hpp
   @brief A chromosome is a container of segments.
-  \note this is a malloc-based container
+  \note this is a malloc-based container, unless it is
+  constructed with a pointer to a sim_arena.
   \ingroup coalescent
 */
 
@@ -80,6 +81,8 @@
 namespace Sequence
 {
   namespace coalsim {
+    class sim_arena;
+
     struct segment
     {
       int beg,end,desc;
@@ -113,15 +116,32 @@ namespace Sequence
 	The number of segments contained in the pointer segs
       */
       unsigned nsegs;
+      /*!
+	The number of segments allocated for segs
+      */
+      unsigned capacity;
+      /*!
+	The arena from which segs is allocated, or NULL if segs
+	is allocated with malloc.  Copies of a chromosome use
+	the same arena.
+      */
+      sim_arena * arena;
       chromosome();
       chromosome(const chromosome & ch);
+      chromosome(chromosome && ch) noexcept;
       chromosome( const std::vector<segment> & initial_segs,
 		  const int & population = 0 );
+      chromosome( const_iterator first, const_iterator last,
+		  const int & population = 0,
+		  sim_arena * storage = NULL );
       ~chromosome();
       chromosome & operator=(const chromosome & ch);
+      chromosome & operator=(chromosome && ch) noexcept;
       void swap_with( chromosome & ch );
       void assign_allocated_segs( segment * newsegs,
 				  const unsigned & new_nsegs );
+      void assign_segs( const_iterator first,
+			const unsigned & new_nsegs );
       int first() const
       /*!
 	\return the first position in the chromosome
@@ -7,6 +7,8 @@
 #include <Sequence/Coalescent/SimTypes.hpp>
 #include <vector>
 #include <memory>
+#include <cstddef>
+#include <cstdint>
 namespace Sequence
 {
   namespace coalsim {
@@ -25,6 +27,55 @@ namespace Sequence
 			const int & ind,
 			const int & branch );
 
+    class marginal_tree_stats
+    /*!
+      @brief Cached statistics of a marginal tree, for placing many mutations on it
+
+      The branch lengths of the tree are kept in a Fenwick tree, so that
+      pick_branch takes time logarithmic in the sample size, and the
+      descendants of each node are kept as a bitset of the tips.  Moving
+      to the next marginal tree of an arg only updates the branch lengths
+      and bitsets that depend on the nodes that differ between the trees,
+      which are usually few.
+      \code
+      marginal_tree_stats stats;
+      for(arg::const_iterator i = history.begin() ; i != history.end() ; ++i)
+      {
+      stats.update(*i);
+      int branch = stats.pick_branch(uni(0.,stats.total_time()));
+      }
+      \endcode
+      \ingroup coalescent
+    */
+    {
+    private:
+      int nsam;
+      std::size_t nwords;
+      std::vector<node> tree;
+      //The two children of each node, or -1
+      std::vector<int> children;
+      std::vector<double> branch_lengths;
+      //Fenwick tree of branch_lengths
+      std::vector<double> branch_sums;
+      double total_time_;
+      //The tips descending from each node, nwords per node
+      std::vector<std::uint64_t> bits;
+      std::vector<int> changed,reparented,dirty;
+      std::vector<char> marked;
+      void rebuild( const marginal & m );
+      void update_branch( const int & i );
+      void mark_ancestors( int i );
+    public:
+      marginal_tree_stats();
+      void update( const marginal & m );
+      double total_time() const;
+      int pick_branch( const double & rtime ) const;
+      const std::uint64_t * descendants( const int & branch ) const;
+      void descendants( const int & branch, std::vector<int> * tips ) const;
+      std::size_t words() const;
+      bool is_descendant( const int & ind, const int & branch ) const;
+    };
+
     double total_time_on_arg( const Sequence::coalsim::arg & sample_history,
 			      const int & total_number_of_sites );
 
@@ -0,0 +1,156 @@
+#ifndef __SEQUENCE_COALESCENT_TREESEQUENCE_HPP__
+#define __SEQUENCE_COALESCENT_TREESEQUENCE_HPP__
+
+#include <Sequence/Coalescent/SimTypes.hpp>
+#include <Sequence/VariantMatrix.hpp>
+#include <map>
+#include <vector>
+
+/*! \file TreeSequence.hpp
+  @brief Storage of an ancestral recombination graph as tables of nodes and edges
+*/
+
+namespace Sequence
+{
+  namespace coalsim {
+    struct edge
+    /*!
+      @brief An edge of a tree sequence.
+      Node child descends from node parent on the marginal trees
+      for sites [left,right).
+      \ingroup coalescent
+    */
+    {
+      int left,right,parent,child;
+    };
+
+    struct tree_sequence
+    /*!
+      @brief An ancestral recombination graph stored as tables of nodes and edges
+
+      Each coalescent event is stored once, as a node, however many marginal
+      trees it belongs to, and each parent/child relationship is stored once,
+      as an edge, for the whole interval of sites over which it holds.  Adjacent
+      marginal trees that differ by a few branches therefore share storage, and
+      memory grows with the number of edges rather than with the number of marginal
+      trees times the sample size, as it does for arg.
+
+      Nodes 0 to nsam-1 are the sample.  Other nodes are numbered in the order in
+      which they were created, which is also in order of increasing time.
+
+      Marginal trees are visited with marginal_tree_walker.
+      \ingroup coalescent
+    */
+    {
+      //! The sample size
+      int nsam;
+      //! The number of sites
+      int nsites;
+      //! The time of each node
+      std::vector<double> node_times;
+      //! The edges, in the order in which they were recorded
+      std::vector<edge> edges;
+      tree_sequence(const int & sample_size, const int & number_of_sites);
+    };
+
+    class tree_sequence_recorder
+    /*!
+      @brief Records coalescent events into a tree_sequence during a simulation
+
+      The segments of the chromosomes of the sample refer to nodes of the
+      tree sequence, rather than to nodes of marginal trees.  The recorder
+      keeps the number of lineages ancestral to each site, so that sites whose
+      most recent common ancestor has been found are removed from the sample.
+      Crossovers are applied with crossover, passing NULL as the arg.
+      \ingroup coalescent
+    */
+    {
+    private:
+      tree_sequence ts;
+      //lineages[x] is the number of lineages ancestral to the
+      //sites from x up to the next key
+      std::map<int,int> lineages;
+      std::vector<int> breakpoints;
+      std::vector<segment> merged;
+      void add_edge( const int & left, const int & right,
+		     const int & parent, const int & child,
+		     const std::size_t & first_edge );
+    public:
+      tree_sequence_recorder( const int & nsam, const int & nsites );
+      int coalesce( const double & time,
+		    const int & current_nsam,
+		    const int & c1,
+		    const int & c2,
+		    int * nlinks,
+		    std::vector<chromosome> * sample );
+      tree_sequence & result();
+    };
+
+    class marginal_tree_walker
+    /*!
+      @brief Visits the marginal trees of a tree_sequence from left to right
+
+      Moving to the next tree removes the edges that end at its left
+      boundary and inserts the edges that begin there, so visiting all of
+      the trees takes time proportional to the number of edges, rather than
+      to the number of trees times the sample size.  The total time on the
+      tree, and the cumulative branch lengths used by pick_branch, are
+      updated as edges are removed and inserted.
+      \code
+      marginal_tree_walker w(ts);
+      while(w.next())
+      {
+      //The tree for sites [w.left(),w.right())
+      double t = w.total_time();
+      }
+      \endcode
+      \ingroup coalescent
+    */
+    {
+    private:
+      const tree_sequence & ts;
+      std::vector<std::size_t> insertion,removal;
+      std::size_t next_insertion,next_removal;
+      int left_,right_;
+      std::vector<int> parent_,children;
+      //Fenwick tree of branch lengths, indexed by child node
+      std::vector<double> branch_sums;
+      double total_time_;
+      void update_branch( const int & node, const double & length );
+      void remove_edge( const edge & e );
+      void insert_edge( const edge & e );
+    public:
+      explicit marginal_tree_walker( const tree_sequence & t );
+      bool next();
+      //! The first site of the current tree
+      int left() const;
+      //! One past the last site of the current tree
+      int right() const;
+      //! The parent of each node in the current tree, or -1
+      const std::vector<int> & parents() const;
+      double total_time() const;
+      int pick_branch( const double & rtime ) const;
+      void descendants( const int & node, std::vector<int> * tips ) const;
+    };
+
+    template<typename uniform_generator,
+	     typename uniform01_generator,
+	     typename exponential_generator>
+    tree_sequence neutral_tree_sequence( uniform_generator & uni,
+					 uniform01_generator & uni01,
+					 exponential_generator & expo,
+					 const double & rho,
+					 const int & nsites,
+					 const int & nsam,
+					 std::vector<chromosome> * sample );
+
+    template<typename poisson_generator,
+	     typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( poisson_generator & poiss,
+						 uniform_generator & uni,
+						 const tree_sequence & ts,
+						 const double & theta );
+  }
+}
+#endif
+#include <Sequence/Coalescent/bits/TreeSequence.tcc>
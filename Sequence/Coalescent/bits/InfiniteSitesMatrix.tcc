@@ -0,0 +1,190 @@
+// Code for the -*- C++ -*- 
+#ifndef __SEQUENCE_COALESCENT_BITS_INFINITESITESMATRIX_TCC__
+#define __SEQUENCE_COALESCENT_BITS_INFINITESITESMATRIX_TCC__
+
+#include <Sequence/Coalescent/TreeOperations.hpp>
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace Sequence
+{
+  namespace coalsim {
+#ifndef DOXYGEN_SKIP
+    template<typename poisson_generator,
+	     typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix_details( poisson_generator & poiss,
+							 uniform_generator & uni,
+							 const int & nsites,
+							 const arg & history,
+							 const double & theta)
+    {
+      std::vector<unsigned> segsites(history.size());
+      std::vector<double> total_times(history.size());
+      arg::const_iterator i = history.begin(),j=i;
+      ++j;
+      size_t nsegs = history.size();
+      for(size_t seg = 0 ; seg < nsegs ; ++seg,++i,++j)
+	{
+	  int end = (seg<nsegs-1) ? j->beg : nsites;
+	  int beg = i->beg;
+	  total_times[seg] = total_time(i->begin(),i->nsam);
+	  segsites[seg] = unsigned(poiss(total_times[seg]*theta*double(end-beg)/double(nsites)));
+	}
+      return infinite_sites_variant_matrix(uni,nsites,history,&total_times[0],&segsites[0]);
+    }
+
+    template<typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix_details( uniform_generator & uni,
+							 const int & nsites,
+							 const arg & history,
+							 const double * total_times,
+							 const unsigned * segsites )
+    //Random numbers are drawn in the same order as infinite_sites_sim_data,
+    //so both return the same sample for the same generators.
+    {
+      assert(total_times != NULL);
+      assert(segsites != NULL);
+      const std::size_t S = std::accumulate(segsites,segsites+history.size(),std::size_t(0));
+      const std::size_t nsam = (S>0) ? std::size_t(history.begin()->nsam) : 0;
+      std::vector<std::int8_t> data(S*nsam,0);
+      std::vector<double> pos(S);
+      marginal_tree_stats stats;
+      std::size_t snp = 0, seg = 0, nsegs = history.size();
+      arg::const_iterator i=history.begin(),
+	j = history.begin();
+      ++j;
+      for( ; seg < nsegs ; ++seg,++i,++j )
+	{
+	  if( *(segsites+seg) > 0 )
+	    {
+	      int end = (seg<nsegs-1) ? j->beg : nsites;
+	      int beg = i->beg;
+	      const double tt = *(total_times+seg);
+	      stats.update(*i);
+	      for(const std::size_t last = snp + *(segsites+seg) ; snp < last ; ++snp)
+		{
+		  pos[snp] = uni(beg,end)/double(nsites);
+		  const std::uint64_t * bits = stats.descendants(stats.pick_branch(uni(0.,tt)));
+		  std::int8_t * row = data.data() + snp*nsam;
+		  for(std::size_t ind = 0 ; ind < nsam ; ++ind)
+		    {
+		      row[ind] = std::int8_t((bits[ind/64] >> (ind%64)) & 1);
+		    }
+		}
+	    }
+	}
+      //Mutations on a marginal tree are exchangeable, and the positions
+      //on different trees do not overlap, so sorting the positions alone
+      //puts the sites in order.
+      std::sort(pos.begin(),pos.end());
+      return VariantMatrix(std::move(data),std::move(pos),1);
+    }
+#endif
+
+    template<typename poisson_generator,
+	     typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( poisson_generator & poiss,
+						 uniform_generator & uni,
+						 const int & nsites,
+						 const arg & history,
+						 const double & theta )
+    /*!
+      @brief Apply the infinitely-many sites mutation model to an ancestral recombination graph,
+      storing the sample in a VariantMatrix
+      \param poiss a Poisson random number generator which takes the mean of the poisson as an argument
+      \param uni a uniform random number generator that takes two doubles as an argument
+      \param nsites the length of the region begin simulated
+      \param history the list of marginal histories for the sample
+      \param theta the coalescent-scaled mutation rate
+      \return A VariantMatrix with one row per segregating site, in which ancestral states are 0
+      and derived states are 1.
+
+      The matrix is allocated once the number of segregating sites is known, and the
+      descendants of the branches of each marginal tree are kept by a marginal_tree_stats,
+      which is updated from one tree to the next.  Unlike infinite_sites, this does not use MAX_SEGSITES or MAX_SEGS_INC.
+      Given the same random numbers, the result is the same as for infinite_sites_sim_data.
+      \ingroup coalescent
+    */
+    {
+      return infinite_sites_variant_matrix_details(poiss,uni,nsites,history,theta);
+    }
+
+    template<typename poisson_generator,
+	     typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( const poisson_generator & poiss,
+						 const uniform_generator & uni,
+						 const int & nsites,
+						 const arg & history,
+						 const double & theta )
+    /*!
+      @brief Apply the infinitely-many sites mutation model to an ancestral recombination graph,
+      storing the sample in a VariantMatrix
+      \param poiss a Poisson random number generator which takes the mean of the poisson as an argument
+      \param uni a uniform random number generator that takes two doubles as an argument
+      \param nsites the length of the region begin simulated
+      \param history the list of marginal histories for the sample
+      \param theta the coalescent-scaled mutation rate
+      \return A VariantMatrix with one row per segregating site, in which ancestral states are 0
+      and derived states are 1.
+
+      The matrix is allocated once the number of segregating sites is known, and the
+      descendants of the branches of each marginal tree are kept by a marginal_tree_stats,
+      which is updated from one tree to the next.  Unlike infinite_sites, this does not use MAX_SEGSITES or MAX_SEGS_INC.
+      Given the same random numbers, the result is the same as for infinite_sites_sim_data.
+      \ingroup coalescent
+    */
+    {
+      return infinite_sites_variant_matrix_details(poiss,uni,nsites,history,theta);
+    }
+
+    template<typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( uniform_generator & uni,
+						 const int & nsites,
+						 const arg & history,
+						 const double * total_times,
+						 const unsigned * segsites )
+    /*!
+      @brief Apply the infinitely-many sites mutation model to an ancestral recombination graph with
+      a fixed number of segregating sites, storing the sample in a VariantMatrix
+      \param uni a uniform random number generator that takes two doubles as an argument
+      \param nsites the length of the region begin simulated
+      \param history the list of marginal histories for the sample
+      \param total_times the total times on each marginal tree in \a history
+      \param segsites the number of segregating sites to place on each tree
+      \return A VariantMatrix with one row per segregating site, in which ancestral states are 0
+      and derived states are 1.
+      \note \a total_times and \a segsites must contain a number of elements equal to history.size()
+      \ingroup coalescent
+    */
+    {
+      return infinite_sites_variant_matrix_details(uni,nsites,history,total_times,segsites);
+    }
+
+    template<typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( const uniform_generator & uni,
+						 const int & nsites,
+						 const arg & history,
+						 const double * total_times,
+						 const unsigned * segsites )
+    /*!
+      @brief Apply the infinitely-many sites mutation model to an ancestral recombination graph with
+      a fixed number of segregating sites, storing the sample in a VariantMatrix
+      \param uni a uniform random number generator that takes two doubles as an argument
+      \param nsites the length of the region begin simulated
+      \param history the list of marginal histories for the sample
+      \param total_times the total times on each marginal tree in \a history
+      \param segsites the number of segregating sites to place on each tree
+      \return A VariantMatrix with one row per segregating site, in which ancestral states are 0
+      and derived states are 1.
+      \note \a total_times and \a segsites must contain a number of elements equal to history.size()
+      \ingroup coalescent
+    */
+    {
+      return infinite_sites_variant_matrix_details(uni,nsites,history,total_times,segsites);
+    }
+  }
+} //ns sequence
+#endif
@@ -49,6 +49,41 @@ namespace Sequence
 	}
     }
 
+    template<typename uniform_generator>
+    void add_S_inf_sites_details( uniform_generator & uni ,
+				  const marginal_tree_stats & stats,
+				  const double & tt,
+				  const int & beg, const int & end,
+				  const int & nsam, const int & nsites,
+				  const int & S ,
+				  const int & first_snp_index,
+				  gamete_storage_type * gametes,
+				  std::vector<int> * tips )
+    //As above, using the cached statistics of the marginal tree
+    {
+      assert(S>=0);
+      assert(tt >= 0.);
+      assert(nsam > 0);
+      assert(nsites > 0);
+      for(std::vector<std::string>::size_type snp = std::vector<std::string>::size_type(first_snp_index) ; 
+	  snp < std::vector<std::string>::size_type(first_snp_index+S) ; ++snp)
+	{
+	  double pos = uni(beg,end)/double(nsites);
+	  gametes->first[snp]=pos;
+	  stats.descendants(stats.pick_branch(uni(0.,tt)),tips);
+	  for(std::vector<std::string>::size_type ind=0;
+	      ind<std::vector<std::string>::size_type(nsam);
+	      ++ind)
+	    {
+	      gametes->second[ind][snp] = '0';
+	    }
+	  for( const int ind : *tips )
+	    {
+	      gametes->second[std::vector<std::string>::size_type(ind)][snp] = '1';
+	    }
+	}
+    }
+
     template<typename poisson_generator,
 	     typename uniform_generator>
     std::vector<std::string>::size_type infinite_sites_details( poisson_generator & poiss,
@@ -62,6 +97,8 @@ namespace Sequence
       assert(theta >= 0.);
       int snp_index_i=0;
       RTYPE ttlS=0;
+      marginal_tree_stats stats;
+      std::vector<int> tips;
       arg::size_type seg=0,nsegs=history.size();
       arg::const_iterator i = history.begin(),j=i;
       ++j;
@@ -92,8 +129,9 @@ namespace Sequence
 		      itr->resize(MAX_SEGSITES);
 		    }
 		}
-	      add_S_inf_sites(uni,i->begin(),tt,beg,end,i->nsam,nsites,
-			      S,snp_index_i,gametes);
+	      stats.update(*i);
+	      add_S_inf_sites_details(uni,stats,tt,beg,end,i->nsam,nsites,
+				      S,snp_index_i,gametes,&tips);
 	      snp_index_i+=S;
 	    }
 	}
@@ -111,6 +149,8 @@ namespace Sequence
 								const unsigned * segsites )  
     {
       typedef std::vector<std::string>::size_type RTYPE;
+      marginal_tree_stats stats;
+      std::vector<int> tips;
       arg::size_type seg=0,nsegs = history.size();
       arg::const_iterator i=history.begin(),
 	j = history.begin();
@@ -139,9 +179,10 @@ namespace Sequence
 		}
 	      int end = (seg<nsegs-1) ? j->beg : nsites;
 	      int beg = i->beg;
-	      add_S_inf_sites(uni,i->begin(),*(total_times+seg),
-			      beg,end,i->nsam,nsites,
-			      *(segsites+seg),ttlS,gametes);
+	      stats.update(*i);
+	      add_S_inf_sites_details(uni,stats,*(total_times+seg),
+				      beg,end,i->nsam,nsites,
+				      int(*(segsites+seg)),int(ttlS),gametes,&tips);
 	    }
 	  ttlS += *(segsites+seg);
 	}
@@ -192,6 +233,8 @@ namespace Sequence
       std::vector<std::string> d(nsam,std::string(S,' '));
       std::vector<double> pos(S);
       auto pos_i = pos.begin();
+      marginal_tree_stats stats;
+      std::vector<int> tips;
       unsigned seg=0,nsegs = unsigned(history.size());
       arg::const_iterator i=history.begin(),
 	j = history.begin();
@@ -205,21 +248,19 @@ namespace Sequence
 	      int end = (seg<nsegs-1) ? j->beg : nsites;
 	      int beg = i->beg;
 	      const double tt = *(total_times+seg);
+	      stats.update(*i);
 	      for(unsigned snp = unsigned(ttlS) ; snp < unsigned(ttlS)+*(segsites+seg) ; ++snp)
 		{
 		  double pos = uni(beg,end)/double(nsites);
 		  *(pos_i+snp)=pos;
-		  int branch = pick_branch(i->begin(),nsam,uni(0.,tt));
+		  stats.descendants(stats.pick_branch(uni(0.,tt)),&tips);
 		  for(unsigned ind=0;ind<nsam;++ind)
 		    {
-		      if( is_descendant(i->begin(),int(ind),branch) )
-			{
-			  d[ind][snp] = '1';
-			}
-		      else
-			{
-			  d[ind][snp] = '0';
-			}
+		      d[ind][snp] = '0';
+		    }
+		  for( const int ind : tips )
+		    {
+		      d[unsigned(ind)][snp] = '1';
 		    }
 		}
 	      ttlS += *(segsites+seg);
@@ -0,0 +1,328 @@
+//  -*- C++ -*-
+#ifndef __SEQUENCE_COALESCENT_BITS_REPLICATEDRIVER_TCC__
+#define __SEQUENCE_COALESCENT_BITS_REPLICATEDRIVER_TCC__
+
+#include <Sequence/Coalescent/Arena.hpp>
+#include <Sequence/Coalescent/InfiniteSitesMatrix.hpp>
+#include <Sequence/Coalescent/NeutralHistory.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Sequence
+{
+  namespace coalsim {
+#ifndef DOXYGEN_SKIP
+    namespace details {
+      //Threads may run this many replicates per thread ahead of the
+      //replicate being output, which bounds the results held in memory.
+      const std::uint64_t REPLICATES_PER_THREAD = 64;
+
+      template<typename result_type,
+	       typename simulation_function>
+      class replicate_pool
+      /*
+	Simulates replicates [0,nreps) on nthreads threads, which are
+	started once and run until every replicate has been taken.
+	Each thread has its own copy of the simulation function and
+	its own rng_streams, and takes the next replicate from a shared
+	counter, which balances the work when replicates differ in run
+	time.  Results wait in a ring of window slots until take() is
+	called for them, in replicate order, and a thread does not start
+	a replicate until its slot is free.
+      */
+      {
+      private:
+	const simulation_function & simulate;
+	const std::uint64_t seed, nreps, window;
+	std::atomic<std::uint64_t> next;
+	std::atomic<bool> stop;
+	//The members below are guarded by mutex
+	std::mutex mutex;
+	std::condition_variable result_ready, slot_free;
+	std::uint64_t taken;
+	std::vector<std::unique_ptr<result_type> > slots;
+	std::exception_ptr error;
+	std::vector<std::thread> threads;
+
+	void work()
+	{
+	  try
+	    {
+	      simulation_function local(simulate);
+	      rng_streams rng(seed,0);
+	      std::uint64_t r;
+	      while( !stop && (r = next++) < nreps )
+		{
+		  {
+		    std::unique_lock<std::mutex> lock(mutex);
+		    slot_free.wait(lock,[this,r](){ return stop || r < taken + window; });
+		  }
+		  if( stop )
+		    {
+		      return;
+		    }
+		  rng.reseed(seed,r);
+		  std::unique_ptr<result_type> result(new result_type(local(rng,r)));
+		  std::lock_guard<std::mutex> lock(mutex);
+		  slots[std::size_t(r%window)] = std::move(result);
+		  result_ready.notify_one();
+		}
+	    }
+	  catch(...)
+	    {
+	      std::lock_guard<std::mutex> lock(mutex);
+	      if( !error )
+		{
+		  error = std::current_exception();
+		}
+	      stop = true;
+	      result_ready.notify_one();
+	      slot_free.notify_all();
+	    }
+	}
+
+	void shutdown()
+	{
+	  {
+	    std::lock_guard<std::mutex> lock(mutex);
+	    stop = true;
+	  }
+	  slot_free.notify_all();
+	  for(auto & t : threads)
+	    {
+	      t.join();
+	    }
+	  threads.clear();
+	}
+      public:
+	replicate_pool(const simulation_function & simulate_,
+		       const std::uint64_t & seed_,
+		       const std::uint64_t & nreps_,
+		       const unsigned & nthreads)
+	  : simulate(simulate_), seed(seed_), nreps(nreps_),
+	    window(REPLICATES_PER_THREAD*nthreads), next(0), stop(false),
+	    mutex(), result_ready(), slot_free(), taken(0),
+	    slots(std::size_t(window)), error(), threads()
+	{
+	  threads.reserve(nthreads);
+	  try
+	    {
+	      for(unsigned t = 0 ; t < nthreads ; ++t)
+		{
+		  threads.emplace_back(&replicate_pool::work,this);
+		}
+	    }
+	  catch(...)
+	    {
+	      //The destructor does not run if the constructor throws,
+	      //so threads that started must be stopped and joined here.
+	      shutdown();
+	      throw;
+	    }
+	}
+
+	replicate_pool(const replicate_pool &) = delete;
+	replicate_pool & operator=(const replicate_pool &) = delete;
+
+	std::unique_ptr<result_type> take(const std::uint64_t & r)
+	//Wait for replicate r, which must follow the last one taken,
+	//and rethrow the first exception of any thread
+	{
+	  std::unique_lock<std::mutex> lock(mutex);
+	  std::unique_ptr<result_type> & slot = slots[std::size_t(r%window)];
+	  result_ready.wait(lock,[this,&slot](){ return slot || error; });
+	  if( error )
+	    {
+	      std::rethrow_exception(error);
+	    }
+	  std::unique_ptr<result_type> rv(std::move(slot));
+	  taken = r+1;
+	  lock.unlock();
+	  slot_free.notify_all();
+	  return rv;
+	}
+
+	~replicate_pool()
+	//Stops the threads early if take() or the output function threw
+	{
+	  shutdown();
+	}
+      };
+
+      class neutral_workspace
+      /*
+	Simulates replicates for neutral_replicates and
+	neutral_variant_matrices.  run_replicates gives each thread
+	its own copy, and a copy starts with empty storage, so each
+	thread keeps one arena, sample and ARG for the whole run.
+	The marginal trees of the previous replicate's ARG are
+	recycled into the arena by init_replicate.
+      */
+      {
+      private:
+	const std::vector<int> pop_config;
+	const double theta, rho;
+	const int nsites, nsam;
+	//Declared first, so that it outlives the sample
+	sim_arena arena;
+	std::vector<chromosome> sample;
+      public:
+	arg history;
+
+	neutral_workspace(const double & theta_, const double & rho_,
+			  const int & nsites_, const int & nsam_)
+	  : pop_config(1,nsam_), theta(theta_), rho(rho_), nsites(nsites_),
+	    nsam(nsam_), arena(), sample(), history()
+	{
+	}
+
+	neutral_workspace(const neutral_workspace & other)
+	  : pop_config(other.pop_config), theta(other.theta), rho(other.rho),
+	    nsites(other.nsites), nsam(other.nsam), arena(), sample(), history()
+	{
+	}
+
+	neutral_workspace & operator=(const neutral_workspace &) = delete;
+
+	VariantMatrix simulate(rng_streams & rng)
+	//Replaces history with the ARG of a new replicate, and returns its sample
+	{
+	  arena.init_replicate(pop_config,nsites,&sample,&history);
+	  neutral_history(rng.uni,rng.uni01,rng.expo,rho,nsites,nsam,&sample,&history);
+	  return infinite_sites_variant_matrix(rng.poiss,rng.uni,nsites,history,theta);
+	}
+      };
+    }
+#endif
+
+    template<typename simulation_function,
+	     typename output_function>
+    void run_replicates( const std::uint64_t & nreps,
+			 const std::uint64_t & seed,
+			 const unsigned & nthreads,
+			 const simulation_function & simulate,
+			 output_function && output )
+    /*!
+      @brief Run replicates of a simulation on several threads
+
+      \param nreps The number of replicates
+      \param seed The seed.  Replicate r uses an rng_streams seeded with \a seed and r.
+      \param nthreads The number of threads simulating replicates
+      \param simulate A function object called as simulate(rng,r), where rng is an
+      rng_streams and r is the replicate number, returning the result of replicate r.
+      Each thread calls its own copy of \a simulate, so the copy may keep storage that
+      it reuses from one replicate to the next, but copies must not share state that
+      they modify.
+      \param output A function object called as output(r,std::move(result)) for replicates
+      r = 0 to \a nreps - 1, in that order, on the calling thread.
+
+      The results do not depend on \a nthreads.  The threads are started once, and each
+      takes the next replicate number from a shared counter until all \a nreps have been
+      taken.  Results are output while later replicates are simulated.  A thread does
+      not start a replicate more than 64 * \a nthreads ahead of the replicate being
+      output, which bounds the number of results held in memory.
+
+      If \a simulate or \a output throws, no more replicates are started, and the
+      exception is rethrown once the running replicates have finished.
+
+      \exception std::invalid_argument if \a nthreads is 0
+      \ingroup coalescent
+    */
+    {
+      if( nthreads == 0 )
+	{
+	  throw std::invalid_argument("nthreads must be > 0");
+	}
+      if( nthreads == 1 )
+	{
+	  simulation_function local(simulate);
+	  rng_streams rng(seed,0);
+	  for( std::uint64_t r = 0 ; r < nreps ; ++r )
+	    {
+	      rng.reseed(seed,r);
+	      output(r,local(rng,r));
+	    }
+	  return;
+	}
+      typedef typename std::decay<decltype(std::declval<simulation_function &>()(std::declval<rng_streams &>(),
+										 std::uint64_t()))>::type result_type;
+      details::replicate_pool<result_type,simulation_function> pool(simulate,seed,nreps,nthreads);
+      for( std::uint64_t r = 0 ; r < nreps ; ++r )
+	{
+	  output(r,std::move(*pool.take(r)));
+	}
+    }
+
+    template<typename output_function>
+    void neutral_replicates( const std::uint64_t & nreps,
+			     const std::uint64_t & seed,
+			     const unsigned & nthreads,
+			     const double & theta,
+			     const double & rho,
+			     const int & nsites,
+			     const int & nsam,
+			     output_function && output )
+    /*!
+      @brief Run replicates of neutral_sample on several threads
+
+      Calls run_replicates with a simulation function that calls neutral_history
+      for a single population, followed by infinite_sites_variant_matrix.
+      \a output is called as output(r,std::move(result)), where result is a
+      neutral_replicate.  The sample is the same as neutral_sample would return
+      for the same random numbers.
+
+      Each thread takes the segments of its chromosomes from one sim_arena for
+      the whole run.  The ARG of each replicate is handed to \a output, so its
+      marginal trees cannot be recycled.  When only the samples are needed,
+      neutral_variant_matrices also reuses the marginal trees.
+      \ingroup coalescent
+    */
+    {
+      details::neutral_workspace workspace(theta,rho,nsites,nsam);
+      auto simulate = [workspace](rng_streams & rng, const std::uint64_t &) mutable
+	{
+	  VariantMatrix genotypes = workspace.simulate(rng);
+	  return neutral_replicate{std::move(workspace.history),std::move(genotypes)};
+	};
+      run_replicates(nreps,seed,nthreads,simulate,output);
+    }
+
+    template<typename output_function>
+    void neutral_variant_matrices( const std::uint64_t & nreps,
+				   const std::uint64_t & seed,
+				   const unsigned & nthreads,
+				   const double & theta,
+				   const double & rho,
+				   const int & nsites,
+				   const int & nsam,
+				   output_function && output )
+    /*!
+      @brief Run replicates of neutral_sample on several threads, keeping only the samples
+
+      As neutral_replicates, but \a output is called as output(r,std::move(genotypes)),
+      where genotypes is the VariantMatrix of replicate r.  The ARG of each replicate
+      stays with the thread that simulated it, which recycles its marginal trees and
+      segments into its sim_arena at the start of the next replicate.  After the first
+      few replicates, the simulation of the ARG makes almost no calls to the heap.
+      \ingroup coalescent
+    */
+    {
+      details::neutral_workspace workspace(theta,rho,nsites,nsam);
+      auto simulate = [workspace](rng_streams & rng, const std::uint64_t &) mutable
+	{
+	  return workspace.simulate(rng);
+	};
+      run_replicates(nreps,seed,nthreads,simulate,output);
+    }
+  }
+}
+#endif
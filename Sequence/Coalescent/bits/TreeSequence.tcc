@@ -0,0 +1,137 @@
+//  -*- C++ -*-
+#ifndef __SEQUENCE_COALESCENT_BITS_TREESEQUENCE_TCC__
+#define __SEQUENCE_COALESCENT_BITS_TREESEQUENCE_TCC__
+
+#include <Sequence/Coalescent/Coalesce.hpp>
+#include <Sequence/Coalescent/Recombination.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+namespace Sequence
+{
+  namespace coalsim {
+    template<typename uniform_generator,
+	     typename uniform01_generator,
+	     typename exponential_generator>
+    tree_sequence neutral_tree_sequence( uniform_generator & uni,
+					 uniform01_generator & uni01,
+					 exponential_generator & expo,
+					 const double & rho,
+					 const int & nsites,
+					 const int & nsam,
+					 std::vector<chromosome> * sample )
+    /*!
+      @brief Simulate the genealogy of a sample under a neutral equilibrium model,
+      recording it as a tree_sequence.
+
+      This is neutral_history, recording the genealogy with a tree_sequence_recorder
+      rather than as an arg.  Given the same random numbers, the marginal trees are
+      the same as those of neutral_history.
+
+      \param uni a function/object capable of returning a random double uniformly from [0,k)
+      \param uni01 a function/object capable of returning a random probability uniformly from [0,1)
+      \param expo a function/object capable of returning an exponentially distributed random variable,
+      taking the mean as an argument
+      \param rho 4Nr, the recombination rate for the whole region
+      \param nsites the number of mutational sites to simulate
+      \param nsam the sample size
+      \param sample A pointer to the sample of chromosomes, initialized with init_sample
+      \ingroup coalescent
+    */
+    {
+      tree_sequence_recorder recorder(nsam,nsites);
+      int NSAM = nsam;
+      double littler = rho/(double(nsites-1));
+      int nlinks = nsam*(nsites-1);
+      double t = 0.;
+      while(NSAM>1)
+	{
+	  double rcoal = double(NSAM*(NSAM-1));
+	  double rrec = (rho>0.) ? littler*double(nlinks) : 0.;
+	  double tcoal = expo(1./rcoal);
+	  double trec = expo(1./rrec);
+	  if ( trec < tcoal )
+	    {
+	      t+=trec;
+	      std::pair<int,int> pos_rec = pick_uniform_spot(uni01(),
+							     nlinks,
+							     sample->begin(),NSAM);
+	      nlinks -= crossover(NSAM,pos_rec.first,pos_rec.second,
+				  sample,NULL);
+	      NSAM++;
+	    }
+	  else
+	    {
+	      t+=tcoal;
+	      std::pair<int,int> two = pick2(uni,NSAM);
+	      NSAM -= recorder.coalesce(t,NSAM,two.first,two.second,&nlinks,sample);
+	    }
+	  if (unsigned(NSAM) < sample->size()/5)
+	    {
+	      sample->erase(sample->begin()+NSAM+1,sample->end());
+	    }
+	}
+      return std::move(recorder.result());
+    }
+
+    template<typename poisson_generator,
+	     typename uniform_generator>
+    VariantMatrix infinite_sites_variant_matrix( poisson_generator & poiss,
+						 uniform_generator & uni,
+						 const tree_sequence & ts,
+						 const double & theta )
+    /*!
+      @brief Apply the infinitely-many sites mutation model to a tree sequence
+      \param poiss a Poisson random number generator which takes the mean of the poisson as an argument
+      \param uni a uniform random number generator that takes two doubles as an argument
+      \param ts the genealogy of the sample
+      \param theta the coalescent-scaled mutation rate
+      \return A VariantMatrix with one row per segregating site, in which ancestral states are 0
+      and derived states are 1.
+
+      The number of mutations on every tree is drawn before any of them are placed, as
+      infinite_sites_variant_matrix does for an arg, so both return the same sample for
+      the same genealogy and the same random numbers.
+      \ingroup coalescent
+    */
+    {
+      const std::size_t nsam = std::size_t(ts.nsam);
+      std::vector<double> total_times;
+      std::vector<int> segsites;
+      {
+	marginal_tree_walker w(ts);
+	while( w.next() )
+	  {
+	    total_times.push_back(w.total_time());
+	    segsites.push_back(poiss(total_times.back()*theta*double(w.right()-w.left())/double(ts.nsites)));
+	  }
+      }
+      std::vector<std::int8_t> data;
+      std::vector<double> pos;
+      std::vector<int> tips;
+      marginal_tree_walker w(ts);
+      for( std::size_t tree = 0 ; w.next() ; ++tree )
+	{
+	  const double tt = total_times[tree];
+	  for( int snp = 0 ; snp < segsites[tree] ; ++snp )
+	    {
+	      pos.push_back(uni(w.left(),w.right())/double(ts.nsites));
+	      w.descendants(w.pick_branch(uni(0.,tt)),&tips);
+	      data.resize(data.size()+nsam,0);
+	      std::int8_t * row = data.data()+data.size()-nsam;
+	      for( const int tip : tips )
+		{
+		  row[tip] = 1;
+		}
+	    }
+	}
+      //Positions on different trees do not overlap, and mutations
+      //on the same tree are exchangeable.
+      std::sort(pos.begin(),pos.end());
+      return VariantMatrix(std::move(data),std::move(pos),1);
+    }
+  }
+}
+#endif
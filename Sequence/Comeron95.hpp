@@ -59,6 +59,9 @@ long with libsequence.  If not, see <http://www.gnu.org/licenses/>.
   is passed, resulting in several places where exceptions can be thrown.  Most of
   these situations are caught in the constructor, which will prevent most leaks.
   However, anything is possible, so use \c auto_ptr
+  \note To compare all pairs of a set of aligned sequences, use Sequence::Comeron95_pairs,
+  which converts each sequence to codons once and can use several threads, rather
+  than the loop in the example below.
   \n
   Example: a simple program to calculate Ka and Ks:\n
   \code
@@ -118,15 +121,27 @@ long with libsequence.  If not, see <http://www.gnu.org/licenses/>.
 #include <Sequence/Seq.hpp>
 #include <array>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace Sequence
   {
     using Com95_t = std::array<double,19>;
+
+    std::vector<Com95_t> Comeron95_pairs(const std::vector<const Seq *> & seqs,
+					 int maxdiffs = 3,
+					 GeneticCodes code = GeneticCodes::UNIVERSAL,
+					 unsigned nthreads = 1);
+
     class Comeron95 
     {
     private:
       struct Com95impl;
       std::unique_ptr<Com95impl> impl;
+      friend std::vector<Com95_t> Comeron95_pairs(const std::vector<const Seq *> & seqs,
+						  int maxdiffs,
+						  GeneticCodes code,
+						  unsigned nthreads);
     public:
       explicit Comeron95( GeneticCodes code = GeneticCodes::UNIVERSAL );
       Comeron95( const Comeron95 & ) = delete;
@@ -141,6 +156,28 @@ namespace Sequence
 			 const WeightingScheme3 *weights3,
 			 int maxdiffs = 3);
   };
+
+    template<typename SeqType>
+    inline typename std::enable_if<std::is_base_of<Seq,SeqType>::value,std::vector<Com95_t> >::type
+    Comeron95_pairs(const std::vector<SeqType> & seqs,
+		    int maxdiffs = 3,
+		    GeneticCodes code = GeneticCodes::UNIVERSAL,
+		    unsigned nthreads = 1)
+    /*!
+      Calculate synonymous and nonsynonymous distances between all pairs of
+      a vector of aligned coding sequences, such as std::vector<Sequence::Fasta>.
+      See the overload taking pointers for details.
+      \ingroup kaks
+    */
+    {
+      std::vector<const Seq *> pointers;
+      pointers.reserve(seqs.size());
+      for (const SeqType & s : seqs)
+	{
+	  pointers.push_back(&s);
+	}
+      return Comeron95_pairs(pointers,maxdiffs,code,nthreads);
+    }
 }
 
 #endif
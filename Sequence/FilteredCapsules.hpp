@@ -0,0 +1,171 @@
+#ifndef FILTERED_CAPSULES_HPP
+#define FILTERED_CAPSULES_HPP
+
+#include "VariantMatrixCapsule.hpp"
+#include "VariantMatrix.hpp"
+#include "VariantMatrixViews.hpp"
+#include <vector>
+
+namespace Sequence
+{
+    class IndexRuns
+    /// \brief An ordered list of indexes, stored as runs of
+    /// consecutive values.
+    ///
+    /// Memory use grows with the number of runs, which is one more
+    /// than the number of gaps, rather than with the number of
+    /// indexes.  Element access is a binary search over the runs.
+    ///
+    /// \ingroup variantmatrix
+    {
+      private:
+        // first_[r] is the first index of run r.  end_[r] is the
+        // position in the list one past the end of run r.
+        std::vector<std::size_t> first_, end_;
+
+      public:
+        /// Empty list
+        IndexRuns();
+        /// The list first, first + 1, ..., first + n - 1
+        IndexRuns(std::size_t first, std::size_t n);
+        /// The list \a indexes
+        explicit IndexRuns(const std::vector<std::size_t>& indexes);
+
+        /// Append an index, extending the last run if possible
+        void push_back(std::size_t index);
+        /// Number of indexes
+        std::size_t size() const;
+        /// True if there are no indexes
+        bool empty() const;
+        /// Index at position \a i of the list, without range checking
+        std::size_t operator[](std::size_t i) const;
+        /// Number of runs
+        std::size_t nruns() const;
+        /// True if the indexes form at most one run
+        bool contiguous() const;
+        /// First index of run \a r
+        std::size_t run_first(std::size_t r) const;
+        /// Position in the list of the start of run \a r
+        std::size_t run_begin(std::size_t r) const;
+        /// Number of indexes in run \a r
+        std::size_t run_length(std::size_t r) const;
+        /// The list as a vector
+        std::vector<std::size_t> expand() const;
+    };
+
+    class FilteredGenotypeCapsule : public GenotypeCapsule
+    /// \brief Read-only view of selected sites and samples of
+    /// other genotype storage.
+    ///
+    /// The view holds a non-owning span of the parent genotypes
+    /// plus the parent indexes of the sites and samples that are
+    /// kept, stored as runs.  Building a view copies no genotypes.
+    /// The parent data must outlive the view.
+    ///
+    /// Row views, column views and spans of the view are made by
+    /// row(), col() and span(), which get_ConstRowView,
+    /// get_ConstColView and get_ConstGenotypeSpan call, so that
+    /// statistics run on any view:
+    ///
+    /// - When the kept samples are one run, as for views that only
+    ///   filter sites, rows point into the parent rows.  A span
+    ///   holds the offset of each kept row, using one std::size_t
+    ///   per site for as long as the span exists.
+    /// - Otherwise, row() gathers the one row that is asked for,
+    ///   and span() gathers the view, into storage owned by the
+    ///   returned object and freed with it.
+    /// - Columns point into the parent when the kept sites are one
+    ///   run, and are gathered otherwise.
+    ///
+    /// Nothing is cached in the capsule.  The pointer interface of
+    /// GenotypeCapsule (data(), begin(), etc.) has nowhere to keep
+    /// gathered data, so it works only when the kept sites and
+    /// samples are both single runs, and throws std::runtime_error
+    /// otherwise.  begin() and end() also need the kept sites to be
+    /// whole parent rows.
+    ///
+    /// The data are read-only: non-const access throws std::runtime_error.
+    ///
+    /// \ingroup variantmatrix
+    {
+      private:
+        ConstGenotypeSpan base_;
+        IndexRuns sites_, samples_;
+        std::size_t nsites_, nsam_;
+        const std::int8_t* first() const;
+
+      public:
+        /// Construct from a span of the parent data and the
+        /// parent indexes of the sites and samples to keep.
+        /// std::out_of_range is thrown if any index is out of
+        /// range for \a base.
+        FilteredGenotypeCapsule(const ConstGenotypeSpan& base,
+                                IndexRuns sites, IndexRuns samples);
+
+        /// The parent genotypes
+        const ConstGenotypeSpan& base() const;
+        /// Parent indexes of the sites in the view
+        const IndexRuns& sites() const;
+        /// Parent indexes of the samples in the view
+        const IndexRuns& samples() const;
+
+        /// Copy the genotypes of \a site into \a out, which
+        /// must have room for nsam() values
+        void gather_row(std::size_t site, std::int8_t* out) const;
+        /// View of a site.  See the class description for when
+        /// the view owns a copy.
+        ConstRowView row(std::size_t site) const;
+        /// View of a sample.  See the class description for when
+        /// the view owns a copy.
+        ConstColView col(std::size_t sample) const;
+        /// Span of the view.  See the class description for what
+        /// the span owns.
+        ConstGenotypeSpan span() const;
+
+        std::size_t& nsites();
+
+        std::size_t& nsam();
+
+        std::size_t nsites() const;
+
+        std::size_t nsam() const;
+
+        std::size_t row_offset() const final;
+
+        std::size_t col_offset() const final;
+
+        std::size_t stride() const final;
+
+        std::int8_t& operator()(std::size_t, std::size_t);
+
+        const std::int8_t& operator()(std::size_t, std::size_t) const;
+
+        std::int8_t* data() final;
+
+        const std::int8_t* data() const final;
+
+        const std::int8_t* cdata() const final;
+
+        std::unique_ptr<GenotypeCapsule> clone() const final;
+
+        std::int8_t* begin() final;
+
+        const std::int8_t* begin() const final;
+
+        std::int8_t* end() final;
+
+        const std::int8_t* end() const final;
+
+        const std::int8_t* cbegin() const final;
+
+        const std::int8_t* cend() const final;
+
+        bool empty() const final;
+
+        std::size_t size() const final;
+
+        bool resizable() const final;
+    };
+} // namespace Sequence
+
+#endif
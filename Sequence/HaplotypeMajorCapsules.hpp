@@ -0,0 +1,140 @@
+#ifndef HAPLOTYPE_MAJOR_CAPSULES_HPP
+#define HAPLOTYPE_MAJOR_CAPSULES_HPP
+
+#include "VariantMatrixCapsule.hpp"
+#include "VariantMatrix.hpp"
+#include "VariantMatrixViews.hpp"
+#include <mutex>
+#include <vector>
+
+namespace Sequence
+{
+    class HaplotypeMajorGenotypeCapsule : public GenotypeCapsule
+    /// \brief Genotype storage with the data of each sample
+    /// ("haplotype") stored contiguously.
+    ///
+    /// The genotype of sample j at site i is stored at
+    /// j * nsites + i, which is the transpose of the
+    /// usual layout.  Routines that work one haplotype at a
+    /// time, such as difference_matrix, label_haplotypes, lhaf
+    /// and nsl, detect this storage and read each haplotype
+    /// as a contiguous block.
+    ///
+    /// Element access via operator() is supported directly.  The
+    /// pointer-based interface of GenotypeCapsule (data(), begin(), etc.)
+    /// requires the usual site-major layout, which is transposed
+    /// once, on first use, and cached, so that a matrix using this
+    /// storage holds both layouts once per-site statistics have been
+    /// calculated from it.  The transpose is done under std::call_once,
+    /// so const access from several threads is safe.
+    ///
+    /// The data are read-only: non-const access throws std::runtime_error.
+    ///
+    /// \ingroup variantmatrix
+    {
+      private:
+        std::vector<std::int8_t> haplotypes;
+        std::size_t nsites_, nsam_;
+        mutable std::vector<std::int8_t> site_major;
+        mutable std::once_flag site_major_flag;
+        const std::int8_t* transpose() const;
+
+      public:
+        /// Construct from a (possibly offset and strided)
+        /// block of site-major data.  The arguments have the
+        /// same meaning as those of NonOwningGenotypeCapsule.
+        HaplotypeMajorGenotypeCapsule(const std::int8_t* data,
+                                      std::size_t nrow, std::size_t ncol,
+                                      std::size_t row_offset,
+                                      std::size_t column_offset,
+                                      std::size_t trailing);
+
+        /// Pointer to the genotypes of \a sample
+        const std::int8_t* haplotype_data(const std::size_t sample) const;
+        /// View of the genotypes of \a sample, with a stride of one
+        ConstColView haplotype(const std::size_t sample) const;
+
+        std::size_t& nsites();
+
+        std::size_t& nsam();
+
+        std::size_t nsites() const;
+
+        std::size_t nsam() const;
+
+        std::size_t row_offset() const final;
+
+        std::size_t col_offset() const final;
+
+        std::size_t stride() const final;
+
+        std::int8_t& operator()(std::size_t, std::size_t);
+
+        const std::int8_t& operator()(std::size_t, std::size_t) const;
+
+        std::int8_t* data() final;
+
+        const std::int8_t* data() const final;
+
+        const std::int8_t* cdata() const final;
+
+        std::unique_ptr<GenotypeCapsule> clone() const final;
+
+        std::int8_t* begin() final;
+
+        const std::int8_t* begin() const final;
+
+        std::int8_t* end() final;
+
+        const std::int8_t* end() const final;
+
+        const std::int8_t* cbegin() const final;
+
+        const std::int8_t* cend() const final;
+
+        bool empty() const final;
+
+        std::size_t size() const final;
+
+        bool resizable() const final;
+    };
+
+    /*! \brief Transpose a block of genotypes
+     * \param input Pointer to the first element of the block
+     * \param nrow Number of rows in the block
+     * \param ncol Number of columns in the block
+     * \param input_stride Distance between the starts of rows of \a input
+     * \param output Destination, which must hold nrow * ncol elements
+     *
+     * Element (i, j) of the input is written to output[j * nrow + i].
+     * The transpose is done in cache-sized tiles, using SSE2 on x86-64.
+     *
+     * \ingroup variantmatrix
+     */
+    void transpose_genotypes(const std::int8_t* input, const std::size_t nrow,
+                             const std::size_t ncol,
+                             const std::size_t input_stride,
+                             std::int8_t* output);
+
+    /*! \brief Return a copy of a VariantMatrix storing haplotypes contiguously
+     * \param m A VariantMatrix
+     *
+     * The returned object uses HaplotypeMajorGenotypeCapsule for the
+     * genotypes and copies the positions.  Converting once and reusing
+     * the result is worthwhile when several haplotype-based statistics
+     * are calculated from a matrix with many sites.
+     *
+     * The result holds nsites * nsam bytes of genotypes.  The first
+     * access that needs the site-major layout (data(), begin(),
+     * get_ConstGenotypeSpan, AlleleCountMatrix, and other per-site
+     * statistics) adds a site-major copy, which is kept for the
+     * lifetime of the result.  From then on the result holds both
+     * layouts, 2 * nsites * nsam bytes, which is twice the memory of
+     * \a m.
+     *
+     * \ingroup variantmatrix
+     */
+    VariantMatrix make_haplotype_major(const VariantMatrix& m);
+} // namespace Sequence
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef MMAP_CAPSULES_HPP
+#define MMAP_CAPSULES_HPP
+
+#include "VariantMatrixCapsule.hpp"
+#include <memory>
+#include <string>
+
+namespace Sequence
+{
+    namespace internal
+    {
+        /// A read-only memory mapping of a file.
+        /// Defined in the implementation.
+        struct mapped_file;
+    } // namespace internal
+
+    class MmapGenotypeCapsule : public GenotypeCapsule
+    /// \brief Read-only genotype data stored in a memory-mapped file.
+    ///
+    /// Objects are created by Sequence::from_mmap_format.  The
+    /// mapping is shared by all clones and released when
+    /// the last of them is destroyed.
+    ///
+    /// Non-const access throws std::runtime_error.
+    ///
+    /// \ingroup variantmatrix
+    {
+      private:
+        std::shared_ptr<const internal::mapped_file> file;
+        const std::int8_t* buffer;
+        std::size_t nsites_, nsam_;
+
+      public:
+        MmapGenotypeCapsule(std::shared_ptr<const internal::mapped_file> f,
+                            const std::int8_t* data, std::size_t nrow,
+                            std::size_t ncol);
+
+        std::size_t& nsites();
+
+        std::size_t& nsam();
+
+        std::size_t nsites() const;
+
+        std::size_t nsam() const;
+
+        std::size_t row_offset() const final;
+
+        std::size_t col_offset() const final;
+
+        std::size_t stride() const final;
+
+        std::int8_t& operator()(std::size_t, std::size_t);
+
+        const std::int8_t& operator()(std::size_t, std::size_t) const;
+
+        std::int8_t* data() final;
+
+        const std::int8_t* data() const final;
+
+        const std::int8_t* cdata() const final;
+
+        std::unique_ptr<GenotypeCapsule> clone() const final;
+
+        std::int8_t* begin() final;
+
+        const std::int8_t* begin() const final;
+
+        std::int8_t* end() final;
+
+        const std::int8_t* end() const final;
+
+        const std::int8_t* cbegin() const final;
+
+        const std::int8_t* cend() const final;
+
+        bool empty() const final;
+
+        std::size_t size() const final;
+
+        bool resizable() const final;
+    };
+
+    class MmapPositionCapsule : public PositionCapsule
+    /// \brief Read-only positions stored in a memory-mapped file.
+    ///
+    /// See MmapGenotypeCapsule.
+    ///
+    /// \ingroup variantmatrix
+    {
+      private:
+        std::shared_ptr<const internal::mapped_file> file;
+        const double* buffer;
+        std::size_t current_size;
+
+      public:
+        MmapPositionCapsule(std::shared_ptr<const internal::mapped_file> f,
+                            const double* data, const std::size_t nsites);
+
+        double& operator[](std::size_t);
+
+        const double& operator[](std::size_t) const;
+
+        double* data() final;
+
+        const double* data() const final;
+
+        const double* cdata() const final;
+
+        std::unique_ptr<PositionCapsule> clone() const final;
+
+        double* begin() final;
+
+        const double* begin() const final;
+
+        double* end() final;
+
+        const double* end() const final;
+
+        const double* cbegin() const final;
+
+        const double* cend() const final;
+
+        bool empty() const final;
+
+        std::size_t size() const final;
+
+        std::size_t nsites() const;
+
+        bool resizable() const final;
+    };
+} // namespace Sequence
+
+#endif
@@ -26,7 +26,8 @@ long with libsequence.  If not, see <http://www.gnu.org/licenses/>.
 #include <string>
 #include <Sequence/SeqEnums.hpp>
 /*! \file Translate.hpp
-  @brief declares Sequence::Translate,a function to translate CDS sequences into peptide sequences
+  @brief declares Sequence::Translate,a function to translate CDS sequences into peptide sequences,
+  and Sequence::TranslateCodon and Sequence::CodonIndex, for single codons
 */
 
 /*!
@@ -50,5 +51,15 @@ namespace Sequence
 			  std::string::const_iterator end,
 			  Sequence::GeneticCodes  genetic_code = GeneticCodes::UNIVERSAL,
 			  const char & gapchar = '-');
+
+    char * Translate(const char * beg, const char * end, char * out,
+		     Sequence::GeneticCodes genetic_code = GeneticCodes::UNIVERSAL,
+		     const char & gapchar = '-');
+
+    char TranslateCodon(const char * codon,
+			Sequence::GeneticCodes genetic_code = GeneticCodes::UNIVERSAL,
+			const char & gapchar = '-');
+
+    int CodonIndex(const char * codon);
 }
 #endif
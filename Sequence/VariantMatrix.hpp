@@ -135,6 +135,8 @@ namespace Sequence
 
         /// \brief Get data from marker `site` and haplotype `haplotype`.
         /// No range-checking is done.
+        /// Each call goes through the genotype capsule.  Loops over
+        /// many elements should use Sequence::GenotypeSpan instead.
         std::int8_t& get(const std::size_t site, const std::size_t haplotype);
         /// \brief Get data from marker `site` and haplotype `haplotype`.
         /// No range-checking is done.
@@ -182,6 +184,12 @@ namespace Sequence
         std::size_t genotype_row_offset() const;
         std::size_t genotype_col_offset() const;
         std::size_t genotype_stride() const;
+        /// \brief Const access to the genotype storage.
+        ///
+        /// Allows algorithms to detect, via dynamic_cast,
+        /// storage types for which specialized implementations
+        /// exist, e.g. BitPackedGenotypeCapsule.
+        const GenotypeCapsule* genotype_capsule() const;
     };
 
     void swap(VariantMatrix& a, VariantMatrix& b);
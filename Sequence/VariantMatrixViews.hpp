@@ -18,6 +18,19 @@ namespace Sequence
     /// \brief Const view of a VariantMatrix column ("haplotype")
     /// \ingroup variantmatrix
     using ConstColView = internal::col_view_<const std::int8_t*>;
+    /// \brief Direct access to the genotypes of a VariantMatrix
+    ///
+    /// The genotype of sample j at site i is data[i * stride + j].
+    /// Obtaining a span calls the genotype capsule once, after which
+    /// element access, and the row and column views it returns, are
+    /// inline and involve no virtual function calls.  A span is
+    /// invalidated by anything that invalidates the matrix's data(),
+    /// such as filtering.
+    /// \ingroup variantmatrix
+    using GenotypeSpan = internal::genotype_span_<std::int8_t*>;
+    /// \brief Const direct access to the genotypes of a VariantMatrix
+    /// \ingroup variantmatrix
+    using ConstGenotypeSpan = internal::genotype_span_<const std::int8_t*>;
 
     // Rather than have member functions, we will have standalone functions:
 
@@ -64,6 +77,14 @@ namespace Sequence
     /// \ingroup variantmatrix
     ConstColView get_ConstColView(const VariantMatrix& m,
                                   const std::size_t col);
+
+    /// \brief Return a GenotypeSpan of VariantMatrix `m`.
+    /// \ingroup variantmatrix
+    GenotypeSpan get_GenotypeSpan(VariantMatrix& m);
+
+    /// \brief Return a ConstGenotypeSpan of VariantMatrix `m`.
+    /// \ingroup variantmatrix
+    ConstGenotypeSpan get_ConstGenotypeSpan(const VariantMatrix& m);
 }
 
 #endif
@@ -148,6 +148,8 @@ namespace Sequence
     \param nperms The number of permutations to do for the test
     \return A pair of doubles (std::pair<double,double>).  the first member of the pair is
     the observed value of the statistic, and the second member is the estimated p-value
+    \note Sequence::snn_test, which takes a VariantMatrix, does the permutations much
+    faster, may use several threads, and can stop early once the p-value is resolved.
     \ingroup popgenanalysis
   */
   {
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 #include <type_traits>
@@ -25,10 +26,19 @@ namespace Sequence
 
             /// Number of elements in row.
             std::size_t row_size;
+            /// Keeps data alive when it was gathered for this view,
+            /// rather than pointing into a matrix.  Usually empty.
+            std::shared_ptr<const void> owner;
 
             row_view_(T data_, std::size_t row_size_)
                 /// Constructor
-                : data(data_), row_size(row_size_)
+                : data(data_), row_size(row_size_), owner()
+            {
+            }
+            row_view_(T data_, std::size_t row_size_,
+                      std::shared_ptr<const void> owner_)
+                /// Constructor for a view that shares ownership of data
+                : data(data_), row_size(row_size_), owner(std::move(owner_))
             {
             }
             inline value_type& operator[](const std::size_t i)
@@ -188,10 +198,20 @@ namespace Sequence
             std::size_t col_end;
             /// Stride of the data in the column
             std::size_t stride;
+            /// Keeps data alive when it was gathered for this view,
+            /// rather than pointing into a matrix.  Usually empty.
+            std::shared_ptr<const void> owner;
 
             col_view_(T data_, std::size_t col_end_, std::size_t stride_)
                 /// Constructor
-                : data(data_), col_end(col_end_), stride(stride_)
+                : data(data_), col_end(col_end_), stride(stride_), owner()
+            {
+            }
+            col_view_(T data_, std::size_t col_end_, std::size_t stride_,
+                      std::shared_ptr<const void> owner_)
+                /// Constructor for a view that shares ownership of data
+                : data(data_), col_end(col_end_), stride(stride_),
+                  owner(std::move(owner_))
             {
             }
             inline value_type& operator[](const std::size_t i)
@@ -348,6 +368,95 @@ namespace Sequence
                     }
             }
         };
+
+        template <typename T> struct genotype_span_
+        /// \brief Implementation details for Sequence::GenotypeSpan and
+        /// Sequence::ConstGenotypeSpan
+        /// \ingroup variantmatrix
+        {
+            static_assert(std::is_pointer<T>::value, "T must be pointer type");
+            /// Pointer to the genotype of the first sample at the first site
+            T data;
+            /// data type
+            using value_type = typename std::remove_pointer<T>::type;
+            /// Number of sites
+            std::size_t nsites;
+            /// Number of samples
+            std::size_t nsam;
+            /// Distance between the starts of adjacent sites.
+            /// Not used when row_starts is set.
+            std::size_t stride;
+            /// If not null, row_starts[site] is the distance from
+            /// data to the first genotype of site, for sites that are
+            /// not evenly spaced.
+            const std::size_t* row_starts;
+            /// Keeps data and row_starts alive when they were made
+            /// for this span, rather than pointing into a matrix.
+            /// Usually empty.
+            std::shared_ptr<const void> owner;
+
+            genotype_span_(T data_, std::size_t nsites_, std::size_t nsam_,
+                           std::size_t stride_)
+                /// Constructor
+                : data(data_), nsites(nsites_), nsam(nsam_), stride(stride_),
+                  row_starts(nullptr), owner()
+            {
+            }
+            genotype_span_(T data_, std::size_t nsites_, std::size_t nsam_,
+                           std::size_t stride_, const std::size_t* row_starts_,
+                           std::shared_ptr<const void> owner_)
+                /// Constructor for a span whose sites are not evenly
+                /// spaced, or that shares ownership of its data.
+                /// \a row_starts_ may be null.
+                : data(data_), nsites(nsites_), nsam(nsam_), stride(stride_),
+                  row_starts(row_starts_), owner(std::move(owner_))
+            {
+            }
+            inline std::size_t
+            row_start(const std::size_t site) const
+            /// Distance from data to the first genotype of a site
+            {
+                return row_starts ? row_starts[site] : site * stride;
+            }
+            inline value_type&
+            operator()(const std::size_t site, const std::size_t sample)
+            /// Element access without range checking
+            {
+                return data[row_start(site) + sample];
+            }
+            inline const value_type&
+            operator()(const std::size_t site, const std::size_t sample) const
+            /// Element access without range checking
+            {
+                return data[row_start(site) + sample];
+            }
+            inline row_view_<T>
+            row(const std::size_t site) const
+            /// View of a site, without range checking
+            {
+                return row_view_<T>(data + row_start(site), nsam, owner);
+            }
+            inline col_view_<T>
+            col(const std::size_t sample) const
+            /// View of a sample, without range checking.  If the
+            /// sites are not evenly spaced, the sample's genotypes
+            /// are copied into storage owned by the view.
+            {
+                if (row_starts == nullptr)
+                    {
+                        return col_view_<T>(data + sample, stride * nsites,
+                                            stride, owner);
+                    }
+                auto gathered = std::make_shared<
+                    std::vector<typename std::remove_const<value_type>::type>>(
+                    nsites);
+                for (std::size_t site = 0; site < nsites; ++site)
+                    {
+                        (*gathered)[site] = data[row_starts[site] + sample];
+                    }
+                return col_view_<T>(gathered->data(), nsites, 1, gathered);
+            }
+        };
     } // namespace internal
 } // namespace Sequence
 
@@ -19,5 +19,9 @@
 #include "summstats/ld.hpp"
 #include "summstats/lhaf.hpp"
 #include "summstats/garud.hpp"
+#include "summstats/snn.hpp"
+#include "summstats/fst.hpp"
+#include "summstats/statistic_plan.hpp"
+#include "summstats/sfs.hpp"
 
 #endif
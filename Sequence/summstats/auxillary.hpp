@@ -10,6 +10,17 @@ namespace Sequence
         double a_sub_n(const std::uint32_t);
         double b_sub_n(const std::uint32_t nsam);
         double b_sub_n_plus1(const std::uint32_t nsam);
+        /// Tajima's D from the sum of per-site diversity, \a pi, and the
+        /// number of mutations, \a S, where \a nsam is the sample size.
+        /// \a S need not be an integer, as for a projected site
+        /// frequency spectrum.  Returns nan if \a S is zero.
+        double tajd(const double pi, const double S,
+                    const std::uint32_t nsam);
+        /// H' from the number of segregating sites, \a S, and the
+        /// estimators \a tp (thetapi) and \a tl (thetal), where
+        /// \a nsam is the sample size.  Returns nan if \a tp is zero.
+        double hprime(const std::uint32_t nsam, const unsigned S,
+                      const double tp, const double tl);
     } // namespace summstats_aux
 } // namespace Sequence
 
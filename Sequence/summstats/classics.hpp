@@ -148,7 +148,14 @@ namespace Sequence
      * "bad" input means that some of the samples consist entirely of 
      * missing data.  In that case, they are given the label of -1.
      *
-     * This function is implemented via a call to difference_matrix.
+     * Samples without missing data are grouped by hashing,
+     * taking time linear in \a nsam.  Samples with missing data
+     * are the same as any sample from which they only differ at
+     * missing sites, and are compared to each group of identical
+     * samples and to one another.  Because that relationship is not
+     * transitive, labels are assigned greedily in order of sample
+     * index: a sample that has not yet been labelled gives its label
+     * to all later samples that are the same as it.
      *
      * Included via Sequence/summstats.hpp or 
      * Sequence/summstats/classics.hpp
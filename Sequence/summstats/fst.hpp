@@ -0,0 +1,129 @@
+#ifndef SEQUENCE_SUMMSTATS_FST_HPP__
+#define SEQUENCE_SUMMSTATS_FST_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+
+namespace Sequence
+{
+    struct PopulationDifferentiation
+    /// \brief Diversity and differentiation for a pair of populations
+    ///
+    /// Diversities are summed over sites.  Each site contributes
+    /// using the samples that are not missing in each population.
+    /// The two populations are weighted equally, as in the
+    /// deprecated Sequence::FST with two populations.
+    /// \ingroup popgenanalysis
+    {
+        /// The populations, with pop1 < pop2
+        std::size_t pop1, pop2;
+        /// Mean pairwise differences within each population
+        double pi1, pi2;
+        /// Mean within-population diversity, \f$(\pi_1+\pi_2)/2\f$
+        double piS;
+        /// Mean pairwise differences between the populations
+        double piB;
+        /// Total diversity, \f$\pi_S/2 + \pi_B/2\f$
+        double piT;
+        /// \f$\pi_B - \pi_S\f$
+        double piD;
+        /// \f$F_{ST} = \pi_D/(\pi_S+\pi_D) = 1 - \pi_S/\pi_B\f$,
+        /// as defined by Hudson, Slatkin and Maddison (1992)
+        double hsm;
+        /// \f$F_{ST} = \pi_D/(2\pi_S+\pi_D)\f$, as defined by Slatkin
+        /// (1993)
+        double slatkin;
+        /// \f$F_{ST} = 1 - \pi_S/\pi_T\f$, as defined by Hudson, Boos
+        /// and Kaplan (1992)
+        double hbk;
+        /// Sites polymorphic in both populations that share a state
+        std::uint32_t shared;
+        /// Sites at which the populations have no state in common
+        std::uint32_t fixed;
+        /// Sites polymorphic in pop1 (pop2) with a state not seen in
+        /// pop2 (pop1)
+        std::uint32_t private1, private2;
+    };
+
+    /*! \brief Diversity and differentiation between all pairs of
+     * populations
+     * \param m A VariantMatrix
+     * \param populations The population of each sample, numbered from
+     * zero.  Samples with negative labels are not used.
+     *
+     * \return One element per pair of populations, ordered by pop1 and
+     * then pop2.  The number of populations is one more than the largest
+     * label.
+     *
+     * The allele counts of each population are found, and all pairs
+     * are updated, in one pass over the sites.
+     *
+     * \exception std::invalid_argument if \a populations does not have
+     * one element per sample.
+     *
+     * \ingroup popgenanalysis
+     */
+    std::vector<PopulationDifferentiation>
+    differentiation(const VariantMatrix& m,
+                    const std::vector<std::int32_t>& populations);
+
+    /*! \brief Diversity and differentiation between all pairs of
+     * populations
+     * \param populations The allele counts of each population, at the
+     * same sites.
+     *
+     * \return As for the overload taking a VariantMatrix.
+     *
+     * \exception std::invalid_argument if the matrices do not have the
+     * same number of rows.
+     *
+     * \ingroup popgenanalysis
+     */
+    std::vector<PopulationDifferentiation>
+    differentiation(const std::vector<AlleleCountMatrix>& populations);
+
+    struct WindowDifferentiation
+    /// \brief Differentiation between all pairs of populations in
+    /// one window
+    /// \ingroup popgenanalysis
+    {
+        /// The window interval, [beg,end]
+        double beg, end;
+        /// Index of the first site in the window and the number of sites
+        std::size_t first_site, nsites;
+        /// One element per pair of populations, as for differentiation
+        std::vector<PopulationDifferentiation> pairs;
+    };
+
+    /*! \brief Diversity and differentiation between all pairs of
+     * populations in sliding windows
+     * \param m A VariantMatrix
+     * \param populations The population of each sample, as for
+     * differentiation
+     * \param beg Start of the first window
+     * \param end Windows start at positions < end
+     * \param window_size The length of each window
+     * \param step The distance between the starts of adjacent windows
+     *
+     * Windows are those of Sequence::windowed_statistics, and the
+     * results are those of differentiation applied to make_window.
+     * The contribution of each site is calculated once, so that
+     * overlapping windows cost no more than non-overlapping ones.
+     * Results may therefore differ from those of make_window by
+     * rounding error.
+     *
+     * \exception std::invalid_argument if \a window_size < 0, if \a step
+     * <= 0, or for the reasons given for differentiation.
+     *
+     * \ingroup popgenanalysis
+     */
+    std::vector<WindowDifferentiation>
+    windowed_differentiation(const VariantMatrix& m,
+                             const std::vector<std::int32_t>& populations,
+                             const double beg, const double end,
+                             const double window_size, const double step);
+} // namespace Sequence
+
+#endif
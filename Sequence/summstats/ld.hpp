@@ -2,6 +2,7 @@
 #define SEQUENCE_SUMMSTATS_LD_HPP__
 
 #include <cstdint>
+#include <limits>
 #include <vector>
 #include <Sequence/VariantMatrix.hpp>
 
@@ -18,6 +19,80 @@ namespace Sequence
     two_locus_haplotype_counts(const VariantMatrix& m, std::size_t sitei,
                                const std::size_t sitej,
                                const bool skip_missing);
+
+    struct TwoLocusLD
+    /// \brief Linkage disequilibrium between a pair of sites
+    /// \ingroup popgenanalysis
+    {
+        /// Indexes of the sites in the VariantMatrix, with i < j.
+        std::size_t i, j;
+        /// \f$r^2\f$, D, and D'
+        double rsq, D, Dprime;
+    };
+
+    /// Statistics that may be requested from ld_matrix
+    /// \ingroup popgenanalysis
+    enum class LDStatistic
+    {
+        rsq,
+        D,
+        Dprime
+    };
+
+    /*! \brief Linkage disequilibrium between pairs of bi-allelic sites
+     * \param m A VariantMatrix
+     * \param max_distance Only pairs of sites whose positions differ by at
+     * most this value are considered.
+     * \param min_rsq Only pairs with \f$r^2 \geq\f$ min_rsq are returned.
+     * \param nthreads The number of threads to use.
+     *
+     * \return A vector of TwoLocusLD, sorted by i and then j.
+     *
+     * Only sites with exactly two non-missing states are considered.
+     * For each pair, the statistics are calculated from the samples
+     * that are not missing at either site.  D and D' are signed with
+     * respect to the minor allele at each site, with ties in allele
+     * counts broken in favor of the smaller state.
+     * Pairs for which \f$r^2\f$ is not defined, because one site is
+     * monomorphic in the samples considered, are not returned.
+     *
+     * The default arguments return all pairs.  With large data,
+     * a finite \a max_distance gives a band of the LD matrix, and
+     * \a min_rsq > 0 gives a sparse representation of it.
+     *
+     * Haplotypes are counted using bit sets, and the sites are divided
+     * among \a nthreads threads in blocks.  The output does not depend
+     * on \a nthreads.
+     *
+     * \exception std::invalid_argument if \a max_distance < 0 or if
+     * \a nthreads is 0.
+     *
+     * \ingroup popgenanalysis
+     */
+    std::vector<TwoLocusLD>
+    pairwise_ld(const VariantMatrix& m,
+                const double max_distance
+                = std::numeric_limits<double>::infinity(),
+                const double min_rsq = 0.0, const unsigned nthreads = 1);
+
+    /*! \brief Matrix of linkage disequilibrium between all pairs of sites
+     * \param m A VariantMatrix
+     * \param statistic The statistic to return
+     * \param nthreads The number of threads to use
+     *
+     * \return A row-major m.nsites() by m.nsites() matrix.
+     *
+     * The values are calculated as for pairwise_ld.  Entries are
+     * nan if the statistic is not defined, including for all pairs
+     * involving sites that are not bi-allelic.
+     *
+     * \exception std::invalid_argument if \a nthreads is 0.
+     *
+     * \ingroup popgenanalysis
+     */
+    std::vector<double> ld_matrix(const VariantMatrix& m,
+                                  const LDStatistic statistic,
+                                  const unsigned nthreads = 1);
 } // namespace Sequence
 
 #endif
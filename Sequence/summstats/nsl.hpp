@@ -40,10 +40,43 @@ namespace Sequence
      * reduction compared to calculating the statistic
      * for each core site on its own.
      *
+     * If \a m has no missing data, suffix lengths are found from the
+     * positional Burrows-Wheeler transform \cite Durbin2014-pb of
+     * the haplotypes, which takes time proportional to m.nsam() per
+     * site, rather than to the number of pairs of haplotypes.
+     *
      * See \cite Ferrer-Admetlla2014-wa for details.
      */
     std::vector<nSLiHS> nsl(const VariantMatrix& m,
                             const std::int8_t refstate);
+
+    /*! \brief nSL and iHS statistics, using multiple threads
+     * \param m A VariantMatrix
+     * \param refstate The value of the reference/ancestral allelic state
+     * \param nthreads The number of threads to use
+     *
+     * \return vector of nSLiHS objects (one for each site)
+     * \ingroup popgenanalysis
+     *
+     * If \a m has no missing data, the two sweeps of the sorted
+     * haplotypes described for nsl(m, refstate) are run concurrently,
+     * so at most two threads are used whatever the value of
+     * \a nthreads, and memory use is proportional to m.nsam() plus
+     * the number of sites.
+     *
+     * Otherwise, core sites are divided into \a nthreads contiguous
+     * blocks, each processed by its own thread.  Each thread keeps its
+     * own suffix lengths for all pairs of haplotypes, meaning that
+     * memory use on this path scales with \a nthreads * m.nsam()^2.
+     *
+     * The return value is identical to that of nsl(m, refstate) for
+     * any number of threads.
+     *
+     * std::invalid_argument is thrown if \a nthreads is 0.
+     */
+    std::vector<nSLiHS> nsl_parallel(const VariantMatrix& m,
+                                     const std::int8_t refstate,
+                                     const unsigned nthreads);
 } // namespace Sequence
 
 #endif
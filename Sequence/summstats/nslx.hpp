@@ -23,9 +23,27 @@ namespace Sequence
      *
      * When \x is 1, this statistic is a proxy for the 
      * SDS score of \cite Field2016-so.
+     *
+     * As with nsl, data without missing genotypes are
+     * processed via the positional Burrows-Wheeler transform.
      */
     std::vector<nSLiHS> nslx(const VariantMatrix& m,
                              const std::int8_t refstate, const int x);
+
+    /*! \brief nslx, using multiple threads
+     * \param m A VariantMatrix
+     * \param refstate The ancestral state
+     * \param x Non-reference allele count
+     * \param nthreads The number of threads to use
+     *
+     * \return vector of nSLiHS, identical to that of nslx(m, refstate, x)
+     * for any number of threads.
+     *
+     * See nsl_parallel for details.
+     */
+    std::vector<nSLiHS> nslx_parallel(const VariantMatrix& m,
+                                      const std::int8_t refstate,
+                                      const int x, const unsigned nthreads);
 } // namespace Sequence
 
 #endif
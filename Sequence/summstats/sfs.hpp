@@ -0,0 +1,226 @@
+/// \file Sequence/summstats/sfs.hpp
+/// \brief Site frequency spectra and estimators calculated from them
+#ifndef SEQUENCE_SUMMSTATS_SFS_HPP__
+#define SEQUENCE_SUMMSTATS_SFS_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+
+namespace Sequence
+{
+    struct SiteFrequencySpectrum
+    /// \brief The site frequency spectrum of a sample
+    ///
+    /// counts[i] is the number of derived states, or minor states
+    /// when folded, seen i times in a sample of size nsam.  An
+    /// unfolded spectrum has nsam + 1 elements and a folded one
+    /// has nsam/2 + 1.  Counts are not integers when sites are
+    /// projected to a smaller sample size.
+    /// \ingroup popgenanalysis
+    {
+        std::uint32_t nsam;
+        bool folded;
+        std::vector<double> counts;
+    };
+
+    struct JointSiteFrequencySpectrum
+    /// \brief The joint site frequency spectrum of several populations
+    ///
+    /// counts is an array with nsam[p] + 1 elements along the
+    /// dimension of population p, stored with the last population
+    /// varying fastest.  The element for i[0], i[1], ..., copies of
+    /// a state in each population is therefore at
+    /// \f$\sum_p i_p\prod_{q>p}(n_q+1)\f$.  A folded spectrum has the
+    /// same layout, with the elements for states seen more than half
+    /// of the time in the whole sample set to zero.
+    /// \ingroup popgenanalysis
+    {
+        std::vector<std::uint32_t> nsam;
+        bool folded;
+        std::vector<double> counts;
+    };
+
+    /*! \brief The unfolded site frequency spectrum
+     * \param ac An AlleleCountMatrix
+     * \param refstate The ancestral state
+     * \param nsam The sample size of the spectrum.  The default, 0,
+     * means ac.nsam.
+     *
+     * Each state other than \a refstate that is seen at a site
+     * contributes to the spectrum separately.  Sites with no such
+     * state contribute to counts[0].
+     *
+     * Sites with more than \a nsam non-missing samples are projected
+     * to \a nsam by hypergeometric sampling \cite Marth2004-ps, and
+     * sites with fewer are not used.  Projection does not change the
+     * expected value of thetapi.
+     *
+     * \exception std::invalid_argument if \a nsam > ac.nsam or if
+     * \a refstate is not a valid state.
+     *
+     * \ingroup popgenanalysis
+     */
+    SiteFrequencySpectrum unfolded_sfs(const AlleleCountMatrix& ac,
+                                       const std::int8_t refstate,
+                                       const std::uint32_t nsam = 0);
+
+    /*! \brief The unfolded site frequency spectrum
+     * \param ac An AlleleCountMatrix
+     * \param refstates The ancestral state of each site.  Sites with
+     * negative values are not used.
+     * \param nsam The sample size of the spectrum.  The default, 0,
+     * means ac.nsam.
+     *
+     * \exception std::invalid_argument if \a refstates does not have
+     * one element per site, or for the reasons given for the overload
+     * taking a single reference state.
+     *
+     * \ingroup popgenanalysis
+     */
+    SiteFrequencySpectrum
+    unfolded_sfs(const AlleleCountMatrix& ac,
+                 const std::vector<std::int8_t>& refstates,
+                 const std::uint32_t nsam = 0);
+
+    /*! \brief The folded site frequency spectrum
+     * \param ac An AlleleCountMatrix
+     * \param nsam The sample size of the spectrum.  The default, 0,
+     * means ac.nsam.
+     *
+     * Each site is polarized by its most common state, projected as
+     * for unfolded_sfs, and the result is folded.
+     *
+     * \exception std::invalid_argument if \a nsam > ac.nsam
+     *
+     * \ingroup popgenanalysis
+     */
+    SiteFrequencySpectrum folded_sfs(const AlleleCountMatrix& ac,
+                                     const std::uint32_t nsam = 0);
+
+    /// \brief Fold an unfolded spectrum.  A folded spectrum is returned
+    /// unchanged.
+    /// \ingroup popgenanalysis
+    SiteFrequencySpectrum fold(const SiteFrequencySpectrum& sfs);
+
+    /*! \brief The unfolded joint site frequency spectrum
+     * \param m A VariantMatrix
+     * \param populations The population of each sample, numbered from
+     * zero.  Samples with negative labels are not used.
+     * \param refstate The ancestral state
+     * \param nsam The sample size of each population in the spectrum.
+     * If empty, the number of samples in each population is used.
+     *
+     * States are counted, and sites projected, as for unfolded_sfs.
+     * A site is used if every population has at least \a nsam
+     * non-missing samples.  If all data are missing, every count is
+     * zero and \a refstate is not checked.
+     *
+     * \exception std::invalid_argument if \a populations does not have
+     * one element per sample, if \a nsam is not empty and does not
+     * have one element per population, if a population has fewer than
+     * \a nsam samples, or if \a refstate is not a valid state.
+     *
+     * \ingroup popgenanalysis
+     */
+    JointSiteFrequencySpectrum
+    joint_sfs(const VariantMatrix& m,
+              const std::vector<std::int32_t>& populations,
+              const std::int8_t refstate,
+              const std::vector<std::uint32_t>& nsam = {});
+
+    /*! \brief The unfolded joint site frequency spectrum
+     * \param m A VariantMatrix
+     * \param populations The population of each sample
+     * \param refstates The ancestral state of each site.  Sites with
+     * negative values are not used.
+     * \param nsam The sample size of each population in the spectrum
+     *
+     * \exception std::invalid_argument if \a refstates does not have
+     * one element per site, or for the reasons given for the overload
+     * taking a single reference state.
+     *
+     * \ingroup popgenanalysis
+     */
+    JointSiteFrequencySpectrum
+    joint_sfs(const VariantMatrix& m,
+              const std::vector<std::int32_t>& populations,
+              const std::vector<std::int8_t>& refstates,
+              const std::vector<std::uint32_t>& nsam = {});
+
+    /*! \brief The folded joint site frequency spectrum
+     * \param m A VariantMatrix
+     * \param populations The population of each sample
+     * \param nsam The sample size of each population in the spectrum
+     *
+     * Each site is polarized by its most common state in the whole
+     * sample, projected as for joint_sfs, and the result is folded.
+     *
+     * \ingroup popgenanalysis
+     */
+    JointSiteFrequencySpectrum
+    folded_joint_sfs(const VariantMatrix& m,
+                     const std::vector<std::int32_t>& populations,
+                     const std::vector<std::uint32_t>& nsam = {});
+
+    /// \brief Fold an unfolded joint spectrum.  A folded spectrum is
+    /// returned unchanged.
+    /// \ingroup popgenanalysis
+    JointSiteFrequencySpectrum fold(const JointSiteFrequencySpectrum& sfs);
+
+    /*! \brief \f$\hat\theta_\pi\f$ from a site frequency spectrum
+     *
+     * The spectrum may be folded.  Without missing data, and when
+     * every site has at most two states, the result is that of thetapi
+     * applied to the AlleleCountMatrix, up to rounding.  A site with
+     * three or more states adds each non-reference state to the
+     * spectrum separately, so the differences between two of those
+     * states are counted twice, and the result is larger than that of
+     * thetapi(const AlleleCountMatrix&).  The estimators below are
+     * calculated in the same way, in time proportional to the sample
+     * size.
+     * \ingroup popgenanalysis
+     */
+    double thetapi(const SiteFrequencySpectrum& sfs);
+
+    /// \brief Watterson's \f$\hat\theta_w\f$ from a site frequency spectrum,
+    /// which may be folded.
+    /// \ingroup popgenanalysis
+    double thetaw(const SiteFrequencySpectrum& sfs);
+
+    /// \brief Tajima's D from a site frequency spectrum, which may be
+    /// folded.  Returns nan if there are no segregating sites.
+    /// \ingroup popgenanalysis
+    double tajd(const SiteFrequencySpectrum& sfs);
+
+    /// \brief Fay and Wu's \f$\hat\theta_H\f$ from an unfolded site
+    /// frequency spectrum
+    /// \exception std::invalid_argument if \a sfs is folded
+    /// \ingroup popgenanalysis
+    double thetah(const SiteFrequencySpectrum& sfs);
+
+    /// \brief \f$\hat\theta_L\f$ from an unfolded site frequency spectrum
+    /// \exception std::invalid_argument if \a sfs is folded
+    /// \ingroup popgenanalysis
+    double thetal(const SiteFrequencySpectrum& sfs);
+
+    /// \brief Fay and Wu's H from an unfolded site frequency spectrum.
+    /// Returns nan if there are no segregating sites.
+    /// \exception std::invalid_argument if \a sfs is folded
+    /// \ingroup popgenanalysis
+    double faywuh(const SiteFrequencySpectrum& sfs);
+
+    /*! \brief Zeng's E from an unfolded site frequency spectrum
+     *
+     * The difference \f$\hat\theta_L - \hat\theta_w\f$, normalized by
+     * its variance as in \cite Zeng2006-is.  Returns nan if there are
+     * no segregating sites.
+     *
+     * \exception std::invalid_argument if \a sfs is folded
+     * \ingroup popgenanalysis
+     */
+    double zenge(const SiteFrequencySpectrum& sfs);
+} // namespace Sequence
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef SEQUENCE_SUMMSTATS_SNN_HPP__
+#define SEQUENCE_SUMMSTATS_SNN_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+
+namespace Sequence
+{
+    struct SnnTestResult
+    /// \brief Result of a permutation test of Hudson's Snn
+    /// \ingroup popgenanalysis
+    {
+        /// The observed value of Snn
+        double snn;
+        /// The fraction of permutations giving Snn at least as large as
+        /// the observed value.  nan if no permutations were done.
+        double pvalue;
+        /// The number of permutations done
+        std::uint32_t nperms;
+        /// The number of permutations giving Snn at least as large as
+        /// the observed value
+        std::uint32_t nextreme;
+    };
+
+    struct SnnPairwiseTestResult : public SnnTestResult
+    /// \brief Result of a permutation test of Snn between two populations
+    /// \ingroup popgenanalysis
+    {
+        /// The labels of the two populations, with pop1 < pop2
+        std::int32_t pop1, pop2;
+    };
+
+    /*! \brief Hudson's (2000) sequence nearest-neighbor statistic
+     * \param m A VariantMatrix
+     * \param populations The population of each sample.  Samples
+     * with negative labels are not used.
+     *
+     * For each sample, the nearest neighbors are the other samples
+     * with the fewest differences from it, counted as for
+     * difference_matrix.  Snn is the mean, over samples, of the
+     * fraction of nearest neighbors that are in the same population.
+     * See \cite Hudson2000-ev.
+     *
+     * \exception std::invalid_argument if \a populations does not
+     * have one element per sample or if fewer than two samples are used.
+     *
+     * \ingroup popgenanalysis
+     */
+    double snn(const VariantMatrix& m,
+               const std::vector<std::int32_t>& populations);
+
+    /*! \brief Permutation test of Hudson's Snn
+     * \param m A VariantMatrix
+     * \param populations The population of each sample, as for snn
+     * \param nperms The maximum number of permutations
+     * \param seed The seed for the random number generators
+     * \param nthreads The number of threads to use
+     * \param stop_after If greater than zero, stop once this many
+     * permutations give Snn at least as large as the observed value.
+     *
+     * The differences between samples are counted once, and the
+     * nearest neighbors of each sample are stored in a flat array, so
+     * that each permutation of the population labels takes time
+     * proportional to the number of nearest neighbors rather than to
+     * the square of the sample size.
+     *
+     * Permutations are done in batches, each shuffled by a random
+     * number generator seeded from \a seed and the index of the batch,
+     * and the batches are divided among \a nthreads threads.  The
+     * output therefore depends on \a seed, but not on \a nthreads.
+     *
+     * With \a stop_after = h > 0, the test stops at the permutation
+     * giving the h-th extreme value, and the p-value is h divided by
+     * the number of permutations done (\cite Besag1991-sq).  The
+     * relative standard error of the p-value is then about
+     * \f$1/\sqrt{h}\f$, and large p-values are resolved after few
+     * permutations.  Otherwise, \a nperms permutations are done.
+     *
+     * \exception std::invalid_argument for the reasons given for snn
+     * or if \a nthreads is 0.
+     *
+     * \ingroup popgenanalysis
+     */
+    SnnTestResult snn_test(const VariantMatrix& m,
+                           const std::vector<std::int32_t>& populations,
+                           const std::uint32_t nperms,
+                           const std::uint64_t seed,
+                           const unsigned nthreads = 1,
+                           const std::uint32_t stop_after = 0);
+
+    /*! \brief Permutation tests of Snn between all pairs of populations
+     * \param m A VariantMatrix
+     * \param populations The population of each sample, as for snn
+     * \param nperms The maximum number of permutations for each pair
+     * \param seed The seed for the random number generators
+     * \param nthreads The number of threads to use
+     * \param stop_after As for snn_test
+     *
+     * \return One result per pair of populations, ordered by pop1
+     * and then pop2.  Each test uses the samples of the two populations,
+     * and permutes labels among them.  The differences between samples
+     * are counted once for all pairs.
+     *
+     * \exception std::invalid_argument for the reasons given for
+     * snn_test.
+     *
+     * \ingroup popgenanalysis
+     */
+    std::vector<SnnPairwiseTestResult>
+    snn_test_pairwise(const VariantMatrix& m,
+                      const std::vector<std::int32_t>& populations,
+                      const std::uint32_t nperms, const std::uint64_t seed,
+                      const unsigned nthreads = 1,
+                      const std::uint32_t stop_after = 0);
+} // namespace Sequence
+
+#endif
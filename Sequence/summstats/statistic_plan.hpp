@@ -0,0 +1,105 @@
+/// \file Sequence/summstats/statistic_plan.hpp
+/// \brief Several summary statistics from one pass over an
+/// AlleleCountMatrix
+#ifndef SEQUENCE_SUMMSTATS_STATISTIC_PLAN_HPP__
+#define SEQUENCE_SUMMSTATS_STATISTIC_PLAN_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <Sequence/AlleleCountMatrix.hpp>
+
+namespace Sequence
+{
+    struct SummaryStatistic
+    /// \brief Flags requesting statistics from a
+    /// Sequence::SummaryStatisticPlan
+    ///
+    /// Flags are combined with bitwise or.
+    /// \ingroup popgenanalysis
+    {
+        enum : unsigned
+        {
+            thetapi = 1u,
+            thetaw = 1u << 1,
+            tajd = 1u << 2,
+            thetah = 1u << 3,
+            thetal = 1u << 4,
+            faywuh = 1u << 5,
+            hprime = 1u << 6,
+            nvariable_sites = 1u << 7,
+            nbiallelic_sites = 1u << 8,
+            total_number_of_mutations = 1u << 9,
+            all = (1u << 10) - 1
+        };
+    };
+
+    struct SummaryStatistics
+    /// \brief The results of a Sequence::SummaryStatisticPlan
+    ///
+    /// Statistics that were not requested are nan, or zero for
+    /// the counts of sites.
+    /// \ingroup popgenanalysis
+    {
+        double thetapi, thetaw, tajd, thetah, thetal, faywuh, hprime;
+        std::uint32_t nvariable_sites, nbiallelic_sites,
+            total_number_of_mutations;
+    };
+
+    class SummaryStatisticPlan
+    /*! \brief Calculate several summary statistics in one pass
+     *
+     * The statistics to calculate are chosen once, with flags from
+     * Sequence::SummaryStatistic, and the plan is then applied to any
+     * number of AlleleCountMatrix objects:
+     *
+     * \code
+     * Sequence::SummaryStatisticPlan plan(Sequence::SummaryStatistic::tajd
+     *                                     | Sequence::SummaryStatistic::faywuh);
+     * for (auto & ac : replicates)
+     * {
+     *     auto s = plan(ac, 0);
+     *     //use s.tajd, s.faywuh
+     * }
+     * \endcode
+     *
+     * Each row of the matrix is visited once, and the terms it
+     * contributes to every requested statistic are calculated from
+     * the same allele counts.  The results, including the exceptions
+     * thrown for bad input, are those of the functions of the same
+     * names in Sequence/summstats/classics.hpp and
+     * Sequence/summstats/nvariablesites.hpp, with the same rounding.
+     *
+     * The constants depending on the sample size, such as
+     * summstats_aux::a_sub_n, are cached for each thread.
+     *
+     * \ingroup popgenanalysis
+     */
+    {
+      private:
+        unsigned statistics;
+        SummaryStatistics apply(const AlleleCountMatrix& ac,
+                                const std::int8_t* refstates,
+                                const std::size_t refstride) const;
+
+      public:
+        /// \param requested Flags from Sequence::SummaryStatistic
+        explicit SummaryStatisticPlan(const unsigned requested);
+        /// The requested statistics
+        unsigned requested() const;
+        /// Whether the plan needs ancestral states
+        bool needs_refstate() const;
+        /// \param ac An AlleleCountMatrix
+        /// \param refstate The ancestral state.  Only used by
+        /// thetah, thetal, faywuh and hprime.
+        SummaryStatistics operator()(const AlleleCountMatrix& ac,
+                                     const std::int8_t refstate = -1) const;
+        /// \param ac An AlleleCountMatrix
+        /// \param refstates The ancestral state of each site.  Only
+        /// used by thetah, thetal, faywuh and hprime.
+        SummaryStatistics
+        operator()(const AlleleCountMatrix& ac,
+                   const std::vector<std::int8_t>& refstates) const;
+    };
+} // namespace Sequence
+
+#endif
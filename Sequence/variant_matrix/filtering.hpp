@@ -5,6 +5,7 @@
 #include <Sequence/VariantMatrixViews.hpp>
 #include <functional>
 #include <cstdint>
+#include <vector>
 
 namespace Sequence
 {
@@ -21,6 +22,88 @@ namespace Sequence
     std::int32_t
     filter_haplotypes(VariantMatrix &m,
                       const std::function<bool(const ConstColView &)> &f);
+
+    /*! \brief Return a filtered view of a VariantMatrix
+     * \param m A VariantMatrix
+     * \param sites Indexes of the sites of \a m to keep
+     * \param samples Indexes of the samples of \a m to keep
+     *
+     * The result stores its genotypes in a FilteredGenotypeCapsule,
+     * which refers to the data of \a m, and a copy of the kept
+     * positions.  The data of \a m must outlive the result.  If \a m
+     * is itself a filtered view, the new view refers to the same parent
+     * data as \a m, so chains of filters cost no more than a single
+     * filter.
+     *
+     * Making the view copies no genotypes.  The view stores the
+     * kept indexes as runs (see IndexRuns), so removing a few sites
+     * or samples from a large matrix costs little memory.
+     * Statistics, row and column views, and get_ConstGenotypeSpan
+     * work on any view.  When the kept samples are a run of
+     * consecutive indexes, as they are when only sites are
+     * filtered, rows are read in place.  Otherwise, rows are
+     * gathered when they are asked for, into storage that is freed
+     * with the row view or span.  See FilteredGenotypeCapsule for
+     * details.  Raw pointer access through data() or cdata() needs
+     * both \a sites and \a samples to be runs, and otherwise throws
+     * std::runtime_error; materialize makes a compact copy.
+     *
+     * The result is read-only.  Non-const access, such as calling
+     * get() or data() on a non-const VariantMatrix, or filter_sites,
+     * throws std::runtime_error.  Use cget(), or a const reference
+     * to the view.
+     *
+     * The indexes are used in the order given.
+     * std::out_of_range is thrown if any index is out of range.
+     *
+     * \ingroup variantmatrix
+     */
+    VariantMatrix make_filtered_view(const VariantMatrix &m,
+                                     const std::vector<std::size_t> &sites,
+                                     const std::vector<std::size_t> &samples);
+
+    /*! \brief Return a view of a VariantMatrix without some sites
+     * \param m A VariantMatrix
+     * \param f A function returning true for sites to remove
+     *
+     * Unlike filter_sites, \a m is not modified and no genotypes
+     * are copied.  Unless \a m is a view without some haplotypes,
+     * row views of the result point into the rows of \a m.  See
+     * make_filtered_view for the lifetime requirements, for what is
+     * copied when the result is used, and for read-only access.
+     *
+     * \ingroup variantmatrix
+     */
+    VariantMatrix
+    filter_sites_view(const VariantMatrix &m,
+                      const std::function<bool(const ConstRowView &)> &f);
+
+    /*! \brief Return a view of a VariantMatrix without some haplotypes
+     * \param m A VariantMatrix
+     * \param f A function returning true for haplotypes to remove
+     *
+     * Unlike filter_haplotypes, \a m is not modified and no genotypes
+     * are copied.  See make_filtered_view for the lifetime
+     * requirements, for what is copied when the result is used, and
+     * for read-only access.
+     *
+     * \ingroup variantmatrix
+     */
+    VariantMatrix
+    filter_haplotypes_view(const VariantMatrix &m,
+                           const std::function<bool(const ConstColView &)> &f);
+
+    /*! \brief Return a compact copy of a VariantMatrix
+     * \param m A VariantMatrix, typically a filtered view
+     *
+     * The result owns its data, using the default capsules,
+     * and has the same max_allele as \a m.  Use it when a filtered
+     * view is read many times with its samples not in one run, or
+     * when raw pointer access is needed.
+     *
+     * \ingroup variantmatrix
+     */
+    VariantMatrix materialize(const VariantMatrix &m);
 }
 
 #endif
@@ -0,0 +1,52 @@
+#ifndef SEQUENCE_VARIANT_MATRIX_MMAP_HPP__
+#define SEQUENCE_VARIANT_MATRIX_MMAP_HPP__
+
+#include <string>
+#include <Sequence/VariantMatrix.hpp>
+
+namespace Sequence
+{
+    /*! \brief Write a VariantMatrix in a binary format suitable for
+     * memory-mapping.
+     * \param m A VariantMatrix
+     * \param filename The output file name
+     * \ingroup variantmatrix
+     *
+     * The layout of the file is:
+     *
+     * 1. The eight characters "LSEQVM01"
+     * 2. nsites, as a std::uint64_t
+     * 3. nsam, as a std::uint64_t
+     * 4. max_allele, as a std::int8_t, followed by seven bytes of padding
+     * 5. The genotypes, as nsites*nsam std::int8_t in row-major order
+     * 6. Zero to seven bytes of padding, so that the next block
+     *    starts at a multiple of eight bytes
+     * 7. The positions, as nsites double
+     *
+     * Integers and doubles are written in the native representation
+     * of the machine, meaning that files are not portable across
+     * architectures with different byte orders.
+     *
+     * std::runtime_error is thrown if the file cannot be written.
+     */
+    void to_mmap_format(const VariantMatrix& m, const std::string& filename);
+
+    /*! \brief Open a file written by to_mmap_format
+     * \param filename The input file name
+     * \return A VariantMatrix whose data are read-only
+     * \ingroup variantmatrix
+     *
+     * The file is mapped read-only into memory, meaning that opening it
+     * takes constant time and that the data are shared, via the page
+     * cache, with other processes reading the same file.  The return
+     * value uses MmapGenotypeCapsule and MmapPositionCapsule, and
+     * windows taken with make_window or make_slice refer directly
+     * to the mapped data.
+     *
+     * std::runtime_error is thrown if the file cannot be opened or
+     * mapped, or if it is not in the expected format.
+     */
+    VariantMatrix from_mmap_format(const std::string& filename);
+} // namespace Sequence
+
+#endif
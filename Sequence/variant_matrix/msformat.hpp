@@ -1,7 +1,11 @@
 #ifndef SEQUENCE_VARIANT_MATRIX_MSFORMAT_HPP__
 #define SEQUENCE_VARIANT_MATRIX_MSFORMAT_HPP__
 
+#include <cstdint>
 #include <istream>
+#include <memory>
+#include <string>
+#include <vector>
 #include <Sequence/VariantMatrix.hpp>
 #include <Sequence/VariantMatrixViews.hpp>
 
@@ -9,55 +13,91 @@ namespace Sequence
 {
     /// \example ms_to_VariantMatrix.cc
 
+    namespace internal
+    {
+        /// Read the next replicate, reusing the memory of the buffers.
+        /// Returns false if there are no more replicates.
+        bool read_msformat(std::istream& input_stream, std::string& line,
+                           std::vector<std::int8_t>& haplotypes,
+                           std::vector<std::int8_t>& genotypes,
+                           std::vector<double>& positions);
+
+        /// Write the haplotypes of m as lines of text.
+        /// Returns false if any state is not from 0 to 9.
+        bool format_haplotypes(const VariantMatrix& m, std::string& buffer);
+    } // namespace internal
+
     /*! \brief Create VariantMatrix from "ms"-like input format
-     * \param input_stream A model of std::istream
+     * \param input_stream An input stream
      * \return A VariantMatrix
      * \ingroup variantmatrix
      *
+     * Trailing whitespace, including the carriage returns of
+     * Windows line endings, is ignored on haplotype lines.
+     *
+     * Each haplotype line is read in one piece and the genotypes
+     * are transposed into the VariantMatrix in blocks.  When reading
+     * many replicates, MsFormatReader avoids allocating memory
+     * for each one.
+     *
+     * If the input has no more replicates, the return value is empty.
+     *
+     * std::runtime_error is thrown if a replicate is malformed.
+     *
      * See ms_to_VariantMatrix.cc for example.
      */
-    template <typename streamtype>
     inline VariantMatrix
-    from_msformat(streamtype& input_stream)
+    from_msformat(std::istream& input_stream)
     {
-        char ch;
-        while (!input_stream.eof())
-            {
-                input_stream >> ch;
-                if (ch == ':')
-                    break;
-            }
-        std::string temp;
-        std::size_t S;
-        input_stream >> S >> temp;
-        std::vector<double> pos(S);
-        for (std::size_t i = 0; i < S; ++i)
-            {
-                input_stream >> pos[i];
-            }
-        std::vector<std::int8_t> data;
-        char next_token;
-        while (!input_stream.eof()
-               && static_cast<char>(input_stream.peek()) != '/')
-            {
-                input_stream >> next_token >> std::ws;
-                data.push_back((next_token == '0') ? 0 : 1);
-            }
-        input_stream >> std::ws;
-        //We now have to transpose the input matrix
-        decltype(data) data_t(data.size(), -1);
-        std::size_t nsam = data.size() / static_cast<std::size_t>(S);
-        std::size_t k = 0;
-        for (std::size_t i = 0; i < static_cast<std::size_t>(S); ++i)
-            {
-                for (std::size_t j = 0; j < nsam; ++j)
-                    {
-                        data_t[k++] = data[i + j * S];
-                    }
-            }
-        return VariantMatrix(std::move(data_t), std::move(pos));
+        std::string line;
+        std::vector<std::int8_t> haplotypes, genotypes;
+        std::vector<double> positions;
+        internal::read_msformat(input_stream, line, haplotypes, genotypes,
+                                positions);
+        return VariantMatrix(std::move(genotypes), std::move(positions));
     }
 
+    class MsFormatReader
+    /*! \brief Read replicates in "ms" format one at a time
+     *
+     * The genotypes and positions of each replicate are read into
+     * buffers that are reused for the next replicate, meaning that
+     * memory is only allocated when a replicate is larger than all
+     * previous replicates.
+     *
+     * \code
+     * Sequence::MsFormatReader reader(std::cin);
+     * while (reader.next())
+     *     {
+     *         auto& m = reader.replicate();
+     *     }
+     * \endcode
+     *
+     * \ingroup variantmatrix
+     */
+    {
+      private:
+        std::istream& input;
+        std::string line;
+        std::vector<std::int8_t> haplotypes, genotypes;
+        std::vector<double> positions;
+        std::unique_ptr<VariantMatrix> current;
+
+      public:
+        /// \param input_stream The input, which must
+        /// remain valid while this object is used.
+        explicit MsFormatReader(std::istream& input_stream);
+        /// Read the next replicate.  Returns false if there
+        /// are no more replicates.  std::runtime_error is thrown
+        /// if the replicate is malformed.
+        bool next();
+        /// The last replicate read by next(), whose data are
+        /// read-only and are only valid until next() is called
+        /// again.  std::runtime_error is thrown if there is no
+        /// such replicate.
+        const VariantMatrix& replicate() const;
+    };
+
     template <typename output_stream>
     inline void
     to_msformat(const VariantMatrix& m, output_stream& o)
@@ -66,6 +106,9 @@ namespace Sequence
      * \param o A model of std::ostream
      * \ingroup variantmatrix
      *
+     * If all states are from 0 to 9, the haplotypes are formatted
+     * into one buffer and written at once.
+     *
      * See ms_to_VariantMatrix.cc for example.
      */
     {
@@ -75,6 +118,12 @@ namespace Sequence
             o << *p << ' ';
         }
         o << '\n';
+        std::string buffer;
+        if (internal::format_haplotypes(m, buffer))
+            {
+                o << buffer;
+                return;
+            }
         for (std::size_t i = 0; i < m.nsam(); ++i)
             {
                 auto col = get_ConstColView(m, i);
@@ -0,0 +1,119 @@
+#ifndef SEQUENCE_VARIANT_MATRIX_VCF_HPP__
+#define SEQUENCE_VARIANT_MATRIX_VCF_HPP__
+
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+
+namespace Sequence
+{
+    class VCFReader
+    /*! \brief Read genotypes from VCF input in blocks of sites
+     *
+     * The input is read one record at a time, and each call to
+     * read_sites or read_interval returns a VariantMatrix holding
+     * the next block of records.  Only one block is held in memory
+     * at a time, meaning that a whole genome may be processed
+     * block by block.
+     *
+     * Each sample contributes ploidy() columns to the VariantMatrix,
+     * in the order of the alleles in its GT field.  Allele indexes
+     * are used as states, meaning that 0 is the REF allele.  Missing
+     * alleles are stored as -1.  Genotypes with fewer alleles than
+     * ploidy(), such as haploid calls on the X chromosome in diploid
+     * data, are padded with -1.  Positions are the POS column.
+     *
+     * A block never contains sites from more than one chromosome.
+     * The chromosome of the last block is given by chromosome().
+     *
+     * The input may be VCF text, or VCF compressed with gzip or
+     * bgzip when libsequence is built with zlib.  Compression is
+     * detected from the first byte of the input.  BCF is not
+     * supported; it may be converted with "bcftools view".
+     *
+     * std::runtime_error is thrown for malformed input.
+     *
+     * \ingroup variantmatrix
+     */
+    {
+      private:
+        // Owned input, for the constructor taking a file name
+        std::unique_ptr<std::istream> file;
+        // Decompression of compressed input
+        std::unique_ptr<std::streambuf> decompressor;
+        std::unique_ptr<std::istream> decompressed;
+        std::istream& input;
+        std::vector<std::string> sample_names;
+        std::size_t ploidy_;
+        std::string chrom;
+        // The next record, which has not been returned yet
+        std::string record;
+        bool have_record;
+        // Column offsets in record
+        std::vector<std::size_t> columns;
+        // Records read ahead of record to find the ploidy
+        std::deque<std::string> pending;
+
+        void read_header();
+        void next_record();
+        bool read_line(std::string& line);
+        void find_ploidy();
+        bool record_has_genotypes() const;
+        std::string record_chromosome() const;
+        double record_position() const;
+        void append_record(std::vector<std::int8_t>& data,
+                           std::vector<double>& pos);
+
+      public:
+        /*! \param input_stream The input, positioned at the start of
+         * the header
+         * \param ploidy The number of alleles per sample.  If 0,
+         * the ploidy is the largest number of alleles in a genotype
+         * of the first record with a GT field.  Genotypes that are
+         * a single ".", which is how some writers record a no-call
+         * of any ploidy, are not counted, and records where all
+         * genotypes are "." are held in memory until a later record
+         * gives the ploidy.  If no record does, the ploidy is 1.
+         *
+         * std::runtime_error is thrown if the input is compressed
+         * and libsequence was built without zlib.
+         */
+        explicit VCFReader(std::istream& input_stream,
+                           const std::size_t ploidy = 0);
+        /*! \param filename The name of a VCF file, which may be
+         * compressed with gzip or bgzip
+         * \param ploidy As for the constructor taking a stream
+         *
+         * std::runtime_error is thrown if the file cannot be opened.
+         */
+        explicit VCFReader(const std::string& filename,
+                           const std::size_t ploidy = 0);
+
+        /// Sample names from the header
+        const std::vector<std::string>& samples() const;
+        /// Number of alleles per sample, which is 0 if it was not
+        /// given to the constructor and no records have been read.
+        std::size_t ploidy() const;
+        /// The chromosome of the last block
+        const std::string& chromosome() const;
+        /// True if all records have been read
+        bool done() const;
+
+        /// Read up to \a max_sites records from the next chromosome.
+        /// Returns an empty VariantMatrix if done().
+        VariantMatrix read_sites(const std::size_t max_sites);
+
+        /// Read the records of the next chromosome whose positions
+        /// are in the same interval [k*length, (k+1)*length), for
+        /// integer k, as the position of the next record.
+        /// Returns an empty VariantMatrix if done().
+        VariantMatrix read_interval(const double length);
+    };
+} // namespace Sequence
+
+#endif
@@ -2,6 +2,7 @@
 #define SEQUENCE_VARIANT_MATRIX_WINDOWS_HPP
 
 #include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <stdexcept>
 #include <Sequence/VariantMatrix.hpp>
@@ -34,6 +35,74 @@ namespace Sequence
                              const double end,
                              const std::size_t i,
                              const std::size_t j);
+
+    struct WindowStatistic
+    /// \brief Flags requesting statistics from Sequence::windowed_statistics
+    ///
+    /// Flags are combined with bitwise or.
+    /// \ingroup variantmatrix
+    {
+        enum : unsigned
+        {
+            thetapi = 1u,
+            thetaw = 1u << 1,
+            tajd = 1u << 2,
+            thetah = 1u << 3,
+            thetal = 1u << 4,
+            faywuh = 1u << 5,
+            hprime = 1u << 6,
+            all = (1u << 7) - 1
+        };
+    };
+
+    struct WindowStatistics
+    /// \brief Summary statistics for one window.
+    ///
+    /// Statistics that were not requested are nan.
+    /// \ingroup variantmatrix
+    {
+        /// The window interval, [beg,end]
+        double beg, end;
+        /// Index of the first site in the window and the number of sites
+        std::size_t first_site, nsites;
+        double thetapi, thetaw, tajd, thetah, thetal, faywuh, hprime;
+    };
+
+    /*! \brief Summary statistics in sliding windows
+     * \param m A VariantMatrix
+     * \param beg Start of the first window
+     * \param end Windows start at positions < end
+     * \param window_size The length of each window
+     * \param step The distance between the starts of adjacent windows
+     * \param statistics Flags from Sequence::WindowStatistic
+     * \param refstate The ancestral state.  Only needed for thetah,
+     * thetal, faywuh and hprime.
+     *
+     * Windows are [beg + k*step, beg + k*step + window_size], which
+     * is the interval returned by make_window, and the results are those
+     * of the functions in Sequence/summstats/classics.hpp applied to
+     * the AlleleCountMatrix of each window.
+     *
+     * Rather than recount each window, the contribution of each site is
+     * calculated once when it enters a window and subtracted when it
+     * leaves, so that overlapping windows cost no more than
+     * non-overlapping ones.  Results may therefore differ from those of
+     * make_window by rounding error.
+     *
+     * std::invalid_argument is thrown if \a window_size < 0, \a step <=
+     * 0, or if \a refstate is negative or greater than the max allelic
+     * state when statistics needing it are requested.
+     * std::runtime_error is thrown if a window contains a site with more
+     * than one derived state when thetah, thetal, faywuh or hprime is
+     * requested.
+     *
+     * \ingroup variantmatrix
+     */
+    std::vector<WindowStatistics>
+    windowed_statistics(const VariantMatrix& m, const double beg,
+                        const double end, const double window_size,
+                        const double step, const unsigned statistics,
+                        const std::int8_t refstate = -1);
 } // namespace Sequence
 
 #endif
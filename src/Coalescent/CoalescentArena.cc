@@ -0,0 +1,180 @@
+#include <Sequence/Coalescent/Arena.hpp>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+  //The number of segments in a chunk.  Larger arrays get a chunk of their own.
+  const std::size_t CHUNK_SIZE = 1<<14;
+
+  unsigned size_class( const unsigned & n )
+  //Returns k such that 2^k is the smallest power of 2 >= n
+  {
+    unsigned k = 0;
+    while( (1u<<k) < n ) ++k;
+    return k;
+  }
+}
+
+namespace Sequence
+{
+  namespace coalsim {
+    sim_arena::sim_arena() : chunks(),chunk(0),offset(0),free_arrays(),
+			     scratch_space(),live(0),spare()
+    {
+    }
+
+    segment * sim_arena::allocate( const unsigned & n, unsigned * capacity )
+    /*!
+      @brief Allocate an array of at least n segments
+      \param n the number of segments
+      \param capacity set to the number of segments in the array, which must
+      be passed to deallocate
+    */
+    {
+      const unsigned k = size_class(n);
+      *capacity = 1u<<k;
+      ++live;
+      if( k < free_arrays.size() && !free_arrays[k].empty() )
+	{
+	  segment * rv = free_arrays[k].back();
+	  free_arrays[k].pop_back();
+	  return rv;
+	}
+      while( chunk < chunks.size() && chunks[chunk].size() - offset < *capacity )
+	{
+	  ++chunk;
+	  offset = 0;
+	}
+      if( chunk == chunks.size() )
+	{
+	  chunks.emplace_back(std::max(CHUNK_SIZE,std::size_t(*capacity)));
+	}
+      segment * rv = chunks[chunk].data() + offset;
+      offset += *capacity;
+      return rv;
+    }
+
+    void sim_arena::deallocate( segment * segs, const unsigned & capacity )
+    /*!
+      @brief Return an array from allocate to the arena
+    */
+    {
+      const unsigned k = size_class(capacity);
+      if( k >= free_arrays.size() )
+	{
+	  free_arrays.resize(k+1);
+	}
+      free_arrays[k].push_back(segs);
+      --live;
+    }
+
+    segment * sim_arena::scratch( const std::size_t & n )
+    /*!
+      @brief Temporary storage for n segments, valid until the next call
+    */
+    {
+      if( scratch_space.size() < n )
+	{
+	  scratch_space.resize(n);
+	}
+      return scratch_space.data();
+    }
+
+    arg::iterator sim_arena::insert_marginal( arg * sample_history,
+					      arg::iterator pos,
+					      const marginal & m )
+    /*!
+      @brief Insert a copy of m before pos, reusing a recycled marginal tree if possible
+      \return an iterator to the copy
+    */
+    {
+      if( !spare.empty() && spare.front().nsam != m.nsam )
+	{
+	  spare.clear();
+	}
+      if( spare.empty() )
+	{
+	  return sample_history->insert(pos,m);
+	}
+      sample_history->splice(pos,spare,spare.begin());
+      arg::iterator rv = std::prev(pos);
+      rv->beg = m.beg;
+      rv->nnodes = m.nnodes;
+      rv->tree = m.tree;
+      return rv;
+    }
+
+    void sim_arena::recycle( arg * sample_history )
+    /*!
+      @brief Move the marginal trees of sample_history into the arena,
+      leaving it empty
+    */
+    {
+      spare.splice(spare.end(),*sample_history);
+    }
+
+    void sim_arena::reset()
+    /*!
+      @brief Make all of the memory for segments available again without freeing it
+      \exception std::logic_error if a chromosome still holds segments from the arena
+    */
+    {
+      if( live )
+	{
+	  throw std::logic_error("sim_arena::reset called while segments are in use");
+	}
+      chunk = offset = 0;
+      for( auto & f : free_arrays )
+	{
+	  f.clear();
+	}
+    }
+
+    void sim_arena::init_replicate( const std::vector<int> & pop_config,
+				    const int & nsites,
+				    std::vector<chromosome> * sample,
+				    arg * sample_history )
+    /*!
+      @brief Initialize a sample and an ARG for a new replicate
+      \param pop_config the sample size of each population, as for init_sample
+      \param nsites the number of sites, as for init_sample
+      \param sample set to a sample of chromosomes using the arena for storage
+      \param sample_history set to an ARG containing a single marginal tree,
+      as returned by init_marginal.  Its previous marginal trees are recycled.
+
+      This is equivalent to calling init_sample and init_marginal, followed
+      by reset(), but reuses the memory of the previous replicate.
+    */
+    {
+      const int nsam = std::accumulate(pop_config.begin(),pop_config.end(),0);
+      sample->clear();
+      recycle(sample_history);
+      reset();
+      segment initial_segment(0,(nsites>0 ? nsites-1 : 0),0);
+      for(unsigned i = 0 ; i < pop_config.size() ; ++i)
+	{
+	  for(int j=0;j<pop_config[i];++j)
+	    {
+	      sample->emplace_back(&initial_segment,&initial_segment+1,int(i),this);
+	      ++initial_segment.desc;
+	    }
+	}
+      if( !spare.empty() && spare.front().nsam == nsam )
+	{
+	  sample_history->splice(sample_history->end(),spare,spare.begin());
+	  marginal & m = sample_history->front();
+	  m.beg = 0;
+	  m.nnodes = nsam-1;
+	  std::fill(m.tree.begin(),m.tree.end(),node());
+	}
+      else
+	{
+	  marginal m(0,nsam,nsam-1,std::vector<node>(std::vector<node>::size_type(2*nsam-1)));
+	  insert_marginal(sample_history,sample_history->end(),m);
+	}
+    }
+  }
+}
@@ -22,6 +22,7 @@
 */
 
 #include <Sequence/Coalescent/Coalesce.hpp>
+#include <Sequence/Coalescent/Arena.hpp>
 #include <cstdlib>
 
 namespace Sequence
@@ -101,7 +102,11 @@ namespace Sequence
       unsigned seg1=0,seg2=0;
 
       //segment * tsp = (segment *)malloc(sample_history->size()*sizeof(segment));
-      segment * tsp = static_cast<segment*>(malloc(sample_history->size()*sizeof(segment)));
+      //When the sample uses an arena, the new segments are built in its scratch
+      //space and copied into the existing storage of ch1.
+      sim_arena * arena = (sbegin+ch1)->arena;
+      segment * tsp = (arena) ? arena->scratch(sample_history->size()) :
+	static_cast<segment*>(malloc(sample_history->size()*sizeof(segment)));
       int tseg = -1;
 
       //iterate over marginal histories
@@ -150,7 +155,7 @@ namespace Sequence
       int flag=0;
       if(tseg < 0)
 	{
-	  free(tsp);
+	  if(!arena) free(tsp);
 	  (sbegin+ch1)->swap_with(*(sbegin+current_nsam-1));
 	  if(ch2 == current_nsam-1)
 	    {
@@ -163,7 +168,14 @@ namespace Sequence
       else
 	{
 	  assert( (sbegin+ch1) < sample->end() );
-	  (sbegin+ch1)->assign_allocated_segs(tsp,unsigned(tseg+1));
+	  if(arena)
+	    {
+	      (sbegin+ch1)->assign_segs(tsp,unsigned(tseg+1));
+	    }
+	  else
+	    {
+	      (sbegin+ch1)->assign_allocated_segs(tsp,unsigned(tseg+1));
+	    }
 	  *nlinks += (sbegin+ch1)->links();
 	}
 
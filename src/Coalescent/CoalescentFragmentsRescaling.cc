@@ -22,7 +22,10 @@
 */
 
 #include <Sequence/Coalescent/FragmentsRescaling.hpp>
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 #include <Sequence/SimData.hpp>
+#pragma GCC diagnostic pop
 #include <cassert>
 #include <numeric>
 
@@ -104,6 +107,9 @@ namespace Sequence
 	}
     }
 
+    //SimData is deprecated, but this function is kept for compatibility
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
     void rescale_mutation_positions(Sequence::SimData * d,
 				    const std::vector< std::pair<double,double> > & sample_scale, 
 				    const std::vector< std::pair<double,double> > & mutation_scale )
@@ -132,6 +138,7 @@ namespace Sequence
 	    }
 	}
     }
+#pragma GCC diagnostic pop
 
     void rescale_arg( arg * sample_history,
 		      const std::vector< std::pair<int,int> > & fragments )
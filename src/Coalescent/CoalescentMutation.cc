@@ -21,7 +21,12 @@
 
 */
 
+//Mutation.hpp declares the deprecated functions returning SimData,
+//which are kept for compatibility
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 #include <Sequence/Coalescent/Mutation.hpp>
+#pragma GCC diagnostic pop
 
 namespace Sequence
 {
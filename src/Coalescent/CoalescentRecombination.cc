@@ -22,6 +22,7 @@
 */
 
 #include <Sequence/Coalescent/Recombination.hpp>
+#include <Sequence/Coalescent/Arena.hpp>
 #include <cassert>
 
 #ifndef NDEBUG
@@ -92,7 +93,9 @@ namespace Sequence
       \param chromo the chromosome on which the crossover event is to occur
       \param pos the crossover event happens between sites pos and pos+1 (0<= pos < nsites)
       \param sample the sample of chromosomes being simulated
-      \param sample_history the genealogy of the sample
+      \param sample_history the genealogy of the sample.  If NULL, only the
+      chromosomes are updated, which is how crossovers are applied when the
+      genealogy is recorded as a tree_sequence.
       \return the number of links lost due to the crossover event
       \note as the type arg is based on std::list, and insertions into lists are done
       in constant time, this routine keeps the ancestral recombination graph sorted
@@ -109,9 +112,11 @@ namespace Sequence
       assert(seg != (sbegin+chromo)->end());
       within = (pos>=seg->beg) ? true:false;
 
-      //2. make new chromosome segments for right-hand end
+      //2. make new chromosome for right-hand end, using the same
+      //storage as the recombinant chromosome
       size_t ns = (sbegin+chromo)->nsegs - size_t(seg-(sbegin+chromo)->begin());
-      std::vector<segment> rtsegs(seg,seg+ns);
+      sim_arena * arena = (sbegin+chromo)->arena;
+      chromosome right(seg,seg+ns,(sbegin+chromo)->pop,arena);
 
       //3. edit vector of segments for left-hand end
       (sbegin+chromo)->nsegs = unsigned((int((seg)-(sbegin+chromo)->begin())) + int(within));
@@ -120,22 +125,22 @@ namespace Sequence
       //4. make sure begs and ends are happy
       if(within)
 	{
-	  rtsegs.begin()->beg = pos+1;
+	  right.begin()->beg = pos+1;
 	  seg->end = pos;
 	}
       else
 	{
-	  rtsegs.begin()->beg = seg->beg;
+	  right.begin()->beg = seg->beg;
 	}
 
       //rv is the number of links lost due to the crossover event
-      int rv = rtsegs.begin()->beg - ((sbegin+chromo)->end()-1)->end;
+      int rv = right.begin()->beg - ((sbegin+chromo)->end()-1)->end;
+      int beg_new_marg = right.begin()->beg;
 
       //5. insert a new chromosom into the sample
       //WARNING: all pointers and iterators declared above
       //should be considered invalidated!
-      int tpop=(sbegin+chromo)->pop;
-      sample->insert(sbegin+current_nsam,chromosome(rtsegs,tpop));
+      sample->insert(sbegin+current_nsam,std::move(right));
       //code below causes too much RAM usage  (not sure why...)
       //     if(std::vector<chromosome>::size_type(current_nsam)+1 > sample->size())
       //       {
@@ -143,14 +148,11 @@ namespace Sequence
       //         sbegin = sample->begin();
       //       }
       //     *(sbegin+current_nsam) = chromosome(rtsegs,tpop);
-      assert( (sample->begin()+current_nsam)->nsegs == rtsegs.size() 
-	      && rtsegs.size() == ns );
+      assert( (sample->begin()+current_nsam)->nsegs == ns );
 
       //6. insert a new marginal tree if necessary
-      if(within == true)
+      if(within == true && sample_history != NULL)
 	{
-	  int beg_new_marg = rtsegs.begin()->beg;
-	
 	  //find place in arg that is affected
 	  arg::iterator argbeg = sample_history->begin();
 	  arg::iterator titr=argbeg;
@@ -161,7 +163,8 @@ namespace Sequence
 	  assert(argbeg!=sample_history->end());
 	  if(argbeg->beg != beg_new_marg)
 	    {
-	      arg::iterator argt = sample_history->insert(titr,*(argbeg));
+	      arg::iterator argt = (arena) ? arena->insert_marginal(sample_history,titr,*argbeg) :
+		sample_history->insert(titr,*(argbeg));
 	      argt->beg = beg_new_marg;
 	      assert(arg_is_sorted(sample_history));
 	    }
@@ -0,0 +1,24 @@
+#include <Sequence/Coalescent/ReplicateDriver.hpp>
+
+namespace Sequence
+{
+  namespace coalsim {
+    rng_streams::rng_streams( const std::uint64_t & seed,
+			      const std::uint64_t & replicate )
+      : engine(), uni{&engine}, uni01{&engine}, expo{&engine}, poiss{&engine}
+    {
+      reseed(seed,replicate);
+    }
+
+    void rng_streams::reseed( const std::uint64_t & seed,
+			      const std::uint64_t & replicate )
+    //seed_seq mixes all of its input into the state, so engines seeded
+    //with nearby replicate numbers give unrelated streams.
+    {
+      std::seed_seq s{ std::uint32_t(seed), std::uint32_t(seed>>32),
+		       std::uint32_t(replicate), std::uint32_t(replicate>>32) };
+      engine.seed(s);
+    }
+
+  }
+}
@@ -22,6 +22,7 @@
 */
 
 #include <Sequence/Coalescent/SimTypes.hpp>
+#include <Sequence/Coalescent/Arena.hpp>
 #include <cassert>
 #include <iostream>
 #include <cstdlib>
@@ -52,7 +53,9 @@ namespace Sequence
 
     chromosome::chromosome() : segs(NULL),
 			       pop(0),
-			       nsegs(0)
+			       nsegs(0),
+			       capacity(0),
+			       arena(NULL)
 			       /*! 
 				 @brief constructor
 				 sets segs to NULL, pop to 0, and nsegs to 0
@@ -65,7 +68,9 @@ namespace Sequence
       //segs((segment *)(malloc(initial_segs.size()*sizeof(segment)))), 
       segs( static_cast<segment*>(malloc(initial_segs.size()*sizeof(segment)))), 
       pop(population),
-      nsegs(unsigned(initial_segs.size()))
+      nsegs(unsigned(initial_segs.size())),
+      capacity(nsegs),
+      arena(NULL)
       /*!
 	@brief constructor
 	\param initial_segs a vector of segments
@@ -76,58 +81,112 @@ namespace Sequence
       std::copy(initial_segs.begin(),initial_segs.end(),segs);
     }
 
+    chromosome::chromosome( const_iterator first, const_iterator last,
+			    const int & population,
+			    sim_arena * storage ) :
+      segs(NULL),
+      pop(population),
+      nsegs(unsigned(last-first)),
+      capacity(nsegs),
+      arena(storage)
+      /*!
+	@brief constructor
+	\param first pointer to the first segment
+	\param last pointer past the last segment
+	\param population used to set pop
+	\param storage the arena from which to allocate segments, or NULL to use malloc
+      */
+    {
+      segs = (arena) ? arena->allocate(nsegs,&capacity) :
+	static_cast<segment*>(malloc(nsegs*sizeof(segment)));
+      std::copy(first,last,segs);
+    }
+
     chromosome::~chromosome()
     /*!
-      frees pointer to segments
+      frees pointer to segments, or returns them to the arena
     */
     {
-      if(nsegs>0) free(segs);
+      if(arena)
+	{
+	  if(segs) arena->deallocate(segs,capacity);
+	}
+      else if(nsegs>0) free(segs);
     }
 
     chromosome::chromosome( const chromosome & ch ) :
       //segs((segment *)malloc(ch.nsegs*sizeof(segment))),
-      segs(static_cast<segment *>(malloc(ch.nsegs*sizeof(segment)))),
+      segs(NULL),
       pop(ch.pop),
-      nsegs(ch.nsegs)
+      nsegs(ch.nsegs),
+      capacity(ch.nsegs),
+      arena(ch.arena)
       /*!
 	@brief copy constructor
+	\note the copy uses the arena of ch, if any
       */
     {
+      segs = (arena) ? arena->allocate(nsegs,&capacity) :
+	static_cast<segment *>(malloc(nsegs*sizeof(segment)));
       std::copy(ch.segs,ch.segs+ch.nsegs,segs);
     }
 
+    chromosome::chromosome( chromosome && ch ) noexcept :
+      segs(ch.segs),
+      pop(ch.pop),
+      nsegs(ch.nsegs),
+      capacity(ch.capacity),
+      arena(ch.arena)
+      /*!
+	@brief move constructor
+	Leaves ch without segments
+      */
+    {
+      ch.segs=NULL;
+      ch.nsegs=ch.capacity=0;
+    }
+
     chromosome & chromosome::operator=(const chromosome & ch)
     /*!
       @brief assignment operator
     */
     {
       if(this == &ch) return *this;
-      if(ch.nsegs>this->nsegs)
-	{
-	  //this->segs = (segment *)realloc(this->segs,ch.nsegs*sizeof(segment));
-	  this->segs = static_cast<segment *>(realloc(this->segs,ch.nsegs*sizeof(segment)));
-	}
-      std::copy(ch.segs,ch.segs+ch.nsegs,segs);
-      this->nsegs = ch.nsegs;
+      assign_segs(ch.segs,ch.nsegs);
       this->pop = ch.pop;
       return *this;
     }
 
+    chromosome & chromosome::operator=(chromosome && ch) noexcept
+    /*!
+      @brief move assignment operator
+      Swaps the segments of the two chromosomes
+    */
+    {
+      swap_with(ch);
+      return *this;
+    }
+
 
     void chromosome::swap_with( chromosome & ch )
     /*!
       Swaps the data members of the current chromosome with chromosome ch.
       Called by the coalesce routine, and is necessary to prevent nastiness
       such as multiple calls to free when vectors of chromosomes go out of scope.
+      The storage of the segments (capacity and arena) is swapped as well.
       Implemented as:
       std::swap(this->segs,ch.segs);
       std::swap(this->nsegs,ch.nsegs);
       std::swap(this->pop,ch.pop);
+      std::swap(this->capacity,ch.capacity);
+      std::swap(this->arena,ch.arena);
     */
     {
       std::swap(this->segs,ch.segs);
       std::swap(this->nsegs,ch.nsegs);
       std::swap(this->pop,ch.pop);
+      std::swap(this->capacity,ch.capacity);
+      std::swap(this->arena,ch.arena);
     }
 
     void chromosome::assign_allocated_segs( segment * newsegs,
@@ -136,11 +195,45 @@ namespace Sequence
       Replaces the current segs with those pointed to by newsegs
       \param newsegs an array of segments allocated with malloc
       \param new_nsegs the number of segs stored in \a newsegs
+      \note If the chromosome uses an arena, the segments are
+      copied into it, and newsegs is freed.
     */
     {
+      if(arena)
+	{
+	  assign_segs(newsegs,new_nsegs);
+	  free(newsegs);
+	  return;
+	}
       free(segs);
       segs=newsegs;
       nsegs=new_nsegs;
+      capacity=new_nsegs;
+    }
+
+    void chromosome::assign_segs( const_iterator first,
+				  const unsigned & new_nsegs )
+    /*!
+      Replaces the current segs with a copy of the new_nsegs segments
+      beginning at first, reallocating only if capacity is too small.
+      \note first must not point into segs
+    */
+    {
+      if(new_nsegs>capacity)
+	{
+	  if(arena)
+	    {
+	      if(segs) arena->deallocate(segs,capacity);
+	      segs = arena->allocate(new_nsegs,&capacity);
+	    }
+	  else
+	    {
+	      segs = static_cast<segment *>(realloc(segs,new_nsegs*sizeof(segment)));
+	      capacity = new_nsegs;
+	    }
+	}
+      std::copy(first,first+new_nsegs,segs);
+      nsegs=new_nsegs;
     }
 
     chromosome::iterator chromosome::begin()
@@ -22,10 +22,27 @@
 */
 
 #include <Sequence/Coalescent/TreeOperations.hpp>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <limits>
 #include <stdexcept>
+
+namespace
+{
+  int lowest_bit( const std::uint64_t & x )
+  //Returns the index of the lowest set bit of x, which must not be 0
+  {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int i = 0;
+    while( !((x>>i)&1) ) ++i;
+    return i;
+#endif
+  }
+}
+
 namespace Sequence
 {
   namespace coalsim {
@@ -127,6 +144,248 @@ namespace Sequence
       return i==branch;
     }
 
+    marginal_tree_stats::marginal_tree_stats()
+      : nsam(0),nwords(0),tree(),children(),branch_lengths(),branch_sums(),
+	total_time_(0.),bits(),changed(),reparented(),dirty(),marked()
+      /*!
+	Call update() with the first marginal tree before using
+	any other member function.
+      */
+    {
+    }
+
+    void marginal_tree_stats::rebuild( const marginal & m )
+    {
+      nsam = m.nsam;
+      nwords = (std::size_t(nsam)+63)/64;
+      tree = m.tree;
+      const std::size_t nnodes = tree.size(), root = nnodes-1;
+      children.assign(2*nnodes,-1);
+      branch_lengths.assign(nnodes,0.);
+      branch_sums.assign(nnodes+1,0.);
+      marked.assign(nnodes,0);
+      total_time_ = 0.;
+      for( std::size_t i = 0 ; i < root ; ++i )
+	{
+	  const std::size_t p = std::size_t(tree[i].abv);
+	  assert( p > i );
+	  children[(children[2*p] == -1) ? 2*p : 2*p+1] = int(i);
+	  branch_lengths[i] = tree[p].time - tree[i].time;
+	  branch_sums[i+1] = branch_lengths[i];
+	  total_time_ += branch_lengths[i];
+	}
+      for( std::size_t i = 1 ; i <= nnodes ; ++i )
+	{
+	  const std::size_t j = i + (i & (~i+1));
+	  if( j <= nnodes ) branch_sums[j] += branch_sums[i];
+	}
+      bits.assign(nnodes*nwords,0);
+      for( std::size_t i = 0 ; i < std::size_t(nsam) ; ++i )
+	{
+	  bits[i*nwords + i/64] = std::uint64_t(1) << (i%64);
+	}
+      for( std::size_t i = std::size_t(nsam) ; i < nnodes ; ++i )
+	{
+	  const std::size_t c0 = std::size_t(children[2*i]), c1 = std::size_t(children[2*i+1]);
+	  for( std::size_t w = 0 ; w < nwords ; ++w )
+	    {
+	      bits[i*nwords+w] = bits[c0*nwords+w] | bits[c1*nwords+w];
+	    }
+	}
+    }
+
+    void marginal_tree_stats::update_branch( const int & i )
+    {
+      const std::size_t c = std::size_t(i);
+      const double length = tree[std::size_t(tree[c].abv)].time - tree[c].time;
+      const double delta = length - branch_lengths[c];
+      if( delta != 0. )
+	{
+	  branch_lengths[c] = length;
+	  for( std::size_t j = c+1 ; j < branch_sums.size() ; j += j & (~j+1) )
+	    {
+	      branch_sums[j] += delta;
+	    }
+	  total_time_ += delta;
+	}
+    }
+
+    void marginal_tree_stats::mark_ancestors( int i )
+    {
+      const int root = int(tree.size())-1;
+      while( !marked[std::size_t(i)] )
+	{
+	  marked[std::size_t(i)] = 1;
+	  dirty.push_back(i);
+	  if( i == root ) break;
+	  i = tree[std::size_t(i)].abv;
+	}
+    }
+
+    void marginal_tree_stats::update( const marginal & m )
+    /*!
+      @brief Move to the marginal tree \a m
+      \param m a complete marginal tree.  It is compared node by node to the
+      previous tree, and only the statistics depending on the nodes that differ
+      are recalculated.  The first call, any call for a tree with a different
+      sample size, and any call for a tree that differs in many nodes, calculates
+      everything.
+    */
+    {
+      if( m.nsam != nsam || m.tree.size() != tree.size() )
+	{
+	  rebuild(m);
+	  return;
+	}
+      const std::size_t nnodes = tree.size(), root = nnodes-1;
+      changed.clear();
+      for( std::size_t i = 0 ; i < nnodes ; ++i )
+	{
+	  if( tree[i].abv != m.tree[i].abv || tree[i].time != m.tree[i].time )
+	    {
+	      changed.push_back(int(i));
+	    }
+	}
+      if( changed.empty() ) return;
+      if( 8*changed.size() > nnodes )
+	{
+	  //Cheaper to start again
+	  rebuild(m);
+	  return;
+	}
+      //Detach every node that moves before attaching any, so that
+      //no node ever has more than two children.
+      reparented.clear();
+      for( const int i : changed )
+	{
+	  const std::size_t c = std::size_t(i);
+	  if( c < root && tree[c].abv != m.tree[c].abv )
+	    {
+	      const std::size_t p = std::size_t(tree[c].abv);
+	      if( children[2*p] == i ) children[2*p] = children[2*p+1];
+	      children[2*p+1] = -1;
+	      reparented.push_back(tree[c].abv);
+	    }
+	}
+      for( const int i : changed )
+	{
+	  const std::size_t c = std::size_t(i);
+	  if( c < root && tree[c].abv != m.tree[c].abv )
+	    {
+	      const std::size_t p = std::size_t(m.tree[c].abv);
+	      children[(children[2*p] == -1) ? 2*p : 2*p+1] = i;
+	      reparented.push_back(m.tree[c].abv);
+	    }
+	  tree[c] = m.tree[c];
+	}
+      //A branch changes length when either of its ends changes time
+      for( const int i : changed )
+	{
+	  const std::size_t c = std::size_t(i);
+	  if( c < root ) update_branch(i);
+	  for( std::size_t k = 2*c ; k < 2*c+2 ; ++k )
+	    {
+	      if( children[k] >= 0 ) update_branch(children[k]);
+	    }
+	}
+      //The tips below a node change when its children change, and
+      //children have smaller indexes than their parents.
+      dirty.clear();
+      for( const int p : reparented )
+	{
+	  mark_ancestors(p);
+	}
+      std::sort(dirty.begin(),dirty.end());
+      for( const int i : dirty )
+	{
+	  const std::size_t p = std::size_t(i);
+	  const std::size_t c0 = std::size_t(children[2*p]), c1 = std::size_t(children[2*p+1]);
+	  for( std::size_t w = 0 ; w < nwords ; ++w )
+	    {
+	      bits[p*nwords+w] = bits[c0*nwords+w] | bits[c1*nwords+w];
+	    }
+	  marked[p] = 0;
+	}
+    }
+
+    double marginal_tree_stats::total_time() const
+    /*!
+      \return the total time on the current tree, as for total_time
+    */
+    {
+      return total_time_;
+    }
+
+    int marginal_tree_stats::pick_branch( const double & rtime ) const
+    /*!
+      @brief pick a random branch of the current tree
+      \param rtime a random double between 0 and total_time()
+      \return the branch on which the cumulative time, with branches ordered by
+      index, reaches \a rtime.  This is the branch returned by pick_branch for the
+      same tree, up to rounding in the cumulative sums, but takes time logarithmic
+      in the sample size.
+    */
+    {
+      const std::size_t nnodes = tree.size();
+      std::size_t pos = 0, step = 1;
+      while( step*2 <= nnodes ) step *= 2;
+      double remaining = rtime;
+      for( ; step > 0 ; step /= 2 )
+	{
+	  if( pos+step <= nnodes && branch_sums[pos+step] < remaining )
+	    {
+	      pos += step;
+	      remaining -= branch_sums[pos];
+	    }
+	}
+      //As for pick_branch, never return the root
+      return int(std::min(pos,nnodes-2));
+    }
+
+    const std::uint64_t * marginal_tree_stats::descendants( const int & branch ) const
+    /*!
+      \return the tips descending from \a branch, as a bitset of words() words.
+      Tip i is bit i%64 of word i/64.
+    */
+    {
+      return bits.data() + std::size_t(branch)*nwords;
+    }
+
+    void marginal_tree_stats::descendants( const int & branch, std::vector<int> * tips ) const
+    /*!
+      @brief The tips descending from a branch of the current tree
+      \param branch a node of the current tree
+      \param tips filled with the tips descending from \a branch, in ascending order
+    */
+    {
+      tips->clear();
+      const std::uint64_t * b = descendants(branch);
+      for( std::size_t w = 0 ; w < nwords ; ++w )
+	{
+	  for( std::uint64_t x = b[w] ; x ; x &= x-1 )
+	    {
+	      tips->push_back(int(64*w) + lowest_bit(x));
+	    }
+	}
+    }
+
+    std::size_t marginal_tree_stats::words() const
+    /*!
+      \return the number of 64-bit words in each bitset returned by descendants
+    */
+    {
+      return nwords;
+    }
+
+    bool marginal_tree_stats::is_descendant( const int & ind, const int & branch ) const
+    /*!
+      \return true if tip \a ind descends from \a branch on the current tree
+    */
+    {
+      const std::size_t i = std::size_t(ind);
+      return (descendants(branch)[i/64] >> (i%64)) & 1;
+    }
+
     double total_time_on_arg( const Sequence::coalsim::arg & sample_history,
 			      const int & total_number_of_sites )
     /*!
@@ -0,0 +1,331 @@
+#include <Sequence/Coalescent/TreeSequence.hpp>
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace Sequence
+{
+  namespace coalsim {
+    tree_sequence::tree_sequence(const int & sample_size,
+				 const int & number_of_sites)
+      : nsam(sample_size),nsites(number_of_sites),
+	node_times(std::vector<double>::size_type(sample_size),0.),edges()
+      /*!
+	\param sample_size the sample size
+	\param number_of_sites the number of sites
+	\note The sample nodes are created, with time 0.
+      */
+    {
+    }
+
+    tree_sequence_recorder::tree_sequence_recorder( const int & nsam, const int & nsites )
+      : ts(nsam,nsites),lineages(),breakpoints(),merged()
+      /*!
+	\param nsam the sample size
+	\param nsites the number of sites
+      */
+    {
+      lineages[0]=nsam;
+      lineages[nsites]=0;
+    }
+
+    void tree_sequence_recorder::add_edge( const int & left, const int & right,
+					   const int & parent, const int & child,
+					   const std::size_t & first_edge )
+    //Extends an edge of the current coalescent event that ends at left,
+    //so that an edge is stored once for contiguous sites.
+    {
+      for( std::size_t i = ts.edges.size() ; i > first_edge ; --i )
+	{
+	  edge & e = ts.edges[i-1];
+	  if( e.child == child && e.right == left )
+	    {
+	      e.right = right;
+	      return;
+	    }
+	}
+      ts.edges.push_back(edge{left,right,parent,child});
+    }
+
+    int tree_sequence_recorder::coalesce( const double & time,
+					  const int & current_nsam,
+					  const int & c1,
+					  const int & c2,
+					  int * nlinks,
+					  std::vector<chromosome> * sample )
+    /*!
+      @brief Common ancestor routine for recording a tree sequence.
+
+      Merges chromosomes \a c1 and \a c2.  Where both have ancestral material,
+      a single new node is created, with an edge to each of them.  Sites whose
+      most recent common ancestor is the new node are not carried by the merged
+      chromosome.  The arguments and return value are as for coalesce, which
+      updates an arg instead.
+      \ingroup coalescent
+    */
+    {
+      int ch1=(c1<c2)?c1:c2, ch2=(c2>c1)?c2:c1;
+      std::vector<chromosome>::iterator sbegin=sample->begin();
+      const chromosome & a = *(sbegin+ch1), & b = *(sbegin+ch2);
+      assert( a.nsegs>0 );
+      assert( b.nsegs>0 );
+
+      breakpoints.clear();
+      for( chromosome::const_iterator s = a.begin() ; s < a.end() ; ++s )
+	{
+	  breakpoints.push_back(s->beg);
+	  breakpoints.push_back(s->end+1);
+	}
+      for( chromosome::const_iterator s = b.begin() ; s < b.end() ; ++s )
+	{
+	  breakpoints.push_back(s->beg);
+	  breakpoints.push_back(s->end+1);
+	}
+      std::sort(breakpoints.begin(),breakpoints.end());
+      breakpoints.erase(std::unique(breakpoints.begin(),breakpoints.end()),breakpoints.end());
+
+      merged.clear();
+      auto append = [this](const int & beg, const int & end, const int & desc)
+	{
+	  if( !merged.empty() && merged.back().desc == desc && merged.back().end+1 == beg )
+	    {
+	      merged.back().end = end;
+	    }
+	  else
+	    {
+	      merged.push_back(segment(beg,end,desc));
+	    }
+	};
+      int parent = -1;
+      const std::size_t first_edge = ts.edges.size();
+      chromosome::const_iterator sa = a.begin(), sb = b.begin();
+      for( std::size_t k = 0 ; k+1 < breakpoints.size() ; ++k )
+	{
+	  const int l = breakpoints[k], r = breakpoints[k+1];
+	  while( sa < a.end() && sa->end < l ) ++sa;
+	  while( sb < b.end() && sb->end < l ) ++sb;
+	  const int da = ( sa < a.end() && sa->beg <= l ) ? sa->desc : -1;
+	  const int db = ( sb < b.end() && sb->beg <= l ) ? sb->desc : -1;
+	  if( da < 0 && db < 0 ) continue;
+	  if( da < 0 || db < 0 )
+	    {
+	      append(l,r-1,(da<0) ? db : da);
+	      continue;
+	    }
+	  if( parent < 0 )
+	    {
+	      parent = int(ts.node_times.size());
+	      ts.node_times.push_back(time);
+	    }
+	  add_edge(l,r,parent,da,first_edge);
+	  add_edge(l,r,parent,db,first_edge);
+	  //One fewer lineage is ancestral to [l,r).  Where one
+	  //remains, the new node is the MRCA.
+	  for( const int x : {l,r} )
+	    {
+	      auto i = lineages.upper_bound(x);
+	      if( std::prev(i)->first != x )
+		{
+		  lineages.emplace_hint(i,x,std::prev(i)->second);
+		}
+	    }
+	  for( auto i = lineages.find(l) ; i->first < r ; ++i )
+	    {
+	      if( --(i->second) > 1 )
+		{
+		  append(i->first,std::next(i)->first-1,parent);
+		}
+	    }
+	}
+
+      *nlinks -= (sbegin+ch1)->links();
+      int flag=0;
+      if( merged.empty() )
+	{
+	  (sbegin+ch1)->swap_with(*(sbegin+current_nsam-1));
+	  if(ch2 == current_nsam-1)
+	    {
+	      ch2=ch1;
+	    }
+	  flag=1;
+	}
+      else
+	{
+	  (sbegin+ch1)->assign_segs(merged.data(),unsigned(merged.size()));
+	  *nlinks += (sbegin+ch1)->links();
+	}
+      *nlinks -= (sbegin+ch2)->links();
+      (sbegin+ch2)->swap_with(*(sbegin+current_nsam-1-flag));
+      return (merged.empty() ? 2 : 1);
+    }
+
+    tree_sequence & tree_sequence_recorder::result()
+    /*!
+      \return the tree sequence recorded so far
+    */
+    {
+      return ts;
+    }
+
+    marginal_tree_walker::marginal_tree_walker( const tree_sequence & t )
+      : ts(t),insertion(t.edges.size()),removal(t.edges.size()),
+	next_insertion(0),next_removal(0),left_(0),right_(0),
+	parent_(t.node_times.size(),-1),children(2*t.node_times.size(),-1),
+	branch_sums(t.node_times.size()+1,0.),total_time_(0.)
+      /*!
+	\param t a tree sequence, which must outlive the walker.
+	Call next() to move to the first tree.
+      */
+    {
+      for( std::size_t i = 0 ; i < insertion.size() ; ++i )
+	{
+	  insertion[i] = removal[i] = i;
+	}
+      std::sort(insertion.begin(),insertion.end(),[&t](const std::size_t & i, const std::size_t & j) {
+	  return t.edges[i].left < t.edges[j].left;
+	});
+      std::sort(removal.begin(),removal.end(),[&t](const std::size_t & i, const std::size_t & j) {
+	  return t.edges[i].right < t.edges[j].right;
+	});
+    }
+
+    void marginal_tree_walker::update_branch( const int & node, const double & length )
+    {
+      for( std::size_t i = std::size_t(node)+1 ; i < branch_sums.size() ; i += i & (~i+1) )
+	{
+	  branch_sums[i] += length;
+	}
+      total_time_ += length;
+    }
+
+    void marginal_tree_walker::remove_edge( const edge & e )
+    {
+      const std::size_t p = std::size_t(e.parent);
+      parent_[std::size_t(e.child)] = -1;
+      if( children[2*p] == e.child )
+	{
+	  children[2*p] = children[2*p+1];
+	}
+      children[2*p+1] = -1;
+      update_branch(e.child,-(ts.node_times[p]-ts.node_times[std::size_t(e.child)]));
+    }
+
+    void marginal_tree_walker::insert_edge( const edge & e )
+    {
+      const std::size_t p = std::size_t(e.parent);
+      parent_[std::size_t(e.child)] = e.parent;
+      children[(children[2*p] == -1) ? 2*p : 2*p+1] = e.child;
+      update_branch(e.child,ts.node_times[p]-ts.node_times[std::size_t(e.child)]);
+    }
+
+    bool marginal_tree_walker::next()
+    /*!
+      @brief Move to the next marginal tree
+      \return false if there are no more trees
+    */
+    {
+      if( right_ >= ts.nsites )
+	{
+	  return false;
+	}
+      const std::size_t nedges = ts.edges.size();
+      const int x = right_;
+      for( ; next_removal < nedges && ts.edges[removal[next_removal]].right == x ; ++next_removal )
+	{
+	  remove_edge(ts.edges[removal[next_removal]]);
+	}
+      for( ; next_insertion < nedges && ts.edges[insertion[next_insertion]].left == x ; ++next_insertion )
+	{
+	  insert_edge(ts.edges[insertion[next_insertion]]);
+	}
+      left_ = x;
+      right_ = ts.nsites;
+      if( next_insertion < nedges )
+	{
+	  right_ = std::min(right_,ts.edges[insertion[next_insertion]].left);
+	}
+      if( next_removal < nedges )
+	{
+	  right_ = std::min(right_,ts.edges[removal[next_removal]].right);
+	}
+      return true;
+    }
+
+    int marginal_tree_walker::left() const
+    {
+      return left_;
+    }
+
+    int marginal_tree_walker::right() const
+    {
+      return right_;
+    }
+
+    const std::vector<int> & marginal_tree_walker::parents() const
+    {
+      return parent_;
+    }
+
+    double marginal_tree_walker::total_time() const
+    /*!
+      \return the total time on the current tree, as for total_time
+    */
+    {
+      return total_time_;
+    }
+
+    int marginal_tree_walker::pick_branch( const double & rtime ) const
+    /*!
+      @brief pick a random branch of the current tree
+      \param rtime a random double between 0 and total_time()
+      \return the node below the branch.  Branches are ordered by
+      node, and the branch on which the cumulative time reaches
+      \a rtime is returned, which takes time logarithmic in the
+      number of nodes.
+    */
+    {
+      const std::size_t n = parent_.size();
+      std::size_t pos = 0, step = 1;
+      while( step*2 <= n ) step *= 2;
+      double remaining = rtime;
+      for( ; step > 0 ; step /= 2 )
+	{
+	  if( pos+step <= n && branch_sums[pos+step] < remaining )
+	    {
+	      pos += step;
+	      remaining -= branch_sums[pos];
+	    }
+	}
+      //Rounding in the sums may land on a node that is not
+      //in the tree, or past the last node.
+      while( pos < n && parent_[pos] < 0 ) ++pos;
+      while( pos == n || parent_[pos] < 0 ) --pos;
+      return int(pos);
+    }
+
+    void marginal_tree_walker::descendants( const int & node, std::vector<int> * tips ) const
+    /*!
+      @brief The sample nodes below a node of the current tree
+      \param node a node of the current tree
+      \param tips filled with the sample nodes descending from \a node, in no particular order
+    */
+    {
+      tips->clear();
+      std::vector<int> stack(1,node);
+      while( !stack.empty() )
+	{
+	  const int i = stack.back();
+	  stack.pop_back();
+	  if( i < ts.nsam )
+	    {
+	      tips->push_back(i);
+	      continue;
+	    }
+	  for( std::size_t c = 2*std::size_t(i) ; c < 2*std::size_t(i)+2 ; ++c )
+	    {
+	      if( children[c] >= 0 ) stack.push_back(children[c]);
+	    }
+	}
+    }
+  }
+}
@@ -25,7 +25,7 @@ long with libsequence.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <Sequence/Seq.hpp>
 #include <Sequence/CodonTable.hpp>
-#include <Sequence/Comparisons.hpp>
+#include <Sequence/Translate.hpp>
 #include <algorithm>
 #include <functional>
 #include <iterator>
@@ -50,6 +50,17 @@ namespace
   Sequence::CodonUsageTable doWork( std::string::const_iterator beg,
 				    std::string::const_iterator end )
   {
+    //Codons are counted in one pass, by their index.  Codons
+    //containing missing data or gaps match none of the 64 codons.
+    std::vector<unsigned> counts(64,0u);
+    for( ; end - beg >= 3 ; beg += 3 )
+      {
+	const int i = Sequence::CodonIndex(&*beg);
+	if( i >= 0 )
+	  {
+	    ++counts[std::size_t(i)];
+	  }
+      }
     Sequence::CodonUsageTable UsageTable;
     for (unsigned i = 0 ; i < alphsize ; ++i)
       for (unsigned j = 0 ; j < alphsize ; ++j)
@@ -59,18 +70,7 @@ namespace
             codon += alphabet[i];
             codon += alphabet[j];
             codon += alphabet[k];
-	    std::string::const_iterator::difference_type pos = 0;
-            unsigned count = 0;
-	    for( ; (beg+pos) < end ; pos += 3 )
-	      {
-		//Ask if positions beg to beg+3 differ from codon, but do 
-		//not allow missing data to result in the answer to be false
-		if( ! Sequence::Different( std::string(beg+pos,beg+pos+3),codon,false) )
-		  {
-		    ++count;
-		  }
-	      }
-            UsageTable.push_back( CodonFreq(codon,count) );
+            UsageTable.push_back( CodonFreq(codon,int(counts[16*i+4*j+k])) );
           }
     return UsageTable;
   }
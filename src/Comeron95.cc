@@ -28,6 +28,11 @@
 #include <cassert>
 #include <limits>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <typeinfo>
+#include <vector>
 #include <Sequence/Seq.hpp>
 #include <Sequence/SeqAlphabets.hpp>
 #include <Sequence/Comparisons.hpp>
@@ -40,12 +45,74 @@
 #include <Sequence/Kimura80.hpp>
 #include <Sequence/RedundancyCom95.hpp>
 #include <Sequence/Comeron95.hpp>
+#include <Sequence/Translate.hpp>
+#include "worker_threads.hpp"
 
 /*!
   \defgroup kaks Classes related to the calculation of Ka and Ks
   \ingroup divergence
 */
 
+namespace
+{
+  //Codons are indexed as by Sequence::CodonIndex, 16*first+4*second+third,
+  //with A,C,G,T as 0 to 3
+  const char bases[] = "ACGT";
+
+  void encode_codons(const Sequence::Seq & seq, std::vector<std::int8_t> * codons)
+  //Codons containing anything other than A,C,G,T are encoded as -1
+  {
+    codons->resize(seq.length()/3);
+    const char * s = seq.c_str();
+    for (std::size_t i = 0; i < codons->size(); ++i)
+      {
+	(*codons)[i] = std::int8_t(Sequence::CodonIndex(s+3*i));
+      }
+  }
+
+  std::string codon_string(const int codon)
+  {
+    return std::string{bases[codon/16],bases[(codon/4)%4],bases[codon%4]};
+  }
+
+  int codon_diffs(const int codon1, const int codon2)
+  {
+    return int(codon1/16 != codon2/16) + int((codon1/4)%4 != (codon2/4)%4)
+      + int(codon1%4 != codon2%4);
+  }
+
+  struct codon_pair_table
+  /*
+    The contributions of a pair of codons to p0, p2S, p2V, p4, q0, q2S, q2V
+    and q4, for one genetic code and pair of weighting schemes.  Entries are
+    filled the first time that a pair of codons is compared.
+  */
+  {
+    std::vector<std::array<double,8> > values;
+    std::vector<char> filled;
+    codon_pair_table() : values(64*64), filled(64*64,0)
+    {
+    }
+    void clear()
+    {
+      std::fill(filled.begin(),filled.end(),0);
+    }
+  };
+
+  struct site_lengths
+  //The numbers of sites of each class compared, as for Sequence::Sites
+  {
+    double L0, L2S, L2V, L4;
+  };
+
+  template<typename substitutions>
+  std::array<double,8> contributions(const substitutions & subs)
+  {
+    return std::array<double,8>{{subs.P0(),subs.P2S(),subs.P2V(),subs.P4(),
+	  subs.Q0(),subs.Q2S(),subs.Q2V(),subs.Q4()}};
+  }
+}
+
 namespace Sequence
 {
   struct Comeron95::Com95impl
@@ -54,18 +121,43 @@ namespace Sequence
       q0, q2S, q2V, q4, p0, p2S, p2V, p4,Ka,Ks;
     std::unique_ptr<RedundancyCom95> sitesObj;
     GeneticCodes code;
-    void diverge(const Sequence::Seq & seq1, const Sequence::Seq & seq2,
+    //Pairs of codons weighted by Grantham distances, which are kept for the
+    //lifetime of the object, and by any other schemes, which are kept for
+    //one comparison.
+    codon_pair_table grantham_pairs, weighted_pairs;
+    //L0, L2S, L2V and L4 of each codon, from sitesObj
+    std::array<std::array<double,4>,64> codon_lengths;
+    std::vector<std::int8_t> codons1, codons2;
+    const std::array<double,8> & pair_contributions(codon_pair_table * table,
+						    const int codon1, const int codon2,
+						    const int ndiff,
+						    const WeightingScheme2 *_weights2,
+						    const WeightingScheme3 *_weights3);
+    void diverge(const std::int8_t * c1, const std::int8_t * c2,
+		 const std::size_t ncodons,
 		 const WeightingScheme2 *_weights2,
 		 const WeightingScheme3 *_weights3,
-		 const int maxhits);
-    void omega (const Sites * s,
+		 const int maxhits,
+		 codon_pair_table * table);
+    site_lengths count_sites(const std::int8_t * c1, const std::int8_t * c2,
+			     const std::size_t ncodons,
+			     const int maxhits) const;
+    void omega (const site_lengths * s,
 		const Sequence::Seq & seqobj1, const Sequence::Seq & seqobj2);
+    Com95_t results (const site_lengths * s) const;
     Com95impl(GeneticCodes __code):
       Qs(0.), Bs(0.), Qa(0.), Ba(0.), A2S(0.), A4(0.), As(0.), A2V(0.), A0(0.), Aa(0.),
       q0(0.), q2S(0.), q2V(0.), q4(0.), p0(0.), p2S(0.), p2V(0.), p4(0.),Ka(0.),Ks(0.),
       sitesObj(std::unique_ptr<RedundancyCom95>(new RedundancyCom95(__code))),
-      code(__code)
+      code(__code),grantham_pairs(),weighted_pairs(),codon_lengths(),
+      codons1(),codons2()
     {
+      for (int c = 0; c < 64; ++c)
+	{
+	  const std::string codon = codon_string(c);
+	  codon_lengths[std::size_t(c)] = {{sitesObj->L0_vals(codon),sitesObj->L2S_vals(codon),
+					    sitesObj->L2V_vals(codon),sitesObj->L4_vals(codon)}};
+	}
     }
     
     /*
@@ -125,10 +217,10 @@ namespace Sequence
     double aa (void) const;
     double bs (void) const;
     double ba (void) const;
-    double L0 (const Sites *) const;
-    double L2S (const Sites * ) const;
-    double L2V (const Sites *) const;
-    double L4 (const Sites *) const;
+    double L0 (const site_lengths *) const;
+    double L2S (const site_lengths * ) const;
+    double L2V (const site_lengths *) const;
+    double L4 (const site_lengths *) const;
   };
 
   Comeron95::Comeron95( GeneticCodes code ) : impl(std::unique_ptr<Com95impl>(new Com95impl(code)))
@@ -169,32 +261,119 @@ namespace Sequence
 				const WeightingScheme3 * weights3,
 				int maxdiffs)
   {
-    Sites s(seqa,seqb,(*impl->sitesObj),maxdiffs);
-    impl->diverge(seqa,seqb,weights2,weights3,maxdiffs);
+    Sites sites(seqa,seqb,(*impl->sitesObj),maxdiffs);
+    const site_lengths s{sites.L0(),sites.L2S(),sites.L2V(),sites.L4()};
+    //Grantham weights depend only on the codons and the genetic code,
+    //so they can be reused across comparisons.
+    codon_pair_table * table = &impl->grantham_pairs;
+    if( weights2 == nullptr || weights3 == nullptr ||
+	typeid(*weights2) != typeid(GranthamWeights2) ||
+	typeid(*weights3) != typeid(GranthamWeights3) )
+      {
+	table = &impl->weighted_pairs;
+	table->clear();
+      }
+    encode_codons(seqa,&impl->codons1);
+    encode_codons(seqb,&impl->codons2);
+    impl->diverge(impl->codons1.data(),impl->codons2.data(),
+		  std::min(impl->codons1.size(),impl->codons2.size()),
+		  weights2,weights3,maxdiffs,table);
     impl->omega(&s,seqa,seqb);
-    return Com95_t({{impl->ka(),
-	    impl->ks(),
-	    impl->ratio(),
-	    impl->P0(),
-	    impl->P2S(),
-	    impl->P2V(),
-	    impl->P4(),
-	    impl->Q0(),
-	    impl->Q2S(),
-	    impl->Q2V(),
-	    impl->Q4(),
-	    impl->as(),
-	    impl->aa(),
-	    impl->bs(),
-	    impl->ba(),
-	    impl->L0(&s),
-	    impl->L2S(&s),
-	    impl->L2V(&s),
-	    impl->L4(&s)
+    return impl->results(&s);
+  }
+
+  Com95_t Comeron95::Com95impl::results (const site_lengths * s) const
+  {
+    return Com95_t({{ka(),
+	    ks(),
+	    ratio(),
+	    P0(),
+	    P2S(),
+	    P2V(),
+	    P4(),
+	    Q0(),
+	    Q2S(),
+	    Q2V(),
+	    Q4(),
+	    as(),
+	    aa(),
+	    bs(),
+	    ba(),
+	    L0(s),
+	    L2S(s),
+	    L2V(s),
+	    L4(s)
 	    }});
   }
+
+  std::vector<Com95_t> Comeron95_pairs(const std::vector<const Seq *> & seqs,
+				       int maxdiffs,
+				       GeneticCodes code,
+				       unsigned nthreads)
+  /*!
+    Calculate synonymous and nonsynonymous distances between all pairs of
+    aligned coding sequences
+    \param seqs pointers to the sequences, which must all have the same length
+    \param maxdiffs maximum number of substitutions per codon to allow in the analysis
+    \param code genetic code, see Sequence::GeneticCodes
+    \param nthreads the number of threads to use
+    \return a row-major seqs.size() by seqs.size() matrix.  Entries (i,j) and
+    (j,i), for i < j, both hold the value that Comeron95::operator()(*seqs[i],*seqs[j],maxdiffs)
+    returns, using Grantham weights.  Entry (i,i) compares seqs[i] to itself.
+
+    Each sequence is converted to codons once.  Each thread keeps its own
+    tables of codon pairs, and pairs of sequences are divided among the threads
+    by rows of the matrix.  The output does not depend on \a nthreads.
+    \exception std::invalid_argument if the sequences differ in length or if
+    \a nthreads is 0
+    \ingroup kaks
+  */
+  {
+    if (nthreads == 0)
+      {
+	throw std::invalid_argument("Sequence::Comeron95_pairs -- nthreads must be > 0");
+      }
+    const std::size_t n = seqs.size();
+    for (const Seq * s : seqs)
+      {
+	if (s->length() != seqs.front()->length())
+	  {
+	    throw std::invalid_argument("Sequence::Comeron95_pairs -- sequences of unequal lengths");
+	  }
+      }
+    std::vector<std::vector<std::int8_t> > codons(n);
+    for (std::size_t i = 0; i < n; ++i)
+      {
+	encode_codons(*seqs[i],&codons[i]);
+      }
+    std::vector<Com95_t> rv(n*n);
+    //Worker t does rows t, t + nworkers, etc., which balances
+    //the work when later rows have fewer pairs.  Each worker
+    //keeps its own tables of codon pairs.
+    const std::size_t nworkers = std::min<std::size_t>(nthreads,n);
+    detail::run_workers(nworkers,[&](const std::size_t t)
+      {
+	Comeron95::Com95impl impl(code);
+	GranthamWeights2 w2;
+	GranthamWeights3 w3;
+	for (std::size_t i = t; i < n; i += nworkers)
+	  {
+	    for (std::size_t j = i; j < n; ++j)
+	      {
+		const std::size_t ncodons = codons[i].size();
+		const site_lengths s = impl.count_sites(codons[i].data(),codons[j].data(),
+							ncodons,maxdiffs);
+		impl.diverge(codons[i].data(),codons[j].data(),ncodons,
+			     &w2,&w3,maxdiffs,&impl.grantham_pairs);
+		impl.omega(&s,*seqs[i],*seqs[j]);
+		rv[i*n+j] = rv[j*n+i] = impl.results(&s);
+	      }
+	  }
+      });
+    return rv;
+  }
   
-  void Comeron95::Com95impl::omega (const Sites * s,
+  void Comeron95::Com95impl::omega (const site_lengths * s,
 				    const Sequence::Seq & seqobj1,
 				    const Sequence::Seq & seqobj2)
   /*!
@@ -209,14 +388,14 @@ namespace Sequence
   {
     double log1, log2;
 
-    Qs = (q2V + q4) / (s->L2V() + s->L4());
+    Qs = (q2V + q4) / (s->L2V + s->L4);
 
     if (!std::isfinite (Qs))
       Qs = 0.0;
 
     Bs = (-0.5) * log (1.0 - (2.0 * Qs));
 
-    Qa = (q0 + q2S) / (s->L0() + s->L2S());
+    Qa = (q0 + q2S) / (s->L0 + s->L2S);
 
     if (!std::isfinite (Qa))
       Qa = 0.0;
@@ -234,12 +413,12 @@ namespace Sequence
       }
     
     //calculate numbers of mutation per site type
-    double P2S_site = p2S / s->L2S();
-    double P2V_site = p2V / s->L2V();
-    double P0_site = p0 / s->L0();
-    double Q0_site = q0 / s->L0();
-    double P4_site = p4 / s->L4();
-    double Q4_site = q4 / s->L4();
+    double P2S_site = p2S / s->L2S;
+    double P2V_site = p2V / s->L2V;
+    double P0_site = p0 / s->L0;
+    double Q0_site = q0 / s->L0;
+    double P4_site = p4 / s->L4;
+    double Q4_site = q4 / s->L4;
 
     log1 = std::log (1.0 - (2.0 * P2S_site) - Qa);
     log2 = std::log (1.0 - (2.0 * Qa));
@@ -261,8 +440,8 @@ namespace Sequence
 
     A4 = (-0.5) * log1 + (0.25) * log2;
 
-    As = (s->L2S() * A2S + s->L4() * A4) / (s->L2S() +
-						    s->L4());
+    As = (s->L2S * A2S + s->L4 * A4) / (s->L2S +
+						    s->L4);
 
     log1 = std::log (1.0 - (2.0 * P2V_site) - Qs);
     log2 = std::log (1.0 - (2.0 * Qs));
@@ -283,8 +462,8 @@ namespace Sequence
 
     A0 = (-0.5) * log1 + (0.25) * log2;
 
-    Aa = (s->L2V() * A2V + s->L0() * A0) / (s->L2V() +
-						    s->L0());
+    Aa = (s->L2V * A2V + s->L0 * A0) / (s->L2V +
+						    s->L0);
 
     if (As <= 0.0)
       As = 0.0;
@@ -304,99 +483,115 @@ namespace Sequence
       Ka = std::numeric_limits<double>::quiet_NaN();
   }
 
-  void Comeron95::Com95impl::diverge (const Sequence::Seq & seq1,
-				      const Sequence::Seq & seq2,
+  const std::array<double,8> &
+  Comeron95::Com95impl::pair_contributions(codon_pair_table * table,
+					   const int codon1, const int codon2,
+					   const int ndiff,
+					   const WeightingScheme2 *weights2,
+					   const WeightingScheme3 *weights3)
+  /*!
+    \return the contributions of a pair of different codons to
+    p0, p2S, p2V, p4, q0, q2S, q2V and q4, calculating them
+    if they are not yet in \a table
+  */
+  {
+    const std::size_t pair = std::size_t(64*codon1+codon2);
+    if (!table->filled[pair])
+      {
+	const std::string cod1 = codon_string(codon1), cod2 = codon_string(codon2);
+	if (ndiff == 1)
+	  {
+	    SingleSub Single;
+	    Single(*sitesObj.get(), cod1, cod2);
+	    table->values[pair] = contributions(Single);
+	  }
+	else if (ndiff == 2)
+	  {
+	    TwoSubs Double;
+	    Double(*sitesObj.get(), cod1, cod2, weights2);
+	    table->values[pair] = contributions(Double);
+	  }
+	else
+	  {
+	    ThreeSubs Triple;
+	    Triple(*sitesObj.get(), cod1, cod2, weights3);
+	    table->values[pair] = contributions(Triple);
+	  }
+	table->filled[pair] = 1;
+      }
+    return table->values[pair];
+  }
+
+  site_lengths Comeron95::Com95impl::count_sites (const std::int8_t * c1,
+						  const std::int8_t * c2,
+						  const std::size_t ncodons,
+						  const int maxdiffs) const
+  /*!
+    The numbers of sites of each class compared, calculated
+    as by Sequence::Sites from codons encoded by encode_codons
+  */
+  {
+    site_lengths s{0.,0.,0.,0.};
+    for (std::size_t i = 0; i < ncodons; ++i)
+      {
+	if (c1[i] < 0 || c2[i] < 0)
+	  {
+	    continue;
+	  }
+	const int nc = codon_diffs(c1[i],c2[i]);
+	if (nc == 0 || (maxdiffs <= 3 && nc == 1) ||
+	    (maxdiffs == 2 && nc <= 2) || (maxdiffs == 3 && nc <= 3))
+	  {
+	    const std::array<double,4> & l1 = codon_lengths[std::size_t(c1[i])],
+	      & l2 = codon_lengths[std::size_t(c2[i])];
+	    s.L0 += (l1[0] + l2[0])/2.0;
+	    s.L2S += (l1[1] + l2[1])/2.0;
+	    s.L2V += (l1[2] + l2[2])/2.0;
+	    s.L4 += (l1[3] + l2[3])/2.0;
+	  }
+      }
+    return s;
+  }
+
+  void Comeron95::Com95impl::diverge (const std::int8_t * c1,
+				      const std::int8_t * c2,
+				      const std::size_t ncodons,
 				      const WeightingScheme2 *weights2,
 				      const WeightingScheme3 *weights3,
-				      const int maxdiffs)
+				      const int maxdiffs,
+				      codon_pair_table * table)
   /*!
     go through every aligned, ungapped codon,
     and calculate divergence.  maintains a running sum of divergence
-    statistics stored a private data to the class
+    statistics stored a private data to the class.  Codons are encoded
+    by encode_codons, and the contribution of each pair of codons is
+    looked up in \a table.
   */
   {
-    size_t i, j;
-    size_t length = seq1.length();
-     q0= q2S= q2V= q4= p0= p2S= p2V= p4 = 0.;
-    //the for loop iterates over codons (block of 3 sites)
-    std::string codon1, codon2;
-    codon1.resize (3);
-    codon2.resize (3);
-
-    for (i = 0; i <= (length - 3); i += 3)
+    q0= q2S= q2V= q4= p0= p2S= p2V= p4 = 0.;
+    for (size_t i = 0; i < ncodons; ++i)
       {
-        for (j = 0; j <= 2; ++j)
-          {
-            //assign the next codon from each sequence
-            codon1[j] = char(std::toupper(seq1[i + j]));
-            codon2[j] = char(std::toupper(seq2[i + j]));
-          }
-        if (  std::find_if(codon1.begin(),codon1.end(),ambiguousNucleotide()) == codon1.end() &&
-	      std::find_if(codon2.begin(),codon2.end(),ambiguousNucleotide()) == codon2.end() )
-          {
-            //find out if codons are different
-            if (Different (codon1, codon2))
-              {
-                //find out how many changes there are between the codons
-                int ndiff = NumDiffs (codon1, codon2);
-                if (ndiff == 1)	//if there is just one difference, use the rules for
-                  //codons that only differ at 1 site
-                  {
-                    SingleSub Single;
-                    Single(*sitesObj.get(), codon1, codon2);
-                    p0 += Single.P0 ();
-                    p2S += Single.P2S ();
-                    p2V += Single.P2V ();
-                    p4 += Single.P4 ();
-                    q0 += Single.Q0 ();
-                    q2S += Single.Q2S ();
-                    q2V += Single.Q2V ();
-                    q4 += Single.Q4 ();
-                  }
-
-                if (maxdiffs > 1)
-                  {	//if codons with >1 difference are allowed
-                    //iterate over codons, as above
-
-                    if (Different
-                        (codon1, codon2))
-                      {
-                        ndiff = NumDiffs
-			  (codon1,
-			   codon2);
-                        //cout << "CHECK:NDIFF="<<ndiff<<endl;
-                        if (ndiff == 2
-                            && maxdiffs >= 2)
-                          {	//if codons differ at 2 sites,
-                            //use rules of class TwoSubstitutions
-                            TwoSubs Double;
-                            Double(*sitesObj.get(), codon1, codon2,weights2);
-                            p0 += Double. P0();
-                            p2S += Double.P2S ();
-                            p2V += Double.P2V ();
-                            p4 += Double.P4();
-                            q0 += Double.Q0 ();
-                            q2S += Double.Q2S ();
-                            q2V += Double.Q2V ();
-                            q4 += Double.Q4 ();
-                          }
-                        else if (ndiff == 3 && maxdiffs > 2)
-                          {
-                            ThreeSubs Triple;
-                            Triple(*sitesObj.get(),codon1, codon2,weights3);
-                            p0 += Triple. P0 ();
-                            p2S += Triple.P2S ();
-                            p2V += Triple.P2V ();
-                            p4 += Triple. P4 ();
-                            q0 += Triple.Q0 ();
-                            q2S += Triple.Q2S ();
-                            q2V += Triple.Q2V ();
-                            q4 += Triple.Q4 ();
-                          }
-                      }
-                  }
-              }
-          }
+	const int codon1 = c1[i], codon2 = c2[i];
+	if (codon1 < 0 || codon2 < 0 || codon1 == codon2)
+	  {
+	    continue;
+	  }
+	//codons differing at more than 1 site are only used
+	//if allowed by maxdiffs
+	const int ndiff = codon_diffs(codon1,codon2);
+	if ( ndiff == 1 || (ndiff == 2 && maxdiffs >= 2) || (ndiff == 3 && maxdiffs > 2) )
+	  {
+	    const std::array<double,8> & c = pair_contributions(table,codon1,codon2,ndiff,
+								 weights2,weights3);
+	    p0 += c[0];
+	    p2S += c[1];
+	    p2V += c[2];
+	    p4 += c[3];
+	    q0 += c[4];
+	    q2S += c[5];
+	    q2V += c[6];
+	    q4 += c[7];
+	  }
       }
 
     if (!std::isfinite (p0))
@@ -417,33 +612,33 @@ namespace Sequence
       q4 = 0.0;
   }
 
-  double Comeron95::Com95impl::L0 (const Sites * sites) const
+  double Comeron95::Com95impl::L0 (const site_lengths * sites) const
   /*!
     \return the number of nondegenerate sites compared
   */
   {
-    return sites->L0();
+    return sites->L0;
   }
-  double Comeron95::Com95impl::L2S (const Sites * sites) const
+  double Comeron95::Com95impl::L2S (const site_lengths * sites) const
   /*!
     \return the number of twofold, transitional-degenerate sites compared
   */
   {
-    return sites->L2S();
+    return sites->L2S;
   }
-  double Comeron95::Com95impl::L2V (const Sites * sites) const
+  double Comeron95::Com95impl::L2V (const site_lengths * sites) const
   /*!
     \return the number of twofold, transversional-degenerate sites compared
   */
   {
-    return sites->L2V();
+    return sites->L2V;
   }
-  double Comeron95::Com95impl::L4 (const Sites * sites) const
+  double Comeron95::Com95impl::L4 (const site_lengths * sites) const
   /*!
     \return the number of 4-fold degenerate sites compared
   */
   {
-    return sites->L4();
+    return sites->L4;
   }
 
   double Comeron95::Com95impl::as (void) const
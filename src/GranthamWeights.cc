@@ -47,22 +47,21 @@ namespace Sequence
     //measured by Grantham distances
     double len_path_1 = 0.0, len_path_2 = 0.0;
 
-    string t1 = Translate (codon1.begin(),codon1.end(), code);
-    string t2 = Translate (intermediates[0].begin(),
-			   intermediates[0].end(), code);
-    len_path_1 += gdist ((t1)[0], (t2)[0]);
+    char t1 = TranslateCodon(codon1.c_str(), code);
+    char t2 = TranslateCodon(intermediates[0].c_str(), code);
+    len_path_1 += gdist (t1, t2);
 
-    t1 = Translate (intermediates[0].begin(),intermediates[0].end(), code);
-    t2 = Translate (codon2.begin(),codon2.end(), code);
-    len_path_1 += gdist ((t1)[0], (t2)[0]);
+    t1 = TranslateCodon(intermediates[0].c_str(), code);
+    t2 = TranslateCodon(codon2.c_str(), code);
+    len_path_1 += gdist (t1, t2);
 
-    t1 = Translate (codon1.begin(),codon1.end(), code);
-    t2 = Translate (intermediates[1].begin(),intermediates[1].end(), code);
-    len_path_2 += gdist ((t1)[0], (t2)[0]);
+    t1 = TranslateCodon(codon1.c_str(), code);
+    t2 = TranslateCodon(intermediates[1].c_str(), code);
+    len_path_2 += gdist (t1, t2);
 
-    t1 = Translate (intermediates[1].begin(),intermediates[1].end(), code);
-    t2 = Translate (codon2.begin(),codon2.end(), code);
-    len_path_2 += gdist ((t1)[0], (t2)[0]);
+    t1 = TranslateCodon(intermediates[1].c_str(), code);
+    t2 = TranslateCodon(codon2.c_str(), code);
+    len_path_2 += gdist (t1, t2);
 
     //calculate the weights themselves
     //double w_path1 = 0., w_path2 = 0.,
@@ -101,102 +100,102 @@ namespace Sequence
     double len_path_1 = 0.0, len_path_2 = 0.0, len_path_3 =
       0., len_path_4 = 0., len_path_5 = 0., len_path_6 = 0.;
 
-    string t1 = Translate (codon1.begin(), codon1.end(),code);
-    string t2 = Translate (intermediates[0].begin(), intermediates[0].end(),code);
-    double dist = gdist ((t1)[0],(t2)[0]);
+    char t1 = TranslateCodon(codon1.c_str(), code);
+    char t2 = TranslateCodon(intermediates[0].c_str(), code);
+    double dist = gdist (t1,t2);
     len_path_1 += dist;
 
 
-    t1 = Translate (intermediates[0].begin(), intermediates[0].end(), code);
-    t2 = Translate (intermediates[1].begin(), intermediates[1].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[0].c_str(), code);
+    t2 = TranslateCodon(intermediates[1].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_1 += dist;
 
 
-    t1 = Translate (intermediates[1].begin(), intermediates[1].end(),code);
-    t2 = Translate (codon2.begin(),codon2.end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[1].c_str(), code);
+    t2 = TranslateCodon(codon2.c_str(), code);
+    dist = gdist (t1,t2);
     len_path_1 += dist;
 
     //path2
 
-    t1 = Translate (codon1.begin(),codon1.end(), code);
-    t2 = Translate (intermediates[0].begin(),intermediates[0].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(codon1.c_str(), code);
+    t2 = TranslateCodon(intermediates[0].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_2 += dist;
 
-    t1 = Translate (intermediates[0].begin(),intermediates[0].end(), code);
-    t2 = Translate (intermediates[2].begin(),intermediates[2].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[0].c_str(), code);
+    t2 = TranslateCodon(intermediates[2].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_2 += dist;
 
-    t1 = Translate (intermediates[2].begin(),intermediates[2].end(), code);
-    t2 = Translate (codon2.begin(),codon2.end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[2].c_str(), code);
+    t2 = TranslateCodon(codon2.c_str(), code);
+    dist = gdist (t1,t2);
     len_path_2 += dist;
 
     //path 3
-    t1 = Translate (codon1.begin(),codon1.end(), code);
-    t2 = Translate (intermediates[3].begin(),intermediates[3].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(codon1.c_str(), code);
+    t2 = TranslateCodon(intermediates[3].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_3 += dist;
 
-    t1 = Translate (intermediates[3].begin(), intermediates[3].end(),code);
-    t2 = Translate (intermediates[4].begin(), intermediates[4].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[3].c_str(), code);
+    t2 = TranslateCodon(intermediates[4].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_3 += dist;
 
-    t1 = Translate (intermediates[4].begin(), intermediates[4].end(), code);
-    t2 = Translate (codon2.begin(),codon2.end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[4].c_str(), code);
+    t2 = TranslateCodon(codon2.c_str(), code);
+    dist = gdist (t1,t2);
     len_path_3 += dist;
 
     //path4
-    t1 = Translate (codon1.begin(),codon1.end(), code);
-    t2 = Translate (intermediates[3].begin(), intermediates[3].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(codon1.c_str(), code);
+    t2 = TranslateCodon(intermediates[3].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_4 += dist;
 
-    t1 = Translate (intermediates[3].begin(), intermediates[3].end(), code);
-    t2 = Translate (intermediates[5].begin(), intermediates[5].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[3].c_str(), code);
+    t2 = TranslateCodon(intermediates[5].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_4 += dist;
 
-    t1 = Translate (intermediates[5].begin(), intermediates[5].end(), code);
-    t2 = Translate (codon2.begin(),codon2.end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[5].c_str(), code);
+    t2 = TranslateCodon(codon2.c_str(), code);
+    dist = gdist (t1,t2);
     len_path_4 += dist;
 
     //path 5
-    t1 = Translate (codon1.begin(),codon1.end(), code);
-    t2 = Translate (intermediates[6].begin(), intermediates[6].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(codon1.c_str(), code);
+    t2 = TranslateCodon(intermediates[6].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_5 += dist;
 
-    t1 = Translate (intermediates[6].begin(), intermediates[6].end(), code);
-    t2 = Translate (intermediates[7].begin(), intermediates[7].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[6].c_str(), code);
+    t2 = TranslateCodon(intermediates[7].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_5 += dist;
 
-    t1 = Translate (intermediates[7].begin(), intermediates[7].end(), code);
-    t2 = Translate (codon2.begin(),codon2.end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[7].c_str(), code);
+    t2 = TranslateCodon(codon2.c_str(), code);
+    dist = gdist (t1,t2);
     len_path_5 += dist;
 
     //path 6
-    t1 = Translate (codon1.begin(),codon1.end(), code);
-    t2 = Translate (intermediates[6].begin(), intermediates[6].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(codon1.c_str(), code);
+    t2 = TranslateCodon(intermediates[6].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_6 += dist;
 
-    t1 = Translate (intermediates[6].begin(), intermediates[6].end(), code);
-    t2 = Translate (intermediates[8].begin(), intermediates[8].end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[6].c_str(), code);
+    t2 = TranslateCodon(intermediates[8].c_str(), code);
+    dist = gdist (t1,t2);
     len_path_6 += dist;
 
-    t1 = Translate (intermediates[8].begin(), intermediates[8].end(), code);
-    t2 = Translate (codon2.begin(),codon2.end(), code);
-    dist = gdist ((t1)[0],(t2)[0]);
+    t1 = TranslateCodon(intermediates[8].c_str(), code);
+    t2 = TranslateCodon(codon2.c_str(), code);
+    dist = gdist (t1,t2);
     len_path_6 += dist;
 
     weights3_t __weights;
@@ -28,6 +28,35 @@ long with libsequence.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace
 {
+  //The universal code, indexed by Sequence::CodonIndex
+  const char universal_table[65] =
+    "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLF";
+
+  const char * code_table( const Sequence::GeneticCodes & genetic_code )
+  {
+    switch (genetic_code)
+      {
+      case Sequence::GeneticCodes::UNIVERSAL:
+	return universal_table;
+      default:
+	throw std::runtime_error ("Translate.cc: Translate(), invalid genetic code passed");
+	break;
+      }
+    return nullptr;
+  }
+
+  int base_index(const char c)
+  {
+    switch(c)
+      {
+      case 'A': case 'a': return 0;
+      case 'C': case 'c': return 1;
+      case 'G': case 'g': return 2;
+      case 'T': case 't': return 3;
+      default: return -1;
+      }
+  }
+
   char Universal (const char codon[4],
 		  const char & gapchar)
   {
@@ -220,6 +249,79 @@ namespace
 
 namespace Sequence
 {
+  int CodonIndex(const char * codon)
+  /*!
+    \param codon a pointer to the first of three characters
+    \return the codon encoded as 16*b0+4*b1+b2, where each base is
+    encoded as A=0,C=1,G=2,T=3 (case-insensitive), or -1 if the codon
+    contains any other character.  Codons are therefore numbered
+    in the order AAA,AAC,...,TTT.
+  */
+  {
+    const int a = base_index(codon[0]), b = base_index(codon[1]), c = base_index(codon[2]);
+    return (a < 0 || b < 0 || c < 0) ? -1 : 16*a+4*b+c;
+  }
+
+  char TranslateCodon(const char * codon,
+		      Sequence::GeneticCodes genetic_code,
+		      const char & gapchar)
+  /*!
+    \param codon a pointer to the first of three characters
+    \param genetic_code must be a value from the enumeration list Sequence::GeneticCodes
+    \param gapchar a character representing an alignment gap
+    \return the amino acid encoded by the codon, as for Translate
+    \throw std::runtime_error if \a genetic_code is invalid
+  */
+  {
+    const char * table = code_table(genetic_code);
+    const int i = CodonIndex(codon);
+    if (i >= 0 && base_index(gapchar) < 0)
+      {
+	return table[i];
+      }
+    //Gaps and ambiguous bases
+    const char c[4] = { char(std::toupper(codon[0])),
+			char(std::toupper(codon[1])),
+			char(std::toupper(codon[2])), '\0' };
+    return Universal(c,gapchar);
+  }
+
+  char * Translate(const char * beg, const char * end, char * out,
+		   Sequence::GeneticCodes genetic_code,
+		   const char & gapchar)
+  /*!
+    @brief Translate a range of a CDS into a preallocated buffer
+    \param beg a pointer to the beginning of the region to translate
+    \param end a pointer to 1 past the end of the region to translate
+    \param out a buffer of at least (end-beg)/3 characters
+    \param genetic_code must be a value from the enumeration list Sequence::GeneticCodes
+    \param gapchar a character representing an alignment gap
+    \return a pointer to 1 past the last character written
+    \throw std::runtime_error if \a genetic_code is invalid
+    \note A partial codon at the end of the range is not translated.
+    Codons made up of A,C,G and T are looked up in a table, so
+    that translating a whole sequence, or one sequence after another
+    into the same buffer, costs one table lookup per codon:
+    \code
+    std::vector<char> peptides(ncodons*sequences.size());
+    char * out = peptides.data();
+    for( const auto & s : sequences )
+    {
+    out = Sequence::Translate(s.c_str(),s.c_str()+3*ncodons,out);
+    }
+    \endcode
+  */
+  {
+    const char * table = code_table(genetic_code);
+    const bool gap_is_base = (base_index(gapchar) >= 0);
+    for( ; end - beg >= 3 ; beg += 3, ++out )
+      {
+	const int i = CodonIndex(beg);
+	*out = (i >= 0 && !gap_is_base) ? table[i] : TranslateCodon(beg,genetic_code,gapchar);
+      }
+    return out;
+  }
+
   std::string Translate(std::string::const_iterator beg,
 			std::string::const_iterator end,
 			Sequence::GeneticCodes genetic_code,
@@ -230,25 +332,8 @@ namespace Sequence
     if (beg > (end-3)) //if the range is less than 3 in length (1 codon), return an empty string
       return std::string();
 
-    std::string translation;
-    char codon[4];
-    codon[3] = '\0'; //null terminate for cleanliness
-    while(beg < end)
-      {
-        codon[0] = char(std::toupper(*beg));
-        codon[1] = char(std::toupper(*(beg+1)));
-        codon[2] = char(std::toupper(*(beg+2)));
-        switch (genetic_code)
-          {
-          case GeneticCodes::UNIVERSAL:
-            translation += Universal (codon,gapchar);
-            break;
-          default:
-            throw std::runtime_error ("Translate.cc: Translate(), invalid genetic code passed");
-            break;
-          }
-        beg += 3;
-      }
+    std::string translation(std::string::size_type((end-beg)/3),'\0');
+    Translate(&*beg,&*beg+(end-beg),&translation[0],genetic_code,gapchar);
     return translation;
   }
 
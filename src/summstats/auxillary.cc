@@ -1,5 +1,57 @@
 #include <cstdint>
 #include <cmath>
+#include <limits>
+#include <vector>
+#include <Sequence/summstats/auxillary.hpp>
+
+namespace
+{
+    // Sample sizes up to this value use the cached sums.
+    constexpr std::uint32_t MAX_CACHED_NSAM = 1u << 18;
+
+    class harmonic_sums
+    // a[n] and b[n] are a_sub_n(n) and b_sub_n(n).  Terms are
+    // added in the same order as the loops below, so the cached
+    // values are identical to the calculated ones.
+    {
+      private:
+        std::vector<double> a, b;
+
+      public:
+        harmonic_sums() : a(2, 0.0), b(2, 0.0) {}
+
+        const harmonic_sums&
+        extend(const std::uint32_t n)
+        {
+            while (a.size() <= n)
+                {
+                    const auto i = static_cast<double>(a.size() - 1);
+                    a.push_back(a.back() + 1.0 / i);
+                    b.push_back(b.back() + 1.0 / std::pow(i, 2.0));
+                }
+            return *this;
+        }
+
+        double
+        a_sub_n(const std::uint32_t n) const
+        {
+            return a[n];
+        }
+
+        double
+        b_sub_n(const std::uint32_t n) const
+        {
+            return b[n];
+        }
+    };
+
+    const harmonic_sums&
+    cached_sums(const std::uint32_t n)
+    {
+        thread_local harmonic_sums sums;
+        return sums.extend(n);
+    }
+} // namespace
 
 namespace Sequence
 {
@@ -8,6 +60,10 @@ namespace Sequence
         double
         a_sub_n(const std::uint32_t nsam)
         {
+            if (nsam <= MAX_CACHED_NSAM)
+                {
+                    return cached_sums(nsam).a_sub_n(nsam);
+                }
             double rv = 0.0;
             for (std::uint32_t i = 1; i < nsam; ++i)
                 {
@@ -19,6 +75,10 @@ namespace Sequence
         double
         b_sub_n(const std::uint32_t nsam)
         {
+            if (nsam <= MAX_CACHED_NSAM)
+                {
+                    return cached_sums(nsam).b_sub_n(nsam);
+                }
             double rv = 0.0;
             for (std::uint32_t i = 1; i < nsam; ++i)
                 {
@@ -30,6 +90,10 @@ namespace Sequence
         double
         b_sub_n_plus1(const std::uint32_t nsam)
         {
+            if (nsam < MAX_CACHED_NSAM)
+                {
+                    return cached_sums(nsam + 1).b_sub_n(nsam + 1);
+                }
             double rv = 0.0;
             for (std::uint32_t i = 1; i < nsam + 1; ++i)
                 {
@@ -37,5 +101,59 @@ namespace Sequence
                 }
             return rv;
         }
+
+        double
+        tajd(const double pi, const double S, const std::uint32_t nsam)
+        {
+            if (!S)
+                {
+                    return std::numeric_limits<double>::quiet_NaN();
+                }
+            auto a1 = a_sub_n(nsam);
+            double w = S / a1;
+            auto a2 = b_sub_n(nsam);
+            auto dn = static_cast<double>(nsam);
+            double b1 = (dn + 1.0) / (3.0 * (dn - 1.0));
+            double b2 = (2.0 * (std::pow(dn, 2.0) + dn + 3.0))
+                        / (9.0 * dn * (dn - 1.0));
+            double c1 = b1 - 1.0 / a1;
+            double c2 = b2 - (dn + 2.0) / (a1 * dn) + a2 / std::pow(a1, 2.0);
+            double e1 = c1 / a1;
+            double e2 = c2 / (std::pow(a1, 2.0) + a2);
+            double denominator
+                = std::pow((e1 * S + e2 * S * (S - 1.0)), 0.5);
+            return (pi - w) / denominator;
+        }
+
+        double
+        hprime(const std::uint32_t nsam, const unsigned S, const double tp,
+               const double tl)
+        {
+            if (tp == 0.0)
+                {
+                    return std::numeric_limits<double>::quiet_NaN();
+                }
+            auto a = a_sub_n(nsam);
+            auto b = b_sub_n(nsam);
+            auto b1 = b_sub_n_plus1(nsam);
+
+            double tw = static_cast<double>(S) / a;
+            double tsq = S * (S - 1) / (a * a + b);
+            double n = static_cast<double>(nsam);
+
+            double vThetal = (n * tw) / (2.0 * (n - 1.0))
+                             + (2.0 * std::pow(n / (n - 1.0), 2.0) * (b1 - 1.0)
+                                - 1.0)
+                                   * tsq;
+            double vPi
+                = (3.0 * n * (n + 1.0) * tw + 2.0 * (n * n + n + 3.0) * tsq)
+                  / (9 * n * (n - 1.0));
+            double cov
+                = ((n + 1.0) / (3.0 * (n - 1.0))) * tw
+                  + ((7.0 * n * n + 3.0 * n - 2.0 - 4.0 * n * (n + 1.0) * b1)
+                     / (2.0 * std::pow((n - 1.0), 2.0)))
+                        * tsq;
+            return (tp - tl) / std::pow(vThetal + vPi - 2.0 * cov, 0.5);
+        }
     } // namespace summstats_aux
 } // namespace Sequence
@@ -0,0 +1,281 @@
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include "bitpacked_kernels.hpp"
+#include "popcount.hpp"
+
+namespace
+{
+    using word_type = Sequence::BitPackedGenotypeCapsule::word_type;
+    constexpr std::size_t word_bits
+        = Sequence::BitPackedGenotypeCapsule::word_bits;
+
+    using Sequence::summstats_details::popcount;
+
+    inline std::size_t
+    count_trailing_zeros(const word_type x)
+    // precondition: x != 0
+    {
+#if defined(__GNUC__)
+        return static_cast<std::size_t>(__builtin_ctzll(x));
+#else
+        std::size_t rv = 0;
+        while (!((x >> rv) & 1))
+            {
+                ++rv;
+            }
+        return rv;
+#endif
+    }
+
+    inline word_type
+    tail_mask(const std::size_t nsam)
+    // Mask for the used bits of the last word of a row
+    {
+        return (nsam % word_bits) ? (word_type(1) << (nsam % word_bits)) - 1
+                                  : ~word_type(0);
+    }
+
+    inline word_type
+    state_mask(const word_type bits, const word_type missing,
+               const std::int8_t state, const word_type tail)
+    // Bits set where a row has state 0, 1, or -1 (missing)
+    {
+        if (state == 1)
+            {
+                return bits;
+            }
+        if (state < 0)
+            {
+                return missing;
+            }
+        return ~(bits | missing) & tail;
+    }
+
+    LIBSEQUENCE_POPCNT_CLONES
+    void
+    count_rows(const Sequence::BitPackedGenotypeCapsule& g,
+               std::vector<std::int32_t>& ones,
+               std::vector<std::int32_t>& nmissing)
+    {
+        const auto nwords = g.words_per_row();
+        for (std::size_t site = 0; site < g.nsites(); ++site)
+            {
+                const auto b = g.row_bits(site);
+                const auto m = g.row_missing(site);
+                std::int32_t o = 0, mi = 0;
+                for (std::size_t w = 0; w < nwords; ++w)
+                    {
+                        o += popcount(b[w]);
+                        mi += popcount(m[w]);
+                    }
+                ones[site] = o;
+                nmissing[site] = mi;
+            }
+    }
+
+    LIBSEQUENCE_POPCNT_CLONES
+    void
+    pairwise_differences(const std::vector<word_type>& hbits,
+                         const std::vector<word_type>& hmissing,
+                         const std::size_t nsam, const std::size_t nwords,
+                         const bool has_missing,
+                         std::vector<std::int32_t>& rv)
+    {
+        for (std::size_t i = 0; i < nsam - 1; ++i)
+            {
+                const word_type* bi = hbits.data() + i * nwords;
+                const word_type* mi = hmissing.data() + i * nwords;
+                for (std::size_t j = i + 1; j < nsam; ++j)
+                    {
+                        const word_type* bj = hbits.data() + j * nwords;
+                        std::int32_t ndiffs = 0;
+                        if (has_missing)
+                            {
+                                const word_type* mj
+                                    = hmissing.data() + j * nwords;
+                                for (std::size_t w = 0; w < nwords; ++w)
+                                    {
+                                        ndiffs += popcount((bi[w] ^ bj[w])
+                                                           & ~(mi[w] | mj[w]));
+                                    }
+                            }
+                        else
+                            {
+                                for (std::size_t w = 0; w < nwords; ++w)
+                                    {
+                                        ndiffs += popcount(bi[w] ^ bj[w]);
+                                    }
+                            }
+                        rv.push_back(ndiffs);
+                    }
+            }
+    }
+
+    struct first_seen
+    {
+        std::int8_t i, j;
+        int n;
+        std::size_t first;
+    };
+
+    LIBSEQUENCE_POPCNT_CLONES
+    void
+    count_two_locus(const Sequence::BitPackedGenotypeCapsule& g,
+                    const std::size_t sitei, const std::size_t sitej,
+                    const bool skip_missing, std::vector<first_seen>& rv)
+    {
+        static const std::int8_t states[3] = { 0, 1, -1 };
+        const auto nwords = g.words_per_row();
+        const auto tail = tail_mask(g.nsam());
+        const auto bi = g.row_bits(sitei), mi = g.row_missing(sitei);
+        const auto bj = g.row_bits(sitej), mj = g.row_missing(sitej);
+        for (auto a : states)
+            {
+                for (auto b : states)
+                    {
+                        if (skip_missing && a < 0 && b < 0)
+                            {
+                                continue;
+                            }
+                        first_seen f{ a, b, 0,
+                                      std::numeric_limits<std::size_t>::max() };
+                        for (std::size_t w = 0; w < nwords; ++w)
+                            {
+                                const word_type t = (w == nwords - 1)
+                                                        ? tail
+                                                        : ~word_type(0);
+                                const word_type x
+                                    = state_mask(bi[w], mi[w], a, t)
+                                      & state_mask(bj[w], mj[w], b, t);
+                                if (x)
+                                    {
+                                        f.n += popcount(x);
+                                        if (f.first
+                                            == std::numeric_limits<
+                                                std::size_t>::max())
+                                            {
+                                                f.first
+                                                    = w * word_bits
+                                                      + count_trailing_zeros(
+                                                          x);
+                                            }
+                                    }
+                            }
+                        if (f.n)
+                            {
+                                rv.push_back(f);
+                            }
+                    }
+            }
+    }
+} // namespace
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        std::vector<std::int32_t>
+        bitpacked_allele_counts(const BitPackedGenotypeCapsule& g,
+                                const std::size_t ncol)
+        {
+            std::vector<std::int32_t> ones(g.nsites()), nmissing(g.nsites());
+            count_rows(g, ones, nmissing);
+            std::vector<std::int32_t> counts;
+            counts.reserve(g.nsites() * ncol);
+            const auto nsam = static_cast<std::int32_t>(g.nsam());
+            for (std::size_t site = 0; site < g.nsites(); ++site)
+                {
+                    if (ones[site] && ncol < 2)
+                        {
+                            throw std::runtime_error(
+                                "found allele value greater "
+                                "than matrix.max_allele");
+                        }
+                    counts.push_back(nsam - ones[site] - nmissing[site]);
+                    for (std::size_t j = 1; j < ncol; ++j)
+                        {
+                            counts.push_back((j == 1) ? ones[site] : 0);
+                        }
+                }
+            return counts;
+        }
+
+        std::vector<std::int32_t>
+        bitpacked_difference_matrix(const BitPackedGenotypeCapsule& g)
+        {
+            std::vector<std::int32_t> rv;
+            const std::size_t nsam = g.nsam();
+            if (nsam < 2)
+                {
+                    return rv;
+                }
+            rv.reserve(nsam * (nsam - 1) / 2);
+            // Transpose into one bit set per haplotype so
+            // that comparing two samples is a run of popcounts
+            // over contiguous words.
+            const std::size_t nwords = g.nsites() / word_bits
+                                       + (g.nsites() % word_bits != 0);
+            std::vector<word_type> hbits(nsam * nwords, 0),
+                hmissing(g.has_missing() ? nsam * nwords : 0, 0);
+            for (std::size_t site = 0; site < g.nsites(); ++site)
+                {
+                    const word_type bit = word_type(1) << (site % word_bits);
+                    const std::size_t offset = site / word_bits;
+                    const auto b = g.row_bits(site);
+                    const auto m = g.row_missing(site);
+                    for (std::size_t w = 0; w < g.words_per_row(); ++w)
+                        {
+                            for (word_type x = b[w]; x; x &= x - 1)
+                                {
+                                    auto sample = w * word_bits
+                                                  + count_trailing_zeros(x);
+                                    hbits[sample * nwords + offset] |= bit;
+                                }
+                            if (g.has_missing())
+                                {
+                                    for (word_type x = m[w]; x; x &= x - 1)
+                                        {
+                                            auto sample
+                                                = w * word_bits
+                                                  + count_trailing_zeros(x);
+                                            hmissing[sample * nwords + offset]
+                                                |= bit;
+                                        }
+                                }
+                        }
+                }
+            pairwise_differences(hbits, hmissing, nsam, nwords,
+                                 g.has_missing(), rv);
+            return rv;
+        }
+
+        std::vector<TwoLocusCounts>
+        bitpacked_two_locus_haplotype_counts(
+            const BitPackedGenotypeCapsule& g, const std::size_t sitei,
+            const std::size_t sitej, const bool skip_missing)
+        {
+            if (sitei >= g.nsites() || sitej >= g.nsites())
+                {
+                    throw std::out_of_range("row index out of range");
+                }
+            std::vector<first_seen> counts;
+            count_two_locus(g, sitei, sitej, skip_missing, counts);
+            // Report haplotypes in the order in which they
+            // are first seen, as the generic implementation does.
+            std::sort(counts.begin(), counts.end(),
+                      [](const first_seen& a, const first_seen& b) {
+                          return a.first < b.first;
+                      });
+            std::vector<TwoLocusCounts> rv;
+            rv.reserve(counts.size());
+            for (auto& c : counts)
+                {
+                    rv.emplace_back(c.i, c.j, c.n);
+                }
+            return rv;
+        }
+    } // namespace summstats_details
+} // namespace Sequence
@@ -0,0 +1,43 @@
+#ifndef SEQUENCE_SUMMSTATS_BITPACKED_KERNELS_HPP
+#define SEQUENCE_SUMMSTATS_BITPACKED_KERNELS_HPP
+
+// These functions are not exported.
+// They are used internally.
+
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/BitPackedCapsules.hpp>
+#include <Sequence/summstats/ld.hpp>
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        inline const BitPackedGenotypeCapsule*
+        as_bitpacked(const VariantMatrix& m)
+        /// Returns nullptr unless m stores its genotypes
+        /// in a BitPackedGenotypeCapsule.
+        {
+            return dynamic_cast<const BitPackedGenotypeCapsule*>(
+                m.genotype_capsule());
+        }
+
+        /// Counts for AlleleCountMatrix.  ncol is max_allele + 1.
+        std::vector<std::int32_t>
+        bitpacked_allele_counts(const BitPackedGenotypeCapsule& g,
+                                const std::size_t ncol);
+
+        /// Same output as Sequence::difference_matrix
+        std::vector<std::int32_t>
+        bitpacked_difference_matrix(const BitPackedGenotypeCapsule& g);
+
+        /// Same output as Sequence::two_locus_haplotype_counts,
+        /// except that all missing data are reported as -1.
+        std::vector<TwoLocusCounts> bitpacked_two_locus_haplotype_counts(
+            const BitPackedGenotypeCapsule& g, const std::size_t sitei,
+            const std::size_t sitej, const bool skip_missing);
+    } // namespace summstats_details
+} // namespace Sequence
+
+#endif
@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/HaplotypeMajorCapsules.hpp>
+#include "difference_kernels.hpp"
+
+// On x86-64, the inner loop is written for SSE2, which all such
+// CPUs have, and for AVX2.  The AVX2 version is used if the CPU
+// running the code supports it.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define LIBSEQUENCE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Counts are kept in bytes for up to this many sites
+    // before being added to the output.
+    constexpr std::size_t SITE_BLOCK = 255;
+    // The number of samples compared to sample i per tile.
+    // SITE_BLOCK*SAMPLE_BLOCK bytes of genotypes should fit
+    // in L2 cache.
+    constexpr std::size_t SAMPLE_BLOCK = 1024;
+    // For haplotype-major data, the number of bytes of all
+    // haplotypes compared per block of sites.
+    constexpr std::size_t HAPLOTYPE_BLOCK_BYTES = 256 * 1024;
+
+    using count_kernel = void (*)(const std::int8_t*, const std::size_t,
+                                  const std::int8_t, std::uint8_t*);
+
+    void
+    count_differences_scalar(const std::int8_t* row, const std::size_t n,
+                             const std::int8_t x, std::uint8_t* counts)
+    // counts[k] += 1 if row[k] is not missing and differs from x.
+    // precondition: x >= 0
+    {
+        for (std::size_t k = 0; k < n; ++k)
+            {
+                counts[k] = static_cast<std::uint8_t>(
+                    counts[k] + (row[k] != x && row[k] >= 0));
+            }
+    }
+
+#ifdef LIBSEQUENCE_X86_KERNELS
+    void
+    count_differences_sse2(const std::int8_t* row, const std::size_t n,
+                           const std::int8_t x, std::uint8_t* counts)
+    {
+        const __m128i vx = _mm_set1_epi8(x);
+        const __m128i minus_one = _mm_set1_epi8(-1);
+        std::size_t k = 0;
+        for (; k + 16 <= n; k += 16)
+            {
+                __m128i v = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(row + k));
+                // All bits set where v != x and v >= 0
+                __m128i d = _mm_andnot_si128(_mm_cmpeq_epi8(v, vx),
+                                             _mm_cmpgt_epi8(v, minus_one));
+                __m128i c = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(counts + k));
+                // Subtracting -1 adds one
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(counts + k),
+                                 _mm_sub_epi8(c, d));
+            }
+        count_differences_scalar(row + k, n - k, x, counts + k);
+    }
+
+    __attribute__((target("avx2"))) void
+    count_differences_avx2(const std::int8_t* row, const std::size_t n,
+                           const std::int8_t x, std::uint8_t* counts)
+    {
+        const __m256i vx = _mm256_set1_epi8(x);
+        const __m256i minus_one = _mm256_set1_epi8(-1);
+        std::size_t k = 0;
+        for (; k + 32 <= n; k += 32)
+            {
+                __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(row + k));
+                __m256i d
+                    = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, vx),
+                                          _mm256_cmpgt_epi8(v, minus_one));
+                __m256i c = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(counts + k));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(counts + k),
+                                    _mm256_sub_epi8(c, d));
+            }
+        count_differences_sse2(row + k, n - k, x, counts + k);
+    }
+#endif
+
+    using pair_kernel = std::int32_t (*)(const std::int8_t*,
+                                         const std::int8_t*,
+                                         const std::size_t);
+
+    std::int32_t
+    count_pair_differences_scalar(const std::int8_t* a, const std::int8_t* b,
+                                  const std::size_t n)
+    // The number of k where a[k] and b[k] differ and neither is missing.
+    {
+        std::int32_t rv = 0;
+        for (std::size_t k = 0; k < n; ++k)
+            {
+                rv += (a[k] != b[k] && a[k] >= 0 && b[k] >= 0);
+            }
+        return rv;
+    }
+
+#ifdef LIBSEQUENCE_X86_KERNELS
+    std::int32_t
+    count_pair_differences_sse2(const std::int8_t* a, const std::int8_t* b,
+                                const std::size_t n)
+    {
+        const __m128i minus_one = _mm_set1_epi8(-1);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i total = zero;
+        const std::size_t nfull = n - n % 16;
+        std::size_t k = 0;
+        while (k < nfull)
+            {
+                // Byte counts are summed into total
+                // before they can overflow.
+                const std::size_t stop = std::min(nfull, k + 255 * 16);
+                __m128i counts = zero;
+                for (; k < stop; k += 16)
+                    {
+                        __m128i va = _mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(a + k));
+                        __m128i vb = _mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(b + k));
+                        __m128i valid
+                            = _mm_and_si128(_mm_cmpgt_epi8(va, minus_one),
+                                            _mm_cmpgt_epi8(vb, minus_one));
+                        counts = _mm_sub_epi8(
+                            counts, _mm_andnot_si128(_mm_cmpeq_epi8(va, vb),
+                                                     valid));
+                    }
+                total = _mm_add_epi64(total, _mm_sad_epu8(counts, zero));
+            }
+        return static_cast<std::int32_t>(
+                   _mm_cvtsi128_si64(total)
+                   + _mm_cvtsi128_si64(_mm_unpackhi_epi64(total, total)))
+               + count_pair_differences_scalar(a + k, b + k, n - k);
+    }
+
+    __attribute__((target("avx2"))) std::int32_t
+    count_pair_differences_avx2(const std::int8_t* a, const std::int8_t* b,
+                                const std::size_t n)
+    {
+        const __m256i minus_one = _mm256_set1_epi8(-1);
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i total = zero;
+        const std::size_t nfull = n - n % 32;
+        std::size_t k = 0;
+        while (k < nfull)
+            {
+                const std::size_t stop = std::min(nfull, k + 255 * 32);
+                __m256i counts = zero;
+                for (; k < stop; k += 32)
+                    {
+                        __m256i va = _mm256_loadu_si256(
+                            reinterpret_cast<const __m256i*>(a + k));
+                        __m256i vb = _mm256_loadu_si256(
+                            reinterpret_cast<const __m256i*>(b + k));
+                        __m256i valid = _mm256_and_si256(
+                            _mm256_cmpgt_epi8(va, minus_one),
+                            _mm256_cmpgt_epi8(vb, minus_one));
+                        counts = _mm256_sub_epi8(
+                            counts, _mm256_andnot_si256(
+                                        _mm256_cmpeq_epi8(va, vb), valid));
+                    }
+                total = _mm256_add_epi64(total,
+                                         _mm256_sad_epu8(counts, zero));
+            }
+        __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(total),
+                                    _mm256_extracti128_si256(total, 1));
+        return static_cast<std::int32_t>(
+                   _mm_cvtsi128_si64(sum)
+                   + _mm_cvtsi128_si64(_mm_unpackhi_epi64(sum, sum)))
+               + count_pair_differences_sse2(a + k, b + k, n - k);
+    }
+#endif
+
+    pair_kernel
+    select_pair_kernel()
+    {
+#ifdef LIBSEQUENCE_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            {
+                return count_pair_differences_avx2;
+            }
+        return count_pair_differences_sse2;
+#else
+        return count_pair_differences_scalar;
+#endif
+    }
+
+    count_kernel
+    select_kernel()
+    {
+#ifdef LIBSEQUENCE_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            {
+                return count_differences_avx2;
+            }
+        return count_differences_sse2;
+#else
+        return count_differences_scalar;
+#endif
+    }
+} // namespace
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        std::vector<std::int32_t>
+        tiled_difference_matrix(const VariantMatrix& m)
+        {
+            static const count_kernel count_differences = select_kernel();
+            const std::size_t n = m.nsam();
+            std::vector<std::int32_t> rv(n * (n - 1) / 2, 0);
+            // Offset of pair (i, i+1) in rv
+            std::vector<std::size_t> pair_offset(n, 0);
+            for (std::size_t i = 1; i < n; ++i)
+                {
+                    pair_offset[i] = pair_offset[i - 1] + (n - i);
+                }
+            const auto g = get_ConstGenotypeSpan(m);
+            std::vector<const std::int8_t*> rows(SITE_BLOCK);
+            std::vector<std::uint8_t> counts(SAMPLE_BLOCK);
+            for (std::size_t site = 0; site < g.nsites; site += SITE_BLOCK)
+                {
+                    const std::size_t nrows
+                        = std::min(SITE_BLOCK, g.nsites - site);
+                    for (std::size_t r = 0; r < nrows; ++r)
+                        {
+                            rows[r] = g.row(site + r).data;
+                        }
+                    for (std::size_t jbeg = 1; jbeg < n; jbeg += SAMPLE_BLOCK)
+                        {
+                            const std::size_t jend
+                                = std::min(n, jbeg + SAMPLE_BLOCK);
+                            for (std::size_t i = 0; i + 1 < jend; ++i)
+                                {
+                                    const std::size_t j = std::max(jbeg, i + 1);
+                                    const std::size_t len = jend - j;
+                                    std::fill(counts.begin(),
+                                              counts.begin()
+                                                  + static_cast<std::ptrdiff_t>(
+                                                        len),
+                                              0);
+                                    for (std::size_t r = 0; r < nrows; ++r)
+                                        {
+                                            const std::int8_t x = rows[r][i];
+                                            if (x >= 0)
+                                                {
+                                                    count_differences(
+                                                        rows[r] + j, len, x,
+                                                        counts.data());
+                                                }
+                                        }
+                                    auto out = rv.begin()
+                                               + static_cast<std::ptrdiff_t>(
+                                                     pair_offset[i] + j - i
+                                                     - 1);
+                                    for (std::size_t k = 0; k < len;
+                                         ++k, ++out)
+                                        {
+                                            *out += counts[k];
+                                        }
+                                }
+                        }
+                }
+            return rv;
+        }
+
+        std::vector<std::int32_t>
+        haplotype_difference_matrix(const HaplotypeMajorGenotypeCapsule& g)
+        {
+            static const pair_kernel count_differences
+                = select_pair_kernel();
+            const std::size_t n = g.nsam(), nsites = g.nsites();
+            std::vector<std::int32_t> rv(n * (n - 1) / 2, 0);
+            // Blocks of sites are chosen so that the block of
+            // every haplotype fits in L2 cache.
+            const std::size_t block = std::max(
+                std::size_t(64), HAPLOTYPE_BLOCK_BYTES / n / 64 * 64);
+            for (std::size_t site = 0; site < nsites; site += block)
+                {
+                    const std::size_t len = std::min(block, nsites - site);
+                    auto out = rv.begin();
+                    for (std::size_t i = 0; i + 1 < n; ++i)
+                        {
+                            const std::int8_t* hi
+                                = g.haplotype_data(i) + site;
+                            for (std::size_t j = i + 1; j < n; ++j, ++out)
+                                {
+                                    *out += count_differences(
+                                        hi, g.haplotype_data(j) + site, len);
+                                }
+                        }
+                }
+            return rv;
+        }
+    } // namespace summstats_details
+} // namespace Sequence
@@ -0,0 +1,30 @@
+#ifndef SEQUENCE_SUMMSTATS_DIFFERENCE_KERNELS_HPP
+#define SEQUENCE_SUMMSTATS_DIFFERENCE_KERNELS_HPP
+
+// These functions are not exported.
+// They are used internally.
+
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/HaplotypeMajorCapsules.hpp>
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        /// Same output as Sequence::difference_matrix, calculated
+        /// in tiles of sites by samples from the rows of \a m.
+        /// precondition: m.nsam() > 1
+        std::vector<std::int32_t>
+        tiled_difference_matrix(const VariantMatrix& m);
+
+        /// Same output as Sequence::difference_matrix, comparing
+        /// contiguous haplotypes in blocks of sites.
+        /// precondition: g.nsam() > 1
+        std::vector<std::int32_t>
+        haplotype_difference_matrix(const HaplotypeMajorGenotypeCapsule& g);
+    } // namespace summstats_details
+} // namespace Sequence
+
+#endif
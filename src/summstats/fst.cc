@@ -0,0 +1,416 @@
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <Sequence/summstats/fst.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+
+namespace
+{
+    enum pair_flag : std::uint8_t
+    {
+        SHARED = 1,
+        FIXED = 2,
+        PRIVATE1 = 4,
+        PRIVATE2 = 8
+    };
+
+    class site_contributions
+    // What one site adds to the diversity within each population
+    // and between each pair of populations, and how the states of
+    // each pair of populations overlap.
+    {
+      public:
+        const std::size_t npop, ncol;
+        // Allele counts for the current site, npop rows of ncol
+        std::vector<std::int32_t> counts;
+        std::vector<double> within, between;
+        std::vector<std::uint8_t> flags;
+
+        site_contributions(const std::size_t npop_, const std::size_t ncol_)
+            : npop{ npop_ }, ncol{ ncol_ }, counts(npop_ * ncol_, 0),
+              within(npop_, 0.0), between(npop_ * (npop_ - 1) / 2, 0.0),
+              flags(between.size(), 0), n(npop_, 0), nstates(npop_, 0)
+        {
+        }
+
+        void
+        update()
+        // Call after filling counts
+        {
+            for (std::size_t i = 0; i < npop; ++i)
+                {
+                    const std::int32_t* c = counts.data() + i * ncol;
+                    std::int32_t ni = 0;
+                    unsigned k = 0;
+                    double homozygosity = 0.0;
+                    for (std::size_t a = 0; a < ncol; ++a)
+                        {
+                            ni += c[a];
+                            k += (c[a] > 0);
+                            homozygosity
+                                += static_cast<double>(c[a] * (c[a] - 1));
+                        }
+                    n[i] = ni;
+                    nstates[i] = k;
+                    within[i] = (ni > 1) ? 1.0
+                                               - homozygosity
+                                                     / static_cast<double>(
+                                                         ni * (ni - 1))
+                                         : 0.0;
+                }
+            std::size_t p = 0;
+            for (std::size_t i = 0; i + 1 < npop; ++i)
+                {
+                    for (std::size_t j = i + 1; j < npop; ++j, ++p)
+                        {
+                            pair_contribution(i, j, p);
+                        }
+                }
+        }
+
+      private:
+        std::vector<std::int32_t> n;
+        std::vector<unsigned> nstates;
+
+        void
+        pair_contribution(const std::size_t i, const std::size_t j,
+                          const std::size_t p)
+        {
+            between[p] = 0.0;
+            flags[p] = 0;
+            if (!n[i] || !n[j])
+                {
+                    return;
+                }
+            const std::int32_t *ci = counts.data() + i * ncol,
+                               *cj = counts.data() + j * ncol;
+            const double ni = static_cast<double>(n[i]),
+                         nj = static_cast<double>(n[j]);
+            unsigned nshared = 0;
+            for (std::size_t a = 0; a < ncol; ++a)
+                {
+                    if (ci[a] > 0)
+                        {
+                            between[p] += (static_cast<double>(ci[a]) / ni)
+                                          * (static_cast<double>(n[j] - cj[a])
+                                             / nj);
+                            nshared += (cj[a] > 0);
+                        }
+                }
+            if (nshared == 0)
+                {
+                    flags[p] |= FIXED;
+                }
+            else if (nstates[i] > 1 && nstates[j] > 1)
+                {
+                    flags[p] |= SHARED;
+                }
+            if (nstates[i] > 1 && nstates[i] > nshared)
+                {
+                    flags[p] |= PRIVATE1;
+                }
+            if (nstates[j] > 1 && nstates[j] > nshared)
+                {
+                    flags[p] |= PRIVATE2;
+                }
+        }
+    };
+
+    class differentiation_totals
+    // Sums of site contributions.  Sites can be removed, for windows.
+    {
+      private:
+        std::size_t npop;
+        std::vector<double> within, between;
+        std::vector<std::uint32_t> nflags;
+
+        template <typename T>
+        void
+        update(const T& within_, const T& between_,
+               const std::uint8_t* flags, const int sign)
+        {
+            for (std::size_t i = 0; i < within.size(); ++i)
+                {
+                    within[i] += sign * within_[i];
+                }
+            for (std::size_t p = 0; p < between.size(); ++p)
+                {
+                    between[p] += sign * between_[p];
+                    for (unsigned f = 0; f < 4; ++f)
+                        {
+                            if (flags[p] & (1u << f))
+                                {
+                                    nflags[4 * p + f] += static_cast<
+                                        std::uint32_t>(sign);
+                                }
+                        }
+                }
+        }
+
+      public:
+        explicit differentiation_totals(const std::size_t npop_)
+            : npop{ npop_ }, within(npop_, 0.0),
+              between(npop_ * (npop_ - 1) / 2, 0.0),
+              nflags(4 * between.size(), 0)
+        {
+        }
+
+        void
+        add(const site_contributions& c)
+        {
+            update(c.within, c.between, c.flags.data(), 1);
+        }
+
+        template <typename T>
+        void
+        remove(const T& within_, const T& between_,
+               const std::uint8_t* flags)
+        {
+            update(within_, between_, flags, -1);
+        }
+
+        std::vector<Sequence::PopulationDifferentiation>
+        results() const
+        {
+            std::vector<Sequence::PopulationDifferentiation> rv;
+            rv.reserve(between.size());
+            std::size_t p = 0;
+            for (std::size_t i = 0; i + 1 < npop; ++i)
+                {
+                    for (std::size_t j = i + 1; j < npop; ++j, ++p)
+                        {
+                            Sequence::PopulationDifferentiation d;
+                            d.pop1 = i;
+                            d.pop2 = j;
+                            d.pi1 = within[i];
+                            d.pi2 = within[j];
+                            // These follow the deprecated Sequence::FST,
+                            // with each population given weight 1/2.
+                            const double w_ii_sq = 0.5, sum_wi_wj = 0.25;
+                            const double weighted_pi_ii
+                                = 0.25 * within[i] + 0.25 * within[j];
+                            const double weighted_pi_ij = 0.25 * between[p];
+                            d.piT = weighted_pi_ii + 2. * weighted_pi_ij;
+                            d.piS = weighted_pi_ii / w_ii_sq;
+                            d.piB = weighted_pi_ij / sum_wi_wj;
+                            d.piD = (d.piT - d.piS) / (2. * sum_wi_wj);
+                            d.hsm = d.piD / (d.piS + d.piD);
+                            d.slatkin = d.piD / (2. * d.piS + d.piD);
+                            d.hbk = 1. - d.piS / d.piT;
+                            d.shared = nflags[4 * p];
+                            d.fixed = nflags[4 * p + 1];
+                            d.private1 = nflags[4 * p + 2];
+                            d.private2 = nflags[4 * p + 3];
+                            rv.push_back(d);
+                        }
+                }
+            return rv;
+        }
+    };
+
+    std::size_t
+    count_populations(const Sequence::VariantMatrix& m,
+                      const std::vector<std::int32_t>& populations)
+    {
+        if (populations.size() != m.nsam())
+            {
+                throw std::invalid_argument(
+                    "populations must contain one label per sample");
+            }
+        std::int32_t max = -1;
+        for (auto p : populations)
+            {
+                max = std::max(max, p);
+            }
+        return static_cast<std::size_t>(max + 1);
+    }
+
+    void
+    count_site(const Sequence::ConstGenotypeSpan& g,
+               const std::vector<std::int32_t>& populations,
+               const std::size_t site, site_contributions& c)
+    {
+        std::fill(c.counts.begin(), c.counts.end(), 0);
+        auto r = g.row(site);
+        for (std::size_t k = 0; k < r.size(); ++k)
+            {
+                const auto state = r[k];
+                if (populations[k] >= 0 && state >= 0)
+                    {
+                        if (static_cast<std::size_t>(state) >= c.ncol)
+                            {
+                                throw std::runtime_error(
+                                    "found allele value greater than "
+                                    "matrix.max_allele");
+                            }
+                        ++c.counts[static_cast<std::size_t>(populations[k])
+                                       * c.ncol
+                                   + static_cast<std::size_t>(state)];
+                    }
+            }
+        c.update();
+    }
+
+    std::size_t
+    allele_columns(const Sequence::VariantMatrix& m)
+    {
+        return (m.max_allele() < 0)
+                   ? 0
+                   : static_cast<std::size_t>(m.max_allele()) + 1;
+    }
+} // namespace
+
+namespace Sequence
+{
+    std::vector<PopulationDifferentiation>
+    differentiation(const VariantMatrix& m,
+                    const std::vector<std::int32_t>& populations)
+    {
+        const auto npop = count_populations(m, populations);
+        site_contributions c(npop, allele_columns(m));
+        const auto g = get_ConstGenotypeSpan(m);
+        differentiation_totals totals(npop);
+        for (std::size_t i = 0; i < m.nsites(); ++i)
+            {
+                count_site(g, populations, i, c);
+                totals.add(c);
+            }
+        return totals.results();
+    }
+
+    std::vector<PopulationDifferentiation>
+    differentiation(const std::vector<AlleleCountMatrix>& populations)
+    {
+        std::size_t ncol = 0;
+        for (auto& p : populations)
+            {
+                if (p.nrow != populations.front().nrow)
+                    {
+                        throw std::invalid_argument(
+                            "allele count matrices must have the same "
+                            "number of rows");
+                    }
+                ncol = std::max(ncol, p.ncol);
+            }
+        site_contributions c(populations.size(), ncol);
+        differentiation_totals totals(populations.size());
+        const std::size_t nrow
+            = populations.empty() ? 0 : populations.front().nrow;
+        for (std::size_t i = 0; i < nrow; ++i)
+            {
+                std::fill(c.counts.begin(), c.counts.end(), 0);
+                for (std::size_t p = 0; p < populations.size(); ++p)
+                    {
+                        auto r = populations[p].row(i);
+                        std::copy(r.first, r.second,
+                                  c.counts.begin()
+                                      + static_cast<std::ptrdiff_t>(p * ncol));
+                    }
+                c.update();
+                totals.add(c);
+            }
+        return totals.results();
+    }
+
+    std::vector<WindowDifferentiation>
+    windowed_differentiation(const VariantMatrix& m,
+                             const std::vector<std::int32_t>& populations,
+                             const double beg, const double end,
+                             const double window_size, const double step)
+    {
+        if (window_size < 0.0)
+            {
+                throw std::invalid_argument("window_size must be >= 0");
+            }
+        if (!(step > 0.0))
+            {
+                throw std::invalid_argument("step must be > 0");
+            }
+        const auto npop = count_populations(m, populations);
+        site_contributions c(npop, allele_columns(m));
+        const auto g = get_ConstGenotypeSpan(m);
+        const std::size_t nwithin = c.within.size(),
+                          nbetween = c.between.size();
+        differentiation_totals totals(npop);
+        // The contributions of the sites in the current window,
+        // nwithin (nbetween) values per site.
+        std::deque<double> within, between;
+        std::deque<std::uint8_t> flags;
+        std::vector<double> first_within(nwithin), first_between(nbetween);
+        std::vector<std::uint8_t> first_flags(nbetween);
+
+        std::vector<WindowDifferentiation> rv;
+        const double* pb = m.cpbegin();
+        const double* pe = m.cpend();
+        // The current window contains sites [left, right)
+        std::size_t left = 0, right = 0;
+        for (std::size_t k = 0;; ++k)
+            {
+                const double wbeg = beg + static_cast<double>(k) * step;
+                if (!(wbeg < end))
+                    {
+                        break;
+                    }
+                const double wend = wbeg + window_size;
+                auto l = static_cast<std::size_t>(
+                    std::lower_bound(pb + left, pe, wbeg) - pb);
+                auto r = static_cast<std::size_t>(
+                    std::upper_bound(pb + l, pe, wend) - pb);
+                if (l >= right)
+                    {
+                        // Discard the window, and any rounding error
+                        totals = differentiation_totals(npop);
+                        within.clear();
+                        between.clear();
+                        flags.clear();
+                        left = right = l;
+                    }
+                for (; right < r; ++right)
+                    {
+                        count_site(g, populations, right, c);
+                        totals.add(c);
+                        within.insert(within.end(), c.within.begin(),
+                                      c.within.end());
+                        between.insert(between.end(), c.between.begin(),
+                                       c.between.end());
+                        flags.insert(flags.end(), c.flags.begin(),
+                                     c.flags.end());
+                    }
+                for (; left < l; ++left)
+                    {
+                        std::copy(within.begin(),
+                                  within.begin()
+                                      + static_cast<std::ptrdiff_t>(nwithin),
+                                  first_within.begin());
+                        std::copy(between.begin(),
+                                  between.begin()
+                                      + static_cast<std::ptrdiff_t>(nbetween),
+                                  first_between.begin());
+                        std::copy(flags.begin(),
+                                  flags.begin()
+                                      + static_cast<std::ptrdiff_t>(nbetween),
+                                  first_flags.begin());
+                        totals.remove(first_within, first_between,
+                                      first_flags.data());
+                        within.erase(within.begin(),
+                                     within.begin()
+                                         + static_cast<std::ptrdiff_t>(
+                                             nwithin));
+                        between.erase(between.begin(),
+                                      between.begin()
+                                          + static_cast<std::ptrdiff_t>(
+                                              nbetween));
+                        flags.erase(flags.begin(),
+                                    flags.begin()
+                                        + static_cast<std::ptrdiff_t>(
+                                            nbetween));
+                    }
+                rv.push_back(WindowDifferentiation{ wbeg, wend, left,
+                                                    right - left,
+                                                    totals.results() });
+            }
+        return rv;
+    }
+} // namespace Sequence
@@ -0,0 +1,51 @@
+#ifndef SEQUENCE_SUMMSTATS_HAPLOTYPE_LAYOUT_HPP
+#define SEQUENCE_SUMMSTATS_HAPLOTYPE_LAYOUT_HPP
+
+// These functions are not exported.
+// They are used internally.
+
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/HaplotypeMajorCapsules.hpp>
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        inline const HaplotypeMajorGenotypeCapsule*
+        as_haplotype_major(const VariantMatrix& m)
+        /// Returns nullptr unless m stores its genotypes
+        /// in a HaplotypeMajorGenotypeCapsule.
+        {
+            return dynamic_cast<const HaplotypeMajorGenotypeCapsule*>(
+                m.genotype_capsule());
+        }
+
+        inline std::vector<ConstColView>
+        haplotype_views(const VariantMatrix& m)
+        /// Views of each sample of m.  The views are
+        /// contiguous when m stores haplotypes contiguously,
+        /// and strided otherwise.
+        {
+            std::vector<ConstColView> rv;
+            rv.reserve(m.nsam());
+            if (auto h = as_haplotype_major(m))
+                {
+                    for (std::size_t i = 0; i < m.nsam(); ++i)
+                        {
+                            rv.push_back(h->haplotype(i));
+                        }
+                    return rv;
+                }
+            const auto g = get_ConstGenotypeSpan(m);
+            for (std::size_t i = 0; i < g.nsam; ++i)
+                {
+                    rv.push_back(g.col(i));
+                }
+            return rv;
+        }
+    } // namespace summstats_details
+} // namespace Sequence
+
+#endif
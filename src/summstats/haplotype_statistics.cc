@@ -8,6 +8,51 @@
 #include <Sequence/VariantMatrix.hpp>
 #include <Sequence/VariantMatrixViews.hpp>
 #include "algorithm.hpp"
+#include "bitpacked_kernels.hpp"
+#include "difference_kernels.hpp"
+#include "haplotype_layout.hpp"
+
+namespace
+{
+    void
+    hash_columns(const Sequence::VariantMatrix& m,
+                 std::vector<std::uint64_t>& hashes,
+                 std::vector<std::int32_t>& nmissing)
+    // FNV-1a hash of each sample, and the number of
+    // missing genotypes in each.  Rows are visited in
+    // order for the sake of memory access, unless
+    // samples are stored contiguously.
+    {
+        if (auto h = Sequence::summstats_details::as_haplotype_major(m))
+            {
+                for (std::size_t i = 0; i < m.nsam(); ++i)
+                    {
+                        const std::int8_t* s = h->haplotype_data(i);
+                        for (std::size_t site = 0; site < m.nsites(); ++site)
+                            {
+                                hashes[i] = (hashes[i]
+                                             ^ static_cast<std::uint8_t>(
+                                                 s[site]))
+                                            * 1099511628211ull;
+                                nmissing[i] += (s[site] < 0);
+                            }
+                    }
+                return;
+            }
+        const auto g = Sequence::get_ConstGenotypeSpan(m);
+        for (std::size_t site = 0; site < g.nsites; ++site)
+            {
+                const std::int8_t* r = g.row(site).data;
+                for (std::size_t i = 0; i < g.nsam; ++i)
+                    {
+                        hashes[i] = (hashes[i]
+                                     ^ static_cast<std::uint8_t>(r[i]))
+                                    * 1099511628211ull;
+                        nmissing[i] += (r[i] < 0);
+                    }
+            }
+    }
+} // namespace
 
 namespace Sequence
 {
@@ -16,21 +61,19 @@ namespace Sequence
     std::vector<std::int32_t>
     difference_matrix(const VariantMatrix& m)
     {
-        std::vector<std::int32_t> rv;
-        rv.reserve(m.nsam());
-        for (std::size_t i = 0; i < m.nsam() - 1; ++i)
+        if (auto bp = summstats_details::as_bitpacked(m))
             {
-                auto ci = get_ConstColView(m, i);
-                for (std::size_t j = i + 1; j < m.nsam(); ++j)
-                    {
-                        auto cj = get_ConstColView(m, j);
-                        std::int32_t ndiffs
-                            = summstats_algo::ndiff_skip_missing(
-                                ci.begin(), ci.end(), cj.begin());
-                        rv.push_back(ndiffs);
-                    }
+                return summstats_details::bitpacked_difference_matrix(*bp);
             }
-        return rv;
+        if (m.nsam() < 2)
+            {
+                return {};
+            }
+        if (auto h = summstats_details::as_haplotype_major(m))
+            {
+                return summstats_details::haplotype_difference_matrix(*h);
+            }
+        return summstats_details::tiled_difference_matrix(m);
     }
 
     std::vector<std::int32_t>
@@ -38,12 +81,7 @@ namespace Sequence
     {
         std::vector<std::int32_t> rv;
         rv.reserve(m.nsam());
-        std::vector<ConstColView> alleles;
-        alleles.reserve(m.nsam());
-        for (std::size_t i = 0; i < m.nsam(); ++i)
-            {
-                alleles.push_back(get_ConstColView(m, i));
-            }
+        const auto alleles = summstats_details::haplotype_views(m);
         for (std::size_t i = 0; i < m.nsam() - 1; ++i)
             {
                 for (std::size_t j = i + 1; j < m.nsam(); ++j)
@@ -61,49 +99,114 @@ namespace Sequence
     label_haplotypes(const VariantMatrix& m)
     {
         std::vector<std::int32_t> rv(m.nsam(), 0);
-        std::vector<std::int32_t> processed(m.nsam(), 0);
         std::iota(begin(rv), end(rv), 0);
         if (rv.empty())
             {
                 return rv;
             }
-        const auto dm = is_different_matrix(m);
         const std::size_t n = m.nsam();
-        const std::size_t C = n * (n - 1) / 2;
+        std::vector<std::uint64_t> hashes(n, 14695981039346656037ull);
+        std::vector<std::int32_t> nmissing(n, 0);
+        hash_columns(m, hashes, nmissing);
+        const auto haplotypes = summstats_details::haplotype_views(m);
+
+        // Samples without missing data are only the same as identical
+        // samples, which are grouped by their hashes.  Each group is
+        // stored in increasing order of sample index.
+        std::vector<std::vector<std::size_t>> groups;
+        std::vector<std::size_t> group_of(n, 0);
+        std::vector<std::size_t> partial;
+        std::unordered_map<std::uint64_t, std::vector<std::size_t>>
+            groups_by_hash;
+        for (std::size_t i = 0; i < n; ++i)
+            {
+                if (nmissing[i] == static_cast<std::int32_t>(m.nsites()))
+                    {
+                        rv[i] = -1;
+                        continue;
+                    }
+                if (nmissing[i])
+                    {
+                        partial.push_back(i);
+                        continue;
+                    }
+                const auto& ci = haplotypes[i];
+                auto& candidates = groups_by_hash[hashes[i]];
+                auto g = std::find_if(
+                    candidates.begin(), candidates.end(),
+                    [&haplotypes, &ci, &groups](const std::size_t c) {
+                        const auto& cj = haplotypes[groups[c][0]];
+                        return std::equal(ci.begin(), ci.end(), cj.begin());
+                    });
+                if (g == candidates.end())
+                    {
+                        candidates.push_back(groups.size());
+                        group_of[i] = groups.size();
+                        groups.emplace_back(1, i);
+                    }
+                else
+                    {
+                        group_of[i] = *g;
+                        groups[*g].push_back(i);
+                    }
+            }
 
-        // k refers to an element in the upper triangle 
-        // of an nsam*nsam matrix, excluding the diagonal.
-        std::size_t k = std::numeric_limits<std::size_t>::max();
-        for (std::size_t i = 0; i < m.nsam(); ++i)
+        // Samples with missing data are the same as any sample
+        // from which they only differ at missing sites.  As this
+        // is not transitive, labels are assigned greedily: each
+        // unlabelled sample passes its label to all later samples
+        // that are the same as it.
+        std::vector<std::int32_t> processed(n, 0);
+        auto assign = [&rv, &processed](const std::size_t i,
+                                        const std::size_t j) {
+            rv[j] = rv[i];
+            processed[j] = 1;
+        };
+        auto same = [&haplotypes](const std::size_t i, const std::size_t j) {
+            const auto& ci = haplotypes[i];
+            const auto& cj = haplotypes[j];
+            return summstats_algo::mismatch_skip_missing(
+                       ci.begin(), ci.end(), cj.begin())
+                       .first
+                   == ci.end();
+        };
+        for (std::size_t i = 0; i < n; ++i)
             {
-                if (!processed[i])
+                if (processed[i] || rv[i] < 0)
                     {
-                        if (!all_missing(get_ConstColView(m, i)))
+                        continue;
+                    }
+                if (!nmissing[i])
+                    {
+                        for (auto j : groups[group_of[i]])
+                            {
+                                if (j > i)
+                                    {
+                                        assign(i, j);
+                                    }
+                            }
+                    }
+                else
+                    {
+                        for (auto& g : groups)
                             {
-                                for (std::size_t j = i + 1; j < m.nsam(); ++j)
+                                if (g.back() > i && same(i, g[0]))
                                     {
-                                        if (!all_missing(
-                                                get_ConstColView(m, j)))
+                                        for (auto j : g)
                                             {
-                                                k = C
-                                                    - (n - i) * (n - i - 1) / 2
-                                                    + j - i - 1;
-                                                if (!dm[k])
+                                                if (j > i)
                                                     {
-                                                        rv[j] = rv[i];
-                                                        processed[j] = 1;
+                                                        assign(i, j);
                                                     }
                                             }
-                                        else
-                                            {
-                                                rv[j] = -1;
-                                                processed[j] = 1;
-                                            }
                                     }
                             }
-                        else
+                    }
+                for (auto j : partial)
+                    {
+                        if (j > i && same(i, j))
                             {
-                                rv[i] = -1;
+                                assign(i, j);
                             }
                     }
             }
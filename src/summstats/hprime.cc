@@ -4,41 +4,6 @@
 #include <Sequence/summstats/auxillary.hpp>
 #include "hprime_faywuh_aggregator.hpp"
 
-namespace
-{
-    double
-    hprime_common(const std::uint32_t nsam, const unsigned S, const double tp,
-                  const double tl)
-    {
-        using namespace Sequence;
-        if (tp == 0.0)
-            {
-                return std::numeric_limits<double>::quiet_NaN();
-            }
-        auto a = summstats_aux::a_sub_n(static_cast<std::uint32_t>(nsam));
-        auto b = summstats_aux::b_sub_n(static_cast<std::uint32_t>(nsam));
-        auto b1
-            = summstats_aux::b_sub_n_plus1(static_cast<std::uint32_t>(nsam));
-
-        double tw
-            = static_cast<double>(S) / a; //TODO: replace with call to thetaw
-        double tsq = S * (S - 1) / (a * a + b);
-        double n = static_cast<double>(nsam);
-
-        double vThetal
-            = (n * tw) / (2.0 * (n - 1.0))
-              + (2.0 * std::pow(n / (n - 1.0), 2.0) * (b1 - 1.0) - 1.0) * tsq;
-        double vPi = (3.0 * n * (n + 1.0) * tw + 2.0 * (n * n + n + 3.0) * tsq)
-                     / (9 * n * (n - 1.0));
-        double cov
-            = ((n + 1.0) / (3.0 * (n - 1.0))) * tw
-              + ((7.0 * n * n + 3.0 * n - 2.0 - 4.0 * n * (n + 1.0) * b1)
-                 / (2.0 * std::pow((n - 1.0), 2.0)))
-                    * tsq;
-        return (tp - tl) / std::pow(vThetal + vPi - 2.0 * cov, 0.5);
-    }
-} // namespace
-
 namespace Sequence
 {
     double
@@ -59,8 +24,8 @@ namespace Sequence
             {
                 rp(ac, i, refindex, detail::stat_is_hprime());
             }
-        return hprime_common(static_cast<std::uint32_t>(ac.nsam), rp.S, rp.pi,
-                             rp.theta);
+        return summstats_aux::hprime(static_cast<std::uint32_t>(ac.nsam),
+                                     rp.S, rp.pi, rp.theta);
     }
 
     double
@@ -100,7 +65,7 @@ namespace Sequence
                         rp(ac, i, refindex, detail::stat_is_hprime());
                     }
             }
-        return hprime_common(static_cast<std::uint32_t>(ac.nsam), rp.S, rp.pi,
-                             rp.theta);
+        return summstats_aux::hprime(static_cast<std::uint32_t>(ac.nsam),
+                                     rp.S, rp.pi, rp.theta);
     }
 } // namespace Sequence
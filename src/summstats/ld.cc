@@ -1,9 +1,42 @@
 #include <cstdint>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 #include <Sequence/summstats/ld.hpp>
 #include <Sequence/VariantMatrix.hpp>
 #include <Sequence/VariantMatrixViews.hpp>
+#include "bitpacked_kernels.hpp"
+#include "ld_kernels.hpp"
+#include "../worker_threads.hpp"
+
+namespace
+{
+    // Number of bi-allelic sites in each unit of work
+    // given to a thread.
+    constexpr std::size_t ROW_BLOCK = 64;
+
+    Sequence::TwoLocusLD
+    make_ld(const std::size_t i, const std::size_t j,
+            const Sequence::summstats_details::two_locus_counts& c)
+    {
+        const auto nan = std::numeric_limits<double>::quiet_NaN();
+        const double n = static_cast<double>(c.n);
+        const double p1 = static_cast<double>(c.ni) / n,
+                     q1 = static_cast<double>(c.nj) / n;
+        const double p0 = 1.0 - p1, q0 = 1.0 - q1;
+        const double D = static_cast<double>(c.n11) / n - p1 * q1;
+        if (c.ni == 0 || c.ni == c.n || c.nj == 0 || c.nj == c.n)
+            {
+                return Sequence::TwoLocusLD{ i, j, nan, D, nan };
+            }
+        const double dmin = std::max(-p0 * q0, -p1 * q1);
+        const double dmax = std::min(p1 * q0, p0 * q1);
+        return Sequence::TwoLocusLD{ i, j, D * D / (p0 * p1 * q0 * q1), D,
+                                     (D < 0) ? -(D / dmin) : D / dmax };
+    }
+} // namespace
 
 namespace Sequence
 {
@@ -17,6 +50,11 @@ namespace Sequence
                                const std::size_t sitej,
                                const bool skip_missing)
     {
+        if (auto bp = summstats_details::as_bitpacked(m))
+            {
+                return summstats_details::bitpacked_two_locus_haplotype_counts(
+                    *bp, sitei, sitej, skip_missing);
+            }
         auto ri = get_ConstRowView(m, sitei);
         auto rj = get_ConstRowView(m, sitej);
         std::vector<TwoLocusCounts> rv;
@@ -41,4 +79,101 @@ namespace Sequence
             }
         return rv;
     }
+
+    std::vector<TwoLocusLD>
+    pairwise_ld(const VariantMatrix& m, const double max_distance,
+                const double min_rsq, const unsigned nthreads)
+    {
+        if (!(max_distance >= 0.0))
+            {
+                throw std::invalid_argument("max_distance must be >= 0");
+            }
+        if (nthreads == 0)
+            {
+                throw std::invalid_argument("nthreads must be > 0");
+            }
+        const summstats_details::biallelic_sites sites(m);
+        std::vector<double> pos;
+        pos.reserve(sites.size());
+        for (std::size_t k = 0; k < sites.size(); ++k)
+            {
+                pos.push_back(m.cposition(sites.site(k)));
+            }
+        const std::size_t nblocks = (sites.size() + ROW_BLOCK - 1) / ROW_BLOCK;
+        std::vector<std::vector<TwoLocusLD>> results(nblocks);
+        detail::run_strided(nblocks, nthreads, [&](const std::size_t block) {
+            std::vector<summstats_details::two_locus_counts> counts;
+            const std::size_t last_row
+                = std::min(sites.size(), (block + 1) * ROW_BLOCK);
+            for (std::size_t a = block * ROW_BLOCK; a < last_row; ++a)
+                {
+                    const auto band_end = static_cast<std::size_t>(
+                        std::upper_bound(pos.begin()
+                                             + static_cast<std::ptrdiff_t>(a),
+                                         pos.end(), pos[a] + max_distance)
+                        - pos.begin());
+                    counts.resize(band_end - a - 1);
+                    sites.counts(a, a + 1, band_end, counts.data());
+                    for (std::size_t k = 0; k < counts.size(); ++k)
+                        {
+                            auto ld = make_ld(sites.site(a),
+                                              sites.site(a + 1 + k),
+                                              counts[k]);
+                            if (ld.rsq >= min_rsq)
+                                {
+                                    results[block].push_back(ld);
+                                }
+                        }
+                }
+        });
+        std::vector<TwoLocusLD> rv;
+        for (auto& r : results)
+            {
+                rv.insert(rv.end(), r.begin(), r.end());
+            }
+        return rv;
+    }
+
+    std::vector<double>
+    ld_matrix(const VariantMatrix& m, const LDStatistic statistic,
+              const unsigned nthreads)
+    {
+        if (nthreads == 0)
+            {
+                throw std::invalid_argument("nthreads must be > 0");
+            }
+        const summstats_details::biallelic_sites sites(m);
+        const std::size_t nsites = m.nsites();
+        std::vector<double> rv(nsites * nsites,
+                               std::numeric_limits<double>::quiet_NaN());
+        const std::size_t nblocks = (sites.size() + ROW_BLOCK - 1) / ROW_BLOCK;
+        detail::run_strided(nblocks, nthreads, [&](const std::size_t block) {
+            std::vector<summstats_details::two_locus_counts> counts;
+            const std::size_t last_row
+                = std::min(sites.size(), (block + 1) * ROW_BLOCK);
+            for (std::size_t a = block * ROW_BLOCK; a < last_row; ++a)
+                {
+                    counts.resize(sites.size() - a);
+                    sites.counts(a, a, sites.size(), counts.data());
+                    const std::size_t i = sites.site(a);
+                    for (std::size_t k = 0; k < counts.size(); ++k)
+                        {
+                            const std::size_t j = sites.site(a + k);
+                            auto ld = make_ld(i, j, counts[k]);
+                            double x = ld.rsq;
+                            if (statistic == LDStatistic::D)
+                                {
+                                    x = ld.D;
+                                }
+                            else if (statistic == LDStatistic::Dprime)
+                                {
+                                    x = ld.Dprime;
+                                }
+                            // Each thread writes to distinct entries.
+                            rv[i * nsites + j] = rv[j * nsites + i] = x;
+                        }
+                }
+        });
+        return rv;
+    }
 } // namespace Sequence
@@ -0,0 +1,173 @@
+#include <cstdint>
+#include <vector>
+#include <stdexcept>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include "bitpacked_kernels.hpp"
+#include "ld_kernels.hpp"
+#include "popcount.hpp"
+
+namespace
+{
+    using word_type = std::uint64_t;
+    constexpr std::size_t word_bits = 64;
+    using Sequence::summstats_details::popcount;
+    using Sequence::summstats_details::two_locus_counts;
+
+    LIBSEQUENCE_POPCNT_CLONES
+    void
+    count_pairs(const word_type* minor, const word_type* present,
+                const std::int32_t* nminor, const std::int8_t* complete,
+                const std::size_t nwords, const std::int32_t nsam,
+                const std::size_t a, const std::size_t first,
+                const std::size_t last, two_locus_counts* out)
+    {
+        const word_type* ma = minor + a * nwords;
+        const word_type* pa = present + a * nwords;
+        for (std::size_t b = first; b < last; ++b, ++out)
+            {
+                const word_type* mb = minor + b * nwords;
+                std::int32_t n11 = 0;
+                if (complete[a] && complete[b])
+                    {
+                        for (std::size_t w = 0; w < nwords; ++w)
+                            {
+                                n11 += popcount(ma[w] & mb[w]);
+                            }
+                        *out = two_locus_counts{ nsam, nminor[a], nminor[b],
+                                                 n11 };
+                        continue;
+                    }
+                // Minor allele bits are only set where data
+                // are present, so only the marginal counts
+                // need masking.
+                const word_type* pb = present + b * nwords;
+                std::int32_t n = 0, ni = 0, nj = 0;
+                for (std::size_t w = 0; w < nwords; ++w)
+                    {
+                        n += popcount(pa[w] & pb[w]);
+                        ni += popcount(ma[w] & pb[w]);
+                        nj += popcount(mb[w] & pa[w]);
+                        n11 += popcount(ma[w] & mb[w]);
+                    }
+                *out = two_locus_counts{ n, ni, nj, n11 };
+            }
+    }
+} // namespace
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        biallelic_sites::biallelic_sites(const VariantMatrix& m)
+            : site_indexes{}, minor{}, present{}, nminor{}, complete{},
+              nwords{ m.nsam() / word_bits + (m.nsam() % word_bits != 0) },
+              nsam{ static_cast<std::int32_t>(m.nsam()) }
+        {
+            AlleleCountMatrix ac(m);
+            const auto bp = as_bitpacked(m);
+            // Not used for bit-packed data, whose int8 form is
+            // unpacked on demand.
+            const auto g = bp ? ConstGenotypeSpan(nullptr, 0, 0, 0)
+                              : get_ConstGenotypeSpan(m);
+            for (std::size_t site = 0; site < ac.nrow; ++site)
+                {
+                    const auto r = ac.row(site);
+                    std::int8_t states[2] = { -1, -1 };
+                    std::int32_t state_counts[2] = { 0, 0 };
+                    unsigned nstates = 0;
+                    for (auto i = r.first; i < r.second; ++i)
+                        {
+                            if (*i > 0)
+                                {
+                                    if (nstates < 2)
+                                        {
+                                            states[nstates]
+                                                = static_cast<std::int8_t>(
+                                                    i - r.first);
+                                            state_counts[nstates] = *i;
+                                        }
+                                    ++nstates;
+                                }
+                        }
+                    if (nstates != 2)
+                        {
+                            continue;
+                        }
+                    const bool minor_is_first
+                        = state_counts[0] <= state_counts[1];
+                    const std::int8_t minor_state
+                        = states[minor_is_first ? 0 : 1];
+                    site_indexes.push_back(site);
+                    nminor.push_back(state_counts[minor_is_first ? 0 : 1]);
+                    complete.push_back(state_counts[0] + state_counts[1]
+                                       == nsam);
+                    const auto offset = minor.size();
+                    minor.resize(offset + nwords, 0);
+                    present.resize(offset + nwords, 0);
+                    if (bp)
+                        {
+                            // Bi-allelic sites in a bit-packed
+                            // matrix have states 0 and 1.
+                            const auto bits = bp->row_bits(site);
+                            const auto missing = bp->row_missing(site);
+                            const word_type tail
+                                = (m.nsam() % word_bits)
+                                      ? (word_type(1) << (m.nsam() % word_bits))
+                                            - 1
+                                      : ~word_type(0);
+                            for (std::size_t w = 0; w < nwords; ++w)
+                                {
+                                    const word_type p
+                                        = ~missing[w]
+                                          & (w + 1 == nwords ? tail
+                                                             : ~word_type(0));
+                                    present[offset + w] = p;
+                                    minor[offset + w]
+                                        = minor_state ? bits[w] : p & ~bits[w];
+                                }
+                            continue;
+                        }
+                    const auto row = g.row(site);
+                    for (std::size_t k = 0; k < row.size(); ++k)
+                        {
+                            const word_type bit = word_type(1)
+                                                  << (k % word_bits);
+                            if (row[k] >= 0)
+                                {
+                                    present[offset + k / word_bits] |= bit;
+                                }
+                            if (row[k] == minor_state)
+                                {
+                                    minor[offset + k / word_bits] |= bit;
+                                }
+                        }
+                }
+        }
+
+        std::size_t
+        biallelic_sites::size() const
+        {
+            return site_indexes.size();
+        }
+
+        std::size_t
+        biallelic_sites::site(const std::size_t k) const
+        {
+            return site_indexes[k];
+        }
+
+        void
+        biallelic_sites::counts(const std::size_t a, const std::size_t first,
+                                const std::size_t last,
+                                two_locus_counts* out) const
+        {
+            if (a >= size() || last > size() || first > last)
+                {
+                    throw std::out_of_range("site index out of range");
+                }
+            count_pairs(minor.data(), present.data(), nminor.data(),
+                        complete.data(), nwords, nsam, a, first, last, out);
+        }
+    } // namespace summstats_details
+} // namespace Sequence
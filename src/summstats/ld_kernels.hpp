@@ -0,0 +1,53 @@
+#ifndef SEQUENCE_SUMMSTATS_LD_KERNELS_HPP
+#define SEQUENCE_SUMMSTATS_LD_KERNELS_HPP
+
+// These functions are not exported.
+// They are used internally by the LD functions and rmin.
+
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        struct two_locus_counts
+        /// Counts for a pair of bi-allelic sites, taken over
+        /// the samples that are not missing at either site.
+        /// The "1" allele at each site is its minor allele.
+        {
+            std::int32_t n, ni, nj, n11;
+        };
+
+        class biallelic_sites
+        /// The bi-allelic sites of a VariantMatrix, stored as one
+        /// bit set per site marking samples with the minor allele,
+        /// and another marking samples that are not missing.
+        /// Ties in allele counts are broken in favor of the
+        /// smaller state.
+        {
+          private:
+            std::vector<std::size_t> site_indexes;
+            std::vector<std::uint64_t> minor, present;
+            std::vector<std::int32_t> nminor;
+            std::vector<std::int8_t> complete;
+            std::size_t nwords;
+            std::int32_t nsam;
+
+          public:
+            explicit biallelic_sites(const VariantMatrix& m);
+            /// Number of bi-allelic sites
+            std::size_t size() const;
+            /// Index in the VariantMatrix of the k-th bi-allelic site
+            std::size_t site(const std::size_t k) const;
+            /// Fills out[0, last - first) with the counts for
+            /// bi-allelic site a and each of sites [first, last).
+            void counts(const std::size_t a, const std::size_t first,
+                        const std::size_t last,
+                        two_locus_counts* out) const;
+        };
+    } // namespace summstats_details
+} // namespace Sequence
+
+#endif
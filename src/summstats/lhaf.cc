@@ -4,30 +4,46 @@
 #include <cmath>
 #include <Sequence/VariantMatrix.hpp>
 #include <Sequence/VariantMatrixViews.hpp>
+#include "haplotype_layout.hpp"
 
 namespace Sequence
 {
     std::vector<double>
     lhaf(const VariantMatrix &m, const std::int8_t refstate, const double l)
     {
-        std::vector<long int> dcounts;
-        dcounts.reserve(m.nsites());
         const auto find_nonref = [refstate](const std::int8_t x) {
             return x != refstate && !(x < 0);
         };
-        for (std::size_t i = 0; i < m.nsites(); ++i)
+        const auto haplotypes = summstats_details::haplotype_views(m);
+        std::vector<long int> dcounts;
+        if (summstats_details::as_haplotype_major(m))
+            {
+                dcounts.resize(m.nsites(), 0);
+                for (auto& c : haplotypes)
+                    {
+                        for (std::size_t i = 0; i < m.nsites(); ++i)
+                            {
+                                dcounts[i] += find_nonref(c[i]);
+                            }
+                    }
+            }
+        else
             {
-                auto r = get_ConstRowView(m, i);
-                dcounts.push_back(
-                    std::count_if(r.begin(), r.end(), find_nonref));
+                dcounts.reserve(m.nsites());
+                const auto g = get_ConstGenotypeSpan(m);
+                for (std::size_t i = 0; i < g.nsites; ++i)
+                    {
+                        auto r = g.row(i);
+                        dcounts.push_back(
+                            std::count_if(r.begin(), r.end(), find_nonref));
+                    }
             }
 
         // Get the values for each element in the data
         std::vector<double> rv;
         rv.reserve(m.nsam());
-        for (std::size_t i = 0; i < m.nsam(); ++i)
+        for (auto& c : haplotypes)
             {
-                auto c = get_ConstColView(m, i);
                 auto j = std::find_if(c.cbegin(), c.cend(), find_nonref);
                 double score = 0.0;
                 while (j != c.cend())
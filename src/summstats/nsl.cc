@@ -6,6 +6,8 @@
 #include <Sequence/VariantMatrixViews.hpp>
 #include <Sequence/summstats/nsl.hpp>
 #include "nsl_common.hpp"
+#include "nsl_pbwt.hpp"
+#include "haplotype_layout.hpp"
 #include "algorithm.hpp"
 
 /// \example nSL_from_ms.cc
@@ -75,6 +77,75 @@ namespace
             }
         return rv;
     }
+
+    void
+    nsl_cores(const Sequence::summstats_details::core_data& data,
+              const std::int8_t refstate, const std::size_t first_core,
+              const std::size_t last_core,
+              std::vector<Sequence::nSLiHS>::iterator out)
+    // Fill out with the statistics for cores [first_core, last_core).
+    // precondition: data.genotypes.nsam > 0
+    {
+        using namespace Sequence;
+        const auto& g = data.genotypes;
+        const auto& alleles = data.haplotypes;
+        const double* positions = data.positions;
+        // A matrix keeping track of the
+        // index where sample i,j last differed.
+        // The lower left corresponds to left edges,
+        // and the upper right are the right edges.
+        // -1 mean unevaluated.
+        auto npairs = g.nsam * (g.nsam - 1) / 2;
+        std::vector<summstats_details::suffix_edges> edges(npairs);
+        if (first_core > 0)
+            {
+                // Recover the left edges that processing
+                // cores [0, first_core) would have given.
+                // Right edges are found on demand.
+                std::size_t pair_index = 0;
+                for (std::size_t i = 0; i < g.nsam - 1; ++i)
+                    {
+                        for (std::size_t j = i + 1; j < g.nsam;
+                             ++j, ++pair_index)
+                            {
+                                edges[pair_index].left = get_left(
+                                    alleles[i], alleles[j], first_core, 0);
+                            }
+                    }
+            }
+        for (std::size_t core = first_core; core < last_core; ++core, ++out)
+            {
+                std::size_t pair_index = 0;
+                auto core_view = g.row(core);
+                double nsl_values[2] = { 0, 0 };
+                double ihs_values[2] = { 0, 0 };
+                //Count sample size for non-ref and
+                //ref alleles at core site contributing to nSL
+                int counts[2] = { 0, 0 };
+                for (std::size_t i = 0; i < g.nsam - 1; ++i)
+                    {
+                        const auto& hapi = alleles[i];
+                        for (std::size_t j = i + 1; j < g.nsam;
+                             ++j, ++pair_index)
+                            {
+                                if (update_edge_matrix(
+                                        core_view, hapi, alleles[j],
+                                        edges[pair_index], core, i, j))
+                                    {
+                                        summstats_details::update_counts(
+                                            nsl_values, ihs_values, counts,
+                                            g.nsites, positions,
+                                            static_cast<std::size_t>(
+                                                core_view[i] == refstate),
+                                            edges[pair_index].left,
+                                            edges[pair_index].right);
+                                    }
+                            }
+                    }
+                *out = summstats_details::get_stat(
+                    core_view, refstate, nsl_values, ihs_values, counts);
+            }
+    }
 } // namespace
 
 namespace Sequence
@@ -84,20 +155,23 @@ namespace Sequence
         const std::int8_t refstate)
     {
         auto core_view = get_ConstRowView(m, core);
+        const auto alleles = summstats_details::haplotype_views(m);
+        const std::size_t nsam = m.nsam();
+        const double* positions = m.pbegin();
         // Keep track of distances from core site
         // for nsl and ihs separately
         double nsl_values[2] = { 0, 0 };
         double ihs_values[2] = { 0, 0 };
         //Count sample size for non-ref and ref alleles at core site contributing to nSL
         int counts[2] = { 0, 0 };
-        for (std::size_t i = 0; i < m.nsam() - 1; ++i)
+        for (std::size_t i = 0; i < nsam - 1; ++i)
             {
-                auto sample_i = get_ConstColView(m, i);
-                for (std::size_t j = i + 1; j < m.nsam(); ++j)
+                const auto& sample_i = alleles[i];
+                for (std::size_t j = i + 1; j < nsam; ++j)
                     {
                         if (core_view[i] == core_view[j] && core_view[i] >= 0)
                             {
-                                auto sample_j = get_ConstColView(m, j);
+                                const auto& sample_j = alleles[j];
                                 //Find where samples i and j differ
                                 auto left
                                     = get_left(sample_i, sample_j, core, 0);
@@ -107,7 +181,7 @@ namespace Sequence
                                                                sample_j, core);
                                         summstats_details::update_counts(
                                             nsl_values, ihs_values, counts,
-                                            m.nsites(), m.pbegin(),
+                                            m.nsites(), positions,
                                             static_cast<std::size_t>(
                                                 core_view[i] == refstate),
                                             left, right);
@@ -127,53 +201,42 @@ namespace Sequence
             {
                 return rv;
             }
-        rv.reserve(m.nsites());
+        if (summstats_details::pbwt_applicable(m))
+            {
+                return summstats_details::nsl_pbwt(
+                    m, refstate, std::vector<std::int8_t>(m.nsites(), 1),
+                    false);
+            }
+        rv.resize(m.nsites());
+        nsl_cores(summstats_details::core_data(m), refstate, 0, m.nsites(),
+                  rv.begin());
+        return rv;
+    }
 
-        // A matrix keeping track of the
-        // index where sample i,j last differed.
-        // The lower left corresponds to left edges,
-        // and the upper right are the right edges.
-        // -1 mean unevaluated.
-        auto npairs = m.nsam() * (m.nsam() - 1) / 2;
-        std::vector<summstats_details::suffix_edges> edges(npairs);
-        std::vector<ConstColView> alleles;
-        alleles.reserve(m.nsam());
-        for (std::size_t i = 0; i < m.nsam(); ++i)
+    std::vector<nSLiHS>
+    nsl_parallel(const VariantMatrix& m, const std::int8_t refstate,
+                 const unsigned nthreads)
+    {
+        if (nthreads == 0)
             {
-                alleles.push_back(get_ConstColView(m, i));
+                throw std::invalid_argument("nthreads must be > 0");
             }
-        for (std::size_t core = 0; core < m.nsites(); ++core)
+        if (m.nsam() == 0)
             {
-                std::size_t pair_index = 0;
-                auto core_view = get_ConstRowView(m, core);
-                double nsl_values[2] = { 0, 0 };
-                double ihs_values[2] = { 0, 0 };
-                //Count sample size for non-ref and
-                //ref alleles at core site contributing to nSL
-                int counts[2] = { 0, 0 };
-                for (std::size_t i = 0; i < m.nsam() - 1; ++i)
-                    {
-                        const auto& hapi = alleles[i];
-                        for (std::size_t j = i + 1; j < m.nsam();
-                             ++j, ++pair_index)
-                            {
-                                if (update_edge_matrix(
-                                        core_view, hapi, alleles[j],
-                                        edges[pair_index], core, i, j))
-                                    {
-                                        summstats_details::update_counts(
-                                            nsl_values, ihs_values, counts,
-                                            m.nsites(), m.pbegin(),
-                                            static_cast<std::size_t>(
-                                                core_view[i] == refstate),
-                                            edges[pair_index].left,
-                                            edges[pair_index].right);
-                                    }
-                            }
-                    }
-                rv.emplace_back(summstats_details::get_stat(
-                    core_view, refstate, nsl_values, ihs_values, counts));
+                return std::vector<nSLiHS>();
             }
-        return rv;
+        if (summstats_details::pbwt_applicable(m))
+            {
+                return summstats_details::nsl_pbwt(
+                    m, refstate, std::vector<std::int8_t>(m.nsites(), 1),
+                    nthreads > 1);
+            }
+        const summstats_details::core_data data(m);
+        return summstats_details::run_over_cores(
+            m.nsites(), nthreads,
+            [&data, refstate](const std::size_t first, const std::size_t last,
+                              std::vector<nSLiHS>::iterator out) {
+                nsl_cores(data, refstate, first, last, out);
+            });
     }
 } // namespace Sequence
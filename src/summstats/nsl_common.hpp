@@ -8,8 +8,11 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <stdexcept>
 #include <Sequence/summstats/nSLiHS.hpp>
 #include <Sequence/VariantMatrixViews.hpp>
+#include "haplotype_layout.hpp"
+#include "../worker_threads.hpp"
 
 namespace Sequence
 {
@@ -21,7 +24,23 @@ namespace Sequence
             suffix_edges() : left(-1), right(-1) {}
         };
 
-        static void
+        struct core_data
+        /// The genotypes, haplotypes and positions of a matrix.
+        /// These are taken once, on the calling thread, so that
+        /// worker threads never make the first access to a capsule
+        /// that builds its data lazily.
+        {
+            ConstGenotypeSpan genotypes;
+            std::vector<ConstColView> haplotypes;
+            const double* positions;
+            explicit core_data(const VariantMatrix& m)
+                : genotypes(get_ConstGenotypeSpan(m)),
+                  haplotypes(haplotype_views(m)), positions(m.cpbegin())
+            {
+            }
+        };
+
+        inline void
         update_counts(double nsl_values[2], double ihs_values[2],
                       int counts[2], const std::size_t nsites,
                       // NOTE: code smell here -- dangerous
@@ -61,6 +80,37 @@ namespace Sequence
                            std::log(iHS_num) - std::log(iHS_den),
                            nonrefcount };
         }
+
+        template <typename F>
+        std::vector<nSLiHS>
+        run_over_cores(const std::size_t nsites, const unsigned nthreads,
+                       const F& process_cores)
+        // Split core sites into one contiguous block per thread.
+        // process_cores(first, last, out) must fill out[0, last-first)
+        // with the results for cores [first, last), and must give the
+        // same result for a core regardless of the block containing it.
+        // It should read the matrix through a core_data built by the
+        // caller rather than through the matrix itself.
+        {
+            if (nthreads == 0)
+                {
+                    throw std::invalid_argument("nthreads must be > 0");
+                }
+            std::vector<nSLiHS> rv(nsites);
+            std::size_t nblocks = std::min<std::size_t>(nthreads, nsites);
+            if (nblocks < 2)
+                {
+                    process_cores(0, nsites, rv.begin());
+                    return rv;
+                }
+            detail::run_workers(nblocks, [&](const std::size_t b) {
+                const std::size_t first = b * nsites / nblocks;
+                const std::size_t last = (b + 1) * nsites / nblocks;
+                process_cores(first, last,
+                              rv.begin() + static_cast<std::ptrdiff_t>(first));
+            });
+            return rv;
+        }
     } // namespace summstats_details
 } // namespace Sequence
 
@@ -0,0 +1,430 @@
+// nSL and iHS via the positional Burrows-Wheeler transform
+// (PBWT) of Durbin (2014, Bioinformatics 30:1266).
+//
+// For a core site c and a pair of haplotypes sharing the allele at c,
+// L is the last break site < c at which the pair differ and R the
+// first break site > c at which they differ.  A pair contributes
+// R - L to nSL (and pos[R] - pos[L] to iHS) if L >= 0 and R < nsites.
+//
+// Sweeping left to right, PBWT prefix and divergence arrays give L for
+// every pair as a range maximum of the divergence array, so that sums
+// of L over all pairs with L >= 0 take O(nsam) time per site.
+// Sweeping right to left gives R in the same way.  What remains are
+// the pairs with L >= 0 but R == nsites, or vice-versa.  A pair with
+// no difference left of c is in a class of haplotypes identical at all
+// breaks < c.  Recording when each such class splits gives a tree of
+// at most 2*nsam nodes, from which the R of all pairs with L < 0 are
+// summed in O(nsam) time per site.  The same tree, built right to
+// left, corrects the sum of L.
+//
+// All sums over pairs of site indexes are exact.  Sums of positions
+// are not, so iHS may differ from the pairwise calculation by
+// rounding error.
+
+#include <algorithm>
+#include <exception>
+#include <numeric>
+#include <thread>
+#include <Sequence/VariantMatrixViews.hpp>
+#include "nsl_common.hpp"
+#include "nsl_pbwt.hpp"
+
+namespace
+{
+    struct pair_sums
+    // Sums over pairs of haplotypes of the index and position of
+    // a suffix edge.  Indexed by whether the pair carries the
+    // reference state at the core site.
+    {
+        std::int64_t sites[2];
+        double positions[2];
+        std::int64_t npairs[2];
+
+        pair_sums() : sites{ 0, 0 }, positions{ 0., 0. }, npairs{ 0, 0 } {}
+
+        inline void
+        add(const std::size_t ref, const std::int64_t site,
+            const double position, const std::int64_t n)
+        {
+            sites[ref] += n * site;
+            positions[ref] += static_cast<double>(n) * position;
+            npairs[ref] += n;
+        }
+    };
+
+    struct class_node
+    // A class of haplotypes identical at all break sites
+    // visited before split
+    {
+        std::int64_t parent;
+        // The sweep index at which the class splits, or -1
+        std::int64_t split;
+        // Index into the child slots, or -1
+        std::int64_t children;
+    };
+
+    class sweep
+    // One pass over the sites of a VariantMatrix in either direction.
+    // Sites are referred to by their sweep index, k, which is the
+    // site index when going left to right.
+    {
+      private:
+        const Sequence::VariantMatrix& m;
+        const Sequence::ConstGenotypeSpan genotypes;
+        const std::vector<std::int8_t>& breaks;
+        const std::int8_t refstate;
+        const bool reverse;
+        const std::size_t nsam, nsites, nstates;
+        std::vector<class_node> nodes;
+        std::vector<std::int64_t> child_slots;
+        std::vector<std::int64_t> leaf_of;
+        // scratch space for edge_sums
+        std::vector<std::int64_t> prev_ge, next_gt, stack;
+
+        std::size_t
+        site(const std::int64_t k) const
+        {
+            return reverse ? nsites - 1 - static_cast<std::size_t>(k)
+                           : static_cast<std::size_t>(k);
+        }
+
+        void
+        edge_sums(const std::vector<std::int64_t>& d, const std::size_t lo,
+                  const std::size_t hi, const std::size_t ref,
+                  pair_sums& sums)
+        // The pairs of a block of haplotypes sharing an allele
+        // correspond to the ranges of d[lo, hi), and a pair
+        // matches since the maximum value in its range.
+        // Each range is assigned to the leftmost position of its max.
+        {
+            const auto n = static_cast<std::int64_t>(hi - lo);
+            prev_ge.resize(hi - lo);
+            next_gt.resize(hi - lo);
+            stack.clear();
+            for (std::int64_t j = 0; j < n; ++j)
+                {
+                    auto dj = d[lo + static_cast<std::size_t>(j)];
+                    while (!stack.empty()
+                           && d[lo + static_cast<std::size_t>(stack.back())]
+                                  < dj)
+                        {
+                            next_gt[static_cast<std::size_t>(stack.back())]
+                                = j;
+                            stack.pop_back();
+                        }
+                    prev_ge[static_cast<std::size_t>(j)]
+                        = stack.empty() ? -1 : stack.back();
+                    stack.push_back(j);
+                }
+            for (auto j : stack)
+                {
+                    next_gt[static_cast<std::size_t>(j)] = n;
+                }
+            for (std::int64_t j = 0; j < n; ++j)
+                {
+                    auto dj = d[lo + static_cast<std::size_t>(j)];
+                    if (dj > 0)
+                        {
+                            auto uj = static_cast<std::size_t>(j);
+                            auto left = site(dj - 1);
+                            sums.add(ref, static_cast<std::int64_t>(left),
+                                     m.cposition(left),
+                                     (j - prev_ge[uj]) * (next_gt[uj] - j));
+                        }
+                }
+        }
+
+        void
+        split_classes(const Sequence::ConstRowView& row,
+                      const std::int64_t k, std::vector<int>& first)
+        {
+            const int unseen = -2, mixed = -1;
+            first.resize(nodes.size());
+            for (auto leaf : leaf_of)
+                {
+                    first[static_cast<std::size_t>(leaf)] = unseen;
+                }
+            for (std::size_t h = 0; h < nsam; ++h)
+                {
+                    auto& f = first[static_cast<std::size_t>(leaf_of[h])];
+                    if (f == unseen)
+                        {
+                            f = row[h];
+                        }
+                    else if (f != row[h])
+                        {
+                            f = mixed;
+                        }
+                }
+            for (std::size_t h = 0; h < nsam; ++h)
+                {
+                    auto parent = static_cast<std::size_t>(leaf_of[h]);
+                    if (first[parent] != mixed)
+                        {
+                            continue;
+                        }
+                    if (nodes[parent].children < 0)
+                        {
+                            nodes[parent].split = k;
+                            nodes[parent].children
+                                = static_cast<std::int64_t>(
+                                    child_slots.size());
+                            child_slots.resize(child_slots.size() + nstates,
+                                               -1);
+                        }
+                    auto slot = static_cast<std::size_t>(
+                                    nodes[parent].children)
+                                + static_cast<std::size_t>(row[h]);
+                    if (child_slots[slot] < 0)
+                        {
+                            child_slots[slot]
+                                = static_cast<std::int64_t>(nodes.size());
+                            nodes.push_back(class_node{
+                                static_cast<std::int64_t>(parent), -1, -1 });
+                        }
+                    leaf_of[h] = child_slots[slot];
+                }
+        }
+
+        pair_sums
+        class_sums(const std::int64_t k, std::vector<std::int64_t>& counts,
+                   std::vector<std::int64_t>& squares) const
+        // Pairs sharing the allele at k and identical at all breaks
+        // visited before k, with the site at which they first differ.
+        {
+            pair_sums rv;
+            auto row = genotypes.row(site(k));
+            counts.assign(nodes.size() * nstates, 0);
+            squares.assign(nodes.size() * nstates, 0);
+            for (std::size_t h = 0; h < nsam; ++h)
+                {
+                    ++counts[static_cast<std::size_t>(leaf_of[h]) * nstates
+                             + static_cast<std::size_t>(row[h])];
+                }
+            // Children are created after their parents
+            for (std::size_t i = nodes.size() - 1; i > 0; --i)
+                {
+                    auto p = static_cast<std::size_t>(nodes[i].parent);
+                    for (std::size_t g = 0; g < nstates; ++g)
+                        {
+                            auto c = counts[i * nstates + g];
+                            counts[p * nstates + g] += c;
+                            squares[p * nstates + g] += c * c;
+                        }
+                }
+            for (std::size_t i = 0; i < nodes.size(); ++i)
+                {
+                    if (nodes[i].split < k)
+                        {
+                            continue;
+                        }
+                    auto s = site(nodes[i].split);
+                    for (std::size_t g = 0; g < nstates; ++g)
+                        {
+                            auto c = counts[i * nstates + g];
+                            auto npairs
+                                = (c * c - squares[i * nstates + g]) / 2;
+                            if (npairs)
+                                {
+                                    rv.add(static_cast<std::size_t>(
+                                               static_cast<std::int8_t>(g)
+                                               == refstate),
+                                           static_cast<std::int64_t>(s),
+                                           m.cposition(s), npairs);
+                                }
+                        }
+                }
+            return rv;
+        }
+
+      public:
+        /// Indexed by sweep index
+        std::vector<pair_sums> edges, classes;
+
+        sweep(const Sequence::VariantMatrix& m_,
+              const std::vector<std::int8_t>& breaks_,
+              const std::int8_t refstate_, const bool reverse_)
+            : m(m_), genotypes(Sequence::get_ConstGenotypeSpan(m_)),
+              breaks(breaks_), refstate(refstate_), reverse(reverse_),
+              nsam(m_.nsam()), nsites(m_.nsites()),
+              nstates(static_cast<std::size_t>(m_.max_allele()) + 1),
+              nodes(1, class_node{ -1, -1, -1 }), child_slots{},
+              leaf_of(m_.nsam(), 0), prev_ge{}, next_gt{}, stack{},
+              edges(m_.nsites()), classes(m_.nsites())
+        {
+        }
+
+        void
+        run()
+        {
+            // Prefix and divergence arrays.  a[i] and a[i-1] are
+            // identical at all breaks in [d[i], k).
+            std::vector<std::size_t> a(nsam), a2(nsam);
+            std::iota(a.begin(), a.end(), 0);
+            std::vector<std::int64_t> d(nsam, 0), d2(nsam);
+            std::vector<std::int64_t> p(nstates);
+            std::vector<std::size_t> offsets(nstates + 1), next(nstates);
+            std::vector<int> first;
+            for (std::int64_t k = 0; k < static_cast<std::int64_t>(nsites);
+                 ++k)
+                {
+                    auto s = site(k);
+                    auto row = genotypes.row(s);
+                    std::fill(offsets.begin(), offsets.end(), 0);
+                    for (auto x : row)
+                        {
+                            ++offsets[static_cast<std::size_t>(x) + 1];
+                        }
+                    std::partial_sum(offsets.begin(), offsets.end(),
+                                     offsets.begin());
+                    std::copy(offsets.begin(), offsets.end() - 1,
+                              next.begin());
+                    std::fill(p.begin(), p.end(), k + 1);
+                    for (std::size_t i = 0; i < nsam; ++i)
+                        {
+                            for (auto& pg : p)
+                                {
+                                    pg = std::max(pg, d[i]);
+                                }
+                            auto x = static_cast<std::size_t>(row[a[i]]);
+                            a2[next[x]] = a[i];
+                            d2[next[x]++] = p[x];
+                            p[x] = 0;
+                        }
+                    for (std::size_t g = 0; g < nstates; ++g)
+                        {
+                            if (offsets[g + 1] > offsets[g])
+                                {
+                                    edge_sums(d2, offsets[g] + 1,
+                                              offsets[g + 1],
+                                              static_cast<std::size_t>(
+                                                  static_cast<std::int8_t>(g)
+                                                  == refstate),
+                                              edges[static_cast<std::size_t>(
+                                                  k)]);
+                                }
+                        }
+                    if (breaks[s])
+                        {
+                            a.swap(a2);
+                            d.swap(d2);
+                            split_classes(row, k, first);
+                        }
+                }
+            std::vector<std::int64_t> counts, squares;
+            for (std::int64_t k = 0; k < static_cast<std::int64_t>(nsites);
+                 ++k)
+                {
+                    classes[static_cast<std::size_t>(k)]
+                        = class_sums(k, counts, squares);
+                }
+        }
+    };
+} // namespace
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        bool
+        pbwt_applicable(const VariantMatrix& m)
+        {
+            if (m.nsam() == 0)
+                {
+                    return false;
+                }
+            // The sweep sizes its tables from max_allele, which
+            // is not checked against the data when it is given
+            // to the constructor or after non-const writes.
+            const auto max_allele = m.max_allele();
+            const auto g = get_ConstGenotypeSpan(m);
+            for (std::size_t i = 0; i < g.nsites; ++i)
+                {
+                    auto r = g.row(i);
+                    if (std::any_of(r.begin(), r.end(),
+                                    [max_allele](const std::int8_t x) {
+                                        return x < 0 || x > max_allele;
+                                    }))
+                        {
+                            return false;
+                        }
+                }
+            return true;
+        }
+
+        std::vector<nSLiHS>
+        nsl_pbwt(const VariantMatrix& m, const std::int8_t refstate,
+                 const std::vector<std::int8_t>& breaks, const bool threaded)
+        {
+            sweep forward(m, breaks, refstate, false),
+                backward(m, breaks, refstate, true);
+            if (threaded)
+                {
+                    std::exception_ptr error;
+                    std::thread t([&backward, &error]() {
+                        try
+                            {
+                                backward.run();
+                            }
+                        catch (...)
+                            {
+                                error = std::current_exception();
+                            }
+                    });
+                    try
+                        {
+                            forward.run();
+                        }
+                    catch (...)
+                        {
+                            t.join();
+                            throw;
+                        }
+                    t.join();
+                    if (error)
+                        {
+                            std::rethrow_exception(error);
+                        }
+                }
+            else
+                {
+                    forward.run();
+                    backward.run();
+                }
+
+            std::vector<nSLiHS> rv;
+            rv.reserve(m.nsites());
+            for (std::size_t core = 0; core < m.nsites(); ++core)
+                {
+                    const auto& lf = forward.edges[core];
+                    const auto& rf = forward.classes[core];
+                    const auto& rb = backward.edges[m.nsites() - core - 1];
+                    const auto& lb = backward.classes[m.nsites() - core - 1];
+                    double nsl_values[2], ihs_values[2];
+                    int counts[2];
+                    for (std::size_t r = 0; r < 2; ++r)
+                        {
+                            // Sums of R over pairs with R < nsites and
+                            // L >= 0, minus sums of L over the same pairs.
+                            nsl_values[r] = static_cast<double>(
+                                (rb.sites[r] - rf.sites[r])
+                                - (lf.sites[r] - lb.sites[r]));
+                            ihs_values[r]
+                                = (rb.positions[r] - rf.positions[r])
+                                  - (lf.positions[r] - lb.positions[r]);
+                            counts[r] = static_cast<int>(lf.npairs[r]
+                                                         - lb.npairs[r]);
+                            if (!counts[r])
+                                {
+                                    // Avoid rounding error
+                                    ihs_values[r] = 0.0;
+                                }
+                        }
+                    rv.emplace_back(get_stat(get_ConstRowView(m, core),
+                                             refstate, nsl_values,
+                                             ihs_values, counts));
+                }
+            return rv;
+        }
+    } // namespace summstats_details
+} // namespace Sequence
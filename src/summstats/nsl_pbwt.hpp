@@ -0,0 +1,33 @@
+#ifndef SEQUENCE_SUMMSTATS_NSL_PBWT_HPP
+#define SEQUENCE_SUMMSTATS_NSL_PBWT_HPP
+
+// These functions are not exported.
+// They are used internally by nsl and nslx.
+
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/summstats/nSLiHS.hpp>
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        /// True if \a m has samples, no missing data, and no
+        /// genotype greater than m.max_allele(), which nsl_pbwt
+        /// requires.
+        bool pbwt_applicable(const VariantMatrix& m);
+
+        /// nSL and iHS for all core sites, where suffix lengths
+        /// are only broken by sites i for which breaks[i] != 0.
+        /// If \a threaded, the two directions are swept
+        /// concurrently.
+        /// precondition: pbwt_applicable(m)
+        std::vector<nSLiHS> nsl_pbwt(const VariantMatrix& m,
+                                     const std::int8_t refstate,
+                                     const std::vector<std::int8_t>& breaks,
+                                     const bool threaded);
+    } // namespace summstats_details
+} // namespace Sequence
+
+#endif
@@ -1,12 +1,14 @@
 #include <algorithm>
-#include <Sequence/summstats/nsl.hpp>
+#include <Sequence/summstats/nslx.hpp>
 #include <Sequence/VariantMatrixViews.hpp>
 #include "nsl_common.hpp"
+#include "nsl_pbwt.hpp"
+#include "haplotype_layout.hpp"
 
 namespace
 {
     inline bool
-    update_edge_matrix(const Sequence::VariantMatrix& m,
+    update_edge_matrix(const std::size_t nsites,
                        const std::vector<std::int64_t>& xtons,
                        const Sequence::ConstRowView& core_view,
                        const Sequence::ConstColView& hapi,
@@ -26,7 +28,7 @@ namespace
                         if (edges.right == -1
                             || static_cast<std::size_t>(edges.right) <= core)
                             {
-                                edges.right = m.nsites();
+                                edges.right = nsites;
                                 // To update right edge:
                                 // Iterate over all xtons > core
                                 // and check if haplotypes i,j
@@ -58,20 +60,16 @@ namespace
 
         return rv;
     }
-} // namespace
 
-namespace Sequence
-{
-    std::vector<nSLiHS>
-    nslx(const VariantMatrix& m, const std::int8_t refstate, const int x)
+    std::vector<std::int64_t>
+    find_xtons(const Sequence::VariantMatrix& m, const std::int8_t refstate,
+               const int x)
     {
-        //Need to get indexes of all x-tons.
-        //Then, if two seqs differ at an x-ton,
-        //the stats get updated.
         std::vector<std::int64_t> xtons;
-        for (std::int64_t i = 0; i < static_cast<std::int64_t>(m.nsites()); ++i)
+        const auto g = Sequence::get_ConstGenotypeSpan(m);
+        for (std::int64_t i = 0; i < static_cast<std::int64_t>(g.nsites); ++i)
             {
-                auto r = get_ConstRowView(m, static_cast<std::size_t>(i));
+                auto r = g.row(static_cast<std::size_t>(i));
                 auto nonref = std::count_if(
                     r.begin(), r.end(), [refstate](const std::int8_t a) {
                         return a != refstate && !(a < 0);
@@ -81,42 +79,94 @@ namespace Sequence
                         xtons.push_back(i);
                     }
             }
-        std::vector<nSLiHS> rv;
-        if (xtons.empty() || !m.nsam() || !m.nsites())
+        return xtons;
+    }
+
+    std::vector<std::int8_t>
+    xton_flags(const Sequence::VariantMatrix& m,
+               const std::vector<std::int64_t>& xtons)
+    {
+        std::vector<std::int8_t> flags(m.nsites(), 0);
+        for (auto x : xtons)
             {
-                return rv;
+                flags[static_cast<std::size_t>(x)] = 1;
             }
+        return flags;
+    }
 
-        std::size_t npairs = m.nsam() * (m.nsam() - 1) / 2;
+    void
+    nslx_cores(const Sequence::summstats_details::core_data& data,
+               const std::vector<std::int64_t>& xtons,
+               const std::int8_t refstate, const std::size_t first_core,
+               const std::size_t last_core,
+               std::vector<Sequence::nSLiHS>::iterator out)
+    // Fill out with the statistics for cores [first_core, last_core).
+    // precondition: !xtons.empty() && data.genotypes.nsam > 0
+    {
+        using namespace Sequence;
+        const auto& g = data.genotypes;
+        const auto& alleles = data.haplotypes;
+        const double* positions = data.positions;
+        std::size_t npairs = g.nsam * (g.nsam - 1) / 2;
         std::vector<summstats_details::suffix_edges> edges(npairs);
-        std::vector<ConstColView> alleles;
-        alleles.reserve(m.nsam());
-        for (std::size_t i = 0; i < m.nsam(); ++i)
+        if (first_core > 0)
             {
-                alleles.push_back(get_ColView(m, i));
+                // Recover the left edges that processing
+                // cores [0, first_core) would have given,
+                // which are the last x-tons before first_core
+                // at which each pair differ.
+                // Right edges are found on demand.
+                auto xtons_lt_core = std::lower_bound(
+                    xtons.begin(), xtons.end(),
+                    static_cast<std::int64_t>(first_core));
+                std::size_t pair_index = 0;
+                for (std::size_t i = 0; i < g.nsam - 1; ++i)
+                    {
+                        for (std::size_t j = i + 1; j < g.nsam;
+                             ++j, ++pair_index)
+                            {
+                                const auto& hapi = alleles[i];
+                                const auto& hapj = alleles[j];
+                                for (auto x = xtons_lt_core;
+                                     x != xtons.begin();)
+                                    {
+                                        --x;
+                                        auto site
+                                            = static_cast<std::size_t>(*x);
+                                        if (hapi[site] != hapj[site]
+                                            && !(hapi[site] < 0
+                                                 || hapj[site] < 0))
+                                            {
+                                                edges[pair_index].left = *x;
+                                                break;
+                                            }
+                                    }
+                            }
+                    }
             }
-        for (std::size_t core = 0; core < m.nsites(); ++core)
+        for (std::size_t core = first_core; core < last_core; ++core, ++out)
             {
-                auto core_view = get_ConstRowView(m, core);
+                auto core_view = g.row(core);
                 // Doing any work requires the existence
                 // of x-tons left and right of core
                 double nsl_values[2] = { 0, 0 };
                 double ihs_values[2] = { 0, 0 };
                 int counts[2] = { 0, 0 };
                 std::size_t pair_index = 0;
-                for (std::size_t i = 0; i < m.nsam() - 1; ++i)
+                for (std::size_t i = 0; i < g.nsam - 1; ++i)
                     {
-                        for (std::size_t j = i + 1; j < m.nsam();
+                        for (std::size_t j = i + 1; j < g.nsam;
                              ++j, ++pair_index)
                             {
-                                if (update_edge_matrix(m, xtons, core_view,
+                                if (update_edge_matrix(g.nsites, xtons,
+                                                       core_view,
                                                        alleles[i], alleles[j],
                                                        edges[pair_index], core,
                                                        i, j))
                                     {
                                         summstats_details::update_counts(
                                             nsl_values, ihs_values, counts,
-                                            m.nsites(), m.pbegin(),
+                                            g.nsites, positions,
                                             static_cast<std::size_t>(
                                                 core_view[i] == refstate),
                                             edges[pair_index].left,
@@ -124,9 +174,62 @@ namespace Sequence
                                     }
                             }
                     }
-                rv.emplace_back(summstats_details::get_stat(
-                    core_view, refstate, nsl_values, ihs_values, counts));
+                *out = summstats_details::get_stat(
+                    core_view, refstate, nsl_values, ihs_values, counts);
+            }
+    }
+} // namespace
+
+namespace Sequence
+{
+    std::vector<nSLiHS>
+    nslx(const VariantMatrix& m, const std::int8_t refstate, const int x)
+    {
+        //Need to get indexes of all x-tons.
+        //Then, if two seqs differ at an x-ton,
+        //the stats get updated.
+        auto xtons = find_xtons(m, refstate, x);
+        std::vector<nSLiHS> rv;
+        if (xtons.empty() || !m.nsam() || !m.nsites())
+            {
+                return rv;
+            }
+        if (summstats_details::pbwt_applicable(m))
+            {
+                return summstats_details::nsl_pbwt(
+                    m, refstate, xton_flags(m, xtons), false);
             }
+        rv.resize(m.nsites());
+        nslx_cores(summstats_details::core_data(m), xtons, refstate, 0,
+                   m.nsites(), rv.begin());
         return rv;
     }
+
+    std::vector<nSLiHS>
+    nslx_parallel(const VariantMatrix& m, const std::int8_t refstate,
+                  const int x, const unsigned nthreads)
+    {
+        if (nthreads == 0)
+            {
+                throw std::invalid_argument("nthreads must be > 0");
+            }
+        auto xtons = find_xtons(m, refstate, x);
+        if (xtons.empty() || !m.nsam() || !m.nsites())
+            {
+                return std::vector<nSLiHS>();
+            }
+        if (summstats_details::pbwt_applicable(m))
+            {
+                return summstats_details::nsl_pbwt(
+                    m, refstate, xton_flags(m, xtons), nthreads > 1);
+            }
+        const summstats_details::core_data data(m);
+        return summstats_details::run_over_cores(
+            m.nsites(), nthreads,
+            [&data, &xtons, refstate](const std::size_t first,
+                                      const std::size_t last,
+                                      std::vector<nSLiHS>::iterator out) {
+                nslx_cores(data, xtons, refstate, first, last, out);
+            });
+    }
 } // namespace Sequence
@@ -0,0 +1,42 @@
+#ifndef SEQUENCE_SUMMSTATS_POPCOUNT_HPP
+#define SEQUENCE_SUMMSTATS_POPCOUNT_HPP
+
+// These functions are not exported.
+// They are used internally.
+
+#include <cstdint>
+
+// When the compiler supports it, the hot loops are
+// compiled twice: once using the popcnt instruction
+// and once for generic hardware.  The version to use
+// is picked at load time.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)           \
+    && defined(__ELF__)
+#define LIBSEQUENCE_POPCNT_CLONES                                             \
+    __attribute__((target_clones("popcnt", "default")))
+#else
+#define LIBSEQUENCE_POPCNT_CLONES
+#endif
+
+namespace Sequence
+{
+    namespace summstats_details
+    {
+        inline std::int32_t
+        popcount(std::uint64_t x)
+        {
+#if defined(__GNUC__)
+            return __builtin_popcountll(x);
+#else
+            x = x - ((x >> 1) & 0x5555555555555555ULL);
+            x = (x & 0x3333333333333333ULL)
+                + ((x >> 2) & 0x3333333333333333ULL);
+            x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+            return static_cast<std::int32_t>((x * 0x0101010101010101ULL)
+                                             >> 56);
+#endif
+        }
+    } // namespace summstats_details
+} // namespace Sequence
+
+#endif
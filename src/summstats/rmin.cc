@@ -1,9 +1,18 @@
 #include <cstdint>
-#include <Sequence/summstats/ld.hpp>
-#include <Sequence/summstats/allele_counts.hpp>
+#include <vector>
+#include <Sequence/summstats/classics.hpp>
 #include <Sequence/VariantMatrix.hpp>
-#include <Sequence/AlleleCountMatrix.hpp>
-#include <Sequence/VariantMatrixViews.hpp>
+#include "ld_kernels.hpp"
+
+namespace
+{
+    inline bool
+    four_gametes(const Sequence::summstats_details::two_locus_counts& c)
+    {
+        return c.n11 > 0 && c.ni > c.n11 && c.nj > c.n11
+               && c.n - c.ni - c.nj + c.n11 > 0;
+    }
+} // namespace
 
 namespace Sequence
 {
@@ -14,42 +23,29 @@ namespace Sequence
             {
                 return -1;
             }
-        Sequence::AlleleCountMatrix acm(m);
-        auto ac = allele_counts(acm);
-        std::vector<std::size_t> biallelic_site_indexes;
-        for (std::size_t i = 0; i < ac.size(); ++i)
-            {
-                if (ac[i].nstates == 2)
-                    {
-                        biallelic_site_indexes.push_back(i);
-                    }
-            }
-        if (biallelic_site_indexes.size() < 2)
+        // We do not allow missing data to result in
+        // additional haplotypes
+        const summstats_details::biallelic_sites sites(m);
+        if (sites.size() < 2)
             {
                 return 0;
             }
-        bool flag = false;
+        std::vector<summstats_details::two_locus_counts> counts;
         std::size_t x = 0;
         std::int32_t rv = 0;
-        for (std::size_t a = x + 1; a < biallelic_site_indexes.size(); ++a)
+        for (std::size_t a = x + 1; a < sites.size(); ++a)
             {
-                for (std::size_t b = (!flag) ? x : a - 1; b < a; ++b)
+                counts.resize(a - x);
+                sites.counts(a, x, a, counts.data());
+                for (auto& c : counts)
                     {
-                        flag = false;
-                        // We do not allow missing data to result in
-                        // additional haplotypes
-                        auto tl = two_locus_haplotype_counts(m, a, b, true);
-                        if (tl.size() == 4)
+                        if (four_gametes(c))
                             {
                                 ++rv;
-                                flag = true;
+                                x = a;
                                 break;
                             }
                     }
-                if (flag == true)
-                    {
-                        x = a;
-                    }
             }
         return rv;
     }
@@ -0,0 +1,600 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <Sequence/summstats/sfs.hpp>
+#include <Sequence/summstats/auxillary.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+
+namespace
+{
+    class projection
+    // Hypergeometric probabilities of seeing j copies of a state in
+    // a subsample of size n, given k copies in a sample of size N.
+    {
+      private:
+        std::vector<double> logfact;
+
+        double
+        lchoose(const std::uint32_t a, const std::uint32_t b) const
+        {
+            return logfact[a] - logfact[b] - logfact[a - b];
+        }
+
+      public:
+        explicit projection(const std::size_t maxN) : logfact(maxN + 1, 0.0)
+        {
+            for (std::size_t i = 2; i < logfact.size(); ++i)
+                {
+                    logfact[i] = logfact[i - 1]
+                                 + std::log(static_cast<double>(i));
+                }
+        }
+
+        void
+        operator()(const std::uint32_t N, const std::uint32_t k,
+                   const std::uint32_t n, std::uint32_t& lo,
+                   std::vector<double>& p) const
+        // Fills p with the probabilities of j = lo, lo + 1, ...
+        {
+            p.clear();
+            if (N == n)
+                {
+                    lo = k;
+                    p.push_back(1.0);
+                    return;
+                }
+            lo = (n + k > N) ? n + k - N : 0;
+            const std::uint32_t hi = std::min(k, n);
+            const double denominator = lchoose(N, n);
+            for (std::uint32_t j = lo; j <= hi; ++j)
+                {
+                    p.push_back(std::exp(lchoose(k, j)
+                                         + lchoose(N - k, n - j)
+                                         - denominator));
+                }
+        }
+    };
+
+    std::size_t
+    major_state(const std::int32_t* c, const std::size_t ncol)
+    {
+        return static_cast<std::size_t>(std::max_element(c, c + ncol) - c);
+    }
+
+    template <typename Add>
+    void
+    visit_derived_states(const std::int32_t* c, const std::size_t ncol,
+                         const std::size_t refindex, const Add& add)
+    // Calls add(state) for each seen state other than refindex, or
+    // add(ncol) if there is none.
+    {
+        bool seen = false;
+        for (std::size_t a = 0; a < ncol; ++a)
+            {
+                if (a != refindex && c[a] > 0)
+                    {
+                        seen = true;
+                        add(a);
+                    }
+            }
+        if (!seen)
+            {
+                add(ncol);
+            }
+    }
+
+    template <typename Polarize>
+    Sequence::SiteFrequencySpectrum
+    sfs_details(const Sequence::AlleleCountMatrix& ac, const std::uint32_t n,
+                const Polarize& polarize)
+    // polarize(row, counts) returns the reference state of a row, or
+    // a negative value to skip it.
+    {
+        const auto nsam = (n == 0) ? static_cast<std::uint32_t>(ac.nsam) : n;
+        if (nsam > ac.nsam)
+            {
+                throw std::invalid_argument(
+                    "sample size of spectrum greater than sample size");
+            }
+        Sequence::SiteFrequencySpectrum rv{ nsam, false,
+                                            std::vector<double>(nsam + 1,
+                                                                0.0) };
+        const projection project(ac.nsam);
+        std::vector<double> p;
+        for (std::size_t row = 0; row < ac.nrow; ++row)
+            {
+                const std::int32_t* c = ac.counts.data() + row * ac.ncol;
+                const auto ref = polarize(row, c);
+                if (ref < 0)
+                    {
+                        continue;
+                    }
+                std::uint32_t N = 0;
+                for (std::size_t a = 0; a < ac.ncol; ++a)
+                    {
+                        N += static_cast<std::uint32_t>(c[a]);
+                    }
+                if (N < nsam)
+                    {
+                        continue;
+                    }
+                visit_derived_states(
+                    c, ac.ncol, static_cast<std::size_t>(ref),
+                    [&](const std::size_t a) {
+                        const auto k = (a < ac.ncol)
+                                           ? static_cast<std::uint32_t>(c[a])
+                                           : 0u;
+                        std::uint32_t lo;
+                        project(N, k, nsam, lo, p);
+                        for (std::size_t j = 0; j < p.size(); ++j)
+                            {
+                                rv.counts[lo + j] += p[j];
+                            }
+                    });
+            }
+        return rv;
+    }
+
+    std::size_t
+    nstates(const Sequence::VariantMatrix& m)
+    // Number of allelic states, which is 0 if all data are missing
+    {
+        return (m.max_allele() < 0)
+                   ? 0
+                   : static_cast<std::size_t>(m.max_allele()) + 1;
+    }
+
+    void
+    check_refstate(const std::int8_t refstate, const std::size_t ncol)
+    // With no allelic states (ncol == 0), all data are missing and
+    // no site is counted, so the reference state is not checked.
+    {
+        if (ncol == 0)
+            {
+                return;
+            }
+        if (refstate < 0 || static_cast<std::size_t>(refstate) >= ncol)
+            {
+                throw std::invalid_argument(
+                    "reference state greater than max allelic state");
+            }
+    }
+
+    void
+    check_refstates(const std::vector<std::int8_t>& refstates,
+                    const std::size_t nrow, const std::size_t ncol)
+    {
+        if (refstates.size() != nrow)
+            {
+                throw std::invalid_argument(
+                    "incorrect number of reference states");
+            }
+        for (auto r : refstates)
+            {
+                if (ncol && r >= 0 && static_cast<std::size_t>(r) >= ncol)
+                    {
+                        throw std::invalid_argument(
+                            "reference state greater than max allelic "
+                            "state");
+                    }
+            }
+    }
+
+    struct population_counts
+    // Per-population allele counts of one site of a VariantMatrix
+    {
+        std::size_t npop, ncol;
+        std::vector<std::uint32_t> popsize, nsam;
+        std::vector<std::int32_t> counts, pooled;
+
+        population_counts(const Sequence::VariantMatrix& m,
+                          const std::vector<std::int32_t>& populations,
+                          const std::vector<std::uint32_t>& nsam_)
+            : npop{ 0 }, ncol{ nstates(m) },
+              popsize{}, nsam{ nsam_ }, counts{}, pooled(ncol, 0)
+        {
+            if (populations.size() != m.nsam())
+                {
+                    throw std::invalid_argument(
+                        "populations must contain one label per sample");
+                }
+            for (auto p : populations)
+                {
+                    if (p >= 0)
+                        {
+                            npop = std::max(npop,
+                                            static_cast<std::size_t>(p) + 1);
+                        }
+                }
+            popsize.resize(npop, 0);
+            for (auto p : populations)
+                {
+                    if (p >= 0)
+                        {
+                            ++popsize[static_cast<std::size_t>(p)];
+                        }
+                }
+            if (nsam.empty())
+                {
+                    nsam = popsize;
+                }
+            if (nsam.size() != npop)
+                {
+                    throw std::invalid_argument(
+                        "nsam must contain one element per population");
+                }
+            for (std::size_t p = 0; p < npop; ++p)
+                {
+                    if (nsam[p] > popsize[p])
+                        {
+                            throw std::invalid_argument(
+                                "sample size of spectrum greater than "
+                                "population size");
+                        }
+                }
+            counts.resize(npop * ncol, 0);
+        }
+
+        bool
+        fill(const Sequence::ConstGenotypeSpan& g,
+             const std::vector<std::int32_t>& populations,
+             const std::size_t site)
+        // Returns false if a population has too few non-missing samples
+        {
+            std::fill(counts.begin(), counts.end(), 0);
+            std::fill(pooled.begin(), pooled.end(), 0);
+            auto r = g.row(site);
+            for (std::size_t k = 0; k < r.size(); ++k)
+                {
+                    const auto state = r[k];
+                    if (populations[k] >= 0 && state >= 0)
+                        {
+                            ++counts[static_cast<std::size_t>(populations[k])
+                                         * ncol
+                                     + static_cast<std::size_t>(state)];
+                            ++pooled[static_cast<std::size_t>(state)];
+                        }
+                }
+            for (std::size_t p = 0; p < npop; ++p)
+                {
+                    std::uint32_t N = 0;
+                    for (std::size_t a = 0; a < ncol; ++a)
+                        {
+                            N += static_cast<std::uint32_t>(
+                                counts[p * ncol + a]);
+                        }
+                    if (N < nsam[p])
+                        {
+                            return false;
+                        }
+                }
+            return true;
+        }
+    };
+
+    template <typename Polarize>
+    Sequence::JointSiteFrequencySpectrum
+    joint_sfs_details(const Sequence::VariantMatrix& m,
+                      const std::vector<std::int32_t>& populations,
+                      const std::vector<std::uint32_t>& nsam,
+                      const Polarize& polarize)
+    {
+        population_counts pc(m, populations, nsam);
+        std::size_t size = 1;
+        for (auto n : pc.nsam)
+            {
+                size *= n + 1;
+            }
+        Sequence::JointSiteFrequencySpectrum rv{
+            pc.nsam, false, std::vector<double>(size, 0.0)
+        };
+        const projection project(m.nsam());
+        const auto g = Sequence::get_ConstGenotypeSpan(m);
+        std::vector<double> p;
+        // Non-zero elements of the product of the projections of each
+        // population, as (index, probability)
+        std::vector<std::pair<std::size_t, double>> cells, next;
+        for (std::size_t site = 0; site < g.nsites; ++site)
+            {
+                if (!pc.fill(g, populations, site))
+                    {
+                        continue;
+                    }
+                const auto ref = polarize(site, pc.pooled);
+                if (ref < 0)
+                    {
+                        continue;
+                    }
+                visit_derived_states(
+                    pc.pooled.data(), pc.ncol, static_cast<std::size_t>(ref),
+                    [&](const std::size_t a) {
+                        cells.assign(1, std::make_pair(std::size_t(0), 1.0));
+                        for (std::size_t q = 0; q < pc.npop; ++q)
+                            {
+                                const std::int32_t* c
+                                    = pc.counts.data() + q * pc.ncol;
+                                std::uint32_t N = 0;
+                                for (std::size_t b = 0; b < pc.ncol; ++b)
+                                    {
+                                        N += static_cast<std::uint32_t>(c[b]);
+                                    }
+                                const auto k
+                                    = (a < pc.ncol)
+                                          ? static_cast<std::uint32_t>(c[a])
+                                          : 0u;
+                                std::uint32_t lo;
+                                project(N, k, pc.nsam[q], lo, p);
+                                next.clear();
+                                for (auto& cell : cells)
+                                    {
+                                        for (std::size_t j = 0; j < p.size();
+                                             ++j)
+                                            {
+                                                next.emplace_back(
+                                                    cell.first
+                                                            * (pc.nsam[q] + 1)
+                                                        + lo + j,
+                                                    cell.second * p[j]);
+                                            }
+                                    }
+                                cells.swap(next);
+                            }
+                        for (auto& cell : cells)
+                            {
+                                rv.counts[cell.first] += cell.second;
+                            }
+                    });
+            }
+        return rv;
+    }
+
+    void
+    check_unfolded(const Sequence::SiteFrequencySpectrum& sfs)
+    {
+        if (sfs.folded)
+            {
+                throw std::invalid_argument(
+                    "statistic requires an unfolded spectrum");
+            }
+    }
+
+    double
+    segregating_sites(const Sequence::SiteFrequencySpectrum& sfs)
+    {
+        double S = 0.0;
+        for (std::size_t i = 1; i < sfs.counts.size() && i < sfs.nsam; ++i)
+            {
+                S += sfs.counts[i];
+            }
+        return S;
+    }
+} // namespace
+
+namespace Sequence
+{
+    SiteFrequencySpectrum
+    unfolded_sfs(const AlleleCountMatrix& ac, const std::int8_t refstate,
+                 const std::uint32_t nsam)
+    {
+        if (ac.nrow)
+            {
+                check_refstate(refstate, ac.ncol);
+            }
+        return sfs_details(ac, nsam,
+                           [refstate](const std::size_t,
+                                      const std::int32_t*) {
+                               return static_cast<std::int32_t>(refstate);
+                           });
+    }
+
+    SiteFrequencySpectrum
+    unfolded_sfs(const AlleleCountMatrix& ac,
+                 const std::vector<std::int8_t>& refstates,
+                 const std::uint32_t nsam)
+    {
+        check_refstates(refstates, ac.nrow, ac.ncol);
+        return sfs_details(ac, nsam,
+                           [&refstates](const std::size_t row,
+                                        const std::int32_t*) {
+                               return static_cast<std::int32_t>(
+                                   refstates[row]);
+                           });
+    }
+
+    SiteFrequencySpectrum
+    folded_sfs(const AlleleCountMatrix& ac, const std::uint32_t nsam)
+    {
+        const auto ncol = ac.ncol;
+        return fold(sfs_details(
+            ac, nsam, [ncol](const std::size_t, const std::int32_t* c) {
+                return static_cast<std::int32_t>(major_state(c, ncol));
+            }));
+    }
+
+    SiteFrequencySpectrum
+    fold(const SiteFrequencySpectrum& sfs)
+    {
+        if (sfs.folded)
+            {
+                return sfs;
+            }
+        SiteFrequencySpectrum rv{ sfs.nsam, true,
+                                  std::vector<double>(sfs.nsam / 2 + 1,
+                                                      0.0) };
+        for (std::size_t i = 0; i < sfs.counts.size(); ++i)
+            {
+                rv.counts[std::min(i, sfs.nsam - i)] += sfs.counts[i];
+            }
+        return rv;
+    }
+
+    JointSiteFrequencySpectrum
+    joint_sfs(const VariantMatrix& m,
+              const std::vector<std::int32_t>& populations,
+              const std::int8_t refstate,
+              const std::vector<std::uint32_t>& nsam)
+    {
+        if (m.nsites())
+            {
+                check_refstate(refstate, nstates(m));
+            }
+        return joint_sfs_details(
+            m, populations, nsam,
+            [refstate](const std::size_t, const std::vector<std::int32_t>&) {
+                return static_cast<std::int32_t>(refstate);
+            });
+    }
+
+    JointSiteFrequencySpectrum
+    joint_sfs(const VariantMatrix& m,
+              const std::vector<std::int32_t>& populations,
+              const std::vector<std::int8_t>& refstates,
+              const std::vector<std::uint32_t>& nsam)
+    {
+        check_refstates(refstates, m.nsites(), nstates(m));
+        return joint_sfs_details(
+            m, populations, nsam,
+            [&refstates](const std::size_t site,
+                         const std::vector<std::int32_t>&) {
+                return static_cast<std::int32_t>(refstates[site]);
+            });
+    }
+
+    JointSiteFrequencySpectrum
+    folded_joint_sfs(const VariantMatrix& m,
+                     const std::vector<std::int32_t>& populations,
+                     const std::vector<std::uint32_t>& nsam)
+    {
+        return fold(joint_sfs_details(
+            m, populations, nsam,
+            [](const std::size_t, const std::vector<std::int32_t>& pooled) {
+                return static_cast<std::int32_t>(
+                    major_state(pooled.data(), pooled.size()));
+            }));
+    }
+
+    JointSiteFrequencySpectrum
+    fold(const JointSiteFrequencySpectrum& sfs)
+    {
+        if (sfs.folded)
+            {
+                return sfs;
+            }
+        JointSiteFrequencySpectrum rv{ sfs.nsam, true, sfs.counts };
+        std::uint32_t total = 0;
+        for (auto n : sfs.nsam)
+            {
+                total += n;
+            }
+        // The mirror of element i, with n - i copies in each
+        // population, is at size - 1 - i.
+        const std::size_t size = rv.counts.size();
+        for (std::size_t i = 0; i < size; ++i)
+            {
+                std::size_t rest = i;
+                std::uint32_t copies = 0;
+                for (std::size_t q = sfs.nsam.size(); q-- > 0;)
+                    {
+                        copies += static_cast<std::uint32_t>(
+                            rest % (sfs.nsam[q] + 1));
+                        rest /= sfs.nsam[q] + 1;
+                    }
+                const std::size_t mirror = size - 1 - i;
+                if (2 * copies > total || (2 * copies == total && i > mirror))
+                    {
+                        rv.counts[mirror] += rv.counts[i];
+                        rv.counts[i] = 0.0;
+                    }
+            }
+        return rv;
+    }
+
+    double
+    thetapi(const SiteFrequencySpectrum& sfs)
+    {
+        const double n = static_cast<double>(sfs.nsam);
+        double pi = 0.0;
+        for (std::size_t i = 1; i < sfs.counts.size() && i < sfs.nsam; ++i)
+            {
+                const double di = static_cast<double>(i);
+                pi += di * (n - di) * sfs.counts[i];
+            }
+        return 2.0 * pi / (n * (n - 1.0));
+    }
+
+    double
+    thetaw(const SiteFrequencySpectrum& sfs)
+    {
+        return segregating_sites(sfs) / summstats_aux::a_sub_n(sfs.nsam);
+    }
+
+    double
+    tajd(const SiteFrequencySpectrum& sfs)
+    {
+        return summstats_aux::tajd(thetapi(sfs), segregating_sites(sfs),
+                                   sfs.nsam);
+    }
+
+    double
+    thetah(const SiteFrequencySpectrum& sfs)
+    {
+        check_unfolded(sfs);
+        const double n = static_cast<double>(sfs.nsam);
+        double h = 0.0;
+        for (std::size_t i = 1; i < sfs.nsam; ++i)
+            {
+                h += std::pow(static_cast<double>(i), 2.0) * sfs.counts[i];
+            }
+        return 2.0 * h / (n * (n - 1.0));
+    }
+
+    double
+    thetal(const SiteFrequencySpectrum& sfs)
+    {
+        check_unfolded(sfs);
+        double l = 0.0;
+        for (std::size_t i = 1; i < sfs.nsam; ++i)
+            {
+                l += static_cast<double>(i) * sfs.counts[i];
+            }
+        return l / (static_cast<double>(sfs.nsam) - 1.0);
+    }
+
+    double
+    faywuh(const SiteFrequencySpectrum& sfs)
+    {
+        check_unfolded(sfs);
+        if (segregating_sites(sfs) == 0.0)
+            {
+                return std::numeric_limits<double>::quiet_NaN();
+            }
+        return thetapi(sfs) - thetah(sfs);
+    }
+
+    double
+    zenge(const SiteFrequencySpectrum& sfs)
+    {
+        check_unfolded(sfs);
+        const double S = segregating_sites(sfs);
+        if (S == 0.0)
+            {
+                return std::numeric_limits<double>::quiet_NaN();
+            }
+        const double n = static_cast<double>(sfs.nsam);
+        const double a = summstats_aux::a_sub_n(sfs.nsam),
+                     b = summstats_aux::b_sub_n(sfs.nsam);
+        const double tw = S / a, tsq = S * (S - 1.0) / (a * a + b);
+        // Zeng et al. (2006), equation 14
+        const double variance
+            = (n / (2.0 * (n - 1.0)) - 1.0 / a) * tw
+              + (b / (a * a) + 2.0 * std::pow(n / (n - 1.0), 2.0) * b
+                 - 2.0 * (n * b - n + 1.0) / ((n - 1.0) * a)
+                 - (3.0 * n + 1.0) / (n - 1.0))
+                    * tsq;
+        return (thetal(sfs) - tw) / std::sqrt(variance);
+    }
+} // namespace Sequence
@@ -0,0 +1,309 @@
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <Sequence/summstats/snn.hpp>
+#include <Sequence/summstats/classics.hpp>
+#include "../worker_threads.hpp"
+
+namespace
+{
+    // Number of permutations shuffled by one random
+    // number generator, and given to a thread at a time.
+    constexpr std::uint32_t PERM_BATCH = 1024;
+
+    struct nearest_neighbors
+    // The nearest neighbors of sample k are
+    // neighbors[offsets[k]] to neighbors[offsets[k+1]-1].
+    // Samples are numbered by their position in the
+    // samples used for a test.
+    {
+        std::vector<std::uint32_t> offsets, neighbors;
+    };
+
+    nearest_neighbors
+    find_nearest_neighbors(const std::vector<std::int32_t>& diffs,
+                           const std::size_t nsam,
+                           const std::vector<std::size_t>& samples)
+    // diffs is the output of difference_matrix for nsam samples.
+    {
+        auto ndiffs = [&diffs, nsam](std::size_t i, std::size_t j) {
+            if (i > j)
+                {
+                    std::swap(i, j);
+                }
+            return diffs[i * nsam - i * (i + 1) / 2 + j - i - 1];
+        };
+        nearest_neighbors nn;
+        nn.offsets.reserve(samples.size() + 1);
+        nn.offsets.push_back(0);
+        for (std::size_t k = 0; k < samples.size(); ++k)
+            {
+                auto min = std::numeric_limits<std::int32_t>::max();
+                for (std::size_t j = 0; j < samples.size(); ++j)
+                    {
+                        if (j != k)
+                            {
+                                min = std::min(
+                                    min, ndiffs(samples[k], samples[j]));
+                            }
+                    }
+                for (std::size_t j = 0; j < samples.size(); ++j)
+                    {
+                        if (j != k && ndiffs(samples[k], samples[j]) == min)
+                            {
+                                nn.neighbors.push_back(
+                                    static_cast<std::uint32_t>(j));
+                            }
+                    }
+                nn.offsets.push_back(
+                    static_cast<std::uint32_t>(nn.neighbors.size()));
+            }
+        return nn;
+    }
+
+    double
+    snn_statistic(const nearest_neighbors& nn, const std::int32_t* labels)
+    {
+        const std::size_t nsam = nn.offsets.size() - 1;
+        double snn = 0.0;
+        for (std::size_t k = 0; k < nsam; ++k)
+            {
+                std::uint32_t same = 0;
+                for (std::uint32_t i = nn.offsets[k]; i < nn.offsets[k + 1];
+                     ++i)
+                    {
+                        same += (labels[nn.neighbors[i]] == labels[k]);
+                    }
+                snn += static_cast<double>(same)
+                       / static_cast<double>(nn.offsets[k + 1]
+                                             - nn.offsets[k]);
+            }
+        return snn / static_cast<double>(nsam);
+    }
+
+    struct batch_result
+    {
+        std::uint32_t nextreme;
+        // Positions within the batch of the extreme permutations.
+        // Only kept when stopping early.
+        std::vector<std::uint32_t> extremes;
+    };
+
+    Sequence::SnnTestResult
+    run_test(const nearest_neighbors& nn,
+             const std::vector<std::int32_t>& labels,
+             const std::uint32_t nperms, const std::uint64_t seed,
+             const std::uint32_t stream, const unsigned nthreads,
+             const std::uint32_t stop_after)
+    // Each batch of permutations gets its own generator, seeded
+    // from seed, stream and the index of the batch, and batches
+    // are merged in order, so the result does not depend on
+    // nthreads.
+    {
+        Sequence::SnnTestResult rv;
+        rv.snn = snn_statistic(nn, labels.data());
+        rv.nperms = rv.nextreme = 0;
+        const std::uint32_t nbatches
+            = nperms / PERM_BATCH + (nperms % PERM_BATCH != 0);
+        // When stopping early, only a few batches per thread are
+        // done before checking whether to stop.
+        const std::uint32_t round
+            = (stop_after > 0) ? std::min<std::uint32_t>(nthreads, nbatches)
+                               : nbatches;
+        std::vector<batch_result> results;
+        bool stopped = false;
+        for (std::uint32_t first = 0; first < nbatches && !stopped;
+             first += round)
+            {
+                const std::uint32_t last
+                    = std::min<std::uint32_t>(nbatches, first + round);
+                results.resize(last - first);
+                Sequence::detail::run_strided(
+                    last - first, nthreads, [&](const std::size_t b) {
+                        const auto batch
+                            = first + static_cast<std::uint32_t>(b);
+                        std::seed_seq seq{
+                            static_cast<std::uint32_t>(seed),
+                            static_cast<std::uint32_t>(seed >> 32), stream,
+                            batch
+                        };
+                        std::mt19937 generator(seq);
+                        const auto n = static_cast<std::uint32_t>(
+                            std::min<std::uint64_t>(
+                                PERM_BATCH,
+                                nperms - std::uint64_t(batch) * PERM_BATCH));
+                        auto permuted = labels;
+                        auto& r = results[b];
+                        r.nextreme = 0;
+                        r.extremes.clear();
+                        for (std::uint32_t p = 0; p < n; ++p)
+                            {
+                                std::shuffle(permuted.begin(), permuted.end(),
+                                             generator);
+                                if (snn_statistic(nn, permuted.data())
+                                    >= rv.snn)
+                                    {
+                                        ++r.nextreme;
+                                        if (stop_after > 0)
+                                            {
+                                                r.extremes.push_back(p);
+                                            }
+                                    }
+                            }
+                    });
+                for (std::uint32_t b = first; b < last && !stopped; ++b)
+                    {
+                        const auto& r = results[b - first];
+                        if (stop_after > 0
+                            && rv.nextreme + r.nextreme >= stop_after)
+                            {
+                                rv.nperms = static_cast<std::uint32_t>(
+                                    std::uint64_t(b) * PERM_BATCH
+                                    + r.extremes[stop_after - rv.nextreme
+                                                 - 1]
+                                    + 1);
+                                rv.nextreme = stop_after;
+                                stopped = true;
+                            }
+                        else
+                            {
+                                rv.nextreme += r.nextreme;
+                                // In 64 bits, as (b + 1) * PERM_BATCH
+                                // may exceed the range of nperms.
+                                rv.nperms = static_cast<std::uint32_t>(
+                                    std::min<std::uint64_t>(
+                                        nperms,
+                                        (std::uint64_t(b) + 1) * PERM_BATCH));
+                            }
+                    }
+            }
+        rv.pvalue = (rv.nperms > 0) ? static_cast<double>(rv.nextreme)
+                                          / static_cast<double>(rv.nperms)
+                                    : std::numeric_limits<double>::quiet_NaN();
+        return rv;
+    }
+
+    std::vector<std::size_t>
+    used_samples(const Sequence::VariantMatrix& m,
+                 const std::vector<std::int32_t>& populations)
+    {
+        if (populations.size() != m.nsam())
+            {
+                throw std::invalid_argument(
+                    "populations must contain one label per sample");
+            }
+        std::vector<std::size_t> samples;
+        for (std::size_t i = 0; i < populations.size(); ++i)
+            {
+                if (populations[i] >= 0)
+                    {
+                        samples.push_back(i);
+                    }
+            }
+        if (samples.size() < 2)
+            {
+                throw std::invalid_argument(
+                    "at least two samples must have population labels");
+            }
+        return samples;
+    }
+
+    std::vector<std::int32_t>
+    sample_labels(const std::vector<std::int32_t>& populations,
+                  const std::vector<std::size_t>& samples)
+    {
+        std::vector<std::int32_t> labels;
+        labels.reserve(samples.size());
+        for (auto i : samples)
+            {
+                labels.push_back(populations[i]);
+            }
+        return labels;
+    }
+} // namespace
+
+namespace Sequence
+{
+    double
+    snn(const VariantMatrix& m, const std::vector<std::int32_t>& populations)
+    {
+        const auto samples = used_samples(m, populations);
+        const auto nn = find_nearest_neighbors(difference_matrix(m), m.nsam(),
+                                               samples);
+        return snn_statistic(nn, sample_labels(populations, samples).data());
+    }
+
+    SnnTestResult
+    snn_test(const VariantMatrix& m,
+             const std::vector<std::int32_t>& populations,
+             const std::uint32_t nperms, const std::uint64_t seed,
+             const unsigned nthreads, const std::uint32_t stop_after)
+    {
+        if (nthreads == 0)
+            {
+                throw std::invalid_argument("nthreads must be > 0");
+            }
+        const auto samples = used_samples(m, populations);
+        const auto nn = find_nearest_neighbors(difference_matrix(m), m.nsam(),
+                                               samples);
+        return run_test(nn, sample_labels(populations, samples), nperms,
+                        seed, 0, nthreads, stop_after);
+    }
+
+    std::vector<SnnPairwiseTestResult>
+    snn_test_pairwise(const VariantMatrix& m,
+                      const std::vector<std::int32_t>& populations,
+                      const std::uint32_t nperms, const std::uint64_t seed,
+                      const unsigned nthreads,
+                      const std::uint32_t stop_after)
+    {
+        if (nthreads == 0)
+            {
+                throw std::invalid_argument("nthreads must be > 0");
+            }
+        used_samples(m, populations);
+        std::vector<std::int32_t> pops;
+        for (auto p : populations)
+            {
+                if (p >= 0)
+                    {
+                        pops.push_back(p);
+                    }
+            }
+        std::sort(pops.begin(), pops.end());
+        pops.erase(std::unique(pops.begin(), pops.end()), pops.end());
+
+        const auto diffs = difference_matrix(m);
+        std::vector<SnnPairwiseTestResult> rv;
+        std::vector<std::size_t> samples;
+        std::uint32_t stream = 0;
+        for (std::size_t i = 0; i + 1 < pops.size(); ++i)
+            {
+                for (std::size_t j = i + 1; j < pops.size(); ++j)
+                    {
+                        samples.clear();
+                        for (std::size_t k = 0; k < populations.size(); ++k)
+                            {
+                                if (populations[k] == pops[i]
+                                    || populations[k] == pops[j])
+                                    {
+                                        samples.push_back(k);
+                                    }
+                            }
+                        const auto nn
+                            = find_nearest_neighbors(diffs, m.nsam(), samples);
+                        SnnPairwiseTestResult r;
+                        static_cast<SnnTestResult&>(r) = run_test(
+                            nn, sample_labels(populations, samples), nperms,
+                            seed, stream++, nthreads, stop_after);
+                        r.pop1 = pops[i];
+                        r.pop2 = pops[j];
+                        rv.push_back(r);
+                    }
+            }
+        return rv;
+    }
+} // namespace Sequence
@@ -0,0 +1,238 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <Sequence/summstats/statistic_plan.hpp>
+#include <Sequence/summstats/auxillary.hpp>
+
+namespace
+{
+    constexpr unsigned REF_STATISTICS
+        = Sequence::SummaryStatistic::thetah
+          | Sequence::SummaryStatistic::thetal
+          | Sequence::SummaryStatistic::faywuh
+          | Sequence::SummaryStatistic::hprime;
+
+    struct row_totals
+    // Sums over rows.  The names of the per-row terms follow the
+    // implementations of the individual statistics.
+    {
+        double pi, w, tajd_pi, h, l, fw_pi, fw_h, fw_l;
+        unsigned S, fw_S;
+        std::int32_t max_nsam;
+        std::uint32_t nvariable, nbiallelic, nmutations;
+        row_totals()
+            : pi{ 0.0 }, w{ 0.0 }, tajd_pi{ 0.0 }, h{ 0.0 }, l{ 0.0 },
+              fw_pi{ 0.0 }, fw_h{ 0.0 }, fw_l{ 0.0 }, S{ 0 }, fw_S{ 0 },
+              max_nsam{ 0 }, nvariable{ 0 }, nbiallelic{ 0 }, nmutations{ 0 }
+        {
+        }
+    };
+} // namespace
+
+namespace Sequence
+{
+    SummaryStatisticPlan::SummaryStatisticPlan(const unsigned requested)
+        : statistics{ requested & SummaryStatistic::all }
+    {
+    }
+
+    unsigned
+    SummaryStatisticPlan::requested() const
+    {
+        return statistics;
+    }
+
+    bool
+    SummaryStatisticPlan::needs_refstate() const
+    {
+        return statistics & REF_STATISTICS;
+    }
+
+    SummaryStatistics
+    SummaryStatisticPlan::operator()(const AlleleCountMatrix& ac,
+                                     const std::int8_t refstate) const
+    {
+        if (needs_refstate() && !ac.counts.empty()
+            && static_cast<std::size_t>(refstate) >= ac.ncol)
+            {
+                throw std::invalid_argument(
+                    "reference state greater than max allelic state");
+            }
+        return apply(ac, &refstate, 0);
+    }
+
+    SummaryStatistics
+    SummaryStatisticPlan::operator()(
+        const AlleleCountMatrix& ac,
+        const std::vector<std::int8_t>& refstates) const
+    {
+        if (needs_refstate() && !ac.counts.empty())
+            {
+                if (refstates.size() != ac.counts.size() / ac.ncol)
+                    {
+                        throw std::invalid_argument(
+                            "incorrect number of reference states");
+                    }
+                if (std::all_of(refstates.begin(), refstates.end(),
+                                [](const std::int8_t i) { return i < 0; }))
+                    {
+                        throw std::invalid_argument(
+                            "all reference states encoded as missing");
+                    }
+            }
+        return apply(ac, refstates.data(), 1);
+    }
+
+    SummaryStatistics
+    SummaryStatisticPlan::apply(const AlleleCountMatrix& ac,
+                                const std::int8_t* refstates,
+                                const std::size_t refstride) const
+    // The state of row i is refstates[i*refstride]
+    {
+        const bool need_ref = needs_refstate(),
+                   need_hl = statistics
+                             & (SummaryStatistic::thetah
+                                | SummaryStatistic::thetal),
+                   need_fw = statistics
+                             & (SummaryStatistic::faywuh
+                                | SummaryStatistic::hprime);
+        const double nnm1 = static_cast<double>(ac.nsam * (ac.nsam - 1));
+        row_totals t;
+        std::size_t row = 0;
+        for (std::size_t i = 0; i < ac.counts.size(); i += ac.ncol, ++row)
+            {
+                const std::int32_t* c = ac.counts.data() + i;
+                std::int32_t nsam = 0;
+                unsigned nstates = 0;
+                double homozygosity = 0.0;
+                for (std::size_t j = 0; j < ac.ncol; ++j)
+                    {
+                        nsam += c[j];
+                        nstates += (c[j] > 0);
+                        homozygosity += static_cast<double>(c[j] * (c[j] - 1));
+                    }
+                const double pi
+                    = 1.0
+                      - homozygosity / static_cast<double>(nsam * (nsam - 1));
+                t.pi += pi;
+                if (nstates > 1)
+                    {
+                        t.w += static_cast<double>(nstates - 1)
+                               / summstats_aux::a_sub_n(
+                                   static_cast<std::uint32_t>(nsam));
+                        ++t.nvariable;
+                        t.nmutations += nstates - 1;
+                    }
+                t.nbiallelic += (nstates == 2);
+                if (nstates)
+                    {
+                        t.max_nsam = std::max(t.max_nsam, nsam);
+                        t.S += nstates - 1;
+                        t.tajd_pi += pi;
+                    }
+                if (!need_ref || refstates[row * refstride] < 0)
+                    {
+                        continue;
+                    }
+                const auto refindex
+                    = static_cast<std::size_t>(refstates[row * refstride]);
+                if (refindex >= ac.ncol)
+                    {
+                        throw std::invalid_argument(
+                            "reference state greater than max allelic "
+                            "state");
+                    }
+                std::int32_t nnonref = 0;
+                double sum_sq = 0.0, sum = 0.0;
+                for (std::size_t j = 0; j < ac.ncol; ++j)
+                    {
+                        if (c[j] > 0 && j != refindex)
+                            {
+                                ++nnonref;
+                                sum_sq += std::pow(c[j], 2.0);
+                                sum += static_cast<double>(c[j]);
+                            }
+                    }
+                const bool ref_seen = c[refindex] > 0;
+                if (need_hl && nnonref > 1)
+                    {
+                        throw std::runtime_error(
+                            "site has more than one derived state");
+                    }
+                if (need_fw && nstates > 2)
+                    {
+                        throw std::runtime_error(
+                            "site has more than one derived state");
+                    }
+                if (need_hl && ref_seen)
+                    {
+                        t.h += sum_sq
+                               * (2.0 / static_cast<double>(nsam * (nsam - 1)));
+                        t.l += sum * (1. / static_cast<double>(nsam - 1));
+                    }
+                if (need_fw)
+                    {
+                        t.fw_S += (nstates > 1);
+                        if (ref_seen)
+                            {
+                                t.fw_pi += 1.0 - homozygosity / nnm1;
+                                t.fw_h += sum_sq
+                                          * (2. / static_cast<double>(
+                                                 ac.nsam * (ac.nsam - 1)));
+                                t.fw_l += sum
+                                          * (1. / static_cast<double>(
+                                                 ac.nsam - 1));
+                            }
+                    }
+            }
+
+        const auto nan = std::numeric_limits<double>::quiet_NaN();
+        SummaryStatistics rv{ nan, nan, nan, nan, nan, nan, nan, 0, 0, 0 };
+        if (statistics & SummaryStatistic::thetapi)
+            {
+                rv.thetapi = t.pi;
+            }
+        if (statistics & SummaryStatistic::thetaw)
+            {
+                rv.thetaw = t.w;
+            }
+        if (statistics & SummaryStatistic::tajd)
+            {
+                rv.tajd = summstats_aux::tajd(
+                    t.tajd_pi, t.S, static_cast<std::uint32_t>(t.max_nsam));
+            }
+        if (statistics & SummaryStatistic::thetah)
+            {
+                rv.thetah = t.h;
+            }
+        if (statistics & SummaryStatistic::thetal)
+            {
+                rv.thetal = t.l;
+            }
+        if ((statistics & SummaryStatistic::faywuh) && !ac.counts.empty()
+            && t.fw_S)
+            {
+                rv.faywuh = t.fw_pi - t.fw_h;
+            }
+        if ((statistics & SummaryStatistic::hprime) && !ac.counts.empty())
+            {
+                rv.hprime = summstats_aux::hprime(
+                    static_cast<std::uint32_t>(ac.nsam), t.fw_S, t.fw_pi,
+                    t.fw_l);
+            }
+        if (statistics & SummaryStatistic::nvariable_sites)
+            {
+                rv.nvariable_sites = t.nvariable;
+            }
+        if (statistics & SummaryStatistic::nbiallelic_sites)
+            {
+                rv.nbiallelic_sites = t.nbiallelic;
+            }
+        if (statistics & SummaryStatistic::total_number_of_mutations)
+            {
+                rv.total_number_of_mutations = t.nmutations;
+            }
+        return rv;
+    }
+} // namespace Sequence
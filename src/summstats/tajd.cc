@@ -1,5 +1,4 @@
-#include <cmath>
-#include <limits>
+#include <algorithm>
 #include <Sequence/AlleleCountMatrix.hpp>
 #include <Sequence/summstats/auxillary.hpp>
 
@@ -36,22 +35,7 @@ namespace Sequence
                                     / static_cast<double>(nsam * (nsam - 1));
                     }
             }
-        if (!S)
-            {
-                return std::numeric_limits<double>::quiet_NaN();
-            }
-        auto a1 = summstats_aux::a_sub_n(static_cast<std::uint32_t>(max_nsam));
-        double w = static_cast<double>(S) / a1;
-        auto a2 = summstats_aux::b_sub_n(static_cast<std::uint32_t>(max_nsam));
-        auto dn = static_cast<double>(max_nsam);
-        double b1 = (dn + 1.0) / (3.0 * (dn - 1.0));
-        double b2
-            = (2.0 * (std::pow(dn, 2.0) + dn + 3.0)) / (9.0 * dn * (dn - 1.0));
-        double c1 = b1 - 1.0 / a1;
-        double c2 = b2 - (dn + 2.0) / (a1 * dn) + a2 / std::pow(a1, 2.0);
-        double e1 = c1 / a1;
-        double e2 = c2 / (std::pow(a1, 2.0) + a2);
-        double denominator = std::pow((e1 * S + e2 * S * (S - 1.0)), 0.5);
-        return (pi - w) / denominator;
+        return summstats_aux::tajd(pi, static_cast<unsigned>(S),
+                                   static_cast<std::uint32_t>(max_nsam));
     }
 } // namespace Sequence
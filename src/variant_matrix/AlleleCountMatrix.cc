@@ -1,6 +1,9 @@
 #include <stdexcept>
 #include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/FilteredCapsules.hpp>
 #include <Sequence/StateCounts.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include "../summstats/bitpacked_kernels.hpp"
 
 namespace Sequence
 {
@@ -11,12 +14,34 @@ namespace Sequence
             {
                 throw std::invalid_argument("matrix max_allele must be >= 0");
             }
+        if (auto bp = summstats_details::as_bitpacked(m))
+            {
+                return summstats_details::bitpacked_allele_counts(
+                    *bp, static_cast<std::size_t>(m.max_allele() + 1));
+            }
         std::vector<std::int32_t> counts;
         counts.reserve(m.nsam() * static_cast<std::size_t>(m.max_allele() + 1));
         StateCounts c;
+        // Rows of a filtered view whose samples are one run are
+        // read in place.  Otherwise, one site at a time is gathered
+        // into a scratch row, rather than gathering the whole view.
+        auto f = dynamic_cast<const FilteredGenotypeCapsule*>(
+            m.genotype_capsule());
+        const bool gather = f && !f->samples().contiguous();
+        std::vector<std::int8_t> scratch(gather ? m.nsam() : 0);
+        const auto g = f ? ConstGenotypeSpan(nullptr, 0, 0, 0)
+                         : get_ConstGenotypeSpan(m);
         for (std::size_t i = 0; i < m.nsites(); ++i)
             {
-                auto r = get_ConstRowView(m, i);
+                ConstRowView r(scratch.data(), scratch.size());
+                if (gather)
+                    {
+                        f->gather_row(i, scratch.data());
+                    }
+                else
+                    {
+                        r = f ? f->row(i) : g.row(i);
+                    }
                 if (static_cast<std::int8_t>(c.max_allele_idx) > m.max_allele())
                     {
                         throw std::runtime_error("found allele value greater "
@@ -80,10 +80,11 @@ namespace Sequence
             }
         std::vector<StateCounts> rv;
         rv.reserve(m.nsites());
-        for (std::size_t i = 0; i < m.nsites(); ++i)
+        const auto g = get_ConstGenotypeSpan(m);
+        for (std::size_t i = 0; i < g.nsites; ++i)
             {
                 StateCounts c(refstates[i]);
-                auto r = get_RowView(m, i);
+                auto r = g.row(i);
                 c(r);
                 rv.emplace_back(std::move(c));
             }
@@ -99,10 +100,11 @@ namespace Sequence
             }
         std::vector<StateCounts> rv;
         rv.reserve(m.nsites());
-        for (std::size_t i = 0; i < m.nsites(); ++i)
+        const auto g = get_ConstGenotypeSpan(m);
+        for (std::size_t i = 0; i < g.nsites; ++i)
             {
                 StateCounts c(refstate);
-                auto r = get_RowView(m, i);
+                auto r = g.row(i);
                 c(r);
                 rv.emplace_back(std::move(c));
             }
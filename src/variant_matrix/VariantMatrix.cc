@@ -41,7 +41,7 @@ namespace Sequence
     double
     VariantMatrix::position(std::size_t i) const
     {
-        return pcapsule->operator[](i);
+        return extract_const_ptr(pcapsule)->operator[](i);
     }
 
     const double&
@@ -66,7 +66,7 @@ namespace Sequence
     const double*
     VariantMatrix::pbegin() const
     {
-        return pcapsule->begin();
+        return extract_const_ptr(pcapsule)->begin();
     }
 
     const double*
@@ -85,7 +85,7 @@ namespace Sequence
     const double*
     VariantMatrix::pend() const
     {
-        return pcapsule->end();
+        return extract_const_ptr(pcapsule)->end();
     }
 
     const double*
@@ -107,7 +107,7 @@ namespace Sequence
     VariantMatrix::get(const std::size_t site,
                        const std::size_t haplotype) const
     {
-        return capsule->operator()(site, haplotype);
+        return extract_const_ptr(capsule)->operator()(site, haplotype);
     }
 
     const std::int8_t&
@@ -139,7 +139,7 @@ namespace Sequence
                 throw std::out_of_range(
                     "VariantMatrix::at -- index out of range");
             }
-        return capsule->operator()(site, haplotype);
+        return extract_const_ptr(capsule)->operator()(site, haplotype);
     }
 
     const std::int8_t&
@@ -164,7 +164,7 @@ namespace Sequence
     const std::int8_t*
     VariantMatrix::data() const
     {
-        return capsule->data();
+        return extract_const_ptr(capsule)->data();
     }
 
     const std::int8_t*
@@ -225,6 +225,12 @@ namespace Sequence
         return capsule->stride();
     }
 
+    const GenotypeCapsule*
+    VariantMatrix::genotype_capsule() const
+    {
+        return capsule.get();
+    }
+
     void
     swap(VariantMatrix& a, VariantMatrix& b)
     {
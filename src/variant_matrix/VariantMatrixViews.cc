@@ -1,8 +1,19 @@
 #include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/FilteredCapsules.hpp>
 #include <stdexcept>
 
 namespace
 {
+    template <typename T>
+    Sequence::internal::genotype_span_<T>
+    make_span(T data, const Sequence::VariantMatrix& m)
+    {
+        return Sequence::internal::genotype_span_<T>(
+            data + m.genotype_row_offset() * m.genotype_stride()
+                + m.genotype_col_offset(),
+            m.nsites(), m.nsam(), m.genotype_stride());
+    }
+
     template <typename T, typename VM>
     T
     row_view_wrapper(VM& m, const std::size_t row)
@@ -11,9 +22,7 @@ namespace
             {
                 throw std::out_of_range("row index out of range");
             }
-        auto x = m.data() + m.genotype_row_offset() * m.genotype_stride()
-                 + m.genotype_col_offset() + row * m.genotype_stride();
-        return T(x, m.nsam());
+        return make_span(m.data(), m).row(row);
     }
 
     template <typename T, typename VM>
@@ -24,35 +33,47 @@ namespace
             {
                 throw std::out_of_range("column index out of range");
             }
-        auto x = m.data() + m.genotype_row_offset() * m.genotype_stride()
-                 + m.genotype_col_offset() + col;
-        return T(x, m.genotype_stride() * m.nsites(), m.genotype_stride());
+        return make_span(m.data(), m).col(col);
     }
 
-    template <typename T, typename VM>
-    T
-    const_row_view_wrapper(VM& m, const std::size_t row)
+    const Sequence::FilteredGenotypeCapsule*
+    as_filtered(const Sequence::VariantMatrix& m)
+    // Filtered views make their own row and column views
+    // and spans, as their sites and samples need not be
+    // evenly spaced.
+    {
+        return dynamic_cast<const Sequence::FilteredGenotypeCapsule*>(
+            m.genotype_capsule());
+    }
+
+    Sequence::ConstRowView
+    const_row_view_wrapper(const Sequence::VariantMatrix& m,
+                           const std::size_t row)
     {
         if (row >= m.nsites())
             {
                 throw std::out_of_range("row index out of range");
             }
-        auto x = m.cdata() + m.genotype_row_offset() * m.genotype_stride()
-                 + m.genotype_col_offset() + row * m.genotype_stride();
-        return T(x, m.nsam());
+        if (auto f = as_filtered(m))
+            {
+                return f->row(row);
+            }
+        return make_span(m.cdata(), m).row(row);
     }
 
-    template <typename T, typename VM>
-    T
-    const_col_view_wrapper(VM& m, const std::size_t col)
+    Sequence::ConstColView
+    const_col_view_wrapper(const Sequence::VariantMatrix& m,
+                           const std::size_t col)
     {
         if (col >= m.nsam())
             {
                 throw std::out_of_range("column index out of range");
             }
-        auto x = m.cdata() + m.genotype_row_offset() * m.genotype_stride()
-                 + m.genotype_col_offset() + col;
-        return T(x, m.genotype_stride() * m.nsites(), m.genotype_stride());
+        if (auto f = as_filtered(m))
+            {
+                return f->col(col);
+            }
+        return make_span(m.cdata(), m).col(col);
     }
 } // namespace
 
@@ -62,7 +83,7 @@ namespace Sequence
     ConstRowView
     get_RowView(const VariantMatrix& m, const std::size_t row)
     {
-        return row_view_wrapper<ConstRowView>(m, row);
+        return const_row_view_wrapper(m, row);
     }
 
     RowView
@@ -74,13 +95,13 @@ namespace Sequence
     ConstRowView
     get_ConstRowView(const VariantMatrix& m, const std::size_t row)
     {
-        return const_row_view_wrapper<ConstRowView>(m, row);
+        return const_row_view_wrapper(m, row);
     }
 
     ConstRowView
     get_ConstRowView(VariantMatrix& m, const std::size_t row)
     {
-        return const_row_view_wrapper<ConstRowView>(m, row);
+        return const_row_view_wrapper(m, row);
     }
 
     ColView
@@ -92,18 +113,34 @@ namespace Sequence
     ConstColView
     get_ColView(const VariantMatrix& m, const std::size_t col)
     {
-        return col_view_wrapper<ConstColView>(m, col);
+        return const_col_view_wrapper(m, col);
     }
 
     ConstColView
     get_ConstColView(VariantMatrix& m, const std::size_t col)
     {
-        return const_col_view_wrapper<ConstColView>(m, col);
+        return const_col_view_wrapper(m, col);
     }
 
     ConstColView
     get_ConstColView(const VariantMatrix& m, const std::size_t col)
     {
-        return const_col_view_wrapper<ConstColView>(m, col);
+        return const_col_view_wrapper(m, col);
+    }
+
+    GenotypeSpan
+    get_GenotypeSpan(VariantMatrix& m)
+    {
+        return make_span(m.data(), m);
+    }
+
+    ConstGenotypeSpan
+    get_ConstGenotypeSpan(const VariantMatrix& m)
+    {
+        if (auto f = as_filtered(m))
+            {
+                return f->span();
+            }
+        return make_span(m.cdata(), m);
     }
 } // namespace Sequence
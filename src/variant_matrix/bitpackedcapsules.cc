@@ -0,0 +1,283 @@
+#include <Sequence/BitPackedCapsules.hpp>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <mutex>
+
+namespace
+{
+    // operator() must return a reference, so we
+    // hand out references to these values.
+    const std::int8_t STATES[3] = { 0, 1, -1 };
+
+    void
+    raise()
+    {
+        throw std::runtime_error("data are read-only");
+    }
+
+    std::size_t
+    words_needed(const std::size_t nsam)
+    {
+        return nsam / Sequence::BitPackedGenotypeCapsule::word_bits
+               + (nsam % Sequence::BitPackedGenotypeCapsule::word_bits != 0);
+    }
+} // namespace
+
+namespace Sequence
+{
+    BitPackedGenotypeCapsule::BitPackedGenotypeCapsule(
+        const std::vector<std::int8_t>& data, const std::size_t num_rows)
+        : BitPackedGenotypeCapsule(
+              data.data(), num_rows, (num_rows > 0) ? data.size() / num_rows : 0,
+              0, 0, (num_rows > 0) ? data.size() / num_rows : 0)
+    {
+    }
+
+    BitPackedGenotypeCapsule::BitPackedGenotypeCapsule(
+        const std::int8_t* data, std::size_t nrow, std::size_t ncol,
+        std::size_t row_offset, std::size_t column_offset,
+        std::size_t trailing)
+        : bits(), missing(), nsites_(nrow), nsam_(ncol),
+          nwords(words_needed(ncol)), has_missing_(false), unpacked()
+    {
+        bits.resize(nsites_ * nwords, 0);
+        missing.resize(nsites_ * nwords, 0);
+        const std::int8_t* start
+            = data + row_offset * trailing + column_offset;
+        for (std::size_t site = 0; site < nsites_; ++site)
+            {
+                const std::int8_t* row = start + site * trailing;
+                word_type* b = bits.data() + site * nwords;
+                word_type* m = missing.data() + site * nwords;
+                for (std::size_t i = 0; i < nsam_; ++i)
+                    {
+                        const word_type bit = word_type(1) << (i % word_bits);
+                        if (row[i] == 1)
+                            {
+                                b[i / word_bits] |= bit;
+                            }
+                        else if (row[i] == VariantMatrix::mask)
+                            {
+                                throw std::invalid_argument(
+                                    "reserved value encountered");
+                            }
+                        else if (row[i] < 0)
+                            {
+                                m[i / word_bits] |= bit;
+                                has_missing_ = true;
+                            }
+                        else if (row[i] != 0)
+                            {
+                                throw std::invalid_argument(
+                                    "bit-packed genotypes must be 0, 1, or "
+                                    "missing");
+                            }
+                    }
+            }
+    }
+
+    const std::int8_t*
+    BitPackedGenotypeCapsule::unpack() const
+    {
+        std::call_once(unpacked_flag, [this]() {
+            unpacked.resize(nsites_ * nsam_);
+            for (std::size_t site = 0; site < nsites_; ++site)
+                {
+                    for (std::size_t i = 0; i < nsam_; ++i)
+                        {
+                            unpacked[site * nsam_ + i]
+                                = this->operator()(site, i);
+                        }
+                }
+        });
+        return unpacked.data();
+    }
+
+    std::size_t
+    BitPackedGenotypeCapsule::words_per_row() const
+    {
+        return nwords;
+    }
+
+    const BitPackedGenotypeCapsule::word_type*
+    BitPackedGenotypeCapsule::row_bits(const std::size_t site) const
+    {
+        return bits.data() + site * nwords;
+    }
+
+    const BitPackedGenotypeCapsule::word_type*
+    BitPackedGenotypeCapsule::row_missing(const std::size_t site) const
+    {
+        return missing.data() + site * nwords;
+    }
+
+    bool
+    BitPackedGenotypeCapsule::has_missing() const
+    {
+        return has_missing_;
+    }
+
+    std::size_t&
+    BitPackedGenotypeCapsule::nsites()
+    {
+        return nsites_;
+    }
+
+    std::size_t&
+    BitPackedGenotypeCapsule::nsam()
+    {
+        return nsam_;
+    }
+
+    std::size_t
+    BitPackedGenotypeCapsule::nsites() const
+    {
+        return nsites_;
+    }
+
+    std::size_t
+    BitPackedGenotypeCapsule::nsam() const
+    {
+        return nsam_;
+    }
+
+    std::size_t
+    BitPackedGenotypeCapsule::row_offset() const
+    {
+        return 0;
+    }
+
+    std::size_t
+    BitPackedGenotypeCapsule::col_offset() const
+    {
+        return 0;
+    }
+
+    std::size_t
+    BitPackedGenotypeCapsule::stride() const
+    {
+        return nsam_;
+    }
+
+    std::int8_t&
+    BitPackedGenotypeCapsule::operator()(std::size_t, std::size_t)
+    {
+        raise();
+        return const_cast<std::int8_t&>(STATES[0]);
+    }
+
+    const std::int8_t&
+    BitPackedGenotypeCapsule::operator()(std::size_t site,
+                                         std::size_t sample) const
+    {
+        const std::size_t word = site * nwords + sample / word_bits;
+        const word_type bit = word_type(1) << (sample % word_bits);
+        if (missing[word] & bit)
+            {
+                return STATES[2];
+            }
+        return STATES[(bits[word] & bit) != 0];
+    }
+
+    std::int8_t*
+    BitPackedGenotypeCapsule::data()
+    {
+        raise();
+        return nullptr;
+    }
+
+    const std::int8_t*
+    BitPackedGenotypeCapsule::data() const
+    {
+        return unpack();
+    }
+
+    const std::int8_t*
+    BitPackedGenotypeCapsule::cdata() const
+    {
+        return unpack();
+    }
+
+    std::unique_ptr<GenotypeCapsule>
+    BitPackedGenotypeCapsule::clone() const
+    {
+        std::unique_ptr<BitPackedGenotypeCapsule> rv(
+            new BitPackedGenotypeCapsule(nullptr, 0, 0, 0, 0, 0));
+        rv->bits = this->bits;
+        rv->missing = this->missing;
+        rv->nsites_ = this->nsites_;
+        rv->nsam_ = this->nsam_;
+        rv->nwords = this->nwords;
+        rv->has_missing_ = this->has_missing_;
+        return std::unique_ptr<GenotypeCapsule>(rv.release());
+    }
+
+    std::int8_t*
+    BitPackedGenotypeCapsule::begin()
+    {
+        raise();
+        return nullptr;
+    }
+
+    const std::int8_t*
+    BitPackedGenotypeCapsule::begin() const
+    {
+        return unpack();
+    }
+
+    std::int8_t*
+    BitPackedGenotypeCapsule::end()
+    {
+        raise();
+        return nullptr;
+    }
+
+    const std::int8_t*
+    BitPackedGenotypeCapsule::end() const
+    {
+        return unpack() + nsites_ * nsam_;
+    }
+
+    const std::int8_t*
+    BitPackedGenotypeCapsule::cbegin() const
+    {
+        return begin();
+    }
+
+    const std::int8_t*
+    BitPackedGenotypeCapsule::cend() const
+    {
+        return end();
+    }
+
+    bool
+    BitPackedGenotypeCapsule::empty() const
+    {
+        return nsam_ == 0 || nsites_ == 0;
+    }
+
+    std::size_t
+    BitPackedGenotypeCapsule::size() const
+    {
+        return nsam_ * nsites_;
+    }
+
+    bool
+    BitPackedGenotypeCapsule::resizable() const
+    {
+        return false;
+    }
+
+    VariantMatrix
+    make_bitpacked(const VariantMatrix& m)
+    {
+        std::unique_ptr<GenotypeCapsule> gc(new BitPackedGenotypeCapsule(
+            m.cdata(), m.nsites(), m.nsam(), m.genotype_row_offset(),
+            m.genotype_col_offset(), m.genotype_stride()));
+        std::unique_ptr<PositionCapsule> pc(new VectorPositionCapsule(
+            std::vector<double>(m.cpbegin(), m.cpend())));
+        return VariantMatrix(std::move(gc), std::move(pc),
+                             std::min(m.max_allele(), std::int8_t(1)));
+    }
+} // namespace Sequence
@@ -0,0 +1,405 @@
+#include <Sequence/FilteredCapsules.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    void
+    raise()
+    {
+        throw std::runtime_error("data are read-only");
+    }
+
+    void
+    check_indexes(const Sequence::IndexRuns& indexes, const std::size_t bound)
+    {
+        for (std::size_t r = 0; r < indexes.nruns(); ++r)
+            {
+                if (indexes.run_first(r) + indexes.run_length(r) > bound)
+                    {
+                        throw std::out_of_range("filtered index out of range");
+                    }
+            }
+    }
+
+    void
+    not_contiguous()
+    {
+        throw std::runtime_error(
+            "filtered view is not contiguous in the parent data; use "
+            "get_ConstGenotypeSpan, row or column views, or "
+            "Sequence::materialize");
+    }
+} // namespace
+
+namespace Sequence
+{
+    IndexRuns::IndexRuns() : first_(), end_() {}
+
+    IndexRuns::IndexRuns(const std::size_t first, const std::size_t n)
+        : first_(), end_()
+    {
+        if (n)
+            {
+                first_.push_back(first);
+                end_.push_back(n);
+            }
+    }
+
+    IndexRuns::IndexRuns(const std::vector<std::size_t>& indexes)
+        : first_(), end_()
+    {
+        for (auto i : indexes)
+            {
+                push_back(i);
+            }
+    }
+
+    void
+    IndexRuns::push_back(const std::size_t index)
+    {
+        const auto n = size();
+        if (!first_.empty()
+            && index == first_.back() + (n - run_begin(nruns() - 1)))
+            {
+                ++end_.back();
+                return;
+            }
+        first_.push_back(index);
+        end_.push_back(n + 1);
+    }
+
+    std::size_t
+    IndexRuns::size() const
+    {
+        return end_.empty() ? 0 : end_.back();
+    }
+
+    bool
+    IndexRuns::empty() const
+    {
+        return end_.empty();
+    }
+
+    std::size_t IndexRuns::operator[](const std::size_t i) const
+    {
+        const auto r = static_cast<std::size_t>(
+            std::upper_bound(end_.begin(), end_.end(), i) - end_.begin());
+        return first_[r] + (i - run_begin(r));
+    }
+
+    std::size_t
+    IndexRuns::nruns() const
+    {
+        return first_.size();
+    }
+
+    bool
+    IndexRuns::contiguous() const
+    {
+        return first_.size() < 2;
+    }
+
+    std::size_t
+    IndexRuns::run_first(const std::size_t r) const
+    {
+        return first_[r];
+    }
+
+    std::size_t
+    IndexRuns::run_begin(const std::size_t r) const
+    {
+        return r ? end_[r - 1] : 0;
+    }
+
+    std::size_t
+    IndexRuns::run_length(const std::size_t r) const
+    {
+        return end_[r] - run_begin(r);
+    }
+
+    std::vector<std::size_t>
+    IndexRuns::expand() const
+    {
+        std::vector<std::size_t> rv;
+        rv.reserve(size());
+        for (std::size_t r = 0; r < nruns(); ++r)
+            {
+                for (std::size_t i = 0; i < run_length(r); ++i)
+                    {
+                        rv.push_back(first_[r] + i);
+                    }
+            }
+        return rv;
+    }
+
+    FilteredGenotypeCapsule::FilteredGenotypeCapsule(
+        const ConstGenotypeSpan& base, IndexRuns sites, IndexRuns samples)
+        : base_(base), sites_(std::move(sites)), samples_(std::move(samples)),
+          nsites_(sites_.size()), nsam_(samples_.size())
+    {
+        check_indexes(sites_, base_.nsites);
+        check_indexes(samples_, base_.nsam);
+    }
+
+    const std::int8_t*
+    FilteredGenotypeCapsule::first() const
+    {
+        if (!sites_.contiguous() || !samples_.contiguous())
+            {
+                not_contiguous();
+            }
+        return base_.data + (nsites_ ? base_.row_start(sites_.run_first(0)) : 0)
+               + (nsam_ ? samples_.run_first(0) : 0);
+    }
+
+    const ConstGenotypeSpan&
+    FilteredGenotypeCapsule::base() const
+    {
+        return base_;
+    }
+
+    const IndexRuns&
+    FilteredGenotypeCapsule::sites() const
+    {
+        return sites_;
+    }
+
+    const IndexRuns&
+    FilteredGenotypeCapsule::samples() const
+    {
+        return samples_;
+    }
+
+    void
+    FilteredGenotypeCapsule::gather_row(const std::size_t site,
+                                        std::int8_t* out) const
+    {
+        const auto row = base_.row(sites_[site]);
+        for (std::size_t r = 0; r < samples_.nruns(); ++r)
+            {
+                out = std::copy(row.data + samples_.run_first(r),
+                                row.data + samples_.run_first(r)
+                                    + samples_.run_length(r),
+                                out);
+            }
+    }
+
+    ConstRowView
+    FilteredGenotypeCapsule::row(const std::size_t site) const
+    {
+        if (samples_.contiguous())
+            {
+                return ConstRowView(base_.row(sites_[site]).data
+                                        + (nsam_ ? samples_.run_first(0) : 0),
+                                    nsam_);
+            }
+        auto gathered = std::make_shared<std::vector<std::int8_t>>(nsam_);
+        gather_row(site, gathered->data());
+        return ConstRowView(gathered->data(), nsam_, gathered);
+    }
+
+    ConstColView
+    FilteredGenotypeCapsule::col(const std::size_t sample) const
+    {
+        const auto parent = samples_[sample];
+        if (sites_.contiguous() && base_.row_starts == nullptr)
+            {
+                return ConstColView(
+                    base_.data
+                        + (nsites_ ? base_.row_start(sites_.run_first(0)) : 0)
+                        + parent,
+                    nsites_ * base_.stride, base_.stride);
+            }
+        auto gathered = std::make_shared<std::vector<std::int8_t>>(nsites_);
+        auto out = gathered->begin();
+        for (std::size_t r = 0; r < sites_.nruns(); ++r)
+            {
+                for (std::size_t i = 0; i < sites_.run_length(r); ++i)
+                    {
+                        *out++ = base_(sites_.run_first(r) + i, parent);
+                    }
+            }
+        return ConstColView(gathered->data(), nsites_, 1, gathered);
+    }
+
+    ConstGenotypeSpan
+    FilteredGenotypeCapsule::span() const
+    {
+        if (sites_.contiguous() && samples_.contiguous()
+            && base_.row_starts == nullptr)
+            {
+                return ConstGenotypeSpan(first(), nsites_, nsam_, base_.stride);
+            }
+        if (samples_.contiguous())
+            {
+                // Rows are read in place, through the
+                // offset of each kept row from the first
+                // kept sample of the parent's first site.
+                auto starts = std::make_shared<std::vector<std::size_t>>();
+                starts->reserve(nsites_);
+                for (std::size_t r = 0; r < sites_.nruns(); ++r)
+                    {
+                        for (std::size_t i = 0; i < sites_.run_length(r); ++i)
+                            {
+                                starts->push_back(
+                                    base_.row_start(sites_.run_first(r) + i));
+                            }
+                    }
+                return ConstGenotypeSpan(
+                    base_.data + (nsam_ ? samples_.run_first(0) : 0), nsites_,
+                    nsam_, base_.stride, starts->data(), starts);
+            }
+        auto gathered
+            = std::make_shared<std::vector<std::int8_t>>(nsites_ * nsam_);
+        for (std::size_t site = 0; site < nsites_; ++site)
+            {
+                gather_row(site, gathered->data() + site * nsam_);
+            }
+        return ConstGenotypeSpan(gathered->data(), nsites_, nsam_, nsam_,
+                                 nullptr, gathered);
+    }
+
+    std::size_t&
+    FilteredGenotypeCapsule::nsites()
+    {
+        return nsites_;
+    }
+
+    std::size_t&
+    FilteredGenotypeCapsule::nsam()
+    {
+        return nsam_;
+    }
+
+    std::size_t
+    FilteredGenotypeCapsule::nsites() const
+    {
+        return nsites_;
+    }
+
+    std::size_t
+    FilteredGenotypeCapsule::nsam() const
+    {
+        return nsam_;
+    }
+
+    std::size_t
+    FilteredGenotypeCapsule::row_offset() const
+    {
+        return 0;
+    }
+
+    std::size_t
+    FilteredGenotypeCapsule::col_offset() const
+    {
+        return 0;
+    }
+
+    std::size_t
+    FilteredGenotypeCapsule::stride() const
+    {
+        return base_.stride;
+    }
+
+    std::int8_t&
+    FilteredGenotypeCapsule::operator()(std::size_t site, std::size_t sample)
+    {
+        raise();
+        return *const_cast<std::int8_t*>(
+            &base_(sites_[site], samples_[sample]));
+    }
+
+    const std::int8_t&
+    FilteredGenotypeCapsule::operator()(std::size_t site,
+                                        std::size_t sample) const
+    {
+        return base_(sites_[site], samples_[sample]);
+    }
+
+    std::int8_t*
+    FilteredGenotypeCapsule::data()
+    {
+        raise();
+        return nullptr;
+    }
+
+    const std::int8_t*
+    FilteredGenotypeCapsule::data() const
+    {
+        return first();
+    }
+
+    const std::int8_t*
+    FilteredGenotypeCapsule::cdata() const
+    {
+        return first();
+    }
+
+    std::unique_ptr<GenotypeCapsule>
+    FilteredGenotypeCapsule::clone() const
+    {
+        return std::unique_ptr<GenotypeCapsule>(
+            new FilteredGenotypeCapsule(base_, sites_, samples_));
+    }
+
+    std::int8_t*
+    FilteredGenotypeCapsule::begin()
+    {
+        raise();
+        return nullptr;
+    }
+
+    const std::int8_t*
+    FilteredGenotypeCapsule::begin() const
+    {
+        if (nsites_ > 1 && base_.stride != nsam_)
+            {
+                not_contiguous();
+            }
+        return first();
+    }
+
+    std::int8_t*
+    FilteredGenotypeCapsule::end()
+    {
+        raise();
+        return nullptr;
+    }
+
+    const std::int8_t*
+    FilteredGenotypeCapsule::end() const
+    {
+        return begin() + nsites_ * nsam_;
+    }
+
+    const std::int8_t*
+    FilteredGenotypeCapsule::cbegin() const
+    {
+        return begin();
+    }
+
+    const std::int8_t*
+    FilteredGenotypeCapsule::cend() const
+    {
+        return end();
+    }
+
+    bool
+    FilteredGenotypeCapsule::empty() const
+    {
+        return nsam_ == 0 || nsites_ == 0;
+    }
+
+    std::size_t
+    FilteredGenotypeCapsule::size() const
+    {
+        return nsam_ * nsites_;
+    }
+
+    bool
+    FilteredGenotypeCapsule::resizable() const
+    {
+        return false;
+    }
+} // namespace Sequence
@@ -1,9 +1,80 @@
 #include <Sequence/variant_matrix/filtering.hpp>
+#include <Sequence/FilteredCapsules.hpp>
 #include <algorithm>
 #include <functional>
 #include <limits>
+#include <numeric>
+#include <stdexcept>
 #include <cmath>
 
+namespace
+{
+    struct view_indexes
+    // The parent data of a matrix and the parent
+    // indexes of its sites and samples.
+    {
+        Sequence::ConstGenotypeSpan base;
+        Sequence::IndexRuns sites, samples;
+    };
+
+    view_indexes
+    get_view_indexes(const Sequence::VariantMatrix &m)
+    {
+        if (auto f = dynamic_cast<const Sequence::FilteredGenotypeCapsule *>(
+                m.genotype_capsule()))
+            {
+                return view_indexes{ f->base(), f->sites(), f->samples() };
+            }
+        return view_indexes{ Sequence::get_ConstGenotypeSpan(m),
+                             Sequence::IndexRuns(0, m.nsites()),
+                             Sequence::IndexRuns(0, m.nsam()) };
+    }
+
+    Sequence::IndexRuns
+    compose(const Sequence::IndexRuns &parent,
+            const std::vector<std::size_t> &indexes)
+    {
+        Sequence::IndexRuns rv;
+        for (auto i : indexes)
+            {
+                if (i >= parent.size())
+                    {
+                        throw std::out_of_range("filtered index out of range");
+                    }
+                rv.push_back(parent[i]);
+            }
+        return rv;
+    }
+
+    template <typename F>
+    void
+    for_each_index(const Sequence::IndexRuns &indexes, const F &f)
+    // Call f(i, indexes[i]) for each i, in order
+    {
+        for (std::size_t r = 0; r < indexes.nruns(); ++r)
+            {
+                for (std::size_t i = 0; i < indexes.run_length(r); ++i)
+                    {
+                        f(indexes.run_begin(r) + i, indexes.run_first(r) + i);
+                    }
+            }
+    }
+
+    Sequence::VariantMatrix
+    make_view(const Sequence::VariantMatrix &m, view_indexes v,
+              std::vector<double> pos)
+    // pos are the positions of the kept sites
+    {
+        std::unique_ptr<Sequence::GenotypeCapsule> gc(
+            new Sequence::FilteredGenotypeCapsule(
+                v.base, std::move(v.sites), std::move(v.samples)));
+        std::unique_ptr<Sequence::PositionCapsule> pc(
+            new Sequence::VectorPositionCapsule(std::move(pos)));
+        return Sequence::VariantMatrix(std::move(gc), std::move(pc),
+                                       m.max_allele());
+    }
+} // namespace
+
 namespace Sequence
 {
     template <typename T>
@@ -133,4 +204,118 @@ namespace Sequence
             },
             m.nsam());
     }
+
+    VariantMatrix
+    make_filtered_view(const VariantMatrix &m,
+                       const std::vector<std::size_t> &sites,
+                       const std::vector<std::size_t> &samples)
+    {
+        auto v = get_view_indexes(m);
+        v.sites = compose(v.sites, sites);
+        v.samples = compose(v.samples, samples);
+        std::vector<double> pos;
+        pos.reserve(sites.size());
+        for (auto i : sites)
+            {
+                pos.push_back(m.cposition(i));
+            }
+        return make_view(m, std::move(v), std::move(pos));
+    }
+
+    VariantMatrix
+    filter_sites_view(const VariantMatrix &m,
+                      const std::function<bool(const ConstRowView &)> &f)
+    {
+        auto v = get_view_indexes(m);
+        // Rows of a view are only contiguous in the parent
+        // when the samples are one run of parent samples.
+        const bool contiguous = v.samples.contiguous();
+        const auto offset = v.samples.empty() ? 0 : v.samples.run_first(0);
+        std::vector<std::int8_t> scratch(contiguous ? 0 : v.samples.size());
+        IndexRuns kept_sites;
+        std::vector<double> pos;
+        for_each_index(v.sites, [&](const std::size_t i,
+                                    const std::size_t site) {
+            auto row = v.base.row(site);
+            if (contiguous)
+                {
+                    row = ConstRowView(row.data + offset, v.samples.size());
+                }
+            else
+                {
+                    auto out = scratch.begin();
+                    for (std::size_t r = 0; r < v.samples.nruns(); ++r)
+                        {
+                            auto first = row.data + v.samples.run_first(r);
+                            out = std::copy(first,
+                                            first + v.samples.run_length(r),
+                                            out);
+                        }
+                    row = ConstRowView(scratch.data(), scratch.size());
+                }
+            if (!f(row))
+                {
+                    kept_sites.push_back(site);
+                    pos.push_back(m.cposition(i));
+                }
+        });
+        v.sites = std::move(kept_sites);
+        return make_view(m, std::move(v), std::move(pos));
+    }
+
+    VariantMatrix
+    filter_haplotypes_view(const VariantMatrix &m,
+                           const std::function<bool(const ConstColView &)> &f)
+    {
+        auto v = get_view_indexes(m);
+        const bool contiguous = v.sites.contiguous();
+        const auto offset = v.sites.empty() ? 0 : v.sites.run_first(0);
+        std::vector<std::int8_t> scratch(contiguous ? 0 : v.sites.size());
+        IndexRuns kept_samples;
+        for_each_index(v.samples, [&](const std::size_t,
+                                      const std::size_t sample) {
+            auto col = v.base.col(sample);
+            if (contiguous)
+                {
+                    col = ConstColView(col.data + offset * v.base.stride,
+                                       v.sites.size() * v.base.stride,
+                                       v.base.stride);
+                }
+            else
+                {
+                    for_each_index(v.sites, [&](const std::size_t i,
+                                                const std::size_t site) {
+                        scratch[i] = v.base(site, sample);
+                    });
+                    col = ConstColView(scratch.data(), scratch.size(), 1);
+                }
+            if (!f(col))
+                {
+                    kept_samples.push_back(sample);
+                }
+        });
+        v.samples = std::move(kept_samples);
+        return make_view(m, std::move(v),
+                         std::vector<double>(m.cpbegin(), m.cpend()));
+    }
+
+    VariantMatrix
+    materialize(const VariantMatrix &m)
+    {
+        auto v = get_view_indexes(m);
+        std::vector<std::int8_t> data;
+        data.reserve(v.sites.size() * v.samples.size());
+        for_each_index(v.sites, [&](const std::size_t, const std::size_t site) {
+            auto row = v.base.row(site);
+            for (std::size_t r = 0; r < v.samples.nruns(); ++r)
+                {
+                    auto first = row.data + v.samples.run_first(r);
+                    data.insert(data.end(), first,
+                                first + v.samples.run_length(r));
+                }
+        });
+        return VariantMatrix(std::move(data),
+                             std::vector<double>(m.cpbegin(), m.cpend()),
+                             m.max_allele());
+    }
 } // namespace Sequence
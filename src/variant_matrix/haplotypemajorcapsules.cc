@@ -0,0 +1,344 @@
+#include <Sequence/HaplotypeMajorCapsules.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define LIBSEQUENCE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Tiles of TILE x TILE bytes are transposed at a time,
+    // so that the rows read and written by a tile stay in L1 cache.
+    constexpr std::size_t TILE = 64;
+    // Tiles are transposed in blocks of BLOCK x BLOCK bytes
+    constexpr std::size_t BLOCK = 16;
+
+    void
+    raise()
+    {
+        throw std::runtime_error("data are read-only");
+    }
+
+    void
+    transpose_scalar(const std::int8_t* input, const std::size_t nrow,
+                     const std::size_t ncol, const std::size_t input_stride,
+                     std::int8_t* output, const std::size_t output_stride)
+    {
+        for (std::size_t i = 0; i < nrow; ++i)
+            {
+                for (std::size_t j = 0; j < ncol; ++j)
+                    {
+                        output[j * output_stride + i]
+                            = input[i * input_stride + j];
+                    }
+            }
+    }
+
+#ifdef LIBSEQUENCE_X86_KERNELS
+    void
+    transpose_block(const std::int8_t* input, const std::size_t input_stride,
+                    std::int8_t* output, const std::size_t output_stride)
+    // Transposes 16 x 16 bytes.  Each round of unpacking
+    // interleaves pairs of registers in units twice as wide
+    // as the round before.
+    {
+        __m128i a[16], b[16];
+        for (std::size_t i = 0; i < 16; ++i)
+            {
+                a[i] = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(input + i * input_stride));
+            }
+        // b[2k] and b[2k + 1] hold columns 0-7 and 8-15
+        // of rows 2k and 2k + 1, in 2-byte units.
+        for (std::size_t k = 0; k < 8; ++k)
+            {
+                b[2 * k] = _mm_unpacklo_epi8(a[2 * k], a[2 * k + 1]);
+                b[2 * k + 1] = _mm_unpackhi_epi8(a[2 * k], a[2 * k + 1]);
+            }
+        // a[4m + q] holds columns 4q to 4q + 3 of rows
+        // 4m to 4m + 3, in 4-byte units.
+        for (std::size_t m = 0; m < 4; ++m)
+            {
+                a[4 * m] = _mm_unpacklo_epi16(b[4 * m], b[4 * m + 2]);
+                a[4 * m + 1] = _mm_unpackhi_epi16(b[4 * m], b[4 * m + 2]);
+                a[4 * m + 2] = _mm_unpacklo_epi16(b[4 * m + 1], b[4 * m + 3]);
+                a[4 * m + 3] = _mm_unpackhi_epi16(b[4 * m + 1], b[4 * m + 3]);
+            }
+        // b[8p + r] holds columns 2r and 2r + 1 of rows
+        // 8p to 8p + 7, in 8-byte units.
+        for (std::size_t p = 0; p < 2; ++p)
+            {
+                for (std::size_t q = 0; q < 4; ++q)
+                    {
+                        b[8 * p + 2 * q] = _mm_unpacklo_epi32(
+                            a[8 * p + q], a[8 * p + 4 + q]);
+                        b[8 * p + 2 * q + 1] = _mm_unpackhi_epi32(
+                            a[8 * p + q], a[8 * p + 4 + q]);
+                    }
+            }
+        for (std::size_t r = 0; r < 8; ++r)
+            {
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(output
+                                               + 2 * r * output_stride),
+                    _mm_unpacklo_epi64(b[r], b[8 + r]));
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(output
+                                               + (2 * r + 1) * output_stride),
+                    _mm_unpackhi_epi64(b[r], b[8 + r]));
+            }
+    }
+#else
+    void
+    transpose_block(const std::int8_t* input, const std::size_t input_stride,
+                    std::int8_t* output, const std::size_t output_stride)
+    {
+        transpose_scalar(input, BLOCK, BLOCK, input_stride, output,
+                         output_stride);
+    }
+#endif
+
+    void
+    transpose_tile(const std::int8_t* input, const std::size_t nrow,
+                   const std::size_t ncol, const std::size_t input_stride,
+                   std::int8_t* output, const std::size_t output_stride)
+    {
+        const std::size_t full_rows = nrow - nrow % BLOCK,
+                          full_cols = ncol - ncol % BLOCK;
+        for (std::size_t i = 0; i < full_rows; i += BLOCK)
+            {
+                for (std::size_t j = 0; j < full_cols; j += BLOCK)
+                    {
+                        transpose_block(input + i * input_stride + j,
+                                        input_stride,
+                                        output + j * output_stride + i,
+                                        output_stride);
+                    }
+            }
+        // Remaining columns, then remaining rows
+        transpose_scalar(input + full_cols, full_rows, ncol - full_cols,
+                         input_stride, output + full_cols * output_stride,
+                         output_stride);
+        transpose_scalar(input + full_rows * input_stride, nrow - full_rows,
+                         ncol, input_stride, output + full_rows,
+                         output_stride);
+    }
+} // namespace
+
+namespace Sequence
+{
+    void
+    transpose_genotypes(const std::int8_t* input, const std::size_t nrow,
+                        const std::size_t ncol, const std::size_t input_stride,
+                        std::int8_t* output)
+    {
+        for (std::size_t i = 0; i < nrow; i += TILE)
+            {
+                const std::size_t rows = std::min(TILE, nrow - i);
+                for (std::size_t j = 0; j < ncol; j += TILE)
+                    {
+                        transpose_tile(input + i * input_stride + j, rows,
+                                       std::min(TILE, ncol - j), input_stride,
+                                       output + j * nrow + i, nrow);
+                    }
+            }
+    }
+
+    HaplotypeMajorGenotypeCapsule::HaplotypeMajorGenotypeCapsule(
+        const std::int8_t* data, std::size_t nrow, std::size_t ncol,
+        std::size_t row_offset, std::size_t column_offset,
+        std::size_t trailing)
+        : haplotypes(nrow * ncol), nsites_(nrow), nsam_(ncol), site_major(),
+          site_major_flag()
+    {
+        if (!haplotypes.empty())
+            {
+                transpose_genotypes(
+                    data + row_offset * trailing + column_offset, nrow, ncol,
+                    trailing, haplotypes.data());
+            }
+    }
+
+    const std::int8_t*
+    HaplotypeMajorGenotypeCapsule::transpose() const
+    {
+        // std::call_once makes concurrent const access safe
+        std::call_once(site_major_flag, [this]() {
+            site_major.resize(haplotypes.size());
+            if (!haplotypes.empty())
+                {
+                    transpose_genotypes(haplotypes.data(), nsam_, nsites_,
+                                        nsites_, site_major.data());
+                }
+        });
+        return site_major.data();
+    }
+
+    const std::int8_t*
+    HaplotypeMajorGenotypeCapsule::haplotype_data(
+        const std::size_t sample) const
+    {
+        return haplotypes.data() + sample * nsites_;
+    }
+
+    ConstColView
+    HaplotypeMajorGenotypeCapsule::haplotype(const std::size_t sample) const
+    {
+        return ConstColView(haplotype_data(sample), nsites_, 1);
+    }
+
+    std::size_t&
+    HaplotypeMajorGenotypeCapsule::nsites()
+    {
+        return nsites_;
+    }
+
+    std::size_t&
+    HaplotypeMajorGenotypeCapsule::nsam()
+    {
+        return nsam_;
+    }
+
+    std::size_t
+    HaplotypeMajorGenotypeCapsule::nsites() const
+    {
+        return nsites_;
+    }
+
+    std::size_t
+    HaplotypeMajorGenotypeCapsule::nsam() const
+    {
+        return nsam_;
+    }
+
+    std::size_t
+    HaplotypeMajorGenotypeCapsule::row_offset() const
+    {
+        return 0;
+    }
+
+    std::size_t
+    HaplotypeMajorGenotypeCapsule::col_offset() const
+    {
+        return 0;
+    }
+
+    std::size_t
+    HaplotypeMajorGenotypeCapsule::stride() const
+    {
+        return nsam_;
+    }
+
+    std::int8_t&
+    HaplotypeMajorGenotypeCapsule::operator()(std::size_t, std::size_t)
+    {
+        raise();
+        return haplotypes.front();
+    }
+
+    const std::int8_t&
+    HaplotypeMajorGenotypeCapsule::operator()(std::size_t site,
+                                              std::size_t sample) const
+    {
+        return haplotypes[sample * nsites_ + site];
+    }
+
+    std::int8_t*
+    HaplotypeMajorGenotypeCapsule::data()
+    {
+        raise();
+        return nullptr;
+    }
+
+    const std::int8_t*
+    HaplotypeMajorGenotypeCapsule::data() const
+    {
+        return transpose();
+    }
+
+    const std::int8_t*
+    HaplotypeMajorGenotypeCapsule::cdata() const
+    {
+        return transpose();
+    }
+
+    std::unique_ptr<GenotypeCapsule>
+    HaplotypeMajorGenotypeCapsule::clone() const
+    {
+        std::unique_ptr<HaplotypeMajorGenotypeCapsule> rv(
+            new HaplotypeMajorGenotypeCapsule(nullptr, 0, 0, 0, 0, 0));
+        rv->haplotypes = this->haplotypes;
+        rv->nsites_ = this->nsites_;
+        rv->nsam_ = this->nsam_;
+        return std::unique_ptr<GenotypeCapsule>(rv.release());
+    }
+
+    std::int8_t*
+    HaplotypeMajorGenotypeCapsule::begin()
+    {
+        raise();
+        return nullptr;
+    }
+
+    const std::int8_t*
+    HaplotypeMajorGenotypeCapsule::begin() const
+    {
+        return transpose();
+    }
+
+    std::int8_t*
+    HaplotypeMajorGenotypeCapsule::end()
+    {
+        raise();
+        return nullptr;
+    }
+
+    const std::int8_t*
+    HaplotypeMajorGenotypeCapsule::end() const
+    {
+        return transpose() + haplotypes.size();
+    }
+
+    const std::int8_t*
+    HaplotypeMajorGenotypeCapsule::cbegin() const
+    {
+        return begin();
+    }
+
+    const std::int8_t*
+    HaplotypeMajorGenotypeCapsule::cend() const
+    {
+        return end();
+    }
+
+    bool
+    HaplotypeMajorGenotypeCapsule::empty() const
+    {
+        return nsam_ == 0 || nsites_ == 0;
+    }
+
+    std::size_t
+    HaplotypeMajorGenotypeCapsule::size() const
+    {
+        return nsam_ * nsites_;
+    }
+
+    bool
+    HaplotypeMajorGenotypeCapsule::resizable() const
+    {
+        return false;
+    }
+
+    VariantMatrix
+    make_haplotype_major(const VariantMatrix& m)
+    {
+        std::unique_ptr<GenotypeCapsule> gc(new HaplotypeMajorGenotypeCapsule(
+            m.cdata(), m.nsites(), m.nsam(), m.genotype_row_offset(),
+            m.genotype_col_offset(), m.genotype_stride()));
+        std::unique_ptr<PositionCapsule> pc(new VectorPositionCapsule(
+            std::vector<double>(m.cpbegin(), m.cpend())));
+        return VariantMatrix(std::move(gc), std::move(pc), m.max_allele());
+    }
+} // namespace Sequence
@@ -0,0 +1,158 @@
+#include <Sequence/variant_matrix/mmap.hpp>
+#include <Sequence/MmapCapsules.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    const char MAGIC[8] = { 'L', 'S', 'E', 'Q', 'V', 'M', '0', '1' };
+    constexpr std::size_t HEADER_SIZE = 32;
+
+    std::size_t
+    padding(const std::size_t genotype_bytes)
+    // Bytes needed after the genotypes to align the positions
+    {
+        return (sizeof(double) - genotype_bytes % sizeof(double))
+               % sizeof(double);
+    }
+} // namespace
+
+namespace Sequence
+{
+    namespace internal
+    {
+        struct mapped_file
+        {
+            void* addr;
+            std::size_t length;
+
+            explicit mapped_file(const std::string& filename)
+                : addr(MAP_FAILED), length(0)
+            {
+                int fd = ::open(filename.c_str(), O_RDONLY);
+                if (fd == -1)
+                    {
+                        throw std::runtime_error("could not open "
+                                                 + filename);
+                    }
+                struct stat st;
+                if (::fstat(fd, &st) == -1)
+                    {
+                        ::close(fd);
+                        throw std::runtime_error("could not stat "
+                                                 + filename);
+                    }
+                length = static_cast<std::size_t>(st.st_size);
+                if (length < HEADER_SIZE)
+                    {
+                        ::close(fd);
+                        throw std::runtime_error(
+                            filename + " is not a VariantMatrix file");
+                    }
+                addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+                ::close(fd);
+                if (addr == MAP_FAILED)
+                    {
+                        throw std::runtime_error("could not map " + filename);
+                    }
+            }
+
+            ~mapped_file()
+            {
+                if (addr != MAP_FAILED)
+                    {
+                        ::munmap(addr, length);
+                    }
+            }
+
+            mapped_file(const mapped_file&) = delete;
+            mapped_file& operator=(const mapped_file&) = delete;
+
+            const char*
+            bytes() const
+            {
+                return static_cast<const char*>(addr);
+            }
+        };
+    } // namespace internal
+
+    void
+    to_mmap_format(const VariantMatrix& m, const std::string& filename)
+    {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        if (!out)
+            {
+                throw std::runtime_error("could not open " + filename);
+            }
+        const std::uint64_t nsites = m.nsites(), nsam = m.nsam();
+        const char header_end[8] = { static_cast<char>(m.max_allele()),
+                                     0, 0, 0, 0, 0, 0, 0 };
+        out.write(MAGIC, sizeof(MAGIC));
+        out.write(reinterpret_cast<const char*>(&nsites), sizeof(nsites));
+        out.write(reinterpret_cast<const char*>(&nsam), sizeof(nsam));
+        out.write(header_end, sizeof(header_end));
+        for (std::size_t i = 0; i < m.nsites(); ++i)
+            {
+                auto r = get_ConstRowView(m, i);
+                out.write(reinterpret_cast<const char*>(r.data),
+                          static_cast<std::streamsize>(r.size()));
+            }
+        const char zeros[sizeof(double)] = {};
+        out.write(zeros, static_cast<std::streamsize>(
+                             padding(m.nsites() * m.nsam())));
+        out.write(reinterpret_cast<const char*>(m.cpbegin()),
+                  static_cast<std::streamsize>(m.nsites() * sizeof(double)));
+        if (!out)
+            {
+                throw std::runtime_error("error writing " + filename);
+            }
+    }
+
+    VariantMatrix
+    from_mmap_format(const std::string& filename)
+    {
+        std::shared_ptr<const internal::mapped_file> f(
+            new internal::mapped_file(filename));
+        const char* bytes = f->bytes();
+        if (std::memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0)
+            {
+                throw std::runtime_error(filename
+                                         + " is not a VariantMatrix file");
+            }
+        std::uint64_t nsites, nsam;
+        std::memcpy(&nsites, bytes + 8, sizeof(nsites));
+        std::memcpy(&nsam, bytes + 16, sizeof(nsam));
+        const auto max_allele = static_cast<std::int8_t>(bytes[24]);
+        // Reject sizes that cannot fit in the file before multiplying,
+        // so that the products below cannot overflow
+        const std::size_t data_bytes = f->length - HEADER_SIZE;
+        if (nsites > data_bytes / sizeof(double)
+            || (nsam != 0 && nsites > data_bytes / nsam))
+            {
+                throw std::runtime_error(filename
+                                         + " has an unexpected file size");
+            }
+        const std::size_t genotype_bytes = nsites * nsam;
+        const std::size_t positions_offset
+            = HEADER_SIZE + genotype_bytes + padding(genotype_bytes);
+        if (f->length != positions_offset + nsites * sizeof(double))
+            {
+                throw std::runtime_error(filename
+                                         + " has an unexpected file size");
+            }
+        std::unique_ptr<GenotypeCapsule> gc(new MmapGenotypeCapsule(
+            f, reinterpret_cast<const std::int8_t*>(bytes + HEADER_SIZE),
+            nsites, nsam));
+        std::unique_ptr<PositionCapsule> pc(new MmapPositionCapsule(
+            f, reinterpret_cast<const double*>(bytes + positions_offset),
+            nsites));
+        return VariantMatrix(std::move(gc), std::move(pc), max_allele);
+    }
+} // namespace Sequence
@@ -0,0 +1,265 @@
+#include <Sequence/MmapCapsules.hpp>
+#include <stdexcept>
+
+namespace
+{
+    void
+    raise()
+    {
+        throw std::runtime_error("data are read-only");
+    }
+} // namespace
+
+namespace Sequence
+{
+    MmapGenotypeCapsule::MmapGenotypeCapsule(
+        std::shared_ptr<const internal::mapped_file> f,
+        const std::int8_t* data, std::size_t nrow, std::size_t ncol)
+        : file(std::move(f)), buffer(data), nsites_(nrow), nsam_(ncol)
+    {
+    }
+
+    std::size_t&
+    MmapGenotypeCapsule::nsites()
+    {
+        return nsites_;
+    }
+
+    std::size_t&
+    MmapGenotypeCapsule::nsam()
+    {
+        return nsam_;
+    }
+
+    std::size_t
+    MmapGenotypeCapsule::nsites() const
+    {
+        return nsites_;
+    }
+
+    std::size_t
+    MmapGenotypeCapsule::nsam() const
+    {
+        return nsam_;
+    }
+
+    std::size_t
+    MmapGenotypeCapsule::row_offset() const
+    {
+        return 0;
+    }
+
+    std::size_t
+    MmapGenotypeCapsule::col_offset() const
+    {
+        return 0;
+    }
+
+    std::size_t
+    MmapGenotypeCapsule::stride() const
+    {
+        return nsam_;
+    }
+
+    std::int8_t&
+    MmapGenotypeCapsule::operator()(std::size_t site, std::size_t sample)
+    {
+        raise();
+        return *const_cast<std::int8_t*>(&buffer[site * nsam_ + sample]);
+    }
+
+    const std::int8_t&
+    MmapGenotypeCapsule::operator()(std::size_t site,
+                                    std::size_t sample) const
+    {
+        return buffer[site * nsam_ + sample];
+    }
+
+    std::int8_t*
+    MmapGenotypeCapsule::data()
+    {
+        raise();
+        return const_cast<std::int8_t*>(buffer);
+    }
+
+    const std::int8_t*
+    MmapGenotypeCapsule::data() const
+    {
+        return buffer;
+    }
+
+    const std::int8_t*
+    MmapGenotypeCapsule::cdata() const
+    {
+        return buffer;
+    }
+
+    std::unique_ptr<GenotypeCapsule>
+    MmapGenotypeCapsule::clone() const
+    {
+        return std::unique_ptr<GenotypeCapsule>(
+            new MmapGenotypeCapsule(file, buffer, nsites_, nsam_));
+    }
+
+    std::int8_t*
+    MmapGenotypeCapsule::begin()
+    {
+        raise();
+        return const_cast<std::int8_t*>(buffer);
+    }
+
+    const std::int8_t*
+    MmapGenotypeCapsule::begin() const
+    {
+        return buffer;
+    }
+
+    std::int8_t*
+    MmapGenotypeCapsule::end()
+    {
+        raise();
+        return const_cast<std::int8_t*>(buffer) + nsam_ * nsites_;
+    }
+
+    const std::int8_t*
+    MmapGenotypeCapsule::end() const
+    {
+        return buffer + nsam_ * nsites_;
+    }
+
+    const std::int8_t*
+    MmapGenotypeCapsule::cbegin() const
+    {
+        return begin();
+    }
+
+    const std::int8_t*
+    MmapGenotypeCapsule::cend() const
+    {
+        return end();
+    }
+
+    bool
+    MmapGenotypeCapsule::empty() const
+    {
+        return nsam_ == 0 || nsites_ == 0;
+    }
+
+    std::size_t
+    MmapGenotypeCapsule::size() const
+    {
+        return nsam_ * nsites_;
+    }
+
+    bool
+    MmapGenotypeCapsule::resizable() const
+    {
+        return false;
+    }
+
+    MmapPositionCapsule::MmapPositionCapsule(
+        std::shared_ptr<const internal::mapped_file> f, const double* data,
+        const std::size_t nsites)
+        : file(std::move(f)), buffer(data), current_size(nsites)
+    {
+    }
+
+    double& MmapPositionCapsule::operator[](std::size_t i)
+    {
+        raise();
+        return *const_cast<double*>(&buffer[i]);
+    }
+
+    const double& MmapPositionCapsule::operator[](std::size_t i) const
+    {
+        return buffer[i];
+    }
+
+    double*
+    MmapPositionCapsule::data()
+    {
+        raise();
+        return const_cast<double*>(buffer);
+    }
+
+    const double*
+    MmapPositionCapsule::data() const
+    {
+        return buffer;
+    }
+
+    const double*
+    MmapPositionCapsule::cdata() const
+    {
+        return buffer;
+    }
+
+    std::unique_ptr<PositionCapsule>
+    MmapPositionCapsule::clone() const
+    {
+        return std::unique_ptr<PositionCapsule>(
+            new MmapPositionCapsule(file, buffer, current_size));
+    }
+
+    double*
+    MmapPositionCapsule::begin()
+    {
+        raise();
+        return const_cast<double*>(buffer);
+    }
+
+    const double*
+    MmapPositionCapsule::begin() const
+    {
+        return buffer;
+    }
+
+    double*
+    MmapPositionCapsule::end()
+    {
+        raise();
+        return const_cast<double*>(buffer) + current_size;
+    }
+
+    const double*
+    MmapPositionCapsule::end() const
+    {
+        return buffer + current_size;
+    }
+
+    const double*
+    MmapPositionCapsule::cbegin() const
+    {
+        return begin();
+    }
+
+    const double*
+    MmapPositionCapsule::cend() const
+    {
+        return end();
+    }
+
+    bool
+    MmapPositionCapsule::empty() const
+    {
+        return current_size == 0;
+    }
+
+    std::size_t
+    MmapPositionCapsule::size() const
+    {
+        return current_size;
+    }
+
+    std::size_t
+    MmapPositionCapsule::nsites() const
+    {
+        return current_size;
+    }
+
+    bool
+    MmapPositionCapsule::resizable() const
+    {
+        return false;
+    }
+} // namespace Sequence
@@ -0,0 +1,210 @@
+#include <cctype>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <Sequence/NonOwningCapsules.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/variant_matrix/msformat.hpp>
+
+namespace
+{
+    // Side length of the blocks used when transposing
+    // between haplotypes and sites.
+    constexpr std::size_t TRANSPOSE_BLOCK = 64;
+
+    void
+    transpose(const std::int8_t* input, const std::size_t nrow,
+              const std::size_t ncol, std::int8_t* output)
+    // output is the ncol by nrow transpose of input,
+    // which is nrow by ncol.  Both are row-major.
+    {
+        for (std::size_t r0 = 0; r0 < nrow; r0 += TRANSPOSE_BLOCK)
+            {
+                const std::size_t r1 = std::min(nrow, r0 + TRANSPOSE_BLOCK);
+                for (std::size_t c0 = 0; c0 < ncol; c0 += TRANSPOSE_BLOCK)
+                    {
+                        const std::size_t c1
+                            = std::min(ncol, c0 + TRANSPOSE_BLOCK);
+                        for (std::size_t c = c0; c < c1; ++c)
+                            {
+                                for (std::size_t r = r0; r < r1; ++r)
+                                    {
+                                        output[c * nrow + r]
+                                            = input[r * ncol + c];
+                                    }
+                            }
+                    }
+            }
+    }
+
+    void
+    strip_trailing_whitespace(std::string& line)
+    // Removes trailing spaces, tabs and the '\r' of
+    // Windows line endings.
+    {
+        while (!line.empty()
+               && std::isspace(static_cast<unsigned char>(line.back())))
+            {
+                line.pop_back();
+            }
+    }
+} // namespace
+
+namespace Sequence
+{
+    namespace internal
+    {
+        bool
+        read_msformat(std::istream& input_stream, std::string& line,
+                      std::vector<std::int8_t>& haplotypes,
+                      std::vector<std::int8_t>& genotypes,
+                      std::vector<double>& positions)
+        {
+            haplotypes.clear();
+            genotypes.clear();
+            positions.clear();
+            bool found = false;
+            while (std::getline(input_stream, line))
+                {
+                    if (line.compare(0, 9, "segsites:") == 0)
+                        {
+                            found = true;
+                            break;
+                        }
+                }
+            if (!found)
+                {
+                    return false;
+                }
+            char* end;
+            const auto S = static_cast<std::size_t>(
+                std::strtoul(line.c_str() + 9, &end, 10));
+            if (end == line.c_str() + 9)
+                {
+                    throw std::runtime_error("invalid segsites line");
+                }
+            if (S > 0)
+                {
+                    std::getline(input_stream, line);
+                    if (line.compare(0, 10, "positions:") != 0)
+                        {
+                            throw std::runtime_error(
+                                "positions line not found");
+                        }
+                    const char* p = line.c_str() + 10;
+                    for (std::size_t i = 0; i < S; ++i)
+                        {
+                            positions.push_back(std::strtod(p, &end));
+                            if (end == p)
+                                {
+                                    throw std::runtime_error(
+                                        "too few positions");
+                                }
+                            p = end;
+                        }
+                }
+            // Haplotypes continue until the next replicate
+            // or the end of input.
+            while ((input_stream >> std::ws)
+                   && input_stream.peek() != '/'
+                   && std::getline(input_stream, line))
+                {
+                    strip_trailing_whitespace(line);
+                    if (line.size() != S)
+                        {
+                            throw std::runtime_error(
+                                "haplotype has the wrong number of sites");
+                        }
+                    for (auto c : line)
+                        {
+                            haplotypes.push_back(c != '0');
+                        }
+                }
+            input_stream >> std::ws;
+            if (S > 0)
+                {
+                    genotypes.resize(haplotypes.size());
+                    transpose(haplotypes.data(), haplotypes.size() / S, S,
+                              genotypes.data());
+                }
+            return true;
+        }
+
+        bool
+        format_haplotypes(const VariantMatrix& m, std::string& buffer)
+        {
+            const std::size_t S = m.nsites(), nsam = m.nsam();
+            // Each haplotype takes S characters plus a newline,
+            // which is omitted for the last one.
+            buffer.assign(nsam ? nsam * (S + 1) - 1 : 0, '\n');
+            std::vector<const std::int8_t*> rows(S);
+            for (std::size_t i = 0; i < S; ++i)
+                {
+                    rows[i] = get_ConstRowView(m, i).data;
+                }
+            for (std::size_t j0 = 0; j0 < nsam; j0 += TRANSPOSE_BLOCK)
+                {
+                    const std::size_t j1 = std::min(nsam, j0 + TRANSPOSE_BLOCK);
+                    for (std::size_t i0 = 0; i0 < S; i0 += TRANSPOSE_BLOCK)
+                        {
+                            const std::size_t i1
+                                = std::min(S, i0 + TRANSPOSE_BLOCK);
+                            for (std::size_t j = j0; j < j1; ++j)
+                                {
+                                    char* out = &buffer[j * (S + 1)];
+                                    for (std::size_t i = i0; i < i1; ++i)
+                                        {
+                                            const std::int8_t x = rows[i][j];
+                                            if (x < 0 || x > 9)
+                                                {
+                                                    return false;
+                                                }
+                                            out[i] = static_cast<char>('0' + x);
+                                        }
+                                }
+                        }
+                }
+            return true;
+        }
+    } // namespace internal
+
+    MsFormatReader::MsFormatReader(std::istream& input_stream)
+        : input(input_stream), line{}, haplotypes{}, genotypes{},
+          positions{}, current{ nullptr }
+    {
+    }
+
+    bool
+    MsFormatReader::next()
+    {
+        current.reset();
+        if (!internal::read_msformat(input, line, haplotypes, genotypes,
+                                     positions))
+            {
+                return false;
+            }
+        const std::size_t nsites = positions.size();
+        const std::size_t nsam = nsites ? genotypes.size() / nsites : 0;
+        std::unique_ptr<GenotypeCapsule> gc(new NonOwningGenotypeCapsule(
+            genotypes.data(), nsites, nsam, 0, 0, nsam));
+        std::unique_ptr<PositionCapsule> pc(
+            new NonOwningPositionCapsule(positions.data(), nsites));
+        const std::int8_t max_allele
+            = genotypes.empty()
+                  ? 0
+                  : *std::max_element(genotypes.begin(), genotypes.end());
+        current.reset(
+            new VariantMatrix(std::move(gc), std::move(pc), max_allele));
+        return true;
+    }
+
+    const VariantMatrix&
+    MsFormatReader::replicate() const
+    {
+        if (!current)
+            {
+                throw std::runtime_error("no replicate has been read");
+            }
+        return *current;
+    }
+} // namespace Sequence
@@ -0,0 +1,537 @@
+#include <config.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <Sequence/variant_matrix/vcf.hpp>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+namespace
+{
+    // The first sample is in this column
+    constexpr std::size_t FIRST_SAMPLE_COLUMN = 9;
+    // The first byte of gzip data, including bgzip.  Text VCF
+    // starts with '#'.
+    constexpr int GZIP_MAGIC = 0x1f;
+
+#ifdef HAVE_LIBZ
+    class gzip_buffer : public std::streambuf
+    /// Decompress gzip data read from a stream.  Files from bgzip,
+    /// and other concatenated gzip files, hold several gzip
+    /// members, which are decompressed in turn.
+    {
+      private:
+        static constexpr std::size_t BUFFER_SIZE = 1 << 16;
+        std::istream& source;
+        z_stream stream;
+        std::vector<char> in, out;
+        // True if the last member read has ended
+        bool member_ended;
+
+      public:
+        explicit gzip_buffer(std::istream& source_stream)
+            : source(source_stream), stream(), in(BUFFER_SIZE),
+              out(BUFFER_SIZE), member_ended(false)
+        {
+            // 15 + 32 reads gzip or zlib headers
+            if (inflateInit2(&stream, 15 + 32) != Z_OK)
+                {
+                    throw std::runtime_error(
+                        "could not initialize zlib decompression");
+                }
+        }
+
+        ~gzip_buffer() { inflateEnd(&stream); }
+
+        gzip_buffer(const gzip_buffer&) = delete;
+        gzip_buffer& operator=(const gzip_buffer&) = delete;
+
+      protected:
+        int_type
+        underflow() override
+        {
+            if (gptr() < egptr())
+                {
+                    return traits_type::to_int_type(*gptr());
+                }
+            for (;;)
+                {
+                    if (stream.avail_in == 0)
+                        {
+                            source.read(in.data(),
+                                        static_cast<std::streamsize>(
+                                            in.size()));
+                            stream.next_in
+                                = reinterpret_cast<Bytef*>(in.data());
+                            stream.avail_in
+                                = static_cast<uInt>(source.gcount());
+                            if (stream.avail_in == 0)
+                                {
+                                    if (!member_ended)
+                                        {
+                                            throw std::runtime_error(
+                                                "compressed VCF input is "
+                                                "truncated");
+                                        }
+                                    return traits_type::eof();
+                                }
+                        }
+                    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+                    stream.avail_out = static_cast<uInt>(out.size());
+                    const int rv = inflate(&stream, Z_NO_FLUSH);
+                    if (rv == Z_STREAM_END)
+                        {
+                            inflateReset(&stream);
+                        }
+                    else if (rv != Z_OK)
+                        {
+                            throw std::runtime_error(
+                                "invalid compressed VCF input");
+                        }
+                    member_ended = (rv == Z_STREAM_END);
+                    const std::size_t n = out.size() - stream.avail_out;
+                    if (n > 0)
+                        {
+                            setg(out.data(), out.data(),
+                                 out.data() + static_cast<std::ptrdiff_t>(n));
+                            return traits_type::to_int_type(*gptr());
+                        }
+                }
+        }
+    };
+#endif
+
+    std::istream&
+    open_input(std::istream& source,
+               std::unique_ptr<std::streambuf>& decompressor,
+               std::unique_ptr<std::istream>& decompressed)
+    // Returns source, or a stream decompressing it if it
+    // holds gzip data.
+    {
+        if (source.peek() != GZIP_MAGIC)
+            {
+                return source;
+            }
+#ifdef HAVE_LIBZ
+        decompressor.reset(new gzip_buffer(source));
+        decompressed.reset(new std::istream(decompressor.get()));
+        // Otherwise, errors thrown while decompressing would only
+        // set badbit, and the input would appear to end early.
+        decompressed->exceptions(std::ios_base::badbit);
+        return *decompressed;
+#else
+        (void)decompressor;
+        (void)decompressed;
+        throw std::runtime_error("compressed VCF input requires "
+                                 "libsequence to be built with zlib");
+#endif
+    }
+
+    std::unique_ptr<std::istream>
+    open_file(const std::string& filename)
+    {
+        std::unique_ptr<std::istream> rv(
+            new std::ifstream(filename, std::ios_base::binary));
+        if (!*rv)
+            {
+                throw std::runtime_error("could not open " + filename);
+            }
+        return rv;
+    }
+
+    void
+    parse_genotype(const char* beg, const char* end, const std::size_t ploidy,
+                   std::int8_t* out)
+    // Parse the alleles of a GT field in [beg, end) into
+    // out[0, ploidy), padding with missing data.
+    {
+        std::size_t nalleles = 0;
+        while (beg < end && *beg != ':')
+            {
+                if (nalleles == ploidy)
+                    {
+                        throw std::runtime_error(
+                            "genotype has more alleles than the ploidy");
+                    }
+                if (*beg == '.')
+                    {
+                        out[nalleles++] = -1;
+                        ++beg;
+                    }
+                else
+                    {
+                        int allele = 0;
+                        const char* digits = beg;
+                        while (beg < end && *beg >= '0' && *beg <= '9')
+                            {
+                                allele = 10 * allele + (*beg - '0');
+                                if (allele > 127)
+                                    {
+                                        throw std::runtime_error(
+                                            "allele index is too large");
+                                    }
+                                ++beg;
+                            }
+                        if (beg == digits)
+                            {
+                                throw std::runtime_error(
+                                    "invalid genotype");
+                            }
+                        out[nalleles++] = static_cast<std::int8_t>(allele);
+                    }
+                if (beg < end && (*beg == '/' || *beg == '|'))
+                    {
+                        ++beg;
+                    }
+            }
+        for (; nalleles < ploidy; ++nalleles)
+            {
+                out[nalleles] = -1;
+            }
+    }
+
+    Sequence::VariantMatrix
+    make_block(std::vector<std::int8_t>& data, std::vector<double>& pos)
+    // Blocks where all data are missing are valid, so
+    // max_allele is at least 0.
+    {
+        std::int8_t max_allele = 0;
+        for (auto x : data)
+            {
+                max_allele = std::max(max_allele, x);
+            }
+        return Sequence::VariantMatrix(std::move(data), std::move(pos),
+                                       max_allele);
+    }
+
+    std::size_t
+    count_alleles(const char* beg, const char* end)
+    // The number of alleles in a GT field.  A GT field that is
+    // only ".", which may be a no-call of any ploidy, has none.
+    {
+        if (beg == end || *beg == ':'
+            || (*beg == '.' && (beg + 1 == end || beg[1] == ':')))
+            {
+                return 0;
+            }
+        std::size_t rv = 1;
+        for (; beg < end && *beg != ':'; ++beg)
+            {
+                rv += (*beg == '/' || *beg == '|');
+            }
+        return rv;
+    }
+
+    std::size_t
+    record_ploidy(const std::string& line)
+    // The largest number of alleles in the GT fields of an unparsed
+    // record, or 0 if there are none.  Malformed records give 0, and
+    // are reported when they are parsed.
+    {
+        std::vector<std::size_t> columns(1, 0);
+        for (std::size_t i = 0; i < line.size(); ++i)
+            {
+                if (line[i] == '\t')
+                    {
+                        columns.push_back(i + 1);
+                    }
+            }
+        columns.push_back(line.size() + 1);
+        if (columns.size() < FIRST_SAMPLE_COLUMN + 2)
+            {
+                return 0;
+            }
+        const std::size_t format = columns[FIRST_SAMPLE_COLUMN - 1];
+        if (line.compare(format, 2, "GT") != 0
+            || (line[format + 2] != ':' && line[format + 2] != '\t'))
+            {
+                return 0;
+            }
+        const char* data = line.data();
+        std::size_t rv = 0;
+        for (std::size_t c = FIRST_SAMPLE_COLUMN; c + 1 < columns.size(); ++c)
+            {
+                rv = std::max(rv, count_alleles(data + columns[c],
+                                                data + columns[c + 1] - 1));
+            }
+        return rv;
+    }
+} // namespace
+
+namespace Sequence
+{
+    VCFReader::VCFReader(std::istream& input_stream, const std::size_t ploidy)
+        : file{}, decompressor{}, decompressed{},
+          input(open_input(input_stream, decompressor, decompressed)),
+          sample_names{}, ploidy_{ ploidy }, chrom{}, record{},
+          have_record{ false }, columns{}, pending{}
+    {
+        read_header();
+    }
+
+    VCFReader::VCFReader(const std::string& filename,
+                         const std::size_t ploidy)
+        : file(open_file(filename)), decompressor{}, decompressed{},
+          input(open_input(*file, decompressor, decompressed)),
+          sample_names{}, ploidy_{ ploidy }, chrom{}, record{},
+          have_record{ false }, columns{}, pending{}
+    {
+        read_header();
+    }
+
+    void
+    VCFReader::read_header()
+    {
+        std::string line;
+        while (std::getline(input, line))
+            {
+                if (line.compare(0, 2, "##") == 0)
+                    {
+                        continue;
+                    }
+                if (line.compare(0, 3, "BCF") == 0)
+                    {
+                        throw std::runtime_error("BCF input is not supported");
+                    }
+                if (line.compare(0, 6, "#CHROM") != 0)
+                    {
+                        throw std::runtime_error(
+                            "VCF header line #CHROM not found");
+                    }
+                std::size_t column = 0, beg = 0;
+                while (beg <= line.size())
+                    {
+                        auto end = line.find('\t', beg);
+                        if (end == std::string::npos)
+                            {
+                                end = line.size();
+                            }
+                        if (column++ >= FIRST_SAMPLE_COLUMN)
+                            {
+                                sample_names.emplace_back(line, beg,
+                                                          end - beg);
+                            }
+                        beg = end + 1;
+                    }
+                next_record();
+                return;
+            }
+        throw std::runtime_error("VCF header line #CHROM not found");
+    }
+
+    void
+    VCFReader::next_record()
+    {
+        have_record = false;
+        while (read_line(record))
+            {
+                if (!record.empty() && record.back() == '\r')
+                    {
+                        record.pop_back();
+                    }
+                if (record.empty())
+                    {
+                        continue;
+                    }
+                columns.clear();
+                columns.push_back(0);
+                for (std::size_t i = 0; i < record.size(); ++i)
+                    {
+                        if (record[i] == '\t')
+                            {
+                                columns.push_back(i + 1);
+                            }
+                    }
+                if (columns.size() < FIRST_SAMPLE_COLUMN - 1
+                    || (!sample_names.empty()
+                        && columns.size()
+                               != FIRST_SAMPLE_COLUMN + sample_names.size()))
+                    {
+                        throw std::runtime_error(
+                            "VCF record has the wrong number of columns");
+                    }
+                // The end of the last column
+                columns.push_back(record.size() + 1);
+                have_record = true;
+                if (ploidy_ == 0 && record_has_genotypes())
+                    {
+                        ploidy_ = record_ploidy(record);
+                        if (ploidy_ == 0)
+                            {
+                                find_ploidy();
+                            }
+                    }
+                return;
+            }
+    }
+
+    bool
+    VCFReader::read_line(std::string& line)
+    {
+        if (!pending.empty())
+            {
+                line = std::move(pending.front());
+                pending.pop_front();
+                return true;
+            }
+        return static_cast<bool>(std::getline(input, line));
+    }
+
+    void
+    VCFReader::find_ploidy()
+    // Every GT of the current record is a lone ".".  Read ahead,
+    // keeping the records for next_record, until one has a GT
+    // that gives the ploidy.  If none does, all genotypes are
+    // missing, and each sample is read as one missing allele.
+    {
+        std::string line;
+        while (std::getline(input, line))
+            {
+                pending.push_back(line);
+                ploidy_ = record_ploidy(line);
+                if (ploidy_ > 0)
+                    {
+                        return;
+                    }
+            }
+        ploidy_ = 1;
+    }
+
+    bool
+    VCFReader::record_has_genotypes() const
+    // GT is the first key of FORMAT when present
+    {
+        if (sample_names.empty())
+            {
+                return false;
+            }
+        const std::size_t format = columns[FIRST_SAMPLE_COLUMN - 1];
+        return record.compare(format, 2, "GT") == 0
+               && (record[format + 2] == ':' || record[format + 2] == '\t');
+    }
+
+    std::string
+    VCFReader::record_chromosome() const
+    {
+        return record.substr(0, columns[1] - 1);
+    }
+
+    double
+    VCFReader::record_position() const
+    {
+        const char* beg = record.data() + columns[1];
+        char* end;
+        const double rv = std::strtod(beg, &end);
+        if (end == beg || *end != '\t')
+            {
+                throw std::runtime_error("invalid VCF position");
+            }
+        return rv;
+    }
+
+    void
+    VCFReader::append_record(std::vector<std::int8_t>& data,
+                             std::vector<double>& pos)
+    // Nothing is appended unless the whole record is valid.
+    {
+        const double position = record_position();
+        const std::size_t offset = data.size();
+        data.resize(offset + sample_names.size() * ploidy_, -1);
+        if (record_has_genotypes())
+            {
+                const char* line = record.data();
+                try
+                    {
+                        for (std::size_t s = 0; s < sample_names.size(); ++s)
+                            {
+                                const std::size_t c = FIRST_SAMPLE_COLUMN + s;
+                                parse_genotype(
+                                    line + columns[c],
+                                    line + columns[c + 1] - 1, ploidy_,
+                                    data.data() + offset + s * ploidy_);
+                            }
+                    }
+                catch (...)
+                    {
+                        data.resize(offset);
+                        throw;
+                    }
+            }
+        pos.push_back(position);
+    }
+
+    const std::vector<std::string>&
+    VCFReader::samples() const
+    {
+        return sample_names;
+    }
+
+    std::size_t
+    VCFReader::ploidy() const
+    {
+        return ploidy_;
+    }
+
+    const std::string&
+    VCFReader::chromosome() const
+    {
+        return chrom;
+    }
+
+    bool
+    VCFReader::done() const
+    {
+        return !have_record;
+    }
+
+    VariantMatrix
+    VCFReader::read_sites(const std::size_t max_sites)
+    {
+        if (max_sites == 0)
+            {
+                throw std::invalid_argument("max_sites must be > 0");
+            }
+        std::vector<std::int8_t> data;
+        std::vector<double> pos;
+        if (have_record)
+            {
+                chrom = record_chromosome();
+            }
+        while (have_record && pos.size() < max_sites
+               && record_chromosome() == chrom)
+            {
+                append_record(data, pos);
+                next_record();
+            }
+        return make_block(data, pos);
+    }
+
+    VariantMatrix
+    VCFReader::read_interval(const double length)
+    {
+        if (!(length > 0.0))
+            {
+                throw std::invalid_argument("length must be > 0");
+            }
+        std::vector<std::int8_t> data;
+        std::vector<double> pos;
+        if (!have_record)
+            {
+                return make_block(data, pos);
+            }
+        chrom = record_chromosome();
+        const double end
+            = (std::floor(record_position() / length) + 1.0) * length;
+        while (have_record && record_chromosome() == chrom
+               && record_position() < end)
+            {
+                append_record(data, pos);
+                next_record();
+            }
+        return make_block(data, pos);
+    }
+} // namespace Sequence
@@ -0,0 +1,356 @@
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/summstats/auxillary.hpp>
+#include <Sequence/variant_matrix/windows.hpp>
+
+namespace
+{
+    struct site_contribution
+    // The terms that one site adds to each statistic.
+    // These mirror the per-row calculations in src/summstats.
+    {
+        // thetapi and thetaw
+        double pi, w;
+        // tajd only considers sites with at least one state
+        bool counted;
+        unsigned S;
+        std::int32_t nsam;
+        // thetah and thetal
+        bool multiple_derived;
+        double h, l;
+        // faywuh and hprime, which use the sample size of the matrix
+        bool too_many_states;
+        unsigned fw_S;
+        double fw_pi, fw_h, fw_l;
+    };
+
+    site_contribution
+    make_contribution(const Sequence::AlleleCountMatrix& ac,
+                      const std::size_t site, const std::size_t refindex)
+    {
+        const std::size_t i = site * ac.ncol;
+        std::int32_t nsam = 0, nnonref = 0;
+        unsigned nstates = 0;
+        bool ref_seen = false;
+        double homozygosity = 0.0, temp_h = 0.0, temp_l = 0.0;
+        for (std::size_t j = i; j < i + ac.ncol; ++j)
+            {
+                auto ci = ac.counts[j];
+                nsam += ci;
+                homozygosity += static_cast<double>(ci * (ci - 1));
+                if (ci > 0)
+                    {
+                        ++nstates;
+                        if (j - i != refindex)
+                            {
+                                ++nnonref;
+                                temp_h += std::pow(ci, 2.0);
+                                temp_l += ci;
+                            }
+                        else
+                            {
+                                ref_seen = true;
+                            }
+                    }
+            }
+        site_contribution c;
+        c.pi = 1.0 - homozygosity / static_cast<double>(nsam * (nsam - 1));
+        c.w = (nstates > 1) ? static_cast<double>(nstates - 1)
+                                  / Sequence::summstats_aux::a_sub_n(
+                                        static_cast<std::uint32_t>(nsam))
+                            : 0.0;
+        c.counted = nstates > 0;
+        c.S = c.counted ? nstates - 1 : 0;
+        c.nsam = nsam;
+        c.multiple_derived = nnonref > 1;
+        c.h = c.l = 0.0;
+        c.too_many_states = nstates > 2;
+        c.fw_S = nstates > 1;
+        c.fw_pi = c.fw_h = c.fw_l = 0.0;
+        if (ref_seen)
+            {
+                c.h = temp_h
+                      * (2.0 / static_cast<double>(nsam * (nsam - 1)));
+                c.l = temp_l * (1. / static_cast<double>(nsam - 1));
+                double nnm1 = static_cast<double>(ac.nsam * (ac.nsam - 1));
+                c.fw_pi = 1.0 - homozygosity / nnm1;
+                c.fw_h = temp_h * (2. / nnm1);
+                c.fw_l = temp_l * (1. / static_cast<double>(ac.nsam - 1));
+            }
+        return c;
+    }
+
+    class running_sum
+    // Removing a nan from a plain sum cannot restore it,
+    // so we count them separately.
+    {
+      private:
+        double sum;
+        unsigned nnan;
+
+      public:
+        running_sum() : sum{ 0.0 }, nnan{ 0 } {}
+
+        void
+        add(const double x)
+        {
+            if (std::isnan(x))
+                {
+                    ++nnan;
+                }
+            else
+                {
+                    sum += x;
+                }
+        }
+
+        void
+        remove(const double x)
+        {
+            if (std::isnan(x))
+                {
+                    --nnan;
+                }
+            else
+                {
+                    sum -= x;
+                }
+        }
+
+        double
+        value() const
+        {
+            return nnan ? std::numeric_limits<double>::quiet_NaN() : sum;
+        }
+    };
+
+    class window_accumulator
+    {
+      private:
+        std::deque<site_contribution> sites;
+        // Sample sizes of counted sites, in decreasing order,
+        // so that the front is the max in the window.
+        std::deque<std::pair<std::size_t, std::int32_t>> max_nsam;
+        running_sum pi, w, tajd_pi, h, l, fw_pi, fw_h, fw_l;
+        unsigned S, fw_S, multiple_derived, too_many_states;
+        std::size_t first_site;
+
+      public:
+        window_accumulator()
+            : sites{}, max_nsam{}, pi{}, w{}, tajd_pi{}, h{}, l{}, fw_pi{},
+              fw_h{}, fw_l{}, S{ 0 }, fw_S{ 0 }, multiple_derived{ 0 },
+              too_many_states{ 0 }, first_site{ 0 }
+        {
+        }
+
+        void
+        reset(const std::size_t site)
+        // Discard all sites, as well as any rounding error.
+        {
+            *this = window_accumulator();
+            first_site = site;
+        }
+
+        void
+        add(const site_contribution& c)
+        {
+            pi.add(c.pi);
+            w.add(c.w);
+            if (c.counted)
+                {
+                    tajd_pi.add(c.pi);
+                    S += c.S;
+                    std::size_t site = first_site + sites.size();
+                    while (!max_nsam.empty()
+                           && max_nsam.back().second <= c.nsam)
+                        {
+                            max_nsam.pop_back();
+                        }
+                    max_nsam.emplace_back(site, c.nsam);
+                }
+            h.add(c.h);
+            l.add(c.l);
+            multiple_derived += c.multiple_derived;
+            fw_pi.add(c.fw_pi);
+            fw_h.add(c.fw_h);
+            fw_l.add(c.fw_l);
+            fw_S += c.fw_S;
+            too_many_states += c.too_many_states;
+            sites.push_back(c);
+        }
+
+        void
+        remove_first()
+        {
+            const auto& c = sites.front();
+            pi.remove(c.pi);
+            w.remove(c.w);
+            if (c.counted)
+                {
+                    tajd_pi.remove(c.pi);
+                    S -= c.S;
+                    if (max_nsam.front().first == first_site)
+                        {
+                            max_nsam.pop_front();
+                        }
+                }
+            h.remove(c.h);
+            l.remove(c.l);
+            multiple_derived -= c.multiple_derived;
+            fw_pi.remove(c.fw_pi);
+            fw_h.remove(c.fw_h);
+            fw_l.remove(c.fw_l);
+            fw_S -= c.fw_S;
+            too_many_states -= c.too_many_states;
+            sites.pop_front();
+            ++first_site;
+        }
+
+        Sequence::WindowStatistics
+        statistics(const double beg, const double end,
+                   const unsigned requested, const std::size_t nsam) const
+        {
+            using Sequence::WindowStatistic;
+            const auto nan = std::numeric_limits<double>::quiet_NaN();
+            Sequence::WindowStatistics rv{
+                beg, end, first_site, sites.size(), nan, nan, nan, nan, nan,
+                nan, nan
+            };
+            if (!sites.empty() && multiple_derived
+                && (requested & (WindowStatistic::thetah
+                                 | WindowStatistic::thetal)))
+                {
+                    throw std::runtime_error(
+                        "site has more than one derived state");
+                }
+            if (!sites.empty() && too_many_states
+                && (requested & (WindowStatistic::faywuh
+                                 | WindowStatistic::hprime)))
+                {
+                    throw std::runtime_error(
+                        "site has more than one derived state");
+                }
+            if (requested & WindowStatistic::thetapi)
+                {
+                    rv.thetapi = pi.value();
+                }
+            if (requested & WindowStatistic::thetaw)
+                {
+                    rv.thetaw = w.value();
+                }
+            if (requested & WindowStatistic::tajd)
+                {
+                    rv.tajd = Sequence::summstats_aux::tajd(
+                        tajd_pi.value(), S,
+                        max_nsam.empty() ? 0
+                                         : static_cast<std::uint32_t>(
+                                               max_nsam.front().second));
+                }
+            if (requested & WindowStatistic::thetah)
+                {
+                    rv.thetah = h.value();
+                }
+            if (requested & WindowStatistic::thetal)
+                {
+                    rv.thetal = l.value();
+                }
+            if (sites.empty())
+                {
+                    return rv;
+                }
+            if ((requested & WindowStatistic::faywuh) && fw_S)
+                {
+                    rv.faywuh = fw_pi.value() - fw_h.value();
+                }
+            if (requested & WindowStatistic::hprime)
+                {
+                    rv.hprime = Sequence::summstats_aux::hprime(
+                        static_cast<std::uint32_t>(nsam), fw_S,
+                        fw_pi.value(), fw_l.value());
+                }
+            return rv;
+        }
+    };
+} // namespace
+
+namespace Sequence
+{
+    std::vector<WindowStatistics>
+    windowed_statistics(const VariantMatrix& m, const double beg,
+                        const double end, const double window_size,
+                        const double step, const unsigned statistics,
+                        const std::int8_t refstate)
+    {
+        if (window_size < 0.0)
+            {
+                throw std::invalid_argument("window_size must be >= 0");
+            }
+        if (!(step > 0.0))
+            {
+                throw std::invalid_argument("step must be > 0");
+            }
+        AlleleCountMatrix ac(m);
+        const bool needs_refstate
+            = statistics
+              & (WindowStatistic::thetah | WindowStatistic::thetal
+                 | WindowStatistic::faywuh | WindowStatistic::hprime);
+        // Without a reference state, no allele is the reference,
+        // and the terms depending on it are zero.
+        auto refindex = ac.ncol;
+        if (needs_refstate)
+            {
+                if (refstate < 0)
+                    {
+                        throw std::invalid_argument(
+                            "reference state must be non-negative");
+                    }
+                refindex = static_cast<std::size_t>(refstate);
+                if (!ac.counts.empty() && refindex >= ac.ncol)
+                    {
+                        throw std::invalid_argument(
+                            "reference state greater than max allelic "
+                            "state");
+                    }
+            }
+
+        std::vector<WindowStatistics> rv;
+        const double* pb = m.cpbegin();
+        const double* pe = m.cpend();
+        window_accumulator acc;
+        // The current window contains sites [left, right)
+        std::size_t left = 0, right = 0;
+        for (std::size_t k = 0;; ++k)
+            {
+                const double wbeg = beg + static_cast<double>(k) * step;
+                if (!(wbeg < end))
+                    {
+                        break;
+                    }
+                const double wend = wbeg + window_size;
+                auto l = static_cast<std::size_t>(
+                    std::lower_bound(pb + left, pe, wbeg) - pb);
+                auto r = static_cast<std::size_t>(
+                    std::upper_bound(pb + l, pe, wend) - pb);
+                if (l >= right)
+                    {
+                        acc.reset(l);
+                        left = right = l;
+                    }
+                for (; right < r; ++right)
+                    {
+                        acc.add(make_contribution(ac, right, refindex));
+                    }
+                for (; left < l; ++left)
+                    {
+                        acc.remove_first();
+                    }
+                rv.emplace_back(
+                    acc.statistics(wbeg, wend, statistics, ac.nsam));
+            }
+        return rv;
+    }
+} // namespace Sequence
@@ -1,5 +1,8 @@
 #include <Sequence/NonOwningCapsules.hpp>
+#include <Sequence/FilteredCapsules.hpp>
 #include <Sequence/variant_matrix/windows.hpp>
+#include <Sequence/variant_matrix/filtering.hpp>
+#include <numeric>
 
 namespace Sequence
 {
@@ -27,6 +30,19 @@ namespace Sequence
             }
         auto pb = std::lower_bound(m.pbegin(), m.pend(), beg);
         auto pe = std::upper_bound(pb, m.pend(), end);
+        std::size_t row_offset = pb - m.pbegin();
+        std::size_t nsites = pe - pb;
+        std::size_t nsam = j - i;
+        if (dynamic_cast<const FilteredGenotypeCapsule*>(
+                m.genotype_capsule()))
+            {
+                // The genotypes of a filtered view are not evenly
+                // spaced, so the slice is a view of the view.
+                std::vector<std::size_t> sites(nsites), samples(nsam);
+                std::iota(sites.begin(), sites.end(), row_offset);
+                std::iota(samples.begin(), samples.end(), i);
+                return make_filtered_view(m, sites, samples);
+            }
         if (pb == m.pend())
             {
                 std::unique_ptr<GenotypeCapsule> gc(
@@ -35,11 +51,10 @@ namespace Sequence
                     new NonOwningPositionCapsule(pb, 0));
                 return VariantMatrix(std::move(gc), std::move(pc), -1);
             }
-        std::size_t nsites = pe - pb;
-        std::size_t nsam = j - i;
-        std::size_t row_offset = pb - m.pbegin();
+        // The span accounts for any offsets and stride of m
+        const auto g = get_ConstGenotypeSpan(m);
         std::unique_ptr<GenotypeCapsule> gc(new NonOwningGenotypeCapsule(
-            m.cdata(), nsites, nsam, row_offset, i, m.nsam()));
+            g.data, nsites, nsam, row_offset, i, g.stride));
         std::unique_ptr<PositionCapsule> pc(
             new NonOwningPositionCapsule(pb, pe - pb));
         return VariantMatrix(std::move(gc), std::move(pc), m.max_allele());
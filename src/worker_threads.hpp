@@ -0,0 +1,95 @@
+#ifndef SEQUENCE_WORKER_THREADS_HPP
+#define SEQUENCE_WORKER_THREADS_HPP
+
+// These functions are not exported.
+// They are used internally.
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace Sequence
+{
+    namespace detail
+    {
+        template <typename F>
+        void
+        run_workers(const std::size_t nworkers, const F& work)
+        // Call work(t) for t in [0, nworkers), each on its own
+        // thread.  With fewer than two workers, work is called on
+        // the calling thread.  Every thread that starts is joined
+        // before returning, including when starting one throws.
+        // The first exception thrown by a worker, in order of t,
+        // is rethrown after all have been joined.
+        {
+            if (nworkers < 2)
+                {
+                    for (std::size_t t = 0; t < nworkers; ++t)
+                        {
+                            work(t);
+                        }
+                    return;
+                }
+            std::vector<std::exception_ptr> errors(nworkers);
+            std::vector<std::thread> threads;
+            threads.reserve(nworkers);
+            try
+                {
+                    for (std::size_t t = 0; t < nworkers; ++t)
+                        {
+                            threads.emplace_back([&work, &errors, t]() {
+                                try
+                                    {
+                                        work(t);
+                                    }
+                                catch (...)
+                                    {
+                                        errors[t] = std::current_exception();
+                                    }
+                            });
+                        }
+                }
+            catch (...)
+                {
+                    for (auto& t : threads)
+                        {
+                            t.join();
+                        }
+                    throw;
+                }
+            for (auto& t : threads)
+                {
+                    t.join();
+                }
+            for (auto& e : errors)
+                {
+                    if (e)
+                        {
+                            std::rethrow_exception(e);
+                        }
+                }
+        }
+
+        template <typename F>
+        void
+        run_strided(const std::size_t nitems, const unsigned nthreads,
+                    const F& process_item)
+        // Thread t processes items t, t + nthreads, etc., which
+        // balances the work when the cost of items changes
+        // steadily with their index.
+        // precondition: nthreads > 0
+        {
+            const std::size_t nworkers
+                = (nthreads < nitems) ? nthreads : nitems;
+            run_workers(nworkers, [&](const std::size_t t) {
+                for (std::size_t i = t; i < nitems; i += nworkers)
+                    {
+                        process_item(i);
+                    }
+            });
+        }
+    } // namespace detail
+} // namespace Sequence
+
+#endif
@@ -160,6 +160,33 @@ BOOST_AUTO_TEST_CASE(test_column_view_invalid_compare)
                         std::invalid_argument);
 }
 
+BOOST_AUTO_TEST_CASE(test_genotype_span)
+{
+    // A window has row and column offsets into its parent's data
+    auto w = Sequence::make_slice(m, m.position(2), m.position(10), 3, 9);
+    for (const Sequence::VariantMatrix* vm : { &m, &w })
+        {
+            auto g = Sequence::get_ConstGenotypeSpan(*vm);
+            BOOST_REQUIRE_EQUAL(g.nsites, vm->nsites());
+            BOOST_REQUIRE_EQUAL(g.nsam, vm->nsam());
+            for (std::size_t i = 0; i < g.nsites; ++i)
+                {
+                    auto r = g.row(i);
+                    BOOST_REQUIRE(std::equal(
+                        r.begin(), r.end(),
+                        Sequence::get_ConstRowView(*vm, i).begin()));
+                    for (std::size_t j = 0; j < g.nsam; ++j)
+                        {
+                            BOOST_REQUIRE_EQUAL(g(i, j), vm->get(i, j));
+                            BOOST_REQUIRE_EQUAL(g.col(j)[i], vm->get(i, j));
+                        }
+                }
+        }
+    auto g = Sequence::get_GenotypeSpan(m);
+    g(1, 2) = 3;
+    BOOST_REQUIRE_EQUAL(m.get(1, 2), 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_FIXTURE_TEST_SUITE(test_deep_copy, vmatrix_from_msprime)
@@ -201,4 +228,137 @@ BOOST_AUTO_TEST_CASE(test_io_roundtrip)
     BOOST_REQUIRE_EQUAL(m != vm, false);
 }
 
+namespace
+{
+    std::string
+    manual_haplotypes(const Sequence::VariantMatrix& m)
+    {
+        std::ostringstream o;
+        for (std::size_t i = 0; i < m.nsam(); ++i)
+            {
+                for (std::size_t site = 0; site < m.nsites(); ++site)
+                    {
+                        o << static_cast<int>(m.get(site, i));
+                    }
+                if (i < m.nsam() - 1)
+                    {
+                        o << '\n';
+                    }
+            }
+        return o.str();
+    }
+
+    std::string
+    haplotype_lines(const std::string& msformat)
+    // Everything after the positions line
+    {
+        auto p = msformat.find("positions:");
+        return msformat.substr(msformat.find('\n', p) + 1);
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_write_window)
+{
+    auto w = Sequence::make_window(m, 0.1, 0.3);
+    std::ostringstream o;
+    Sequence::to_msformat(w, o);
+    BOOST_REQUIRE_EQUAL(haplotype_lines(o.str()), manual_haplotypes(w));
+    std::istringstream in(o.str());
+    auto vm = Sequence::from_msformat(in);
+    BOOST_REQUIRE_EQUAL(vm.nsites(), w.nsites());
+    BOOST_REQUIRE_EQUAL(vm.nsam(), w.nsam());
+    for (std::size_t site = 0; site < vm.nsites(); ++site)
+        {
+            for (std::size_t i = 0; i < vm.nsam(); ++i)
+                {
+                    BOOST_REQUIRE_EQUAL(vm.get(site, i), w.cget(site, i));
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_write_multiple_digit_states)
+{
+    std::vector<std::int8_t> data{ 0, 12, 1, -1 };
+    std::vector<double> pos{ 0.1, 0.2 };
+    Sequence::VariantMatrix vm(std::move(data), std::move(pos));
+    std::ostringstream o;
+    Sequence::to_msformat(vm, o);
+    BOOST_REQUIRE_EQUAL(haplotype_lines(o.str()), "01\n12-1");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(test_msformat_reader, msprime_stream)
+
+BOOST_AUTO_TEST_CASE(test_reader_matches_from_msformat)
+{
+    std::istringstream in2(in.str());
+    Sequence::MsFormatReader reader(in2);
+    BOOST_REQUIRE_THROW(reader.replicate(), std::runtime_error);
+    std::size_t nreps = 0;
+    do
+        {
+            auto m = Sequence::from_msformat(in);
+            BOOST_REQUIRE(reader.next());
+            BOOST_REQUIRE(reader.replicate() == m);
+            BOOST_REQUIRE_EQUAL(reader.replicate().max_allele(),
+                                m.max_allele());
+            ++nreps;
+        }
+    while (!in.eof());
+    BOOST_REQUIRE(nreps > 1);
+    BOOST_REQUIRE(!reader.next());
+    BOOST_REQUIRE_THROW(reader.replicate(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_reader_no_segregating_sites)
+{
+    std::istringstream input("ms 4 2 -t 1\n1 2 3\n\n//\nsegsites: 0\n\n//\n"
+                             "segsites: 2\npositions: 0.25 0.5\n01\n10\n11\n"
+                             "00\n");
+    Sequence::MsFormatReader reader(input);
+    BOOST_REQUIRE(reader.next());
+    BOOST_REQUIRE_EQUAL(reader.replicate().nsites(), 0);
+    BOOST_REQUIRE(reader.next());
+    auto& m = reader.replicate();
+    BOOST_REQUIRE_EQUAL(m.nsites(), 2);
+    BOOST_REQUIRE_EQUAL(m.nsam(), 4);
+    BOOST_REQUIRE_EQUAL(m.get(0, 2), 1);
+    BOOST_REQUIRE_EQUAL(m.get(1, 3), 0);
+    BOOST_REQUIRE_EQUAL(m.cposition(1), 0.5);
+    BOOST_REQUIRE(!reader.next());
+
+    std::istringstream bad("//\nsegsites: 2\npositions: 0.25 0.5\n01\n1\n");
+    Sequence::MsFormatReader bad_reader(bad);
+    BOOST_REQUIRE_THROW(bad_reader.next(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_crlf_line_endings)
+{
+    std::istringstream input("//\r\nsegsites: 2\r\npositions: 0.25 0.5\r\n"
+                             "01\r\n10\r\n11\r\n");
+    auto m = Sequence::from_msformat(input);
+    BOOST_REQUIRE_EQUAL(m.nsites(), 2);
+    BOOST_REQUIRE_EQUAL(m.nsam(), 3);
+    BOOST_REQUIRE_EQUAL(m.get(0, 0), 0);
+    BOOST_REQUIRE_EQUAL(m.get(1, 0), 1);
+    BOOST_REQUIRE_EQUAL(m.get(0, 2), 1);
+    BOOST_REQUIRE_EQUAL(m.cposition(1), 0.5);
+}
+
+BOOST_AUTO_TEST_CASE(test_trailing_spaces)
+{
+    std::istringstream input("//\nsegsites: 2\npositions: 0.25 0.5 \n"
+                             "01  \n10\t\n11 \n");
+    Sequence::MsFormatReader reader(input);
+    BOOST_REQUIRE(reader.next());
+    auto& m = reader.replicate();
+    BOOST_REQUIRE_EQUAL(m.nsites(), 2);
+    BOOST_REQUIRE_EQUAL(m.nsam(), 3);
+    BOOST_REQUIRE_EQUAL(m.get(1, 0), 1);
+    BOOST_REQUIRE_EQUAL(m.get(0, 1), 1);
+    BOOST_REQUIRE_EQUAL(m.get(1, 2), 1);
+    BOOST_REQUIRE(!reader.next());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,67 @@
+#ifndef LIBSEQUENCE_TEST_COALESCENT_TEST_DATA_HPP
+#define LIBSEQUENCE_TEST_COALESCENT_TEST_DATA_HPP
+
+// Parameters and helpers shared by the tests of the coalescent routines
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/Coalescent/SimTypes.hpp>
+#include <Sequence/Coalescent/Initialize.hpp>
+#include <Sequence/Coalescent/NeutralHistory.hpp>
+#include <Sequence/Coalescent/ReplicateDriver.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace coalescent_test_data
+{
+    const double theta = 20.0, rho = 10.0;
+    const int nsites = 1000, nsam = 20;
+    const std::uint64_t seed = 101;
+
+    inline bool
+    close(const double a, const double b)
+    {
+        return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(a));
+    }
+
+    inline bool
+    same_matrix(const Sequence::VariantMatrix& a,
+                const Sequence::VariantMatrix& b)
+    {
+        return a.nsites() == b.nsites() && a.nsam() == b.nsam()
+               && std::equal(a.data(), a.data() + a.nsites() * a.nsam(),
+                             b.data())
+               && std::equal(a.pbegin(), a.pend(), b.pbegin());
+    }
+
+    inline std::vector<Sequence::VariantMatrix>
+    run(const std::uint64_t nreps, const unsigned nthreads)
+    // The output of neutral_replicates, in order
+    {
+        std::vector<Sequence::VariantMatrix> rv;
+        Sequence::coalsim::neutral_replicates(
+            nreps, seed, nthreads, theta, rho, nsites, nsam,
+            [&rv](const std::uint64_t r,
+                  Sequence::coalsim::neutral_replicate&& result) {
+                BOOST_REQUIRE_EQUAL(r, rv.size());
+                rv.emplace_back(std::move(result.genotypes));
+            });
+        return rv;
+    }
+
+    inline Sequence::coalsim::arg
+    simulate_history(Sequence::coalsim::rng_streams& rng)
+    {
+        auto sample = Sequence::coalsim::init_sample(
+            std::vector<int>(1, nsam), nsites);
+        Sequence::coalsim::arg history(
+            1, Sequence::coalsim::init_marginal(nsam));
+        Sequence::coalsim::neutral_history(rng.uni, rng.uni01, rng.expo, rho,
+                                           nsites, nsam, &sample, &history);
+        return history;
+    }
+} // namespace coalescent_test_data
+
+#endif
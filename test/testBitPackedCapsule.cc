@@ -0,0 +1,153 @@
+//! \file testBitPackedCapsule.cc @brief unit tests for Sequence::BitPackedGenotypeCapsule
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/BitPackedCapsules.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/summstats/classics.hpp>
+#include <Sequence/summstats/ld.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+namespace
+{
+    Sequence::VariantMatrix
+    add_missing_data(const Sequence::VariantMatrix& m)
+    {
+        std::vector<std::int8_t> data(m.data(),
+                                      m.data() + m.nsites() * m.nsam());
+        for (std::size_t i = 0; i < data.size(); i += 7)
+            {
+                data[i] = -1;
+            }
+        return Sequence::VariantMatrix(
+            std::move(data), std::vector<double>(m.pbegin(), m.pend()));
+    }
+
+    void
+    compare_two_locus_counts(const Sequence::VariantMatrix& a,
+                             const Sequence::VariantMatrix& b)
+    {
+        for (std::size_t i = 0; i < 25; ++i)
+            {
+                for (std::size_t j = i + 1; j < 25; ++j)
+                    {
+                        for (auto skip : { true, false })
+                            {
+                                auto x = Sequence::two_locus_haplotype_counts(
+                                    a, i, j, skip);
+                                auto y = Sequence::two_locus_haplotype_counts(
+                                    b, i, j, skip);
+                                BOOST_REQUIRE_EQUAL(x.size(), y.size());
+                                for (std::size_t k = 0; k < x.size(); ++k)
+                                    {
+                                        BOOST_REQUIRE_EQUAL(x[k].i, y[k].i);
+                                        BOOST_REQUIRE_EQUAL(x[k].j, y[k].j);
+                                        BOOST_REQUIRE_EQUAL(x[k].n, y[k].n);
+                                    }
+                            }
+                    }
+            }
+    }
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(test_bitpacked_capsule, vmatrix_from_msprime)
+
+BOOST_AUTO_TEST_CASE(test_element_access)
+{
+    auto bp = Sequence::make_bitpacked(m);
+    BOOST_REQUIRE_EQUAL(bp.nsites(), m.nsites());
+    BOOST_REQUIRE_EQUAL(bp.nsam(), m.nsam());
+    BOOST_REQUIRE_EQUAL(bp.max_allele(), m.max_allele());
+    for (std::size_t i = 0; i < m.nsites(); ++i)
+        {
+            for (std::size_t j = 0; j < m.nsam(); ++j)
+                {
+                    BOOST_REQUIRE_EQUAL(bp.cget(i, j), m.get(i, j));
+                }
+        }
+    BOOST_REQUIRE(bp == m);
+}
+
+BOOST_AUTO_TEST_CASE(test_read_only)
+{
+    auto bp = Sequence::make_bitpacked(m);
+    BOOST_REQUIRE_THROW(bp.get(0, 0) = 1, std::runtime_error);
+    BOOST_REQUIRE_THROW(bp.data(), std::runtime_error);
+    BOOST_REQUIRE_EQUAL(bp.resizable(), false);
+}
+
+BOOST_AUTO_TEST_CASE(test_concurrent_unpacking)
+{
+    // Const access from several threads unpacks the data once
+    const auto bp = Sequence::make_bitpacked(m);
+    std::vector<const std::int8_t*> pointers(4, nullptr);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < pointers.size(); ++i)
+        {
+            threads.emplace_back(
+                [&bp, &pointers, i]() { pointers[i] = bp.cdata(); });
+        }
+    for (auto& t : threads)
+        {
+            t.join();
+        }
+    for (auto p : pointers)
+        {
+            BOOST_REQUIRE(p == pointers[0]);
+        }
+    BOOST_REQUIRE(std::equal(pointers[0],
+                             pointers[0] + m.nsites() * m.nsam(), m.data()));
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid_states)
+{
+    std::vector<std::int8_t> data{ 0, 1, 2, 0 };
+    BOOST_REQUIRE_THROW(Sequence::BitPackedGenotypeCapsule(data, 2),
+                        std::invalid_argument);
+    data[2] = Sequence::VariantMatrix::mask;
+    BOOST_REQUIRE_THROW(Sequence::BitPackedGenotypeCapsule(data, 2),
+                        std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_allele_counts)
+{
+    auto bp = Sequence::make_bitpacked(m);
+    Sequence::AlleleCountMatrix bpc(bp);
+    BOOST_REQUIRE_EQUAL(bpc.ncol, c.ncol);
+    BOOST_REQUIRE_EQUAL(bpc.nrow, c.nrow);
+    BOOST_REQUIRE(bpc.counts == c.counts);
+    BOOST_REQUIRE_EQUAL(Sequence::thetapi(bpc), Sequence::thetapi(c));
+    BOOST_REQUIRE_EQUAL(Sequence::thetaw(bpc), Sequence::thetaw(c));
+}
+
+BOOST_AUTO_TEST_CASE(test_allele_counts_missing_data)
+{
+    auto mm = add_missing_data(m);
+    auto bp = Sequence::make_bitpacked(mm);
+    BOOST_REQUIRE(Sequence::AlleleCountMatrix(bp).counts
+                  == Sequence::AlleleCountMatrix(mm).counts);
+}
+
+BOOST_AUTO_TEST_CASE(test_difference_matrix)
+{
+    auto bp = Sequence::make_bitpacked(m);
+    BOOST_REQUIRE(Sequence::difference_matrix(bp)
+                  == Sequence::difference_matrix(m));
+    auto mm = add_missing_data(m);
+    auto bpm = Sequence::make_bitpacked(mm);
+    BOOST_REQUIRE(Sequence::difference_matrix(bpm)
+                  == Sequence::difference_matrix(mm));
+}
+
+BOOST_AUTO_TEST_CASE(test_two_locus_haplotype_counts)
+{
+    compare_two_locus_counts(m, Sequence::make_bitpacked(m));
+    auto mm = add_missing_data(m);
+    compare_two_locus_counts(mm, Sequence::make_bitpacked(mm));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,7 @@
 #include <Sequence/VariantMatrix.hpp>
 #include <Sequence/VariantMatrixViews.hpp>
 #include <Sequence/summstats/classics.hpp>
+#include <Sequence/variant_matrix/windows.hpp>
 #include "msprime_data_fixture.hpp"
 #include <boost/test/unit_test.hpp>
 
@@ -63,6 +64,49 @@ manual_thetah(const Sequence::VariantMatrix& m, const std::int8_t refstate)
     return h;
 }
 
+static std::vector<std::int32_t>
+greedy_haplotype_labels(const Sequence::VariantMatrix& m)
+// The pairwise labelling used before label_haplotypes
+// hashed samples.
+{
+    std::vector<std::int32_t> rv(m.nsam());
+    std::iota(rv.begin(), rv.end(), 0);
+    std::vector<int> processed(m.nsam(), 0);
+    auto dm = Sequence::is_different_matrix(m);
+    auto missing = [&m](std::size_t i) {
+        auto c = Sequence::get_ConstColView(m, i);
+        return std::all_of(c.begin(), c.end(),
+                           [](std::int8_t x) { return x < 0; });
+    };
+    std::size_t n = m.nsam(), C = n * (n - 1) / 2;
+    for (std::size_t i = 0; i < n; ++i)
+        {
+            if (processed[i])
+                {
+                    continue;
+                }
+            if (missing(i))
+                {
+                    rv[i] = -1;
+                    continue;
+                }
+            for (std::size_t j = i + 1; j < n; ++j)
+                {
+                    if (missing(j))
+                        {
+                            rv[j] = -1;
+                            processed[j] = 1;
+                        }
+                    else if (!dm[C - (n - i) * (n - i - 1) / 2 + j - i - 1])
+                        {
+                            rv[j] = rv[i];
+                            processed[j] = 1;
+                        }
+                }
+        }
+    return rv;
+}
+
 int
 manual_num_haps(const Sequence::VariantMatrix& m)
 {
@@ -106,6 +150,29 @@ manual_haplotype_labels_no_missing_data(const Sequence::VariantMatrix& m)
     return l;
 }
 
+static std::vector<std::int32_t>
+manual_difference_matrix(const Sequence::VariantMatrix& m)
+// Pairwise differences, skipping sites where either sample is missing
+{
+    std::vector<std::int32_t> rv;
+    for (std::size_t i = 0; i + 1 < m.nsam(); ++i)
+        {
+            auto hi = Sequence::get_ConstColView(m, i);
+            for (std::size_t j = i + 1; j < m.nsam(); ++j)
+                {
+                    auto hj = Sequence::get_ConstColView(m, j);
+                    std::int32_t ndiffs = 0;
+                    for (std::size_t k = 0; k < hi.size(); ++k)
+                        {
+                            ndiffs += (hi[k] >= 0 && hj[k] >= 0
+                                       && hi[k] != hj[k]);
+                        }
+                    rv.push_back(ndiffs);
+                }
+        }
+    return rv;
+}
+
 BOOST_FIXTURE_TEST_SUITE(test_classic_stats, vmatrix_from_msprime)
 
 BOOST_AUTO_TEST_CASE(test_thetapi)
@@ -292,6 +359,41 @@ BOOST_AUTO_TEST_CASE(test_number_of_differences)
         }
 }
 
+BOOST_AUTO_TEST_CASE(test_number_of_differences_missing_data)
+{
+    std::vector<std::int8_t> temp(m.data(), m.data() + m.nsites() * m.nsam());
+    std::vector<double> tpos(m.pbegin(), m.pend());
+    Sequence::VariantMatrix m2(std::move(temp), std::move(tpos));
+    for (std::size_t i = 0; i < m2.nsam(); i += 7)
+        {
+            for (std::size_t site = i; site < m2.nsites(); site += 3)
+                {
+                    m2.get(site, i) = -1;
+                }
+        }
+    BOOST_REQUIRE(Sequence::difference_matrix(m2)
+                  == manual_difference_matrix(m2));
+    auto w = Sequence::make_window(m2, 0.2, 0.4);
+    BOOST_REQUIRE(Sequence::difference_matrix(w)
+                  == manual_difference_matrix(w));
+}
+
+BOOST_AUTO_TEST_CASE(test_number_of_differences_many_samples)
+// More samples and sites than fit in one tile of the kernel
+{
+    const std::size_t nsam = 1100, nsites = 300;
+    std::vector<std::int8_t> data(nsam * nsites);
+    for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = static_cast<std::int8_t>((i * 2654435761u) % 5) - 1;
+        }
+    std::vector<double> pos(nsites);
+    std::iota(pos.begin(), pos.end(), 0.0);
+    Sequence::VariantMatrix m2(std::move(data), std::move(pos));
+    BOOST_REQUIRE(Sequence::difference_matrix(m2)
+                  == manual_difference_matrix(m2));
+}
+
 BOOST_AUTO_TEST_CASE(test_is_different_matrix)
 {
     auto nd = Sequence::difference_matrix(m);
@@ -337,6 +439,34 @@ BOOST_AUTO_TEST_CASE(test_haploype_label_correctness)
         }
 }
 
+BOOST_AUTO_TEST_CASE(test_haplotype_labels_missing_data)
+{
+    BOOST_REQUIRE(Sequence::label_haplotypes(m) == greedy_haplotype_labels(m));
+    std::vector<std::int8_t> temp(m.data(), m.data() + m.nsites() * m.nsam());
+    std::vector<double> tpos(m.pbegin(), m.pend());
+    Sequence::VariantMatrix m2(std::move(temp), std::move(tpos));
+    // Sprinkle missing data, including a sample with no data
+    for (std::size_t i = 0; i < m2.nsam(); i += 7)
+        {
+            for (std::size_t site = i; site < m2.nsites(); site += 3)
+                {
+                    m2.get(site, i) = -1;
+                }
+        }
+    for (std::size_t site = 0; site < m2.nsites(); ++site)
+        {
+            m2.get(site, 10) = -1;
+            // Samples 20 and 30 are copies of 25 with missing data
+            m2.get(site, 20) = (site % 2) ? m2.get(site, 25) : -1;
+            m2.get(site, 30) = (site % 5) ? m2.get(site, 25) : -1;
+        }
+    auto labels = Sequence::label_haplotypes(m2);
+    BOOST_REQUIRE(labels == greedy_haplotype_labels(m2));
+    BOOST_REQUIRE_EQUAL(labels[10], -1);
+    BOOST_REQUIRE_EQUAL(labels[25], labels[20]);
+    BOOST_REQUIRE_EQUAL(labels[30], labels[20]);
+}
+
 BOOST_AUTO_TEST_CASE(test_num_haplotypes)
 {
     auto nh = Sequence::number_of_haplotypes(m);
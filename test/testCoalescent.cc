@@ -0,0 +1,58 @@
+//! \file testCoalescent.cc @brief unit tests for the coalescent simulation routines
+
+#include <stdexcept>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/Coalescent/ReplicateDriver.hpp>
+#include <boost/test/unit_test.hpp>
+#include "coalescent_test_data.hpp"
+
+using namespace coalescent_test_data;
+
+BOOST_AUTO_TEST_SUITE(test_coalescent)
+
+BOOST_AUTO_TEST_CASE(test_replicates_do_not_depend_on_threads)
+{
+    // More replicates than the threads may run ahead of the output
+    const auto serial = run(300, 1);
+    BOOST_REQUIRE_EQUAL(serial.size(), 300);
+    for (unsigned nthreads : { 2u, 4u })
+        {
+            const auto threaded = run(300, nthreads);
+            BOOST_REQUIRE_EQUAL(threaded.size(), serial.size());
+            for (std::size_t i = 0; i < serial.size(); ++i)
+                {
+                    BOOST_REQUIRE(same_matrix(serial[i], threaded[i]));
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_replicate_exceptions)
+{
+    auto simulate = [](Sequence::coalsim::rng_streams& rng,
+                       const std::uint64_t r) {
+        if (r == 200)
+            {
+                throw std::runtime_error("simulation failed");
+            }
+        return rng.uni01();
+    };
+    auto ignore = [](const std::uint64_t, const double) {};
+    BOOST_CHECK_THROW(
+        Sequence::coalsim::run_replicates(1000, seed, 4, simulate, ignore),
+        std::runtime_error);
+    auto fail = [](const std::uint64_t r, const double) {
+        if (r == 10)
+            {
+                throw std::runtime_error("output failed");
+            }
+    };
+    BOOST_CHECK_THROW(
+        Sequence::coalsim::run_replicates(1000, seed, 4, simulate, fail),
+        std::runtime_error);
+    BOOST_CHECK_THROW(
+        Sequence::coalsim::run_replicates(10, seed, 0, simulate, ignore),
+        std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,69 @@
+//! \file testCoalescentArena.cc @brief unit tests for arena storage of the coalescent ARG
+
+#include <cstdint>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/Coalescent/Arena.hpp>
+#include <Sequence/Coalescent/ReplicateDriver.hpp>
+#include <boost/test/unit_test.hpp>
+#include "coalescent_test_data.hpp"
+
+using namespace coalescent_test_data;
+
+BOOST_AUTO_TEST_SUITE(test_coalescent_arena)
+
+BOOST_AUTO_TEST_CASE(test_arena_matches_heap)
+{
+    Sequence::coalsim::sim_arena arena;
+    std::vector<Sequence::coalsim::chromosome> sample;
+    Sequence::coalsim::arg history;
+    Sequence::coalsim::rng_streams rng(seed, 0);
+    for (std::uint64_t r = 0; r < 20; ++r)
+        {
+            rng.reseed(seed, r);
+            const auto expected = simulate_history(rng);
+            rng.reseed(seed, r);
+            arena.init_replicate(std::vector<int>(1, nsam), nsites, &sample,
+                                 &history);
+            Sequence::coalsim::neutral_history(rng.uni, rng.uni01, rng.expo,
+                                               rho, nsites, nsam, &sample,
+                                               &history);
+            BOOST_REQUIRE_EQUAL(history.size(), expected.size());
+            auto j = expected.begin();
+            for (auto i = history.begin(); i != history.end(); ++i, ++j)
+                {
+                    BOOST_REQUIRE_EQUAL(i->beg, j->beg);
+                    BOOST_REQUIRE_EQUAL(i->nnodes, j->nnodes);
+                    for (int k = 0; k < i->nnodes; ++k)
+                        {
+                            BOOST_REQUIRE_EQUAL((*i)[k].time, (*j)[k].time);
+                            BOOST_REQUIRE_EQUAL((*i)[k].abv, (*j)[k].abv);
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_neutral_variant_matrices)
+{
+    // The same samples as neutral_replicates, with the ARGs
+    // kept and recycled by the simulating threads
+    const auto expected = run(300, 1);
+    for (unsigned nthreads : { 1u, 3u })
+        {
+            std::vector<Sequence::VariantMatrix> matrices;
+            Sequence::coalsim::neutral_variant_matrices(
+                300, seed, nthreads, theta, rho, nsites, nsam,
+                [&matrices](const std::uint64_t r,
+                            Sequence::VariantMatrix&& m) {
+                    BOOST_REQUIRE_EQUAL(r, matrices.size());
+                    matrices.emplace_back(std::move(m));
+                });
+            BOOST_REQUIRE_EQUAL(matrices.size(), expected.size());
+            for (std::size_t i = 0; i < expected.size(); ++i)
+                {
+                    BOOST_REQUIRE(same_matrix(matrices[i], expected[i]));
+                }
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
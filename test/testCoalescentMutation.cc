@@ -0,0 +1,68 @@
+//! \file testCoalescentMutation.cc @brief unit tests for placing coalescent mutations into a VariantMatrix
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+// The output of infinite_sites_variant_matrix is compared with
+// the deprecated SimData returned by neutral_sample
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#include <Sequence/Coalescent/NeutralSample.hpp>
+#include <Sequence/Coalescent/InfiniteSitesMatrix.hpp>
+#include <boost/test/unit_test.hpp>
+#include "coalescent_test_data.hpp"
+
+using namespace coalescent_test_data;
+
+namespace
+{
+    Sequence::VariantMatrix
+    as_variant_matrix(const Sequence::SimData& gametes)
+    // Gametes are rows of SimData but columns of VariantMatrix
+    {
+        const std::size_t nsam = gametes.size(), S = gametes.numsites();
+        std::vector<std::int8_t> data(nsam * S);
+        std::vector<double> pos(S);
+        for (std::size_t site = 0; site < S; ++site)
+            {
+                pos[site] = gametes.position(site);
+            }
+        for (std::size_t i = 0; i < nsam; ++i)
+            {
+                const std::string& g = gametes[i];
+                for (std::size_t site = 0; site < S; ++site)
+                    {
+                        data[site * nsam + i] = std::int8_t(g[site] == '1');
+                    }
+            }
+        return Sequence::VariantMatrix(std::move(data), std::move(pos), 1);
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_coalescent_mutation)
+
+BOOST_AUTO_TEST_CASE(test_variant_matrix_matches_sim_data)
+{
+    Sequence::coalsim::rng_streams rng(seed, 0);
+    std::vector<Sequence::coalsim::chromosome> sample;
+    Sequence::coalsim::arg history;
+    for (std::uint64_t r = 0; r < 20; ++r)
+        {
+            rng.reseed(seed, r);
+            sample = Sequence::coalsim::init_sample(std::vector<int>(1, nsam),
+                                                    nsites);
+            history.clear();
+            history.push_back(Sequence::coalsim::init_marginal(nsam));
+            const auto gametes = Sequence::coalsim::neutral_sample(
+                rng.uni, rng.uni01, rng.expo, rng.poiss, theta, rho, nsites,
+                nsam, &sample, &history);
+            rng.reseed(seed, r);
+            const auto h = simulate_history(rng);
+            const auto m = Sequence::coalsim::infinite_sites_variant_matrix(
+                rng.poiss, rng.uni, nsites, h, theta);
+            BOOST_REQUIRE(
+                same_matrix(m, as_variant_matrix(gametes)));
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
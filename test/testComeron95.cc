@@ -0,0 +1,229 @@
+//! \file testComeron95.cc @brief unit tests for Sequence::Comeron95 and Sequence::Comeron95_pairs
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <Sequence/Fasta.hpp>
+#include <Sequence/Comeron95.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    bool
+    same_value(const double a, const double b)
+    {
+        return (std::isnan(a) && std::isnan(b)) || a == b;
+    }
+
+    bool
+    close_value(const double a, const double b)
+    {
+        return (std::isnan(a) && std::isnan(b))
+               || std::fabs(a - b) <= 1e-12 * std::max(1.0, std::fabs(b));
+    }
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    struct expected_result
+    // Ka, Ks, P0, P2S, P2V, P4, Q0, Q2S, Q2V and Q4 for
+    // sequences i and j of make_sequences
+    {
+        int maxdiffs;
+        std::size_t i, j;
+        std::array<double, 10> values;
+    };
+
+    // Output of libsequence 1.9.8, before codon pairs were
+    // looked up in a table.
+    const expected_result expected_results[] = {
+          { 1, 0, 1,
+            { 0.015963091739242759, nan, 0.0, 4.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+              3.0 } },
+          { 1, 0, 2,
+            { 0.24816783802311226, 0.44512827333838917, 2.0, 0.0, 1.0, 1.0,
+              2.0, 0.0, 1.0, 0.0 } },
+          { 1, 0, 3,
+            { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 } },
+          { 1, 0, 4,
+            { 0.12997345399454571, 0.0, 1.0, 0.0, 0.0, 0.0, 0.5, 0.5, 0.0,
+              0.0 } },
+          { 1, 1, 2,
+            { 0.17843197206499151, nan, 1.0, 1.0, 1.0, 0.0, 1.0, 0.0, 0.0,
+              2.0 } },
+          { 1, 1, 3,
+            { 0.015963091739242759, nan, 0.0, 4.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+              3.0 } },
+          { 1, 1, 4,
+            { 0.025452520329837646, nan, 0.0, 2.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+              1.0 } },
+          { 1, 2, 3,
+            { 0.24816783802311226, 0.44512827333838917, 2.0, 0.0, 1.0, 1.0,
+              2.0, 0.0, 1.0, 0.0 } },
+          { 1, 2, 4,
+            { 0.15063884164631772, 0.64964149206513044, 1.0, 0.0, 1.0, 1.0,
+              0.5, 0.5, 1.0, 0.0 } },
+          { 1, 3, 4,
+            { 0.12997345399454571, 0.0, 1.0, 0.0, 0.0, 0.0, 0.5, 0.5, 0.0,
+              0.0 } },
+          { 2, 0, 1,
+            { 0.015963091739242759, nan, 0.0, 4.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+              3.0 } },
+          { 2, 0, 2,
+            { 0.24816783802311226, 0.44512827333838917, 2.0, 0.0, 1.0, 1.0,
+              2.0, 0.0, 1.0, 0.0 } },
+          { 2, 0, 3,
+            { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 } },
+          { 2, 0, 4,
+            { 0.12997345399454571, 0.0, 1.0, 0.0, 0.0, 0.0, 0.5, 0.5, 0.0,
+              0.0 } },
+          { 2, 1, 2,
+            { 0.24601771631368208, nan, 2.0, 3.0, 1.0, 1.0, 2.0, 0.0, 1.0,
+              2.0 } },
+          { 2, 1, 3,
+            { 0.015963091739242759, nan, 0.0, 4.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+              3.0 } },
+          { 2, 1, 4,
+            { 0.18498780639709722, nan, 1.0, 2.0, 0.0, 0.0, 1.0,
+              0.25574588194499343, 0.2442541180550066, 2.5 } },
+          { 2, 2, 3,
+            { 0.24816783802311226, 0.44512827333838917, 2.0, 0.0, 1.0, 1.0,
+              2.0, 0.0, 1.0, 0.0 } },
+          { 2, 2, 4,
+            { 0.15063884164631772, 0.64964149206513044, 1.0, 0.0, 1.0, 1.0,
+              0.5, 0.5, 1.0, 0.0 } },
+          { 2, 3, 4,
+            { 0.12997345399454571, 0.0, 1.0, 0.0, 0.0, 0.0, 0.5, 0.5, 0.0,
+              0.0 } },
+          { 3, 0, 1,
+            { 0.015963091739242759, nan, 0.0, 4.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+              3.0 } },
+          { 3, 0, 2,
+            { 0.24816783802311226, 0.44512827333838917, 2.0, 0.0, 1.0, 1.0,
+              2.0, 0.0, 1.0, 0.0 } },
+          { 3, 0, 3,
+            { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 } },
+          { 3, 0, 4,
+            { 0.42364787210024868, 0.30443102936504074, 1.0, 0.0, 0.0, 0.0,
+              4.3348507888240251, 1.7530882559385192, 0.34481783706195479,
+              0.56724311817550099 } },
+          { 3, 1, 2,
+            { 0.24601771631368208, nan, 2.0, 3.0, 1.0, 1.0, 2.0, 0.0, 1.0,
+              2.0 } },
+          { 3, 1, 3,
+            { 0.015963091739242759, nan, 0.0, 4.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+              3.0 } },
+          { 3, 1, 4,
+            { 0.49840733195677006, nan, 1.0, 2.0, 0.0, 0.0,
+              5.0061806097400163, 1.5116139785603426, 0.41496229352414027,
+              3.0672431181755009 } },
+          { 3, 2, 3,
+            { 0.24816783802311226, 0.44512827333838917, 2.0, 0.0, 1.0, 1.0,
+              2.0, 0.0, 1.0, 0.0 } },
+          { 3, 2, 4,
+            { 0.48575611425877696, nan, 1.7480576861012915,
+              0.25194231389870841, 1.0, 1.0, 3.4313719182391327,
+              1.2480576861012915, 1.0686280817608675, 1.2519423138987087 } },
+          { 3, 3, 4,
+            { 0.42364787210024868, 0.30443102936504074, 1.0, 0.0, 0.0, 0.0,
+              4.3348507888240251, 1.7530882559385192, 0.34481783706195479,
+              0.56724311817550099 } },
+    };
+
+    std::vector<Sequence::Fasta>
+    make_sequences()
+    {
+        // Codons differing at 1, 2 and 3 positions, stop codons,
+        // and ambiguous bases.
+        std::vector<Sequence::Fasta> rv;
+        rv.emplace_back("s0", "ATGAAACCCGGGTTTAGAGCACTGTGGCATTAA");
+        rv.emplace_back("s1", "ATGAAGCCAGGGTTCAGGGCTCTCTGGCACTAA");
+        rv.emplace_back("s2", "ATGCAACCTGCGTTTCGAGCNCTGTAGCGTTAG");
+        rv.emplace_back("s3", "ATGAAACCCGGGTTTAGAGCACTGTGGCATTAA");
+        rv.emplace_back("s4", "ATGTTTCCC---TTTAGAACAATGTGGGCATAA");
+        return rv;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Comeron95Test)
+
+BOOST_AUTO_TEST_CASE(matches_values_before_lookup_tables)
+{
+    auto seqs = make_sequences();
+    Sequence::Comeron95 C;
+    // Positions in Com95_t of the values in expected_result
+    const std::array<std::size_t, 10> indexes{ { 0, 1, 3, 4, 5, 6, 7, 8, 9,
+                                                 10 } };
+    for (auto& e : expected_results)
+        {
+            auto r = C(seqs[e.i], seqs[e.j], e.maxdiffs);
+            for (std::size_t k = 0; k < indexes.size(); ++k)
+                {
+                    BOOST_CHECK_MESSAGE(
+                        close_value(r[indexes[k]], e.values[k]),
+                        "maxdiffs = " << e.maxdiffs << ", sequences "
+                                      << e.i << " and " << e.j
+                                      << ", value " << indexes[k] << ": "
+                                      << r[indexes[k]]
+                                      << " != " << e.values[k]);
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(pairs_match_single_comparisons)
+{
+    auto seqs = make_sequences();
+    const std::size_t n = seqs.size();
+    Sequence::Comeron95 C;
+    for (int maxdiffs = 1; maxdiffs <= 3; ++maxdiffs)
+        {
+            auto m = Sequence::Comeron95_pairs(seqs, maxdiffs);
+            BOOST_REQUIRE_EQUAL(m.size(), n * n);
+            for (std::size_t i = 0; i < n; ++i)
+                {
+                    for (std::size_t j = i; j < n; ++j)
+                        {
+                            auto r = C(seqs[i], seqs[j], maxdiffs);
+                            for (std::size_t k = 0; k < r.size(); ++k)
+                                {
+                                    BOOST_CHECK(
+                                        same_value(m[i * n + j][k], r[k]));
+                                    BOOST_CHECK(
+                                        same_value(m[j * n + i][k], r[k]));
+                                }
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(pairs_do_not_depend_on_nthreads)
+{
+    auto seqs = make_sequences();
+    auto m1 = Sequence::Comeron95_pairs(seqs, 3,
+                                        Sequence::GeneticCodes::UNIVERSAL, 1);
+    auto m3 = Sequence::Comeron95_pairs(seqs, 3,
+                                        Sequence::GeneticCodes::UNIVERSAL, 3);
+    BOOST_REQUIRE_EQUAL(m1.size(), m3.size());
+    for (std::size_t i = 0; i < m1.size(); ++i)
+        {
+            for (std::size_t k = 0; k < m1[i].size(); ++k)
+                {
+                    BOOST_CHECK(same_value(m1[i][k], m3[i][k]));
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(pairs_bad_input)
+{
+    auto seqs = make_sequences();
+    BOOST_CHECK_THROW(Sequence::Comeron95_pairs(
+                          seqs, 3, Sequence::GeneticCodes::UNIVERSAL, 0),
+                      std::invalid_argument);
+    seqs.emplace_back("short", "ATGAAA");
+    BOOST_CHECK_THROW(Sequence::Comeron95_pairs(seqs), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,181 @@
+//! \file testFST.cc @brief unit tests for Sequence::differentiation
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/variant_matrix/windows.hpp>
+#include <Sequence/SimData.hpp>
+#include <Sequence/FST.hpp>
+#include <Sequence/summstats/fst.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+namespace
+{
+    Sequence::SimData
+    to_simdata(const Sequence::VariantMatrix& m)
+    {
+        std::vector<std::string> haps(m.nsam(), std::string(m.nsites(), '0'));
+        for (std::size_t i = 0; i < m.nsites(); ++i)
+            {
+                auto r = Sequence::get_ConstRowView(m, i);
+                for (std::size_t j = 0; j < m.nsam(); ++j)
+                    {
+                        haps[j][i] = static_cast<char>('0' + r[j]);
+                    }
+            }
+        // Some positions are repeated, and Sequence::FST returns sets
+        // of positions, so sites are numbered instead.
+        std::vector<double> pos(m.nsites());
+        for (std::size_t i = 0; i < pos.size(); ++i)
+            {
+                pos[i] = static_cast<double>(i);
+            }
+        return Sequence::SimData(pos, haps);
+    }
+
+    std::vector<std::int32_t>
+    contiguous_populations(const std::vector<unsigned>& config)
+    {
+        std::vector<std::int32_t> pops;
+        for (std::size_t i = 0; i < config.size(); ++i)
+            {
+                pops.insert(pops.end(), config[i],
+                            static_cast<std::int32_t>(i));
+            }
+        return pops;
+    }
+
+    bool
+    close(const double a, const double b)
+    {
+        return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(a));
+    }
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(test_FST, vmatrix_from_msprime)
+
+BOOST_AUTO_TEST_CASE(test_two_populations_match_deprecated_FST)
+{
+    std::vector<unsigned> config{ static_cast<unsigned>(m.nsam() / 3),
+                                  static_cast<unsigned>(
+                                      m.nsam() - m.nsam() / 3) };
+    auto d = Sequence::differentiation(m, contiguous_populations(config));
+    BOOST_REQUIRE_EQUAL(d.size(), 1);
+    auto sd = to_simdata(m);
+    Sequence::FST fst(&sd, 2, config.data());
+    BOOST_CHECK(close(d[0].piS, fst.piS()));
+    BOOST_CHECK(close(d[0].piB, fst.piB()));
+    BOOST_CHECK(close(d[0].piT, fst.piT()));
+    BOOST_CHECK(close(d[0].piD, fst.piD()));
+    BOOST_CHECK(close(d[0].hsm, fst.HSM()));
+    BOOST_CHECK(close(d[0].hsm, 1.0 - d[0].piS / d[0].piB));
+    BOOST_CHECK(close(d[0].slatkin, fst.Slatkin()));
+    BOOST_CHECK(close(d[0].hbk, fst.HBK()));
+    BOOST_CHECK_EQUAL(d[0].shared, fst.shared(0, 1).size());
+    BOOST_CHECK_EQUAL(d[0].fixed, fst.fixed(0, 1).size());
+    auto p = fst.Private(0, 1);
+    BOOST_CHECK_EQUAL(d[0].private1, p.first.size());
+    BOOST_CHECK_EQUAL(d[0].private2, p.second.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_all_pairs)
+{
+    const unsigned n = static_cast<unsigned>(m.nsam());
+    std::vector<unsigned> config{ n / 4, n / 4, n - 2 * (n / 4) };
+    auto pops = contiguous_populations(config);
+    auto d = Sequence::differentiation(m, pops);
+    BOOST_REQUIRE_EQUAL(d.size(), 3);
+    auto sd = to_simdata(m);
+    Sequence::FST fst(&sd, 3, config.data());
+    std::size_t k = 0;
+    for (unsigned i = 0; i < 2; ++i)
+        {
+            for (unsigned j = i + 1; j < 3; ++j, ++k)
+                {
+                    BOOST_CHECK_EQUAL(d[k].pop1, i);
+                    BOOST_CHECK_EQUAL(d[k].pop2, j);
+                    BOOST_CHECK_EQUAL(d[k].shared, fst.shared(i, j).size());
+                    BOOST_CHECK_EQUAL(d[k].fixed, fst.fixed(i, j).size());
+                    auto p = fst.Private(i, j);
+                    BOOST_CHECK_EQUAL(d[k].private1, p.first.size());
+                    BOOST_CHECK_EQUAL(d[k].private2, p.second.size());
+                    // Each pair is the same as using its samples alone
+                    auto two = pops;
+                    for (auto& x : two)
+                        {
+                            x = (x == static_cast<std::int32_t>(i))
+                                    ? 0
+                                    : (x == static_cast<std::int32_t>(j)
+                                           ? 1
+                                           : -1);
+                        }
+                    auto d2 = Sequence::differentiation(m, two);
+                    BOOST_CHECK_EQUAL(d2[0].pi1, d[k].pi1);
+                    BOOST_CHECK_EQUAL(d2[0].pi2, d[k].pi2);
+                    BOOST_CHECK_EQUAL(d2[0].piB, d[k].piB);
+                    BOOST_CHECK_EQUAL(d2[0].hsm, d[k].hsm);
+                }
+        }
+
+    // Per-population allele counts give the same result
+    std::vector<Sequence::AlleleCountMatrix> counts;
+    std::size_t first = 0;
+    for (auto c : config)
+        {
+            counts.emplace_back(Sequence::make_slice(
+                m, m.position(0), m.position(m.nsites() - 1), first,
+                first + c));
+            first += c;
+        }
+    auto dc = Sequence::differentiation(counts);
+    BOOST_REQUIRE_EQUAL(dc.size(), d.size());
+    for (std::size_t i = 0; i < d.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(dc[i].piB, d[i].piB);
+            BOOST_CHECK_EQUAL(dc[i].hbk, d[i].hbk);
+            BOOST_CHECK_EQUAL(dc[i].shared, d[i].shared);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_windowed_differentiation)
+{
+    const unsigned n = static_cast<unsigned>(m.nsam());
+    auto pops = contiguous_populations({ n / 2, n - n / 2 });
+    auto w = Sequence::windowed_differentiation(m, pops, 0.0, 1.0, 0.1,
+                                                0.05);
+    BOOST_REQUIRE_EQUAL(w.size(), 20);
+    for (auto& x : w)
+        {
+            auto win = Sequence::make_window(m, x.beg, x.end);
+            BOOST_REQUIRE_EQUAL(win.nsites(), x.nsites);
+            auto d = Sequence::differentiation(win, pops);
+            BOOST_REQUIRE_EQUAL(x.pairs.size(), 1);
+            BOOST_CHECK(close(x.pairs[0].pi1, d[0].pi1));
+            BOOST_CHECK(close(x.pairs[0].piB, d[0].piB));
+            BOOST_CHECK_EQUAL(x.pairs[0].shared, d[0].shared);
+            BOOST_CHECK_EQUAL(x.pairs[0].fixed, d[0].fixed);
+            BOOST_CHECK_EQUAL(x.pairs[0].private1, d[0].private1);
+            BOOST_CHECK_EQUAL(x.pairs[0].private2, d[0].private2);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_differentiation_bad_input)
+{
+    std::vector<std::int32_t> pops(m.nsam() - 1, 0);
+    BOOST_CHECK_THROW(Sequence::differentiation(m, pops),
+                      std::invalid_argument);
+    pops.push_back(1);
+    BOOST_CHECK_THROW(
+        Sequence::windowed_differentiation(m, pops, 0.0, 1.0, 0.1, 0.0),
+        std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,280 @@
+//! \file testFilteredCapsule.cc @brief unit tests for Sequence::FilteredGenotypeCapsule
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <numeric>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/FilteredCapsules.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/variant_matrix/filtering.hpp>
+#include <Sequence/StateCounts.hpp>
+#include <Sequence/summstats/classics.hpp>
+#include <Sequence/summstats/nsl.hpp>
+#include <Sequence/summstats/nSLiHS.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+namespace
+{
+    void
+    compare_matrices(const Sequence::VariantMatrix& a,
+                     const Sequence::VariantMatrix& b)
+    {
+        BOOST_REQUIRE_EQUAL(a.nsites(), b.nsites());
+        BOOST_REQUIRE_EQUAL(a.nsam(), b.nsam());
+        for (std::size_t i = 0; i < a.nsites(); ++i)
+            {
+                BOOST_REQUIRE_EQUAL(a.position(i), b.position(i));
+                for (std::size_t j = 0; j < a.nsam(); ++j)
+                    {
+                        BOOST_REQUIRE_EQUAL(a.get(i, j), b.get(i, j));
+                    }
+            }
+    }
+
+    bool
+    is_singleton(const Sequence::ConstRowView& r)
+    {
+        return std::count(r.begin(), r.end(), 1) == 1;
+    }
+
+    bool
+    odd_derived_count(const Sequence::ConstColView& c)
+    {
+        return std::count(c.begin(), c.end(), 1) % 2 == 1;
+    }
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(test_filtered_capsule, vmatrix_from_msprime)
+
+BOOST_AUTO_TEST_CASE(test_filtered_view_matches_filtering)
+{
+    auto copy = m.deepcopy();
+    Sequence::filter_sites(
+        copy, std::function<bool(const Sequence::RowView&)>(
+                  [](const Sequence::RowView& r) {
+                      return std::count(r.begin(), r.end(), 1) == 1;
+                  }));
+    auto view = Sequence::filter_sites_view(m, is_singleton);
+    BOOST_REQUIRE(dynamic_cast<const Sequence::FilteredGenotypeCapsule*>(
+        view.genotype_capsule()));
+    compare_matrices(view, copy);
+    BOOST_CHECK_EQUAL(view.max_allele(), m.max_allele());
+}
+
+BOOST_AUTO_TEST_CASE(test_chained_views)
+{
+    auto sites = Sequence::filter_sites_view(m, is_singleton);
+    auto both = Sequence::filter_haplotypes_view(sites, odd_derived_count);
+    auto other_order = Sequence::filter_sites_view(
+        Sequence::filter_haplotypes_view(m, odd_derived_count),
+        is_singleton);
+    BOOST_REQUIRE(both.nsam() < m.nsam());
+
+    // Chained views refer directly to the original data
+    auto f = dynamic_cast<const Sequence::FilteredGenotypeCapsule*>(
+        both.genotype_capsule());
+    BOOST_REQUIRE(f);
+    BOOST_CHECK(f->base().data == Sequence::get_ConstGenotypeSpan(m).data);
+
+    auto compact = Sequence::materialize(both);
+    BOOST_CHECK(!dynamic_cast<const Sequence::FilteredGenotypeCapsule*>(
+        compact.genotype_capsule()));
+    compare_matrices(compact, both);
+
+    // Removing haplotypes first changes which sites are singletons,
+    // so the order of filters matters, but each view must agree
+    // with its materialized copy.
+    compare_matrices(Sequence::materialize(other_order), other_order);
+}
+
+BOOST_AUTO_TEST_CASE(test_make_filtered_view)
+{
+    std::vector<std::size_t> sites{ 3, 1, 4, 1, 5 }, samples{ 9, 2, 6 };
+    const auto view = Sequence::make_filtered_view(m, sites, samples);
+    BOOST_REQUIRE_EQUAL(view.nsites(), sites.size());
+    BOOST_REQUIRE_EQUAL(view.nsam(), samples.size());
+    for (std::size_t i = 0; i < sites.size(); ++i)
+        {
+            BOOST_REQUIRE_EQUAL(view.position(i), m.position(sites[i]));
+            for (std::size_t j = 0; j < samples.size(); ++j)
+                {
+                    BOOST_REQUIRE_EQUAL(view.get(i, j),
+                                        m.get(sites[i], samples[j]));
+                }
+        }
+    // Indexes of a view of a view are relative to the view
+    const auto view2 = Sequence::make_filtered_view(view, { 4, 0 }, { 2 });
+    BOOST_CHECK_EQUAL(view2.get(0, 0), m.get(5, 6));
+    BOOST_CHECK_EQUAL(view2.get(1, 0), m.get(3, 6));
+
+    BOOST_CHECK_THROW(
+        Sequence::make_filtered_view(m, { m.nsites() }, samples),
+        std::out_of_range);
+    BOOST_CHECK_THROW(Sequence::make_filtered_view(view, sites, { 3 }),
+                      std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(test_views_are_read_only)
+{
+    auto view = Sequence::filter_sites_view(m, is_singleton);
+    BOOST_CHECK_THROW(view.get(0, 0) = 1, std::runtime_error);
+    BOOST_CHECK_THROW(view.data(), std::runtime_error);
+    const auto& cview = view;
+    BOOST_CHECK_EQUAL(cview.get(0, 0), view.cget(0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(test_index_runs)
+{
+    const std::vector<std::size_t> indexes{ 3, 4, 5, 9, 1, 2, 7 };
+    Sequence::IndexRuns runs(indexes);
+    BOOST_REQUIRE_EQUAL(runs.size(), indexes.size());
+    BOOST_REQUIRE_EQUAL(runs.nruns(), 4);
+    BOOST_CHECK(!runs.contiguous());
+    for (std::size_t i = 0; i < indexes.size(); ++i)
+        {
+            BOOST_REQUIRE_EQUAL(runs[i], indexes[i]);
+        }
+    BOOST_CHECK(runs.expand() == indexes);
+    BOOST_CHECK(Sequence::IndexRuns(6, 4).contiguous());
+    BOOST_CHECK_EQUAL(Sequence::IndexRuns(6, 4)[3], 9);
+    BOOST_CHECK(Sequence::IndexRuns().empty());
+
+    // Removing one haplotype from the middle leaves two runs
+    std::size_t removed = m.nsam() / 2;
+    auto view = Sequence::filter_haplotypes_view(
+        m, [&m = m, removed](const Sequence::ConstColView& c) {
+            return c.data == Sequence::get_ConstColView(m, removed).data;
+        });
+    auto f = dynamic_cast<const Sequence::FilteredGenotypeCapsule*>(
+        view.genotype_capsule());
+    BOOST_REQUIRE(f);
+    BOOST_REQUIRE_EQUAL(view.nsam(), m.nsam() - 1);
+    BOOST_CHECK_EQUAL(f->samples().nruns(), 2);
+    BOOST_CHECK_EQUAL(f->sites().nruns(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_site_views_use_parent_rows)
+{
+    std::vector<std::size_t> sites{ 7, 2, 5 }, all(m.nsam());
+    std::iota(all.begin(), all.end(), 0);
+    const auto view = Sequence::make_filtered_view(m, sites, all);
+    const auto span = Sequence::get_ConstGenotypeSpan(view);
+    for (std::size_t i = 0; i < sites.size(); ++i)
+        {
+            const auto parent = Sequence::get_ConstRowView(m, sites[i]).data;
+            BOOST_REQUIRE(Sequence::get_ConstRowView(view, i).data == parent);
+            BOOST_REQUIRE(span.row(i).data == parent);
+        }
+    // The kept sites are not contiguous, so there is no
+    // single block of the parent for a raw pointer.
+    BOOST_CHECK_THROW(view.cdata(), std::runtime_error);
+    compare_matrices(Sequence::materialize(view), view);
+
+    const auto singletons = Sequence::filter_sites_view(m, is_singleton);
+    Sequence::AlleleCountMatrix cv(singletons),
+        cc(Sequence::materialize(singletons));
+    BOOST_CHECK(cv.counts == cc.counts);
+}
+
+BOOST_AUTO_TEST_CASE(test_contiguous_views_use_parent_data)
+{
+    const auto block = Sequence::make_filtered_view(m, { 2, 3, 4 }, { 1, 2, 3 });
+    const auto span = Sequence::get_ConstGenotypeSpan(block);
+    BOOST_REQUIRE(span.data == &m.cget(2, 1));
+    BOOST_REQUIRE(span.row_starts == nullptr);
+    BOOST_REQUIRE_EQUAL(span.stride, m.nsam());
+    BOOST_REQUIRE(block.cdata() == span.data);
+    for (std::size_t j = 0; j < block.nsam(); ++j)
+        {
+            BOOST_REQUIRE(!Sequence::get_ConstColView(block, j).owner);
+        }
+    // The rows of the block are not adjacent in memory
+    BOOST_CHECK_THROW(block.genotype_capsule()->cbegin(), std::runtime_error);
+
+    std::vector<std::size_t> all(m.nsam());
+    std::iota(all.begin(), all.end(), 0);
+    const auto rows = Sequence::make_filtered_view(m, { 2, 3, 4 }, all);
+    auto g = rows.genotype_capsule();
+    BOOST_REQUIRE(g->cbegin() == &m.cget(2, 0));
+    BOOST_REQUIRE(std::equal(g->cbegin(), g->cend(),
+                             Sequence::materialize(rows).data()));
+}
+
+BOOST_AUTO_TEST_CASE(test_views_of_scattered_samples)
+{
+    const std::vector<std::size_t> sites{ 0, 1, 3, 6, 7, 9 },
+        samples{ 4, 2, 30, 31, 32, 11 };
+    const auto view = Sequence::make_filtered_view(m, sites, samples);
+    const auto compact = Sequence::materialize(view);
+    BOOST_CHECK_THROW(view.cdata(), std::runtime_error);
+
+    // Rows and columns are gathered into storage owned by the view
+    for (std::size_t i = 0; i < sites.size(); ++i)
+        {
+            auto r = Sequence::get_ConstRowView(view, i);
+            BOOST_REQUIRE(r.owner);
+            BOOST_REQUIRE(std::equal(
+                r.begin(), r.end(), Sequence::get_ConstRowView(compact, i).begin()));
+        }
+    for (std::size_t j = 0; j < samples.size(); ++j)
+        {
+            auto c = Sequence::get_ConstColView(view, j);
+            BOOST_REQUIRE(std::equal(
+                c.begin(), c.end(), Sequence::get_ConstColView(compact, j).begin()));
+        }
+    const auto span = Sequence::get_ConstGenotypeSpan(view);
+    for (std::size_t i = 0; i < sites.size(); ++i)
+        {
+            for (std::size_t j = 0; j < samples.size(); ++j)
+                {
+                    BOOST_REQUIRE_EQUAL(span(i, j), compact.cget(i, j));
+                }
+        }
+    Sequence::AlleleCountMatrix cv(view), cc(compact);
+    BOOST_CHECK(cv.counts == cc.counts);
+}
+
+BOOST_AUTO_TEST_CASE(test_statistics_without_some_haplotypes)
+{
+    // Statistics run directly on a view without some
+    // haplotypes, and on a view of scattered sites.
+    for (const auto& view :
+         { Sequence::filter_haplotypes_view(m, odd_derived_count),
+           Sequence::filter_haplotypes_view(
+               Sequence::filter_sites_view(m, is_singleton),
+               odd_derived_count) })
+        {
+            const auto compact = Sequence::materialize(view);
+            BOOST_REQUIRE(Sequence::difference_matrix(view)
+                          == Sequence::difference_matrix(compact));
+            BOOST_CHECK_EQUAL(Sequence::number_of_haplotypes(view),
+                              Sequence::number_of_haplotypes(compact));
+            BOOST_CHECK_EQUAL(Sequence::rmin(view), Sequence::rmin(compact));
+            const auto a = Sequence::nsl(view, 0), b = Sequence::nsl(compact, 0);
+            BOOST_REQUIRE_EQUAL(a.size(), b.size());
+            for (std::size_t i = 0; i < a.size(); ++i)
+                {
+                    BOOST_REQUIRE_EQUAL(a[i].core_count, b[i].core_count);
+                    if (!std::isnan(b[i].nsl))
+                        {
+                            BOOST_REQUIRE_EQUAL(a[i].nsl, b[i].nsl);
+                        }
+                }
+            for (std::size_t i = 0; i < view.nsites(); ++i)
+                {
+                    Sequence::StateCounts sv, sc;
+                    auto rv = Sequence::get_ConstRowView(view, i);
+                    auto rc = Sequence::get_ConstRowView(compact, i);
+                    sv(rv);
+                    sc(rc);
+                    BOOST_REQUIRE(sv.counts == sc.counts);
+                }
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
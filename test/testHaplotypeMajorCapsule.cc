@@ -0,0 +1,172 @@
+//! \file testHaplotypeMajorCapsule.cc @brief unit tests for Sequence::HaplotypeMajorGenotypeCapsule
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <stdexcept>
+#include <thread>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/HaplotypeMajorCapsules.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/summstats/classics.hpp>
+#include <Sequence/summstats/lhaf.hpp>
+#include <Sequence/summstats/nsl.hpp>
+#include <Sequence/summstats/nslx.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+namespace
+{
+    Sequence::VariantMatrix
+    add_missing_data(const Sequence::VariantMatrix& m)
+    {
+        std::vector<std::int8_t> data(m.data(),
+                                      m.data() + m.nsites() * m.nsam());
+        for (std::size_t i = 0; i < data.size(); i += 7)
+            {
+                data[i] = -1;
+            }
+        return Sequence::VariantMatrix(
+            std::move(data), std::vector<double>(m.pbegin(), m.pend()));
+    }
+
+    bool
+    same(const double a, const double b)
+    {
+        return a == b || (std::isnan(a) && std::isnan(b));
+    }
+
+    void
+    compare_nsl(const std::vector<Sequence::nSLiHS>& a,
+                const std::vector<Sequence::nSLiHS>& b)
+    {
+        BOOST_REQUIRE_EQUAL(a.size(), b.size());
+        for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                BOOST_REQUIRE(same(a[i].nsl, b[i].nsl));
+                BOOST_REQUIRE(same(a[i].ihs, b[i].ihs));
+                BOOST_REQUIRE_EQUAL(a[i].core_count, b[i].core_count);
+            }
+    }
+
+    void
+    compare_statistics(const Sequence::VariantMatrix& a,
+                       const Sequence::VariantMatrix& b)
+    {
+        BOOST_REQUIRE(Sequence::difference_matrix(a)
+                      == Sequence::difference_matrix(b));
+        BOOST_REQUIRE(Sequence::is_different_matrix(a)
+                      == Sequence::is_different_matrix(b));
+        BOOST_REQUIRE(Sequence::label_haplotypes(a)
+                      == Sequence::label_haplotypes(b));
+        BOOST_REQUIRE(Sequence::lhaf(a, 0, 2.0) == Sequence::lhaf(b, 0, 2.0));
+        compare_nsl(Sequence::nsl(a, 0), Sequence::nsl(b, 0));
+        compare_nsl(Sequence::nslx(a, 0, 3), Sequence::nslx(b, 0, 3));
+        for (std::size_t core = 0; core < a.nsites(); core += 10)
+            {
+                compare_nsl({ Sequence::nsl(a, core, 0) },
+                            { Sequence::nsl(b, core, 0) });
+            }
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_transpose)
+
+BOOST_AUTO_TEST_CASE(test_transpose_genotypes)
+{
+    for (auto dims : { std::make_pair(1, 1), std::make_pair(16, 16),
+                       std::make_pair(17, 33), std::make_pair(64, 64),
+                       std::make_pair(100, 250), std::make_pair(250, 3) })
+        {
+            const std::size_t nrow = static_cast<std::size_t>(dims.first),
+                              ncol = static_cast<std::size_t>(dims.second),
+                              stride = ncol + 5;
+            std::vector<std::int8_t> input(nrow * stride);
+            for (std::size_t i = 0; i < input.size(); ++i)
+                {
+                    input[i] = static_cast<std::int8_t>(i * 31 % 251);
+                }
+            std::vector<std::int8_t> output(nrow * ncol);
+            Sequence::transpose_genotypes(input.data(), nrow, ncol, stride,
+                                          output.data());
+            for (std::size_t i = 0; i < nrow; ++i)
+                {
+                    for (std::size_t j = 0; j < ncol; ++j)
+                        {
+                            BOOST_REQUIRE_EQUAL(output[j * nrow + i],
+                                                input[i * stride + j]);
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(test_haplotype_major_capsule, vmatrix_from_msprime)
+
+BOOST_AUTO_TEST_CASE(test_element_access)
+{
+    const auto h = Sequence::make_haplotype_major(m);
+    BOOST_REQUIRE_EQUAL(h.nsites(), m.nsites());
+    BOOST_REQUIRE_EQUAL(h.nsam(), m.nsam());
+    BOOST_REQUIRE_EQUAL(h.max_allele(), m.max_allele());
+    auto capsule = dynamic_cast<const Sequence::HaplotypeMajorGenotypeCapsule*>(
+        h.genotype_capsule());
+    BOOST_REQUIRE(capsule);
+    for (std::size_t i = 0; i < m.nsites(); ++i)
+        {
+            for (std::size_t j = 0; j < m.nsam(); ++j)
+                {
+                    BOOST_REQUIRE_EQUAL(h.get(i, j), m.get(i, j));
+                    BOOST_REQUIRE_EQUAL(capsule->haplotype(j)[i], m.get(i, j));
+                }
+        }
+    // The site-major copy is the original data
+    BOOST_REQUIRE(std::equal(h.data(), h.data() + h.nsites() * h.nsam(),
+                             m.data()));
+    Sequence::AlleleCountMatrix ch(h);
+    BOOST_CHECK(ch.counts == c.counts);
+}
+
+BOOST_AUTO_TEST_CASE(test_read_only)
+{
+    auto h = Sequence::make_haplotype_major(m);
+    BOOST_CHECK_THROW(h.get(0, 0) = 1, std::runtime_error);
+    BOOST_CHECK_THROW(h.data(), std::runtime_error);
+    auto copy = h.deepcopy();
+    BOOST_CHECK(dynamic_cast<const Sequence::HaplotypeMajorGenotypeCapsule*>(
+        copy.genotype_capsule()));
+}
+
+BOOST_AUTO_TEST_CASE(test_haplotype_statistics)
+{
+    compare_statistics(m, Sequence::make_haplotype_major(m));
+    auto missing = add_missing_data(m);
+    compare_statistics(missing, Sequence::make_haplotype_major(missing));
+}
+
+BOOST_AUTO_TEST_CASE(test_concurrent_transpose)
+{
+    // Const access from several threads transposes the data once
+    const auto h = Sequence::make_haplotype_major(m);
+    std::vector<const std::int8_t*> pointers(4, nullptr);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < pointers.size(); ++i)
+        {
+            threads.emplace_back(
+                [&h, &pointers, i]() { pointers[i] = h.cdata(); });
+        }
+    for (auto& t : threads)
+        {
+            t.join();
+        }
+    for (auto p : pointers)
+        {
+            BOOST_REQUIRE(p == pointers[0]);
+        }
+    BOOST_REQUIRE(std::equal(pointers[0],
+                             pointers[0] + m.nsites() * m.nsam(), m.data()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
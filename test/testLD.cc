@@ -2,14 +2,186 @@
 
 #include <cmath>
 #include <algorithm>
+#include <iterator>
+#include <limits>
+#include <numeric>
 #include <vector>
 #include <iostream>
 #include <Sequence/VariantMatrix.hpp>
 #include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/BitPackedCapsules.hpp>
 #include <Sequence/summstats/ld.hpp>
+#include <Sequence/summstats/classics.hpp>
 #include <boost/test/unit_test.hpp>
 #include "msprime_data_fixture.hpp"
 
+namespace
+{
+    std::int8_t
+    minor_allele(const Sequence::VariantMatrix& m, const std::size_t site,
+                 unsigned& nstates)
+    {
+        std::vector<int> counts(128, 0);
+        auto r = Sequence::get_ConstRowView(m, site);
+        for (auto x : r)
+            {
+                if (x >= 0)
+                    {
+                        counts[static_cast<std::size_t>(x)]++;
+                    }
+            }
+        nstates = 0;
+        std::int8_t rv = -1;
+        int minor_count = 0;
+        for (std::size_t s = 0; s < counts.size(); ++s)
+            {
+                if (counts[s])
+                    {
+                        ++nstates;
+                        if (rv < 0 || counts[s] < minor_count)
+                            {
+                                rv = static_cast<std::int8_t>(s);
+                                minor_count = counts[s];
+                            }
+                    }
+            }
+        return rv;
+    }
+
+    bool
+    manual_ld(const Sequence::VariantMatrix& m, const std::size_t i,
+              const std::size_t j, Sequence::TwoLocusLD& ld)
+    // Returns false unless both sites are bi-allelic
+    {
+        unsigned si, sj;
+        auto ai = minor_allele(m, i, si), aj = minor_allele(m, j, sj);
+        if (si != 2 || sj != 2)
+            {
+                return false;
+            }
+        auto ri = Sequence::get_ConstRowView(m, i);
+        auto rj = Sequence::get_ConstRowView(m, j);
+        double n = 0, ni = 0, nj = 0, n11 = 0;
+        for (std::size_t k = 0; k < ri.size(); ++k)
+            {
+                if (ri[k] >= 0 && rj[k] >= 0)
+                    {
+                        ++n;
+                        ni += (ri[k] == ai);
+                        nj += (rj[k] == aj);
+                        n11 += (ri[k] == ai && rj[k] == aj);
+                    }
+            }
+        double p1 = ni / n, q1 = nj / n, p0 = 1. - p1, q0 = 1. - q1;
+        ld.i = i;
+        ld.j = j;
+        ld.D = n11 / n - p1 * q1;
+        ld.rsq = ld.D * ld.D / (p0 * p1 * q0 * q1);
+        ld.Dprime = (ld.D < 0) ? -ld.D / std::max(-p0 * q0, -p1 * q1)
+                               : ld.D / std::min(p1 * q0, p0 * q1);
+        if (ni == 0 || ni == n || nj == 0 || nj == n)
+            {
+                ld.rsq = ld.Dprime = std::numeric_limits<double>::quiet_NaN();
+            }
+        return true;
+    }
+
+    std::vector<Sequence::TwoLocusLD>
+    manual_pairwise_ld(const Sequence::VariantMatrix& m)
+    {
+        std::vector<Sequence::TwoLocusLD> rv;
+        for (std::size_t i = 0; i + 1 < m.nsites(); ++i)
+            {
+                for (std::size_t j = i + 1; j < m.nsites(); ++j)
+                    {
+                        Sequence::TwoLocusLD ld;
+                        if (manual_ld(m, i, j, ld) && !std::isnan(ld.rsq))
+                            {
+                                rv.push_back(ld);
+                            }
+                    }
+            }
+        return rv;
+    }
+
+    void
+    compare_ld(const std::vector<Sequence::TwoLocusLD>& a,
+               const std::vector<Sequence::TwoLocusLD>& b)
+    {
+        BOOST_REQUIRE_EQUAL(a.size(), b.size());
+        for (std::size_t k = 0; k < a.size(); ++k)
+            {
+                BOOST_REQUIRE_EQUAL(a[k].i, b[k].i);
+                BOOST_REQUIRE_EQUAL(a[k].j, b[k].j);
+                BOOST_REQUIRE_CLOSE(a[k].rsq, b[k].rsq, 1e-8);
+                BOOST_REQUIRE_SMALL(a[k].D - b[k].D, 1e-12);
+                BOOST_REQUIRE_SMALL(a[k].Dprime - b[k].Dprime, 1e-10);
+            }
+    }
+
+    Sequence::VariantMatrix
+    with_missing_data(const Sequence::VariantMatrix& m)
+    // Also makes site 3 tri-allelic
+    {
+        std::vector<std::int8_t> temp(m.data(),
+                                      m.data() + m.nsites() * m.nsam());
+        temp[3 * m.nsam() + 1] = 2;
+        std::vector<double> tpos(m.pbegin(), m.pend());
+        Sequence::VariantMatrix rv(std::move(temp), std::move(tpos));
+        for (std::size_t i = 0; i < rv.nsam(); i += 7)
+            {
+                for (std::size_t site = i; site < rv.nsites(); site += 3)
+                    {
+                        rv.get(site, i) = -1;
+                    }
+            }
+        return rv;
+    }
+
+    std::int32_t
+    manual_rmin(const Sequence::VariantMatrix& m)
+    {
+        std::vector<std::size_t> biallelic;
+        for (std::size_t i = 0; i < m.nsites(); ++i)
+            {
+                unsigned nstates;
+                minor_allele(m, i, nstates);
+                if (nstates == 2)
+                    {
+                        biallelic.push_back(i);
+                    }
+            }
+        std::size_t x = 0;
+        std::int32_t rv = 0;
+        for (std::size_t a = 1; a < biallelic.size(); ++a)
+            {
+                for (std::size_t b = x; b < a; ++b)
+                    {
+                        auto ra = Sequence::get_ConstRowView(m, biallelic[a]);
+                        auto rb = Sequence::get_ConstRowView(m, biallelic[b]);
+                        std::vector<std::pair<std::int8_t, std::int8_t>> haps;
+                        for (std::size_t k = 0; k < ra.size(); ++k)
+                            {
+                                if (ra[k] >= 0 && rb[k] >= 0)
+                                    {
+                                        haps.emplace_back(ra[k], rb[k]);
+                                    }
+                            }
+                        std::sort(haps.begin(), haps.end());
+                        if (std::unique(haps.begin(), haps.end())
+                                - haps.begin()
+                            == 4)
+                            {
+                                ++rv;
+                                x = a;
+                                break;
+                            }
+                    }
+            }
+        return rv;
+    }
+} // namespace
+
 BOOST_FIXTURE_TEST_SUITE(test_LD, vmatrix_from_msprime)
 
 BOOST_AUTO_TEST_CASE(test_two_locus_haplotype_counts)
@@ -38,4 +210,110 @@ BOOST_AUTO_TEST_CASE(test_two_locus_haplotype_counts)
         }
 }
 
+BOOST_AUTO_TEST_CASE(test_pairwise_ld)
+{
+    compare_ld(Sequence::pairwise_ld(m), manual_pairwise_ld(m));
+}
+
+BOOST_AUTO_TEST_CASE(test_pairwise_ld_missing_data)
+{
+    auto m2 = with_missing_data(m);
+    auto rv = Sequence::pairwise_ld(m2);
+    // The site with three states is skipped
+    BOOST_REQUIRE(std::none_of(
+        rv.begin(), rv.end(),
+        [](const Sequence::TwoLocusLD& ld) { return ld.i == 3 || ld.j == 3; }));
+    compare_ld(rv, manual_pairwise_ld(m2));
+    // Without the tri-allelic site, bit-packed data give the same result
+    m2.get(3, 1) = 0;
+    auto m3 = Sequence::make_bitpacked(m2);
+    compare_ld(Sequence::pairwise_ld(m3), manual_pairwise_ld(m2));
+}
+
+BOOST_AUTO_TEST_CASE(test_pairwise_ld_band_and_threshold)
+{
+    const double max_distance = 0.05, min_rsq = 0.2;
+    auto all = Sequence::pairwise_ld(m);
+    decltype(all) expected;
+    std::copy_if(all.begin(), all.end(), std::back_inserter(expected),
+                 [this, max_distance,
+                  min_rsq](const Sequence::TwoLocusLD& ld) {
+                     return m.position(ld.j)
+                                <= m.position(ld.i) + max_distance
+                            && ld.rsq >= min_rsq;
+                 });
+    BOOST_REQUIRE(!expected.empty());
+    for (unsigned nthreads = 1; nthreads < 5; ++nthreads)
+        {
+            compare_ld(
+                Sequence::pairwise_ld(m, max_distance, min_rsq, nthreads),
+                expected);
+        }
+    BOOST_REQUIRE_THROW(Sequence::pairwise_ld(m, -1.0),
+                        std::invalid_argument);
+    BOOST_REQUIRE_THROW(Sequence::pairwise_ld(m, 1.0, 0.0, 0),
+                        std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_ld_matrix)
+{
+    auto m2 = with_missing_data(m);
+    auto rsq = Sequence::ld_matrix(m2, Sequence::LDStatistic::rsq, 3);
+    auto D = Sequence::ld_matrix(m2, Sequence::LDStatistic::D);
+    auto Dprime = Sequence::ld_matrix(m2, Sequence::LDStatistic::Dprime);
+    BOOST_REQUIRE_EQUAL(rsq.size(), m2.nsites() * m2.nsites());
+    for (std::size_t i = 0; i < m2.nsites(); ++i)
+        {
+            for (std::size_t j = i; j < m2.nsites(); ++j)
+                {
+                    auto ij = i * m2.nsites() + j, ji = j * m2.nsites() + i;
+                    Sequence::TwoLocusLD ld;
+                    if (!manual_ld(m2, i, j, ld))
+                        {
+                            BOOST_REQUIRE(std::isnan(rsq[ij]));
+                            BOOST_REQUIRE(std::isnan(D[ij]));
+                            BOOST_REQUIRE(std::isnan(Dprime[ij]));
+                            continue;
+                        }
+                    BOOST_REQUIRE_EQUAL(std::isnan(rsq[ij]),
+                                        std::isnan(ld.rsq));
+                    if (!std::isnan(ld.rsq))
+                        {
+                            BOOST_REQUIRE_CLOSE(rsq[ij], ld.rsq, 1e-8);
+                            BOOST_REQUIRE_SMALL(Dprime[ij] - ld.Dprime,
+                                                1e-10);
+                        }
+                    BOOST_REQUIRE_SMALL(D[ij] - ld.D, 1e-12);
+                    BOOST_REQUIRE(std::isnan(rsq[ij]) ? std::isnan(rsq[ji])
+                                                      : rsq[ij] == rsq[ji]);
+                    BOOST_REQUIRE_EQUAL(D[ij], D[ji]);
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_rmin)
+{
+    // These data have no pairs of sites with four gametes
+    BOOST_REQUIRE_EQUAL(Sequence::rmin(m), 0);
+    BOOST_REQUIRE_EQUAL(Sequence::rmin(m), manual_rmin(m));
+    // Arbitrary data, with missing values and some tri-allelic sites
+    const std::size_t nsam = 20, nsites = 50;
+    std::vector<std::int8_t> data(nsam * nsites);
+    for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            auto x = (i * 2654435761u) >> 7;
+            data[i] = static_cast<std::int8_t>((x % 41 == 0) ? -1 : x % 2);
+            if (i % 331 == 0)
+                {
+                    data[i] = 2;
+                }
+        }
+    std::vector<double> pos(nsites);
+    std::iota(pos.begin(), pos.end(), 0.0);
+    Sequence::VariantMatrix m2(std::move(data), std::move(pos));
+    auto rm = Sequence::rmin(m2);
+    BOOST_REQUIRE(rm > 0);
+    BOOST_REQUIRE_EQUAL(rm, manual_rmin(m2));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,49 @@
+//! \file testMarginalTreeStats.cc @brief unit tests for cached statistics of marginal trees
+
+#include <cstdint>
+#include <Sequence/Coalescent/TreeOperations.hpp>
+#include <boost/test/unit_test.hpp>
+#include "coalescent_test_data.hpp"
+
+using namespace coalescent_test_data;
+
+BOOST_AUTO_TEST_SUITE(test_marginal_tree_stats)
+
+BOOST_AUTO_TEST_CASE(test_marginal_tree_stats)
+{
+    Sequence::coalsim::rng_streams rng(seed, 0);
+    Sequence::coalsim::marginal_tree_stats stats;
+    for (std::uint64_t r = 0; r < 10; ++r)
+        {
+            rng.reseed(seed, r);
+            const auto history = simulate_history(rng);
+            for (auto& m : history)
+                {
+                    // The cached values are updated from the previous tree
+                    stats.update(m);
+                    const double t
+                        = Sequence::coalsim::total_time(m.begin(), nsam);
+                    BOOST_REQUIRE(close(stats.total_time(), t));
+                    for (int branch = 0; branch < 2 * nsam - 2; ++branch)
+                        {
+                            for (int ind = 0; ind < nsam; ++ind)
+                                {
+                                    BOOST_REQUIRE_EQUAL(
+                                        stats.is_descendant(ind, branch),
+                                        Sequence::coalsim::is_descendant(
+                                            m.begin(), ind, branch));
+                                }
+                        }
+                    for (int i = 0; i < 10; ++i)
+                        {
+                            const double rtime = rng.uni(0., t);
+                            BOOST_REQUIRE_EQUAL(
+                                stats.pick_branch(rtime),
+                                Sequence::coalsim::pick_branch(m.begin(),
+                                                               nsam, rtime));
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,124 @@
+//! \file testMmapFormat.cc @brief unit tests for memory-mapped VariantMatrix files
+
+#include <cstdio>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/variant_matrix/mmap.hpp>
+#include <Sequence/variant_matrix/windows.hpp>
+#include <Sequence/summstats/classics.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+namespace
+{
+    bool
+    same_data(const Sequence::VariantMatrix& a,
+              const Sequence::VariantMatrix& b)
+    // operator== assumes contiguous data, which windows are not
+    {
+        if (a.nsites() != b.nsites() || a.nsam() != b.nsam()
+            || !std::equal(a.cpbegin(), a.cpend(), b.cpbegin()))
+            {
+                return false;
+            }
+        for (std::size_t i = 0; i < a.nsites(); ++i)
+            {
+                auto ra = Sequence::get_ConstRowView(a, i);
+                auto rb = Sequence::get_ConstRowView(b, i);
+                if (!std::equal(ra.begin(), ra.end(), rb.begin()))
+                    {
+                        return false;
+                    }
+            }
+        return true;
+    }
+} // namespace
+
+struct mmap_file_fixture : public vmatrix_from_msprime
+{
+    const std::string filename;
+    mmap_file_fixture() : vmatrix_from_msprime(), filename("mmap_test.vm")
+    {
+        Sequence::to_mmap_format(m, filename);
+    }
+    ~mmap_file_fixture() { std::remove(filename.c_str()); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(test_mmap_format, mmap_file_fixture)
+
+BOOST_AUTO_TEST_CASE(test_round_trip)
+{
+    auto mm = Sequence::from_mmap_format(filename);
+    BOOST_REQUIRE(mm == m);
+    BOOST_REQUIRE_EQUAL(mm.resizable(), false);
+    BOOST_REQUIRE_THROW(mm.get(0, 0) = 1, std::runtime_error);
+    BOOST_REQUIRE_EQUAL(mm.cget(1, 2), m.get(1, 2));
+    BOOST_REQUIRE_EQUAL(mm.cposition(3), m.position(3));
+}
+
+BOOST_AUTO_TEST_CASE(test_summstats)
+{
+    auto mm = Sequence::from_mmap_format(filename);
+    Sequence::AlleleCountMatrix ac(mm);
+    BOOST_REQUIRE(ac.counts == c.counts);
+    BOOST_REQUIRE_EQUAL(Sequence::thetapi(ac), Sequence::thetapi(c));
+}
+
+BOOST_AUTO_TEST_CASE(test_windows)
+{
+    auto mm = Sequence::from_mmap_format(filename);
+    auto w = Sequence::make_window(mm, 0.2, 0.4);
+    auto w2 = Sequence::make_window(m, 0.2, 0.4);
+    BOOST_REQUIRE(same_data(w, w2));
+    // The window refers directly to the mapped data
+    BOOST_REQUIRE(get_ConstRowView(w, 0).data
+                  == get_ConstRowView(mm, static_cast<std::size_t>(
+                                              w.cpbegin() - mm.cpbegin()))
+                         .data);
+}
+
+BOOST_AUTO_TEST_CASE(test_window_round_trip)
+{
+    auto w = Sequence::make_slice(m, 0.2, 0.4, 3, 17);
+    Sequence::to_mmap_format(w, filename);
+    auto mm = Sequence::from_mmap_format(filename);
+    BOOST_REQUIRE(same_data(mm, w));
+    BOOST_REQUIRE_EQUAL(mm.nsam(), 14u);
+}
+
+BOOST_AUTO_TEST_CASE(test_bad_input)
+{
+    {
+        std::ofstream out(filename, std::ios::trunc);
+        out << "this is not a VariantMatrix in binary format\n";
+    }
+    BOOST_REQUIRE_THROW(Sequence::from_mmap_format(filename),
+                        std::runtime_error);
+    BOOST_REQUIRE_THROW(Sequence::from_mmap_format("no_such_file.vm"),
+                        std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_overflowing_header)
+{
+    // nsites * nsam wraps to 0, so that the file size would
+    // match a header that claims 2^64 genotypes
+    {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        const std::uint64_t nsites = 2, nsam = std::uint64_t(1) << 63;
+        const char magic[8] = { 'L', 'S', 'E', 'Q', 'V', 'M', '0', '1' };
+        const char zeros[8 + 2 * sizeof(double)] = {};
+        out.write(magic, sizeof(magic));
+        out.write(reinterpret_cast<const char*>(&nsites), sizeof(nsites));
+        out.write(reinterpret_cast<const char*>(&nsam), sizeof(nsam));
+        out.write(zeros, sizeof(zeros));
+    }
+    BOOST_REQUIRE_THROW(Sequence::from_mmap_format(filename),
+                        std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,240 @@
+//! \file testNSL.cc @brief unit tests for nSL and nSLx
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/summstats/nsl.hpp>
+#include <Sequence/summstats/nslx.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+namespace
+{
+    bool
+    same_value(const double a, const double b)
+    {
+        return (std::isnan(a) && std::isnan(b)) || a == b;
+    }
+
+    bool
+    same_results(const std::vector<Sequence::nSLiHS>& a,
+                 const std::vector<Sequence::nSLiHS>& b)
+    {
+        if (a.size() != b.size())
+            {
+                return false;
+            }
+        for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                if (!same_value(a[i].nsl, b[i].nsl)
+                    || !same_value(a[i].ihs, b[i].ihs)
+                    || a[i].core_count != b[i].core_count)
+                    {
+                        return false;
+                    }
+            }
+        return true;
+    }
+
+    std::vector<Sequence::nSLiHS>
+    pairwise_nsl(const Sequence::VariantMatrix& m, const std::int8_t refstate,
+                 const std::vector<bool>& breaks)
+    // Direct calculation from the definition: suffix lengths of
+    // pairs sharing the core allele end at the nearest break sites
+    // at which the pair differ.
+    {
+        std::vector<Sequence::nSLiHS> rv;
+        const auto n = static_cast<std::int64_t>(m.nsites());
+        for (std::int64_t core = 0; core < n; ++core)
+            {
+                double nsl_values[2] = { 0, 0 }, ihs_values[2] = { 0, 0 };
+                int counts[2] = { 0, 0 };
+                auto differ = [&m](std::size_t i, std::size_t j,
+                                   std::int64_t site) {
+                    auto a = m.cget(static_cast<std::size_t>(site), i);
+                    auto b = m.cget(static_cast<std::size_t>(site), j);
+                    return a != b && a >= 0 && b >= 0;
+                };
+                auto core_view = Sequence::get_ConstRowView(
+                    m, static_cast<std::size_t>(core));
+                for (std::size_t i = 0; i < m.nsam(); ++i)
+                    {
+                        for (std::size_t j = i + 1; j < m.nsam(); ++j)
+                            {
+                                if (core_view[i] != core_view[j]
+                                    || core_view[i] < 0)
+                                    {
+                                        continue;
+                                    }
+                                auto left = core - 1;
+                                while (left >= 0
+                                       && !(breaks[static_cast<std::size_t>(
+                                                left)]
+                                            && differ(i, j, left)))
+                                    {
+                                        --left;
+                                    }
+                                auto right = core + 1;
+                                while (right < n
+                                       && !(breaks[static_cast<std::size_t>(
+                                                right)]
+                                            && differ(i, j, right)))
+                                    {
+                                        ++right;
+                                    }
+                                if (left >= 0 && right < n)
+                                    {
+                                        auto r = static_cast<std::size_t>(
+                                            core_view[i] == refstate);
+                                        nsl_values[r] += static_cast<double>(
+                                            right - left);
+                                        ihs_values[r]
+                                            += m.cposition(
+                                                   static_cast<std::size_t>(
+                                                       right))
+                                               - m.cposition(
+                                                     static_cast<std::size_t>(
+                                                         left));
+                                        ++counts[r];
+                                    }
+                            }
+                    }
+                auto nonref = std::count_if(
+                    core_view.begin(), core_view.end(),
+                    [refstate](const std::int8_t a) {
+                        return a >= 0 && a != refstate;
+                    });
+                rv.push_back(Sequence::nSLiHS{
+                    std::log(nsl_values[1] / counts[1])
+                        - std::log(nsl_values[0] / counts[0]),
+                    std::log(ihs_values[1] / counts[1])
+                        - std::log(ihs_values[0] / counts[0]),
+                    static_cast<std::int32_t>(nonref) });
+            }
+        return rv;
+    }
+
+    void
+    check_close(const std::vector<Sequence::nSLiHS>& a,
+                const std::vector<Sequence::nSLiHS>& b)
+    {
+        BOOST_REQUIRE_EQUAL(a.size(), b.size());
+        for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                BOOST_REQUIRE_EQUAL(std::isnan(a[i].nsl), std::isnan(b[i].nsl));
+                BOOST_REQUIRE_EQUAL(std::isnan(a[i].ihs), std::isnan(b[i].ihs));
+                if (std::isfinite(a[i].nsl))
+                    {
+                        BOOST_REQUIRE_SMALL(a[i].nsl - b[i].nsl, 1e-8);
+                    }
+                if (std::isfinite(a[i].ihs))
+                    {
+                        BOOST_REQUIRE_SMALL(a[i].ihs - b[i].ihs, 1e-8);
+                    }
+                BOOST_REQUIRE_EQUAL(a[i].core_count, b[i].core_count);
+            }
+    }
+
+    std::vector<bool>
+    xton_breaks(const Sequence::VariantMatrix& m, const std::int8_t refstate,
+                const int x)
+    {
+        std::vector<bool> breaks;
+        for (std::size_t i = 0; i < m.nsites(); ++i)
+            {
+                auto r = Sequence::get_ConstRowView(m, i);
+                auto nonref = std::count_if(
+                    r.begin(), r.end(), [refstate](const std::int8_t a) {
+                        return a != refstate && a >= 0;
+                    });
+                breaks.push_back(nonref > 0 && nonref <= x);
+            }
+        return breaks;
+    }
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(test_nsl, vmatrix_from_msprime)
+
+BOOST_AUTO_TEST_CASE(test_nsl_parallel)
+{
+    auto serial = Sequence::nsl(m, 0);
+    BOOST_REQUIRE_EQUAL(serial.size(), m.nsites());
+    for (unsigned nthreads : { 1u, 2u, 3u, 8u })
+        {
+            BOOST_REQUIRE(
+                same_results(serial, Sequence::nsl_parallel(m, 0, nthreads)));
+        }
+    BOOST_REQUIRE_THROW(Sequence::nsl_parallel(m, 0, 0),
+                        std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_nsl_core)
+{
+    auto all = Sequence::nsl(m, 0);
+    for (std::size_t core : { std::size_t(0), m.nsites() / 2 })
+        {
+            check_close({ all[core] }, { Sequence::nsl(m, core, 0) });
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_nsl_pairwise)
+{
+    check_close(Sequence::nsl(m, 0),
+                pairwise_nsl(m, 0, std::vector<bool>(m.nsites(), true)));
+}
+
+BOOST_AUTO_TEST_CASE(test_nslx_pairwise)
+{
+    for (int x : { 1, 2, 5 })
+        {
+            check_close(Sequence::nslx(m, 0, x),
+                        pairwise_nsl(m, 0, xton_breaks(m, 0, x)));
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_nsl_missing_data)
+{
+    // Missing data use the pairwise calculation
+    auto mm = vmatrix_from_msprime::read();
+    mm.get(3, 7) = -1;
+    mm.get(200, 12) = -1;
+    check_close(Sequence::nsl(mm, 0),
+                pairwise_nsl(mm, 0, std::vector<bool>(mm.nsites(), true)));
+    BOOST_REQUIRE(same_results(Sequence::nsl(mm, 0),
+                               Sequence::nsl_parallel(mm, 0, 3)));
+    check_close(Sequence::nslx(mm, 0, 2),
+                pairwise_nsl(mm, 0, xton_breaks(mm, 0, 2)));
+}
+
+BOOST_AUTO_TEST_CASE(test_nsl_stale_max_allele)
+{
+    // A genotype above max_allele, written after construction,
+    // must not be used to index the tables of the PBWT sweep.
+    auto mm = vmatrix_from_msprime::read();
+    BOOST_REQUIRE_EQUAL(mm.max_allele(), 1);
+    mm.get(3, 7) = 2;
+    mm.get(100, 0) = 3;
+    BOOST_REQUIRE_EQUAL(mm.max_allele(), 1);
+    check_close(Sequence::nsl(mm, 0),
+                pairwise_nsl(mm, 0, std::vector<bool>(mm.nsites(), true)));
+    BOOST_REQUIRE(same_results(Sequence::nsl(mm, 0),
+                               Sequence::nsl_parallel(mm, 0, 3)));
+    check_close(Sequence::nslx(mm, 0, 2),
+                pairwise_nsl(mm, 0, xton_breaks(mm, 0, 2)));
+}
+
+BOOST_AUTO_TEST_CASE(test_nslx_parallel)
+{
+    for (int x : { 1, 3 })
+        {
+            auto serial = Sequence::nslx(m, 0, x);
+            for (unsigned nthreads : { 1u, 2u, 5u })
+                {
+                    BOOST_REQUIRE(same_results(
+                        serial, Sequence::nslx_parallel(m, 0, x, nthreads)));
+                }
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
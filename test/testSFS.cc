@@ -0,0 +1,209 @@
+//! \file testSFS.cc @brief unit tests for Sequence/summstats/sfs.hpp
+
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/variant_matrix/windows.hpp>
+#include <Sequence/summstats/classics.hpp>
+#include <Sequence/summstats/sfs.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+namespace
+{
+    bool
+    close(const double a, const double b)
+    {
+        return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(a));
+    }
+
+    double
+    sum(const std::vector<double>& x)
+    {
+        return std::accumulate(x.begin(), x.end(), 0.0);
+    }
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(test_SFS, vmatrix_from_msprime)
+
+BOOST_AUTO_TEST_CASE(test_unfolded_sfs_estimators)
+{
+    auto sfs = Sequence::unfolded_sfs(c, 0);
+    BOOST_REQUIRE_EQUAL(sfs.nsam, c.nsam);
+    BOOST_REQUIRE_EQUAL(sfs.counts.size(), c.nsam + 1);
+    BOOST_CHECK(!sfs.folded);
+    BOOST_CHECK_EQUAL(sum(sfs.counts), static_cast<double>(c.nrow));
+    BOOST_CHECK(close(Sequence::thetapi(sfs), Sequence::thetapi(c)));
+    BOOST_CHECK(close(Sequence::thetaw(sfs), Sequence::thetaw(c)));
+    BOOST_CHECK(close(Sequence::tajd(sfs), Sequence::tajd(c)));
+    BOOST_CHECK(close(Sequence::thetah(sfs), Sequence::thetah(c, 0)));
+    BOOST_CHECK(close(Sequence::thetal(sfs), Sequence::thetal(c, 0)));
+    BOOST_CHECK(close(Sequence::faywuh(sfs), Sequence::faywuh(c, 0)));
+    auto e = Sequence::zenge(sfs);
+    BOOST_CHECK(std::isfinite(e));
+    BOOST_CHECK_EQUAL(e > 0.0,
+                      Sequence::thetal(sfs) > Sequence::thetaw(sfs));
+
+    std::vector<std::int8_t> refstates(c.nrow, 0);
+    auto sfs2 = Sequence::unfolded_sfs(c, refstates);
+    BOOST_CHECK(sfs2.counts == sfs.counts);
+    refstates[0] = -1;
+    sfs2 = Sequence::unfolded_sfs(c, refstates);
+    BOOST_CHECK_EQUAL(sum(sfs2.counts), static_cast<double>(c.nrow - 1));
+}
+
+BOOST_AUTO_TEST_CASE(test_folded_sfs)
+{
+    auto folded = Sequence::folded_sfs(c);
+    BOOST_REQUIRE(folded.folded);
+    BOOST_REQUIRE_EQUAL(folded.counts.size(), c.nsam / 2 + 1);
+    auto f2 = Sequence::fold(Sequence::unfolded_sfs(c, 0));
+    for (std::size_t i = 0; i < folded.counts.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(folded.counts[i], f2.counts[i]);
+        }
+    BOOST_CHECK(close(Sequence::thetapi(folded), Sequence::thetapi(c)));
+    BOOST_CHECK(close(Sequence::thetaw(folded), Sequence::thetaw(c)));
+    BOOST_CHECK(close(Sequence::tajd(folded), Sequence::tajd(c)));
+    BOOST_CHECK_THROW(Sequence::thetah(folded), std::invalid_argument);
+    BOOST_CHECK_THROW(Sequence::zenge(folded), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_projection)
+{
+    const auto n = static_cast<std::uint32_t>(c.nsam - 10);
+    auto sfs = Sequence::unfolded_sfs(c, 0, n);
+    BOOST_REQUIRE_EQUAL(sfs.counts.size(), n + 1);
+    // Each site is spread over the classes with total weight one
+    BOOST_CHECK(close(sum(sfs.counts), static_cast<double>(c.nrow)));
+    // and the expected diversity of each site is unchanged
+    BOOST_CHECK(close(Sequence::thetapi(sfs), Sequence::thetapi(c)));
+
+    // Sites with fewer than n non-missing samples are not used
+    for (std::size_t i = 0; i < 11; ++i)
+        {
+            m.get(0, i) = -1;
+        }
+    for (std::size_t i = 0; i < 5; ++i)
+        {
+            m.get(1, i) = -1;
+        }
+    Sequence::AlleleCountMatrix missing(m);
+    auto sfs2 = Sequence::unfolded_sfs(missing, 0, n);
+    BOOST_CHECK(close(sum(sfs2.counts), static_cast<double>(c.nrow - 1)));
+    BOOST_CHECK_THROW(Sequence::unfolded_sfs(c, 0, c.nsam + 1),
+                      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_joint_sfs)
+{
+    const auto n1 = static_cast<std::uint32_t>(m.nsam() / 3),
+               n2 = static_cast<std::uint32_t>(m.nsam() - n1);
+    std::vector<std::int32_t> pops(n1, 0);
+    pops.resize(m.nsam(), 1);
+    auto joint = Sequence::joint_sfs(m, pops, 0);
+    BOOST_REQUIRE_EQUAL(joint.nsam.size(), 2);
+    BOOST_REQUIRE_EQUAL(joint.nsam[0], n1);
+    BOOST_REQUIRE_EQUAL(joint.nsam[1], n2);
+    BOOST_REQUIRE_EQUAL(joint.counts.size(), (n1 + 1) * (n2 + 1));
+    BOOST_CHECK_EQUAL(sum(joint.counts), static_cast<double>(m.nsites()));
+
+    // The margins are the spectra of each population
+    Sequence::AlleleCountMatrix c1(Sequence::make_slice(
+        m, m.position(0), m.position(m.nsites() - 1), 0, n1));
+    auto sfs1 = Sequence::unfolded_sfs(c1, 0);
+    for (std::uint32_t i = 1; i <= n1; ++i)
+        {
+            double margin = 0.0;
+            for (std::uint32_t j = 0; j <= n2; ++j)
+                {
+                    margin += joint.counts[i * (n2 + 1) + j];
+                }
+            BOOST_CHECK_EQUAL(margin, sfs1.counts[i]);
+        }
+
+    // Projection
+    auto projected = Sequence::joint_sfs(m, pops, 0, { 4, 6 });
+    BOOST_REQUIRE_EQUAL(projected.counts.size(), 5 * 7);
+    BOOST_CHECK(close(sum(projected.counts), static_cast<double>(m.nsites())));
+
+    // Folding
+    auto folded = Sequence::folded_joint_sfs(m, pops);
+    BOOST_REQUIRE(folded.folded);
+    BOOST_CHECK_EQUAL(sum(folded.counts), static_cast<double>(m.nsites()));
+    for (std::uint32_t i = 0; i <= n1; ++i)
+        {
+            for (std::uint32_t j = 0; j <= n2; ++j)
+                {
+                    if (2 * (i + j) > n1 + n2)
+                        {
+                            BOOST_CHECK_EQUAL(
+                                folded.counts[i * (n2 + 1) + j], 0.0);
+                        }
+                }
+        }
+    auto f2 = Sequence::fold(joint);
+    BOOST_CHECK(f2.counts == folded.counts);
+}
+
+BOOST_AUTO_TEST_CASE(test_joint_sfs_bad_input)
+{
+    std::vector<std::int32_t> pops(m.nsam() - 1, 0);
+    BOOST_CHECK_THROW(Sequence::joint_sfs(m, pops, 0), std::invalid_argument);
+    pops.push_back(1);
+    BOOST_CHECK_THROW(Sequence::joint_sfs(m, pops, 0, { 2 }),
+                      std::invalid_argument);
+    BOOST_CHECK_THROW(
+        Sequence::joint_sfs(m, pops, 0,
+                            { 2, static_cast<std::uint32_t>(m.nsam()) }),
+        std::invalid_argument);
+    BOOST_CHECK_THROW(Sequence::joint_sfs(m, pops, 2), std::invalid_argument);
+    BOOST_CHECK_THROW(Sequence::joint_sfs(m, pops,
+                                          std::vector<std::int8_t>(1, 0)),
+                      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_joint_sfs_all_missing)
+// All-missing data, as VCFReader returns them, give an empty spectrum
+{
+    Sequence::VariantMatrix missing(std::vector<std::int8_t>(8, -1),
+                                    std::vector<double>{ 0.1, 0.2 }, 0);
+    std::vector<std::int32_t> pops{ 0, 0, 1, 1 };
+    auto joint = Sequence::joint_sfs(missing, pops, 0);
+    BOOST_REQUIRE_EQUAL(joint.counts.size(), 9);
+    for (auto c : joint.counts)
+        {
+            BOOST_REQUIRE_EQUAL(c, 0.0);
+        }
+    auto per_site = Sequence::joint_sfs(missing, pops,
+                                        std::vector<std::int8_t>(2, 0));
+    BOOST_REQUIRE(per_site.counts == joint.counts);
+}
+
+BOOST_AUTO_TEST_CASE(test_thetapi_multiallelic)
+{
+    // One site with states 0, 0, 1, 2.  Each derived state is a
+    // singleton in the spectrum, so the pair of derived states
+    // is counted twice.
+    Sequence::VariantMatrix m(std::vector<std::int8_t>{ 0, 0, 1, 2 },
+                              std::vector<double>{ 0.5 });
+    Sequence::AlleleCountMatrix ac(m);
+    const auto sfs = Sequence::unfolded_sfs(ac, 0);
+    BOOST_REQUIRE_EQUAL(sfs.counts[1], 2.0);
+    BOOST_CHECK(close(Sequence::thetapi(ac), 10.0 / 12.0));
+    BOOST_CHECK(close(Sequence::thetapi(sfs), 1.0));
+
+    // With two states per site, the two agree
+    Sequence::VariantMatrix biallelic(std::vector<std::int8_t>{ 0, 0, 1, 1 },
+                                      std::vector<double>{ 0.5 });
+    Sequence::AlleleCountMatrix bac(biallelic);
+    BOOST_CHECK(close(Sequence::thetapi(Sequence::unfolded_sfs(bac, 0)),
+                      Sequence::thetapi(bac)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,143 @@
+//! \file testSnn.cc @brief unit tests for Sequence::snn and its permutation tests
+
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/summstats/snn.hpp>
+#include <Sequence/summstats/classics.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+namespace
+{
+    double
+    manual_snn(const Sequence::VariantMatrix& m,
+               const std::vector<std::int32_t>& populations)
+    // Hudson's definition, with all samples labelled
+    {
+        const auto diffs = Sequence::difference_matrix(m);
+        const std::size_t n = m.nsam();
+        auto d = [&](std::size_t i, std::size_t j) {
+            if (i > j)
+                std::swap(i, j);
+            return diffs[i * n - i * (i + 1) / 2 + j - i - 1];
+        };
+        double snn = 0.0;
+        for (std::size_t k = 0; k < n; ++k)
+            {
+                std::int32_t min = -1;
+                for (std::size_t j = 0; j < n; ++j)
+                    {
+                        if (j != k && (min < 0 || d(k, j) < min))
+                            min = d(k, j);
+                    }
+                int T = 0, M = 0;
+                for (std::size_t j = 0; j < n; ++j)
+                    {
+                        if (j != k && d(k, j) == min)
+                            {
+                                ++T;
+                                M += (populations[j] == populations[k]);
+                            }
+                    }
+                snn += double(M) / double(T);
+            }
+        return snn / double(n);
+    }
+
+    std::vector<std::int32_t>
+    three_populations(const std::size_t nsam)
+    {
+        std::vector<std::int32_t> pops(nsam);
+        for (std::size_t i = 0; i < nsam; ++i)
+            {
+                pops[i] = static_cast<std::int32_t>(3 * i / nsam);
+            }
+        return pops;
+    }
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(test_Snn, vmatrix_from_msprime)
+
+BOOST_AUTO_TEST_CASE(test_snn_statistic)
+{
+    auto pops = three_populations(m.nsam());
+    BOOST_CHECK_EQUAL(Sequence::snn(m, pops), manual_snn(m, pops));
+    for (std::size_t i = 0; i < pops.size(); ++i)
+        {
+            pops[i] = static_cast<std::int32_t>(i % 2);
+        }
+    BOOST_CHECK_EQUAL(Sequence::snn(m, pops), manual_snn(m, pops));
+}
+
+BOOST_AUTO_TEST_CASE(test_snn_test_does_not_depend_on_nthreads)
+{
+    auto pops = three_populations(m.nsam());
+    for (std::uint32_t stop_after : { 0u, 5u })
+        {
+            auto r1 = Sequence::snn_test(m, pops, 5000, 42, 1, stop_after);
+            auto r4 = Sequence::snn_test(m, pops, 5000, 42, 4, stop_after);
+            BOOST_CHECK_EQUAL(r1.snn, Sequence::snn(m, pops));
+            BOOST_CHECK_EQUAL(r1.snn, r4.snn);
+            BOOST_CHECK_EQUAL(r1.nperms, r4.nperms);
+            BOOST_CHECK_EQUAL(r1.nextreme, r4.nextreme);
+            BOOST_CHECK_EQUAL(r1.pvalue, r4.pvalue);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_snn_test_stops_early)
+{
+    // Labels unrelated to the data give large p-values
+    std::vector<std::int32_t> pops(m.nsam());
+    for (std::size_t i = 0; i < pops.size(); ++i)
+        {
+            pops[i] = static_cast<std::int32_t>(i % 2);
+        }
+    auto full = Sequence::snn_test(m, pops, 5000, 101, 2);
+    BOOST_REQUIRE_EQUAL(full.nperms, 5000);
+    BOOST_REQUIRE(full.nextreme > 10);
+    auto r = Sequence::snn_test(m, pops, 5000, 101, 2, 10);
+    BOOST_CHECK_EQUAL(r.nextreme, 10);
+    BOOST_CHECK(r.nperms < 5000);
+    BOOST_CHECK_EQUAL(r.pvalue, 10.0 / double(r.nperms));
+}
+
+BOOST_AUTO_TEST_CASE(test_snn_test_pairwise)
+{
+    auto pops = three_populations(m.nsam());
+    auto r = Sequence::snn_test_pairwise(m, pops, 1000, 7, 3);
+    BOOST_REQUIRE_EQUAL(r.size(), 3);
+    std::size_t k = 0;
+    for (std::int32_t i = 0; i < 2; ++i)
+        {
+            for (std::int32_t j = i + 1; j < 3; ++j, ++k)
+                {
+                    BOOST_CHECK_EQUAL(r[k].pop1, i);
+                    BOOST_CHECK_EQUAL(r[k].pop2, j);
+                    BOOST_CHECK_EQUAL(r[k].nperms, 1000);
+                    auto p = pops;
+                    for (auto& x : p)
+                        {
+                            if (x != i && x != j)
+                                x = -1;
+                        }
+                    BOOST_CHECK_EQUAL(r[k].snn, Sequence::snn(m, p));
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_snn_bad_input)
+{
+    auto pops = three_populations(m.nsam());
+    BOOST_CHECK_THROW(Sequence::snn_test(m, pops, 10, 1, 0),
+                      std::invalid_argument);
+    pops.pop_back();
+    BOOST_CHECK_THROW(Sequence::snn(m, pops), std::invalid_argument);
+    std::vector<std::int32_t> one(m.nsam(), -1);
+    one[0] = 0;
+    BOOST_CHECK_THROW(Sequence::snn(m, one), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,102 @@
+//! \file testStatisticPlan.cc @brief unit tests for Sequence::SummaryStatisticPlan
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/VariantMatrixViews.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/summstats/classics.hpp>
+#include <Sequence/summstats/nvariablesites.hpp>
+#include <Sequence/summstats/statistic_plan.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+BOOST_FIXTURE_TEST_SUITE(test_statistic_plan, vmatrix_from_msprime)
+
+BOOST_AUTO_TEST_CASE(test_plan_matches_individual_functions)
+{
+    Sequence::SummaryStatisticPlan plan(Sequence::SummaryStatistic::all);
+    BOOST_REQUIRE(plan.needs_refstate());
+    auto s = plan(c, 0);
+    BOOST_CHECK_EQUAL(s.thetapi, Sequence::thetapi(c));
+    BOOST_CHECK_EQUAL(s.thetaw, Sequence::thetaw(c));
+    BOOST_CHECK_EQUAL(s.tajd, Sequence::tajd(c));
+    BOOST_CHECK_EQUAL(s.thetah, Sequence::thetah(c, 0));
+    BOOST_CHECK_EQUAL(s.thetal, Sequence::thetal(c, 0));
+    BOOST_CHECK_EQUAL(s.faywuh, Sequence::faywuh(c, 0));
+    BOOST_CHECK_EQUAL(s.hprime, Sequence::hprime(c, 0));
+    BOOST_CHECK_EQUAL(s.nvariable_sites, Sequence::nvariable_sites(c));
+    BOOST_CHECK_EQUAL(s.nbiallelic_sites, Sequence::nbiallelic_sites(c));
+    BOOST_CHECK_EQUAL(s.total_number_of_mutations,
+                      Sequence::total_number_of_mutations(c));
+}
+
+BOOST_AUTO_TEST_CASE(test_plan_with_reference_state_per_site)
+{
+    std::vector<std::int8_t> refstates(m.nsites());
+    for (std::size_t i = 0; i < refstates.size(); ++i)
+        {
+            refstates[i] = (i % 5 == 0) ? -1 : static_cast<std::int8_t>(i % 2);
+        }
+    Sequence::SummaryStatisticPlan plan(Sequence::SummaryStatistic::all);
+    auto s = plan(c, refstates);
+    BOOST_CHECK_EQUAL(s.thetapi, Sequence::thetapi(c));
+    BOOST_CHECK_EQUAL(s.thetah, Sequence::thetah(c, refstates));
+    BOOST_CHECK_EQUAL(s.thetal, Sequence::thetal(c, refstates));
+    BOOST_CHECK_EQUAL(s.faywuh, Sequence::faywuh(c, refstates));
+    BOOST_CHECK_EQUAL(s.hprime, Sequence::hprime(c, refstates));
+
+    refstates.pop_back();
+    BOOST_CHECK_THROW(plan(c, refstates), std::invalid_argument);
+    refstates.assign(m.nsites(), -1);
+    BOOST_CHECK_THROW(plan(c, refstates), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_unrequested_statistics)
+{
+    Sequence::SummaryStatisticPlan plan(Sequence::SummaryStatistic::thetapi
+                                        | Sequence::SummaryStatistic::tajd);
+    BOOST_REQUIRE(!plan.needs_refstate());
+    // No ancestral state is needed, so none is checked
+    auto s = plan(c);
+    BOOST_CHECK_EQUAL(s.thetapi, Sequence::thetapi(c));
+    BOOST_CHECK_EQUAL(s.tajd, Sequence::tajd(c));
+    BOOST_CHECK(std::isnan(s.thetaw));
+    BOOST_CHECK(std::isnan(s.faywuh));
+    BOOST_CHECK_EQUAL(s.nvariable_sites, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_plan_multiple_derived_states)
+{
+    auto f = Sequence::get_RowView(m, 0);
+    for (std::size_t i = 0; i < f.size(); ++i)
+        {
+            f[i] = static_cast<std::int8_t>(i % 3);
+        }
+    std::vector<std::int8_t> temp(m.data(), m.data() + m.nsites() * m.nsam());
+    std::vector<double> tpos(m.pbegin(), m.pend());
+    Sequence::VariantMatrix m2(temp, tpos);
+    Sequence::AlleleCountMatrix ac(m2);
+    BOOST_CHECK_THROW(
+        Sequence::SummaryStatisticPlan(Sequence::SummaryStatistic::thetah)(ac,
+                                                                           0),
+        std::runtime_error);
+    BOOST_CHECK_THROW(
+        Sequence::SummaryStatisticPlan(Sequence::SummaryStatistic::faywuh)(ac,
+                                                                           0),
+        std::runtime_error);
+    BOOST_CHECK_THROW(
+        Sequence::SummaryStatisticPlan(Sequence::SummaryStatistic::thetal)(ac,
+                                                                           3),
+        std::invalid_argument);
+    auto s = Sequence::SummaryStatisticPlan(
+        Sequence::SummaryStatistic::thetaw
+        | Sequence::SummaryStatistic::total_number_of_mutations)(ac);
+    BOOST_CHECK_EQUAL(s.thetaw, Sequence::thetaw(ac));
+    BOOST_CHECK_EQUAL(s.total_number_of_mutations,
+                      Sequence::total_number_of_mutations(ac));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+//! \file testTranslate.cc @brief unit tests for Sequence::Translate, Sequence::TranslateCodon and Sequence::makeCodonUsageTable
+
+#include <numeric>
+#include <string>
+#include <vector>
+#include <Sequence/Translate.hpp>
+#include <Sequence/CodonTable.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    const char bases[] = "ACGT";
+
+    std::string
+    codon_at(const int index)
+    // The codon numbered index by Sequence::CodonIndex
+    {
+        return std::string{ bases[index / 16], bases[(index / 4) % 4],
+                            bases[index % 4] };
+    }
+
+    char
+    unused_base(const std::string& codon)
+    // A base that is not in codon.  Passed as the gap character,
+    // it makes TranslateCodon use the switch-based translation
+    // without changing the result.
+    {
+        for (const char* b = bases; *b; ++b)
+            {
+                if (codon.find(*b) == std::string::npos)
+                    {
+                        return *b;
+                    }
+            }
+        return '\0';
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TranslateTest)
+
+BOOST_AUTO_TEST_CASE(codon_index_numbers_all_codons)
+{
+    for (int i = 0; i < 64; ++i)
+        {
+            BOOST_REQUIRE_EQUAL(Sequence::CodonIndex(codon_at(i).c_str()), i);
+        }
+    BOOST_REQUIRE_EQUAL(Sequence::CodonIndex("tTg"),
+                        Sequence::CodonIndex("TTG"));
+    for (const char* c : { "ANG", "A-G", "NNN", "AT?" })
+        {
+            BOOST_REQUIRE_EQUAL(Sequence::CodonIndex(c), -1);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(table_matches_switch_for_every_codon)
+{
+    for (int i = 0; i < 64; ++i)
+        {
+            const std::string codon = codon_at(i);
+            const char gap = unused_base(codon);
+            BOOST_REQUIRE(gap != '\0');
+            BOOST_CHECK_EQUAL(
+                Sequence::TranslateCodon(codon.c_str()),
+                Sequence::TranslateCodon(codon.c_str(),
+                                         Sequence::GeneticCodes::UNIVERSAL,
+                                         gap));
+        }
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("ATG"), 'M');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("TGG"), 'W');
+    for (const char* stop : { "TAA", "TAG", "TGA" })
+        {
+            BOOST_CHECK_EQUAL(Sequence::TranslateCodon(stop), '*');
+        }
+}
+
+BOOST_AUTO_TEST_CASE(case_gaps_and_missing_data)
+{
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("atg"), 'M');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("tGa"), '*');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("---"), '-');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("A-G"), 'X');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("--G"), 'X');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("ANG"), 'X');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("NNN"), 'X');
+    // Ambiguity at a fourfold-degenerate site is resolved
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("GCN"), 'A');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("gcn"), 'A');
+
+    // Other gap characters
+    const auto code = Sequence::GeneticCodes::UNIVERSAL;
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("...", code, '.'), '-');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("A.G", code, '.'), 'X');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("---", code, '.'), 'X');
+    // A gap character that is also a base
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("AAA", code, 'A'), '-');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("ATG", code, 'A'), 'X');
+    BOOST_CHECK_EQUAL(Sequence::TranslateCodon("CCC", code, 'A'), 'P');
+
+    const std::string cds = "atgGCN---A-GtaA";
+    BOOST_CHECK_EQUAL(Sequence::Translate(cds.begin(), cds.end()), "MA-X*");
+}
+
+BOOST_AUTO_TEST_CASE(partial_codon_is_dropped)
+{
+    const std::string cds = "ATGTGGTA";
+    BOOST_CHECK_EQUAL(Sequence::Translate(cds.begin(), cds.end()), "MW");
+    BOOST_CHECK_EQUAL(Sequence::Translate(cds.begin(), cds.begin() + 2), "");
+
+    std::vector<char> out(4, '?');
+    char* end = Sequence::Translate(cds.data(), cds.data() + cds.size(),
+                                    out.data());
+    BOOST_REQUIRE_EQUAL(end - out.data(), 2);
+    BOOST_CHECK_EQUAL(std::string(out.data(), end), "MW");
+    BOOST_CHECK_EQUAL(out[2], '?');
+}
+
+BOOST_AUTO_TEST_CASE(back_to_back_buffer_translation)
+{
+    const std::vector<std::string> sequences{ "ATGAAACCCTAA", "atgNNN---TGG",
+                                              "GGGTTTCAGTGA" };
+    std::vector<char> peptides(4 * sequences.size());
+    char* out = peptides.data();
+    std::string expected;
+    for (const auto& s : sequences)
+        {
+            out = Sequence::Translate(s.data(), s.data() + s.size(), out);
+            expected += Sequence::Translate(s.begin(), s.end());
+        }
+    BOOST_REQUIRE(out == peptides.data() + peptides.size());
+    BOOST_CHECK_EQUAL(std::string(peptides.begin(), peptides.end()), expected);
+    BOOST_CHECK_EQUAL(expected, "MKP*MX-WGFQ*");
+}
+
+BOOST_AUTO_TEST_CASE(codon_usage_counts)
+{
+    // Codons with missing data or gaps are not counted, nor is
+    // the partial codon at the end.
+    const std::string cds = "ATGatgNTGAAA---TTGaTnTT";
+    auto table = Sequence::makeCodonUsageTable(cds);
+    BOOST_REQUIRE_EQUAL(table.size(), 64);
+    for (int i = 0; i < 64; ++i)
+        {
+            BOOST_REQUIRE_EQUAL(table[std::size_t(i)].first, codon_at(i));
+        }
+    auto count = [&table](const char* codon) {
+        return table[std::size_t(Sequence::CodonIndex(codon))].second;
+    };
+    BOOST_CHECK_EQUAL(count("ATG"), 2);
+    BOOST_CHECK_EQUAL(count("AAA"), 1);
+    BOOST_CHECK_EQUAL(count("TTG"), 1);
+    BOOST_CHECK_EQUAL(count("ATT"), 0);
+    BOOST_CHECK_EQUAL(
+        std::accumulate(table.begin(), table.end(), 0,
+                        [](int n, const Sequence::CodonUsageTable::value_type& c) {
+                            return n + c.second;
+                        }),
+        4);
+
+    auto from_range = Sequence::makeCodonUsageTable(cds.begin() + 3, cds.end());
+    BOOST_CHECK_EQUAL(from_range[std::size_t(Sequence::CodonIndex("ATG"))].second,
+                      1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+//! \file testTreeSequence.cc @brief unit tests for tree sequences recorded by the coalescent
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/Coalescent/TreeOperations.hpp>
+#include <Sequence/Coalescent/TreeSequence.hpp>
+#include <Sequence/Coalescent/InfiniteSitesMatrix.hpp>
+#include <boost/test/unit_test.hpp>
+#include "coalescent_test_data.hpp"
+
+using namespace coalescent_test_data;
+
+BOOST_AUTO_TEST_SUITE(test_tree_sequence)
+
+BOOST_AUTO_TEST_CASE(test_tree_sequence_matches_arg)
+{
+    Sequence::coalsim::rng_streams rng(seed, 0);
+    for (std::uint64_t r = 0; r < 20; ++r)
+        {
+            rng.reseed(seed, r);
+            const auto history = simulate_history(rng);
+            rng.reseed(seed, r);
+            auto sample = Sequence::coalsim::init_sample(
+                std::vector<int>(1, nsam), nsites);
+            const auto ts = Sequence::coalsim::neutral_tree_sequence(
+                rng.uni, rng.uni01, rng.expo, rho, nsites, nsam, &sample);
+            BOOST_REQUIRE_EQUAL(ts.nsam, nsam);
+            BOOST_REQUIRE_EQUAL(ts.nsites, nsites);
+
+            Sequence::coalsim::marginal_tree_walker w(ts);
+            std::vector<int> tips;
+            BOOST_REQUIRE(w.next());
+            BOOST_REQUIRE_EQUAL(w.left(), 0);
+            for (auto& m : history)
+                {
+                    while (w.right() <= m.beg)
+                        {
+                            BOOST_REQUIRE(w.next());
+                        }
+                    BOOST_REQUIRE(w.left() <= m.beg);
+                    BOOST_REQUIRE(close(
+                        w.total_time(),
+                        Sequence::coalsim::total_time(m.begin(), nsam)));
+                    // Nodes of the tree sequence are numbered in order of
+                    // time, as are the nodes of a marginal tree, so the
+                    // nodes of the current tree, in order, are the nodes
+                    // of m.
+                    std::vector<int> nodes;
+                    for (int node = 0; node < int(w.parents().size()); ++node)
+                        {
+                            if (w.parents()[std::size_t(node)] >= 0)
+                                {
+                                    nodes.push_back(node);
+                                }
+                        }
+                    BOOST_REQUIRE_EQUAL(nodes.size(), 2 * nsam - 2);
+                    for (int branch = 0; branch < 2 * nsam - 2; ++branch)
+                        {
+                            BOOST_REQUIRE_EQUAL(
+                                ts.node_times[std::size_t(nodes[branch])],
+                                m[branch].time);
+                            w.descendants(nodes[branch], &tips);
+                            std::vector<int> expected;
+                            for (int ind = 0; ind < nsam; ++ind)
+                                {
+                                    if (Sequence::coalsim::is_descendant(
+                                            m.begin(), ind, branch))
+                                        {
+                                            expected.push_back(ind);
+                                        }
+                                }
+                            std::sort(tips.begin(), tips.end());
+                            BOOST_REQUIRE(tips == expected);
+                        }
+                    const double t = w.total_time();
+                    for (int i = 0; i < 10; ++i)
+                        {
+                            const double rtime = rng.uni(0., t);
+                            BOOST_REQUIRE_EQUAL(
+                                w.pick_branch(rtime),
+                                nodes[std::size_t(
+                                    Sequence::coalsim::pick_branch(
+                                        m.begin(), nsam, rtime))]);
+                        }
+                }
+            BOOST_REQUIRE_EQUAL(w.right(), nsites);
+            BOOST_REQUIRE(!w.next());
+
+            // Adjacent trees of either may be identical, so the ARG is
+            // split at the boundaries of the trees of the tree sequence.
+            // The mutations are then the same, given the same random
+            // numbers.
+            Sequence::coalsim::arg trees;
+            Sequence::coalsim::marginal_tree_walker w2(ts);
+            auto m = history.begin();
+            while (w2.next())
+                {
+                    while (std::next(m) != history.end()
+                           && std::next(m)->beg <= w2.left())
+                        {
+                            ++m;
+                        }
+                    trees.push_back(Sequence::coalsim::marginal(
+                        w2.left(), m->nsam, m->nnodes, m->tree));
+                }
+            rng.reseed(seed, r + 1000);
+            const auto from_arg
+                = Sequence::coalsim::infinite_sites_variant_matrix(
+                    rng.poiss, rng.uni, nsites, trees, theta);
+            rng.reseed(seed, r + 1000);
+            const auto from_ts
+                = Sequence::coalsim::infinite_sites_variant_matrix(
+                    rng.poiss, rng.uni, ts, theta);
+            BOOST_REQUIRE(from_arg.nsites() > 0);
+            BOOST_REQUIRE(same_matrix(from_ts, from_arg));
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
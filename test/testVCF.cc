@@ -0,0 +1,290 @@
+//! \file testVCF.cc @brief unit tests for reading VariantMatrix from VCF
+
+#include <config.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <Sequence/VariantMatrix.hpp>
+#include <Sequence/variant_matrix/vcf.hpp>
+#include <Sequence/variant_matrix/msformat.hpp>
+#include <boost/test/unit_test.hpp>
+#include "msprime_data_fixture.hpp"
+
+namespace
+{
+    const char* vcf_data
+        = "##fileformat=VCFv4.2\n"
+          "##contig=<ID=1>\n"
+          "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\tB\tC\n"
+          "1\t10\t.\tA\tG\t.\tPASS\t.\tGT\t0|1\t1/1\t./.\n"
+          "1\t150\t.\tA\tG,T\t.\tPASS\t.\tGT:DP\t2|0:10\t0/.:3\t1|1:5\n"
+          "1\t220\t.\tC\tT\t.\tPASS\t.\tDP\t1\t2\t3\n"
+          "2\t5\t.\tC\tT\t.\tPASS\t.\tGT\t1\t0|1\t.\n"
+          "2\t120\t.\tC\tT\t.\tPASS\t.\tGT\t0|0\t0|1\t1|0\n";
+
+    // vcf_data compressed as two gzip members, split before the
+    // second record, as bgzip writes blocks
+    const char vcf_gzip[]
+        = "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\x0d\x89\xb1\x0a\xc2\x30"
+          "\x18\x06\xe7\x2f\xaf\xf1\xef\x69\x23\x8e\x46\xf8\x4d\x9b\x1a\x48"
+          "\x4d\x4d\x62\x77\x11\x2b\x05\xb5\x20\xc5\xc9\x87\x37\xcb\x1d\xc7"
+          "\x11\x4d\xf3\xf3\x3e\x2d\x9f\xd7\x75\xd5\xa3\xb1\xdf\xad\xdc\x08"
+          "\xa2\xdb\xf2\x5e\xe7\x87\xde\xb9\x46\xab\xbd\x20\x73\x8c\xa1\xc7"
+          "\x10\x12\x5c\x83\xd8\x5a\xb0\xcf\x38\x5f\xd8\xc3\x3a\x9f\xdb\x08"
+          "\x77\xb2\x01\x36\xc4\x9e\x33\x18\x07\x18\xa1\xa0\x6a\xc8\x12\x5d"
+          "\xe1\xc0\x29\x15\x75\x19\xf5\xaf\x8c\x4a\x41\x56\x52\xfc\x01\xb2"
+          "\x21\x1c\xad\x7c\x00\x00\x00\x1f\x8b\x08\x00\x00\x00\x00\x00\x02"
+          "\x03\x65\x8b\x31\x0a\x80\x30\x10\x04\xeb\xcd\x5b\x24\xde\x5e\x48"
+          "\x73\x5d\x50\x48\x1b\x48\x9e\x73\x8f\xf7\xb4\x12\xad\x06\x76\x66"
+          "\x09\x56\x41\x46\x43\xdf\x56\x70\xb4\x39\x03\x7d\xd9\x39\xa0\x2e"
+          "\x46\x81\xec\xd9\x0a\xe8\xb4\x9a\x08\xd5\xbb\x3f\xf0\xaa\x23\x8d"
+          "\x1d\x25\x29\xea\xd7\xf5\x15\x4e\x9c\xc8\x61\xf9\xff\x86\x17\x97"
+          "\xa7\xa0\x4b\xba\x00\xde\x16\x1d\x86\x90\x00\x00\x00";
+
+    std::string
+    gzip_data()
+    {
+        return std::string(vcf_gzip, sizeof(vcf_gzip) - 1);
+    }
+
+    std::vector<std::int8_t>
+    row(const Sequence::VariantMatrix& m, const std::size_t site)
+    {
+        std::vector<std::int8_t> rv;
+        for (std::size_t i = 0; i < m.nsam(); ++i)
+            {
+                rv.push_back(m.get(site, i));
+            }
+        return rv;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(test_vcf)
+
+BOOST_AUTO_TEST_CASE(test_read_sites)
+{
+    std::istringstream in(vcf_data);
+    Sequence::VCFReader reader(in);
+    BOOST_REQUIRE_EQUAL(reader.samples().size(), 3);
+    BOOST_REQUIRE_EQUAL(reader.samples()[2], "C");
+    BOOST_REQUIRE_EQUAL(reader.ploidy(), 2);
+
+    auto m = reader.read_sites(2);
+    BOOST_REQUIRE_EQUAL(reader.chromosome(), "1");
+    BOOST_REQUIRE_EQUAL(m.nsites(), 2);
+    BOOST_REQUIRE_EQUAL(m.nsam(), 6);
+    BOOST_REQUIRE_EQUAL(m.position(0), 10.0);
+    BOOST_REQUIRE_EQUAL(m.position(1), 150.0);
+    BOOST_REQUIRE(row(m, 0) == (std::vector<std::int8_t>{ 0, 1, 1, 1, -1, -1 }));
+    BOOST_REQUIRE(row(m, 1) == (std::vector<std::int8_t>{ 2, 0, 0, -1, 1, 1 }));
+    BOOST_REQUIRE_EQUAL(m.max_allele(), 2);
+
+    // Blocks stop at the end of a chromosome, and records
+    // without GT are missing data
+    m = reader.read_sites(10);
+    BOOST_REQUIRE_EQUAL(m.nsites(), 1);
+    BOOST_REQUIRE(row(m, 0) == std::vector<std::int8_t>(6, -1));
+
+    // Haploid calls are padded with missing data
+    m = reader.read_sites(10);
+    BOOST_REQUIRE_EQUAL(reader.chromosome(), "2");
+    BOOST_REQUIRE_EQUAL(m.nsites(), 2);
+    BOOST_REQUIRE(row(m, 0) == (std::vector<std::int8_t>{ 1, -1, 0, 1, -1, -1 }));
+    BOOST_REQUIRE(reader.done());
+    m = reader.read_sites(10);
+    BOOST_REQUIRE_EQUAL(m.nsites(), 0);
+    BOOST_REQUIRE_THROW(reader.read_sites(0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_read_interval)
+{
+    std::istringstream in(vcf_data);
+    Sequence::VCFReader reader(in);
+    std::vector<std::size_t> nsites;
+    std::vector<std::string> chroms;
+    while (!reader.done())
+        {
+            nsites.push_back(reader.read_interval(100.0).nsites());
+            chroms.push_back(reader.chromosome());
+        }
+    BOOST_REQUIRE(nsites == (std::vector<std::size_t>{ 1, 1, 1, 1, 1 }));
+    BOOST_REQUIRE(chroms
+                  == (std::vector<std::string>{ "1", "1", "1", "2", "2" }));
+    std::istringstream in2(vcf_data);
+    Sequence::VCFReader reader2(in2);
+    BOOST_REQUIRE_EQUAL(reader2.read_interval(1000.0).nsites(), 3);
+    BOOST_REQUIRE_THROW(reader2.read_interval(0.0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_ploidy_and_errors)
+{
+    std::istringstream in(vcf_data);
+    Sequence::VCFReader haploid(in, 1);
+    BOOST_REQUIRE_THROW(haploid.read_sites(1), std::runtime_error);
+
+    std::istringstream no_header("1\t10\t.\tA\tG\t.\tPASS\t.\tGT\t0\n");
+    BOOST_REQUIRE_THROW(Sequence::VCFReader r(no_header), std::runtime_error);
+
+    std::istringstream bad_columns(
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\tB\n"
+        "1\t10\t.\tA\tG\t.\tPASS\t.\tGT\t0|1\n");
+    BOOST_REQUIRE_THROW(Sequence::VCFReader r(bad_columns),
+                        std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_ploidy_skips_single_no_calls)
+// A lone "." does not give the ploidy
+{
+    std::istringstream in(
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\tB\tC\n"
+        "1\t10\t.\tA\tG\t.\tPASS\t.\tGT:DP\t.:0\t0/1:4\t.\n"
+        "1\t20\t.\tA\tG\t.\tPASS\t.\tGT\t1|1\t.\t0\n");
+    Sequence::VCFReader reader(in);
+    BOOST_REQUIRE_EQUAL(reader.ploidy(), 2);
+    auto m = reader.read_sites(10);
+    BOOST_REQUIRE_EQUAL(m.nsam(), 6);
+    BOOST_REQUIRE(row(m, 0)
+                  == (std::vector<std::int8_t>{ -1, -1, 0, 1, -1, -1 }));
+    BOOST_REQUIRE(row(m, 1)
+                  == (std::vector<std::int8_t>{ 1, 1, -1, -1, 0, -1 }));
+
+    std::istringstream all_missing(
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\n"
+        "1\t10\t.\tA\tG\t.\tPASS\t.\tGT\t.\n");
+    Sequence::VCFReader unknown(all_missing);
+    BOOST_REQUIRE_EQUAL(unknown.ploidy(), 1);
+    m = unknown.read_sites(1);
+    BOOST_REQUIRE_EQUAL(m.nsites(), 1);
+    BOOST_REQUIRE(row(m, 0) == (std::vector<std::int8_t>{ -1 }));
+}
+
+BOOST_AUTO_TEST_CASE(test_ploidy_after_missing_first_record)
+// Records where all genotypes are "." are kept while
+// later records are read to find the ploidy
+{
+    std::istringstream in(
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\tB\n"
+        "1\t10\t.\tA\tG\t.\tPASS\t.\tGT\t.\t.\n"
+        "1\t20\t.\tA\tG\t.\tPASS\t.\tGT:DP\t.:1\t.:2\n"
+        "1\t30\t.\tA\tG\t.\tPASS\t.\tGT\t0|1\t1|1\n"
+        "1\t40\t.\tA\tG\t.\tPASS\t.\tGT\t1|0\t.\n");
+    Sequence::VCFReader reader(in);
+    BOOST_REQUIRE_EQUAL(reader.ploidy(), 2);
+    auto m = reader.read_sites(2);
+    BOOST_REQUIRE_EQUAL(m.nsites(), 2);
+    BOOST_REQUIRE_EQUAL(m.nsam(), 4);
+    BOOST_REQUIRE_EQUAL(m.position(0), 10.0);
+    BOOST_REQUIRE_EQUAL(m.position(1), 20.0);
+    BOOST_REQUIRE(row(m, 0) == (std::vector<std::int8_t>(4, -1)));
+    BOOST_REQUIRE(row(m, 1) == (std::vector<std::int8_t>(4, -1)));
+    m = reader.read_sites(10);
+    BOOST_REQUIRE_EQUAL(m.nsites(), 2);
+    BOOST_REQUIRE_EQUAL(m.position(0), 30.0);
+    BOOST_REQUIRE(row(m, 0) == (std::vector<std::int8_t>{ 0, 1, 1, 1 }));
+    BOOST_REQUIRE(row(m, 1) == (std::vector<std::int8_t>{ 1, 0, -1, -1 }));
+    BOOST_REQUIRE(reader.done());
+}
+
+BOOST_AUTO_TEST_CASE(test_failed_record_is_not_appended)
+// A record that cannot be parsed leaves the reader at that
+// record, and is not part of any block
+{
+    std::istringstream in(
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\n"
+        "1\t10\t.\tA\tG\t.\tPASS\t.\tGT\t0|1\n"
+        "1\t20\t.\tA\tG\t.\tPASS\t.\tGT\t0|x\n");
+    Sequence::VCFReader reader(in);
+    auto m = reader.read_sites(1);
+    BOOST_REQUIRE_EQUAL(m.nsites(), 1);
+    BOOST_REQUIRE_THROW(reader.read_sites(1), std::runtime_error);
+    BOOST_REQUIRE(!reader.done());
+    BOOST_REQUIRE_THROW(reader.read_sites(1), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_gzip_input)
+{
+#ifdef HAVE_LIBZ
+    std::istringstream plain(vcf_data), compressed(gzip_data());
+    Sequence::VCFReader expected(plain), reader(compressed);
+    BOOST_REQUIRE(reader.samples() == expected.samples());
+    BOOST_REQUIRE_EQUAL(reader.ploidy(), 2);
+    while (!expected.done())
+        {
+            auto a = expected.read_sites(1);
+            auto b = reader.read_sites(1);
+            BOOST_REQUIRE_EQUAL(reader.chromosome(), expected.chromosome());
+            BOOST_REQUIRE_EQUAL(b.position(0), a.position(0));
+            BOOST_REQUIRE(row(b, 0) == row(a, 0));
+        }
+    BOOST_REQUIRE(reader.done());
+
+    const std::string filename("vcf_test.vcf.gz");
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << gzip_data();
+    }
+    Sequence::VCFReader from_file(filename);
+    BOOST_REQUIRE_EQUAL(from_file.read_interval(1000.0).nsites(), 3);
+    std::remove(filename.c_str());
+
+    // Input ending inside a gzip member
+    const std::string data = gzip_data();
+    std::istringstream truncated(data.substr(0, data.size() - 20));
+    BOOST_REQUIRE_THROW(
+        {
+            Sequence::VCFReader r(truncated);
+            while (!r.done())
+                {
+                    r.read_sites(1);
+                }
+        },
+        std::runtime_error);
+#else
+    std::istringstream compressed(gzip_data());
+    BOOST_REQUIRE_THROW(Sequence::VCFReader r(compressed), std::runtime_error);
+#endif
+    BOOST_REQUIRE_THROW(Sequence::VCFReader r("no_such_file.vcf"),
+                        std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_round_trip, vmatrix_from_msprime)
+// Write the fixture as haploid VCF and read it back in blocks
+{
+    std::ostringstream out;
+    out << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+    for (std::size_t i = 0; i < m.nsam(); ++i)
+        {
+            out << "\ts" << i;
+        }
+    out << '\n';
+    for (std::size_t site = 0; site < m.nsites(); ++site)
+        {
+            out << "1\t" << site + 1 << "\t.\tA\tG\t.\tPASS\t.\tGT";
+            for (std::size_t i = 0; i < m.nsam(); ++i)
+                {
+                    out << '\t' << static_cast<int>(m.get(site, i));
+                }
+            out << '\n';
+        }
+    std::istringstream in(out.str());
+    Sequence::VCFReader reader(in);
+    BOOST_REQUIRE_EQUAL(reader.ploidy(), 1);
+    std::size_t site = 0;
+    while (!reader.done())
+        {
+            auto block = reader.read_sites(100);
+            BOOST_REQUIRE(block.nsites() <= 100);
+            BOOST_REQUIRE_EQUAL(block.nsam(), m.nsam());
+            for (std::size_t i = 0; i < block.nsites(); ++i, ++site)
+                {
+                    BOOST_REQUIRE_EQUAL(block.position(i),
+                                        static_cast<double>(site + 1));
+                    BOOST_REQUIRE(row(block, i) == row(m, site));
+                }
+        }
+    BOOST_REQUIRE_EQUAL(site, m.nsites());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
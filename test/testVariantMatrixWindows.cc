@@ -2,12 +2,33 @@
 #include <Sequence/VariantMatrixViews.hpp>
 #include <Sequence/variant_matrix/windows.hpp>
 #include <Sequence/variant_matrix/msformat.hpp>
+#include <Sequence/variant_matrix/filtering.hpp>
+#include <Sequence/AlleleCountMatrix.hpp>
+#include <Sequence/summstats/classics.hpp>
 #include <boost/test/unit_test.hpp>
 #include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <sstream>
 #include <iostream>
 #include "msformatdata.hpp"
 
+namespace
+{
+    void
+    check_stat(const double windowed, const double direct)
+    {
+        if (std::isnan(direct))
+            {
+                BOOST_REQUIRE(std::isnan(windowed));
+            }
+        else
+            {
+                BOOST_REQUIRE_SMALL(windowed - direct, 1e-8);
+            }
+    }
+} // namespace
+
 BOOST_AUTO_TEST_SUITE(testVariantMatrixWindows)
 
 BOOST_AUTO_TEST_CASE(test_windows)
@@ -56,4 +77,100 @@ BOOST_AUTO_TEST_CASE(test_slices)
         }
 }
 
+BOOST_AUTO_TEST_CASE(test_slices_of_filtered_views)
+{
+    std::vector<std::int8_t> data(8);
+    std::iota(data.begin(), data.end(), 0);
+    Sequence::VariantMatrix vm(data, std::vector<double>{ 0.1, 0.2 });
+    auto view = Sequence::make_filtered_view(vm, { 0, 1 }, { 1, 2 });
+    auto w = Sequence::make_window(view, 0.0, 1.0);
+    BOOST_REQUIRE_EQUAL(w.nsites(), 2);
+    BOOST_REQUIRE_EQUAL(w.nsam(), 2);
+    const std::int8_t expected[] = { 1, 2, 5, 6 };
+    for (std::size_t site = 0; site < 2; ++site)
+        {
+            for (std::size_t sample = 0; sample < 2; ++sample)
+                {
+                    BOOST_REQUIRE_EQUAL(w.cget(site, sample),
+                                        expected[2 * site + sample]);
+                }
+        }
+
+    // Samples that are not contiguous in the parent
+    std::istringstream i(get_msformat_data());
+    auto ms = Sequence::from_msformat(i);
+    auto scattered = Sequence::make_filtered_view(
+        ms, { 1, 4, 5, 6, 9, 12 }, { 40, 3, 7, 8, 9, 21 });
+    auto s = Sequence::make_slice(scattered, scattered.cposition(1),
+                                  scattered.cposition(4), 2, 5);
+    BOOST_REQUIRE_EQUAL(s.nsites(), 4);
+    BOOST_REQUIRE_EQUAL(s.nsam(), 3);
+    for (std::size_t site = 0; site < s.nsites(); ++site)
+        {
+            BOOST_REQUIRE_EQUAL(s.cposition(site),
+                                scattered.cposition(site + 1));
+            for (std::size_t sample = 0; sample < s.nsam(); ++sample)
+                {
+                    BOOST_REQUIRE_EQUAL(s.cget(site, sample),
+                                        scattered.cget(site + 1, sample + 2));
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_windowed_statistics)
+{
+    std::istringstream i(get_msformat_data());
+    auto vm = Sequence::from_msformat(i);
+    // Overlapping windows, and windows separated by gaps
+    for (auto step : { 0.01, 0.05, 0.15 })
+        {
+            auto stats = Sequence::windowed_statistics(
+                vm, 0.0, 1.0, 0.1, step, Sequence::WindowStatistic::all, 0);
+            BOOST_REQUIRE(!stats.empty());
+            for (auto& s : stats)
+                {
+                    auto w = Sequence::make_window(vm, s.beg, s.end);
+                    BOOST_REQUIRE_EQUAL(s.nsites, w.nsites());
+                    if (s.nsites)
+                        {
+                            BOOST_REQUIRE_EQUAL(vm.cposition(s.first_site),
+                                                w.cposition(0));
+                        }
+                    Sequence::AlleleCountMatrix ac(w);
+                    check_stat(s.thetapi, Sequence::thetapi(ac));
+                    check_stat(s.thetaw, Sequence::thetaw(ac));
+                    check_stat(s.tajd, Sequence::tajd(ac));
+                    check_stat(s.thetah, Sequence::thetah(ac, 0));
+                    check_stat(s.thetal, Sequence::thetal(ac, 0));
+                    check_stat(s.faywuh, Sequence::faywuh(ac, 0));
+                    check_stat(s.hprime, Sequence::hprime(ac, 0));
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_windowed_statistics_subset)
+{
+    std::istringstream i(get_msformat_data());
+    auto vm = Sequence::from_msformat(i);
+    auto stats = Sequence::windowed_statistics(
+        vm, 0.0, 1.0, 0.2, 0.1,
+        Sequence::WindowStatistic::thetapi | Sequence::WindowStatistic::tajd);
+    BOOST_REQUIRE_EQUAL(stats.size(), 10);
+    for (auto& s : stats)
+        {
+            BOOST_REQUIRE(std::isnan(s.thetaw));
+            BOOST_REQUIRE(std::isnan(s.hprime));
+            BOOST_REQUIRE(!std::isnan(s.thetapi));
+        }
+    // Statistics needing an ancestral state require one
+    BOOST_REQUIRE_THROW(
+        Sequence::windowed_statistics(vm, 0.0, 1.0, 0.2, 0.1,
+                                      Sequence::WindowStatistic::faywuh),
+        std::invalid_argument);
+    BOOST_REQUIRE_THROW(Sequence::windowed_statistics(
+                            vm, 0.0, 1.0, 0.2, 0.0,
+                            Sequence::WindowStatistic::thetapi),
+                        std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()